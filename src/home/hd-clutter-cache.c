@@ -22,10 +22,14 @@
  */
 
 /* This class is a singleton that caches textures that may be loaded multiple
- * times - for instance theme textures.
+ * times - for instance theme textures.  It also caches rendered text, so
+ * labels showing the same string don't lay it out and render it again.
  */
 
 #include "tidy/tidy-sub-texture.h"
+#include "tidy/tidy-util.h"
+
+#include <string.h>
 
 #include "hd-clutter-cache.h"
 #include "hd-render-manager.h"
@@ -48,6 +52,28 @@ static HdClutterCache *the_clutter_cache = 0;
 #define HD_CLUTTER_CACHE_THEME_PATH "/etc/hildon/theme/images/"
 #define HD_CLUTTER_CACHE_FALLBACK_THEME_PATH "/usr/share/themes/default/images/"
 
+/* How many rendered labels nobody uses are kept for later. */
+#define HD_CLUTTER_CACHE_UNUSED_LABELS 64
+
+/* A string rendered by hd_clutter_cache_get_label(). */
+typedef struct
+{
+  gchar *key;
+  ClutterActor *texture;
+  /* How many clones of @texture exist.  If none, it's in Unused_labels. */
+  guint refs;
+  /* Whether it's still in Labels, ie. not from before a theme change. */
+  gboolean current;
+} HdClutterCacheLabel;
+
+/* key -> HdClutterCacheLabel */
+static GHashTable *Labels;
+/* The unused labels, most recently used first. */
+static GQueue Unused_labels = G_QUEUE_INIT;
+/* Parent of the label textures, so theme changes don't try to reload
+ * them from a file. */
+static ClutterActor *Label_textures;
+
 /* ------------------------------------------------------------------------- */
 
 static void
@@ -398,4 +424,189 @@ void hd_clutter_cache_theme_changed(void) {
 
   clutter_container_foreach (CLUTTER_CONTAINER(the_clutter_cache),
                              reload_texture_cb, 0);
+
+  /* The text needs to be rendered again with the new fonts, but the
+   * labels in use keep what they have until they're replaced. */
+  if (Labels)
+    g_hash_table_remove_all (Labels);
+}
+
+static void
+label_free (HdClutterCacheLabel *label)
+{
+  clutter_actor_destroy (label->texture);
+  g_free (label->key);
+  g_slice_free (HdClutterCacheLabel, label);
+}
+
+static void
+label_unref (HdClutterCacheLabel *label)
+{
+  if (--label->refs)
+    return;
+
+  if (!label->current)
+    {
+      label_free (label);
+      return;
+    }
+
+  g_queue_push_head (&Unused_labels, label);
+  while (g_queue_get_length (&Unused_labels) > HD_CLUTTER_CACHE_UNUSED_LABELS)
+    {
+      /* Removing it from Labels frees it. */
+      label = g_queue_pop_tail (&Unused_labels);
+      g_hash_table_remove (Labels, label->key);
+    }
+}
+
+/* Destroy notify of Labels. */
+static void
+label_forget (HdClutterCacheLabel *label)
+{
+  label->current = FALSE;
+  if (!label->refs)
+    {
+      g_queue_remove (&Unused_labels, label);
+      label_free (label);
+    }
+}
+
+static void
+label_clone_gone (gpointer label, GObject *clone)
+{
+  label_unref (label);
+}
+
+/* Returns a #ClutterLabel of @text, sized as hd_clutter_cache_get_label()
+ * says. */
+static ClutterActor *
+label_new (const gchar *text, const gchar *font,
+           const ClutterColor *color, guint max_width,
+           PangoEllipsizeMode ellipsize)
+{
+  ClutterActor *label;
+  ClutterUnit natural;
+  guint width, height;
+
+  label = clutter_label_new_full (font, text, color);
+  clutter_label_set_alignment (CLUTTER_LABEL (label), PANGO_ALIGN_CENTER);
+  if (ellipsize != PANGO_ELLIPSIZE_NONE)
+    clutter_label_set_ellipsize (CLUTTER_LABEL (label), ellipsize);
+  else
+    {
+      /* Break it up anywhere if it's too wide, see HdLauncherTile. */
+      clutter_label_set_ellipsize (CLUTTER_LABEL (label),
+                                   PANGO_ELLIPSIZE_NONE);
+      clutter_label_set_line_wrap (CLUTTER_LABEL (label), TRUE);
+      clutter_label_set_line_wrap_mode (CLUTTER_LABEL (label),
+                                        PANGO_WRAP_CHAR);
+    }
+
+  clutter_actor_get_preferred_width (label, -1, NULL, &natural);
+  width = CLUTTER_UNITS_TO_DEVICE (natural);
+  if (max_width)
+    width = MIN (width, max_width);
+  clutter_actor_get_preferred_height (label, CLUTTER_UNITS_FROM_DEVICE (width),
+                                      NULL, &natural);
+  height = CLUTTER_UNITS_TO_DEVICE (natural);
+  width = MAX (width, 1);
+  height = MAX (height, 1);
+  clutter_actor_set_size (label, width, height);
+
+  return label;
+}
+
+/* Renders @text like a #ClutterLabel would into a new texture. */
+static ClutterActor *
+label_render (const gchar *text, const gchar *font,
+              const ClutterColor *color, guint max_width,
+              PangoEllipsizeMode ellipsize)
+{
+  ClutterActor *label, *texture;
+  ClutterColor clear;
+  CoglHandle tex, fbo;
+  guint width, height;
+
+  label = label_new (text, font, color, max_width, ellipsize);
+  clutter_actor_get_size (label, &width, &height);
+  tex = cogl_texture_new_with_size (width, height, 0, FALSE,
+                                    COGL_PIXEL_FORMAT_RGBA_8888);
+  fbo = cogl_offscreen_new_to_texture (tex);
+
+  /* Keep the colour of the text everywhere and only accumulate the
+   * coverage in the alpha channel, so the result can be blended like
+   * any other non-premultiplied texture. */
+  clear = *color;
+  clear.alpha = 0;
+  cogl_push_matrix ();
+  tidy_util_cogl_push_offscreen_buffer (fbo);
+  cogl_paint_init (&clear);
+  tidy_util_cogl_push_blend_func_separate (CGL_ONE, CGL_ZERO,
+                                           CGL_ONE, CGL_ONE_MINUS_SRC_ALPHA);
+  clutter_actor_paint (label);
+  tidy_util_cogl_pop_blend_func ();
+  tidy_util_cogl_pop_offscreen_buffer ();
+  cogl_pop_matrix ();
+
+  texture = clutter_texture_new ();
+  clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (texture), tex);
+  clutter_actor_set_name (texture, text);
+
+  cogl_offscreen_unref (fbo);
+  cogl_texture_unref (tex);
+  clutter_actor_destroy (label);
+  return texture;
+}
+
+ClutterActor *
+hd_clutter_cache_get_label (const gchar *text, const gchar *font,
+                            const ClutterColor *color, guint max_width,
+                            PangoEllipsizeMode ellipsize)
+{
+  HdClutterCacheLabel *label;
+  ClutterActor *clone;
+  gchar *key;
+
+  if (!cogl_features_available (COGL_FEATURE_OFFSCREEN))
+    /* We can't render it into a texture, so just paint the text. */
+    return label_new (text, font, color, max_width, ellipsize);
+
+  if (!Labels)
+    {
+      Labels = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                      (GDestroyNotify) label_forget);
+      Label_textures = clutter_group_new ();
+      clutter_actor_set_name (Label_textures, "HdClutterCache::labels");
+      clutter_container_add_actor (CLUTTER_CONTAINER (hd_get_clutter_cache ()),
+                                   Label_textures);
+    }
+
+  key = g_strdup_printf ("%s\n%s\n%02x%02x%02x%02x\n%u\n%d", text, font,
+                         color->red, color->green, color->blue, color->alpha,
+                         max_width, ellipsize);
+  if ((label = g_hash_table_lookup (Labels, key)) != NULL)
+    {
+      g_free (key);
+      if (!label->refs)
+        g_queue_remove (&Unused_labels, label);
+    }
+  else
+    {
+      label = g_slice_new0 (HdClutterCacheLabel);
+      label->key = key;
+      label->current = TRUE;
+      label->texture = label_render (text, font, color, max_width, ellipsize);
+      clutter_container_add_actor (CLUTTER_CONTAINER (Label_textures),
+                                   label->texture);
+      g_hash_table_insert (Labels, label->key, label);
+    }
+
+  label->refs++;
+  clone = clutter_clone_texture_new (CLUTTER_TEXTURE (label->texture));
+  clutter_actor_set_size (clone, clutter_actor_get_width (label->texture),
+                          clutter_actor_get_height (label->texture));
+  clutter_actor_set_name (clone, text);
+  g_object_weak_ref (G_OBJECT (clone), label_clone_gone, label);
+  return clone;
 }
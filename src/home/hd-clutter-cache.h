@@ -90,4 +90,19 @@ hd_clutter_cache_get_sub_texture_for_area(const char *filename,
                                           ClutterGeometry *geo,
                                           ClutterGeometry *area);
 
+/* Returns an actor showing @text in @font and @color, centered, like a
+ * #ClutterLabel of its natural size would, but at most @max_width wide
+ * (if not 0).  If it's wider, it's ellipsized if @ellipsize says so,
+ * otherwise broken into lines anywhere.  The rendered text is shared by
+ * all the actors showing the same thing, and kept for a while after
+ * the last one is destroyed, until the theme changes.  Without
+ * offscreen rendering it's just a #ClutterLabel.
+ * This is created specially and is not owned by the cache. */
+ClutterActor *
+hd_clutter_cache_get_label(const gchar *text,
+                           const gchar *font,
+                           const ClutterColor *color,
+                           guint max_width,
+                           PangoEllipsizeMode ellipsize);
+
 #endif
@@ -21,6 +21,8 @@
 
 #include "hd-home-view-layout.h"
 #include "hd-comp-mgr.h"
+#include "hd-render-manager.h"
+#include "hd-free-space.h"
 
 /* Padding between applets - Just enough to get 5 contacts onto the screen.
  * See bug 137601
@@ -28,26 +30,23 @@
 #define PADDING 13
 #define MIN_SIZE (2 * PADDING + 1)
 
-typedef struct rect_t rect_t;
 typedef struct layer_t layer_t;
 
-struct rect_t
-{
-  int x1;
-  int y1;
-  int x2;
-  int y2;
-};
-
+/* When there is no room left for an applet it's put on top of the others,
+ * on a new layer, which is then filled the same way. */
 struct layer_t
 {
   layer_t *child;
-  GList *rectangles;
+  HdFreeSpace *space;
 };
 
 struct _HdHomeViewLayoutPrivate
 {
   layer_t *layer;
+
+  /* The size of the area @layer was made for. */
+  gint width;
+  gint height;
 };
 
 G_DEFINE_TYPE_WITH_CODE (HdHomeViewLayout,
@@ -55,146 +54,24 @@ G_DEFINE_TYPE_WITH_CODE (HdHomeViewLayout,
                          G_TYPE_OBJECT,
                          G_ADD_PRIVATE (HdHomeViewLayout));
 
-static rect_t *
-rect_new (int x1, int y1,
-          int x2, int y2)
-{
-  rect_t *r = g_slice_new (rect_t);
-
-  r->x1 = x1;
-  r->y1 = y1;
-  r->x2 = x2;
-  r->y2 = y2;
-
-  return r;
-}
-
-static void
-rect_free (rect_t *r)
-{
-  if (r)
-    g_slice_free (rect_t, r);
-}
-
-static gint
-rect_cmp (gconstpointer a,
-          gconstpointer b)
-{
-  const rect_t *r1, *r2;
-
-  r1 = a;
-  r2 = b;
-
-  return r1->y1 != r2->y1 ? r1->y1 - r2->y1 : r1->x1 - r2->x1;
-}
-
-static gboolean
-rect_subtract (rect_t *r1, rect_t *r2, GList **l)
-{
-  if (r1->x1 < r2->x2 &&
-      r2->x1 < r1->x2 &&
-      r1->y1 < r2->y2 &&
-      r2->y1 < r1->y2)
-    {
-      /* intersect */
-
-      /* new north rectangle */
-      if ((r2->y1 - r1->y1) >= MIN_SIZE)
-        *l = g_list_insert_sorted (*l,
-                                   rect_new (r1->x1, r1->y1,
-                                             r1->x2, r2->y1),
-                                   rect_cmp);
-      /* new south rectangle */
-      if ((r1->y2 - r2->y2) >= MIN_SIZE)
-        *l = g_list_insert_sorted (*l,
-                                   rect_new (r1->x1, r2->y2,
-                                             r1->x2, r1->y2),
-                                   rect_cmp);
-      /* new west rectangle */
-      if ((r2->x1 - r1->x1) >= MIN_SIZE)
-        *l = g_list_insert_sorted (*l,
-                                   rect_new (r1->x1, r1->y1,
-                                             r2->x1, r1->y2),
-                                   rect_cmp);
-      /* new east rectangle */
-      if ((r1->x2 - r2->x2) >= MIN_SIZE)
-        *l = g_list_insert_sorted (*l,
-                                   rect_new (r2->x2, r1->y1,
-                                             r1->x2, r1->y2),
-                                   rect_cmp);
-
-      return TRUE;
-    }
-
-  /* no intersection */
-  return FALSE;
-}
-
-static GList *
-list_subtract (GList *list, rect_t *r)
-{
-  GList *new_list = NULL;
-
-  while (list)
-    {
-      rect_t *old = list->data;
-
-      list = g_list_delete_link (list, list);
-
-      if (rect_subtract (old, r, &new_list))
-        rect_free (old);
-      else
-        new_list = g_list_insert_sorted (new_list,
-                                         old,
-                                         rect_cmp);
-    }
-
-  return new_list;
-}
-
-static rect_t *
-list_find (GList *list, rect_t *r)
-{
-  GList *l;
-
-  for (l = list; l; l = l->next)
-    {
-      rect_t *d = l->data;
-
-      if ((d->x2 - d->x1) >= (r->x2 - r->x1) &&
-          (d->y2 - d->y1) >= (r->y2 - r->y1))
-        return d;
-    }
-
-  return NULL;
-}
-
 static layer_t *
-layer_new (GSList *applets)
+layer_new (GSList *applets, gint width, gint height)
 {
   layer_t *layer = g_slice_new0 (layer_t);
   GSList *a;
 
-  layer->rectangles = g_list_prepend (NULL, rect_new (0,
-                                                      HD_COMP_MGR_TOP_MARGIN,
-                                                      HD_COMP_MGR_LANDSCAPE_WIDTH,
-                                                      HD_COMP_MGR_LANDSCAPE_HEIGHT));
+  layer->space = hd_free_space_new (0, HD_COMP_MGR_TOP_MARGIN,
+                                    width, height - HD_COMP_MGR_TOP_MARGIN,
+                                    MIN_SIZE);
 
   for (a = applets; a; a = a->next)
     {
       gint x, y;
-      guint width, height;
-      rect_t r;
+      guint w, h;
 
       clutter_actor_get_position (CLUTTER_ACTOR (a->data), &x, &y);
-      clutter_actor_get_size (CLUTTER_ACTOR (a->data), &width, &height);
-
-      r.x1 = x;
-      r.y1 = y;
-      r.x2 = r.x1 + width;
-      r.y2 = r.y1 + height;
-
-      layer->rectangles = list_subtract (layer->rectangles, &r);
+      clutter_actor_get_size (CLUTTER_ACTOR (a->data), &w, &h);
+      hd_free_space_occupy (layer->space, x, y, w, h);
     }
 
   return layer;
@@ -208,8 +85,7 @@ layer_free (layer_t *layer)
 
   layer_free (layer->child);
 
-  g_list_foreach (layer->rectangles, (GFunc) rect_free, NULL);
-  g_list_free (layer->rectangles);
+  hd_free_space_free (layer->space);
   g_slice_free (layer_t, layer);
 }
 
@@ -253,6 +129,22 @@ hd_home_view_layout_reset (HdHomeViewLayout *layout)
     priv->layer = (layer_free (priv->layer), NULL);
 }
 
+/* The size of the area applets can be put in the current orientation. */
+static void
+get_area (gint *area_width, gint *area_height)
+{
+  if (STATE_IS_PORTRAIT (hd_render_manager_get_state ()))
+    {
+      *area_width = HD_COMP_MGR_PORTRAIT_WIDTH;
+      *area_height = HD_COMP_MGR_PORTRAIT_HEIGHT;
+    }
+  else
+    {
+      *area_width = HD_COMP_MGR_LANDSCAPE_WIDTH;
+      *area_height = HD_COMP_MGR_LANDSCAPE_HEIGHT;
+    }
+}
+
 void
 hd_home_view_layout_arrange_applet (HdHomeViewLayout *layout,
                                     GSList           *applets,
@@ -260,63 +152,104 @@ hd_home_view_layout_arrange_applet (HdHomeViewLayout *layout,
 {
   HdHomeViewLayoutPrivate *priv = layout->priv;
   guint width, height;
-  rect_t r;
-  layer_t *l;
+  gint x, y, area_width, area_height;
+  layer_t *l, *k;
 
-  if (!priv->layer)
-    priv->layer = layer_new (applets);
+  get_area (&area_width, &area_height);
 
-  clutter_actor_get_size (new_applet, &width, &height);
-
-  r.x1 = 0;
-  r.y1 = 0;
-  r.x2 = width + 2 * PADDING;
-  r.y2 = height + 2 * PADDING;
+  /* Start over if the screen was rotated meanwhile. */
+  if (priv->layer
+      && (priv->width != area_width || priv->height != area_height))
+    priv->layer = (layer_free (priv->layer), NULL);
 
-  for (l = priv->layer; l; l = l->child)
+  if (!priv->layer)
     {
-      rect_t *f = list_find (l->rectangles, &r);
-
-      if (f)
-        {
-          layer_t *k;
+      priv->layer = layer_new (applets, area_width, area_height);
+      priv->width = area_width;
+      priv->height = area_height;
+    }
 
-          clutter_actor_set_position (new_applet, f->x1 + PADDING, f->y1 + PADDING);
+  clutter_actor_get_size (new_applet, &width, &height);
 
-          r.x1 = f->x1 + PADDING;
-          r.y1 = f->y1 + PADDING;
-          r.x2 = r.x1 + width;
-          r.y2 = r.y1 + height;
+  for (l = priv->layer; l; l = l->child)
+    if (hd_free_space_find (l->space, HD_FREE_SPACE_TOP_LEFT,
+                            width + 2 * PADDING, height + 2 * PADDING,
+                            &x, &y))
+      break;
 
-          for (k = priv->layer; k; k = k->child)
-            {
-              k->rectangles = list_subtract (k->rectangles,
-                                             &r);
+  if (l)
+    {
+      x += PADDING;
+      y += PADDING;
+    }
+  else
+    {
+      /* No room anywhere, start a new layer. */
+      x = PADDING;
+      y = HD_COMP_MGR_TOP_MARGIN + PADDING;
+    }
 
-              if (k == l)
-                return;
-            }
+  clutter_actor_set_position (new_applet, x, y);
 
-          return;
+  /* It's in the way on all the layers below. */
+  for (k = priv->layer; ; k = k->child)
+    {
+      hd_free_space_occupy (k->space, x, y, width, height);
+      if (k == l)
+        break;
+      if (!k->child && !l)
+        {
+          k->child = layer_new (NULL, area_width, area_height);
+          hd_free_space_occupy (k->child->space, x, y, width, height);
+          break;
         }
     }
+}
 
-  clutter_actor_set_position (new_applet, PADDING, HD_COMP_MGR_TOP_MARGIN + PADDING);
-
-  r.x1 = PADDING;
-  r.y1 = HD_COMP_MGR_TOP_MARGIN + PADDING;
-  r.x2 = r.x1 + width;
-  r.y2 = r.y1 + height;
+/* Called when @applet has been dropped in edit mode.  If it covers any
+ * of the other @applets, it's moved to the free spot closest to where
+ * it was dropped; if there's no such spot it's left where it is. */
+void
+hd_home_view_layout_drop_applet (HdHomeViewLayout *layout,
+                                 GSList           *applets,
+                                 ClutterActor     *applet)
+{
+  HdFreeSpace *space;
+  gint x, y, new_x, new_y, area_width, area_height;
+  guint width, height;
+  GSList *a;
 
-  for (l = priv->layer; l; l = l->child)
+  get_area (&area_width, &area_height);
+  space = hd_free_space_new (0, HD_COMP_MGR_TOP_MARGIN,
+                             area_width,
+                             area_height - HD_COMP_MGR_TOP_MARGIN,
+                             MIN_SIZE);
+  for (a = applets; a; a = a->next)
     {
-      l->rectangles = list_subtract (l->rectangles, &r);
+      gint ax, ay;
+      guint aw, ah;
+
+      if (a->data == applet)
+        continue;
+      clutter_actor_get_position (CLUTTER_ACTOR (a->data), &ax, &ay);
+      clutter_actor_get_size (CLUTTER_ACTOR (a->data), &aw, &ah);
+      hd_free_space_occupy (space, ax, ay, aw, ah);
+    }
 
-      if (!l->child)
-        {
-          l->child = layer_new (NULL);
-          l->child->rectangles = list_subtract (l->child->rectangles, &r);
-          return;
-        }
+  clutter_actor_get_position (applet, &x, &y);
+  clutter_actor_get_size (applet, &width, &height);
+
+  /* Where it is now is fine if nothing's there. */
+  if (!hd_free_space_find_near (space, width, height, x, y, &new_x, &new_y)
+      || new_x != x || new_y != y)
+    {
+      if (hd_free_space_find_near (space,
+                                   width + 2 * PADDING, height + 2 * PADDING,
+                                   x - PADDING, y - PADDING,
+                                   &new_x, &new_y))
+        clutter_actor_set_position (applet,
+                                    new_x + PADDING, new_y + PADDING);
     }
+
+  hd_free_space_free (space);
 }
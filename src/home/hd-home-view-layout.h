@@ -57,6 +57,9 @@ void              hd_home_view_layout_reset          (HdHomeViewLayout *layout);
 void              hd_home_view_layout_arrange_applet (HdHomeViewLayout *layout,
                                                       GSList           *applets,
                                                       ClutterActor     *new_applet);
+void              hd_home_view_layout_drop_applet    (HdHomeViewLayout *layout,
+                                                      GSList           *applets,
+                                                      ClutterActor     *applet);
 
 G_END_DECLS
 
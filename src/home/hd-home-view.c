@@ -35,9 +35,11 @@
 #include "hd-render-manager.h"
 #include "hd-clutter-cache.h"
 #include "hd-transition.h"
+#include "hd-recorder.h"
 
 #include "hildon-desktop.h"
 #include "../tidy/tidy-sub-texture.h"
+#include "../tidy/tidy-cached-group.h"
 
 #include <clutter/clutter.h>
 #include <clutter/x11/clutter-x11.h>
@@ -66,6 +68,9 @@
 
 #define HD_HOME_VIEW_PARALLAX_AMOUNT (hd_transition_get_double("home", "parallax", 1.3))
 
+/* How long applets have to be left alone before they are cached (ms) */
+#define HD_HOME_VIEW_APPLET_CACHE_IDLE (hd_transition_get_int("home", "applet_cache_idle", 2000))
+
 enum
 {
   PROP_COMP_MGR = 1,
@@ -100,6 +105,14 @@ struct _HdHomeViewPrivate
   gint                      applet_motion_start_position_x;
   gint                      applet_motion_start_position_y;
 
+  /* The last motion of the dragged applet not handled yet. */
+  ClutterActor             *applet_motion;
+  guint                     applet_motion_idle;
+  gint                      applet_motion_x;
+  gint                      applet_motion_y;
+  guint                     applet_motion_events;
+  gint64                    applet_motion_received;
+
   gboolean                  applet_motion_tap : 1;
 
   gboolean                  move_applet_left : 1;
@@ -148,6 +161,7 @@ hd_home_view_allocation_changed (HdHomeView    *home_view,
                                  gpointer    user_data);
 
 static void snap_widget_to_grid (ClutterActor *widget);
+static void hd_home_view_update_applet_cache (HdHomeView *view);
 
 typedef struct _HdHomeViewAppletData HdHomeViewAppletData;
 
@@ -249,12 +263,70 @@ hd_home_view_class_init (HdHomeViewClass *klass)
                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 }
 
+/* Nothing is drawn of the applets of views which are off the screen, so
+ * don't make the X server report their damage or update their textures
+ * then.  When the view comes back, whatever they drew meanwhile is
+ * taken at once. */
+static void
+hd_home_view_track_applet_damage (HdHomeViewAppletData *data, gboolean track)
+{
+  ClutterActor *child;
+  gint i;
+
+  if (!data->cc || mb_wm_comp_mgr_clutter_client_is_unredirected (data->cc))
+    return;
+
+  mb_wm_comp_mgr_clutter_client_track_damage (
+                          MB_WM_COMP_MGR_CLUTTER_CLIENT (data->cc), track);
+  if (!track || !CLUTTER_IS_GROUP (data->actor))
+    return;
+
+  for (i = 0, child = clutter_group_get_nth_child (CLUTTER_GROUP (data->actor), 0);
+       child;
+       child = clutter_group_get_nth_child (CLUTTER_GROUP (data->actor), ++i))
+    if (CLUTTER_X11_IS_TEXTURE_PIXMAP (child))
+      {
+        guint w, h;
+
+        g_object_get (child, "pixmap-width", &w, "pixmap-height", &h, NULL);
+        clutter_x11_texture_pixmap_update_area (
+                          CLUTTER_X11_TEXTURE_PIXMAP (child), 0, 0, w, h);
+      }
+}
+
+static void
+hd_home_view_track_applets_damage (HdHomeView *view, gboolean track)
+{
+  HdHomeViewPrivate *priv = view->priv;
+  GHashTableIter iter;
+  gpointer value;
+
+  if (!priv->applets)
+    return;
+
+  g_hash_table_iter_init (&iter, priv->applets);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    hd_home_view_track_applet_damage (value, track);
+}
+
+/* Tracks the damage of the applets of @view if it is showing, and stops
+ * tracking it otherwise.  For when the damage of every client has been
+ * turned on or off behind our back. */
+void
+hd_home_view_update_applets_damage (HdHomeView *view)
+{
+  g_return_if_fail (HD_IS_HOME_VIEW (view));
+
+  hd_home_view_track_applets_damage (view, CLUTTER_ACTOR_IS_VISIBLE (view));
+}
+
 /* applets_container is not a member of HdHomeView (it is in HdHome's 'front'
  * container. Hence we want to show/hide the applets container whenever the
  * home view itself is hidden */
 static gboolean hd_home_view_shown(HdHomeView *view) {
   HdHomeViewPrivate        *priv = view->priv;
   clutter_actor_show(priv->applets_container);
+  hd_home_view_track_applets_damage(view, TRUE);
   return FALSE;
 }
 /* applets_container is not a member of HdHomeView (it is in HdHome's 'front'
@@ -263,6 +335,7 @@ static gboolean hd_home_view_shown(HdHomeView *view) {
 static gboolean hd_home_view_hidden(HdHomeView *view) {
   HdHomeViewPrivate        *priv = view->priv;
   clutter_actor_hide(priv->applets_container);
+  hd_home_view_track_applets_damage(view, FALSE);
   return FALSE;
 }
 
@@ -378,7 +451,12 @@ hd_home_view_constructed (GObject *object)
                            priv->background_container);
   clutter_container_add_actor (CLUTTER_CONTAINER (object), priv->background_container);
 
-  priv->applets_container = clutter_group_new ();
+  /* Applets rarely change, so draw them from a single texture when
+   * they've been idle for a while. */
+  priv->applets_container = tidy_cached_group_new ();
+  tidy_cached_group_set_use_alpha (priv->applets_container, TRUE);
+  tidy_cached_group_set_downsampling_factor (priv->applets_container, 1);
+  hd_home_view_update_applet_cache (self);
   clutter_actor_set_name (priv->applets_container, "HdHomeView::applets-container");
   clutter_actor_set_visibility_detect(priv->applets_container, FALSE);
   clutter_actor_set_position (priv->applets_container, 0, 0);
@@ -440,6 +518,9 @@ hd_home_view_dispose (GObject *object)
   if (priv->load_background_source)
     priv->load_background_source = (g_source_remove (priv->load_background_source), 0);
 
+  if (priv->applet_motion_idle)
+    priv->applet_motion_idle = (g_source_remove (priv->applet_motion_idle), 0);
+
   if (priv->gconf_client)
     priv->gconf_client = (g_object_unref (priv->gconf_client), NULL);
 
@@ -890,6 +971,7 @@ hd_home_view_applet_resize (ClutterActor *applet,
 
   if (!(data = g_hash_table_lookup (view->priv->applets, applet)))
     return;
+  tidy_cached_group_changed (view->priv->applets_container);
   clutter_actor_set_position (data->close_button,
                          clutter_actor_get_width (applet)
                          - clutter_actor_get_width (data->close_button),
@@ -900,10 +982,11 @@ hd_home_view_applet_resize (ClutterActor *applet,
                        - clutter_actor_get_height (data->close_button));
 }
 
-static gboolean
-hd_home_view_applet_motion (ClutterActor       *applet,
-			    ClutterMotionEvent *event,
-			    HdHomeView         *view)
+static void
+hd_home_view_do_applet_motion (HdHomeView   *view,
+                               ClutterActor *applet,
+                               gint          event_x,
+                               gint          event_y)
 {
   HdHomeViewPrivate *priv = view->priv;
   gint x, y;
@@ -912,18 +995,19 @@ hd_home_view_applet_motion (ClutterActor       *applet,
   /* Check if it is still a tap or already a move */
   if (priv->applet_motion_tap)
     {
-      if (ABS (priv->applet_motion_start_x - event->x) > MAX_TAP_DISTANCE ||
-          ABS (priv->applet_motion_start_y - event->y) > MAX_TAP_DISTANCE)
+      if (ABS (priv->applet_motion_start_x - event_x) > MAX_TAP_DISTANCE ||
+          ABS (priv->applet_motion_start_y - event_y) > MAX_TAP_DISTANCE)
         priv->applet_motion_tap = FALSE;
       else
-        return FALSE;
+        return;
     }
 
   hd_home_show_edge_indication (priv->home);
+  tidy_cached_group_changed (priv->applets_container);
 
   /* New position of applet actor based on movement */
-  x = priv->applet_motion_start_position_x + event->x - priv->applet_motion_start_x;
-  y = priv->applet_motion_start_position_y + event->y - priv->applet_motion_start_y;
+  x = priv->applet_motion_start_position_x + event_x - priv->applet_motion_start_x;
+  y = priv->applet_motion_start_position_y + event_y - priv->applet_motion_start_y;
 
   /* Get size of home view and applet actor */
   clutter_actor_get_size (applet, &w, &h);
@@ -960,7 +1044,7 @@ hd_home_view_applet_motion (ClutterActor       *applet,
   /* Check if this is the only active Home view */
   if (!hd_home_view_container_get_previous_view (HD_HOME_VIEW_CONTAINER (priv->view_container)) ||
       !hd_home_view_container_get_next_view (HD_HOME_VIEW_CONTAINER (priv->view_container)))
-    return FALSE;
+    return;
 
   /*
    * If the "drag cursor" entered the left/right indication area, highlight the indication.
@@ -970,30 +1054,84 @@ hd_home_view_applet_motion (ClutterActor       *applet,
 
 	if(!STATE_IS_PORTRAIT (hd_render_manager_get_state()))
 	{
-    if (event->x < HD_EDGE_INDICATION_WIDTH)
+    if (event_x < HD_EDGE_INDICATION_WIDTH)
     	priv->move_applet_left = TRUE;
-   	else if (event->x > HD_COMP_MGR_LANDSCAPE_WIDTH - HD_EDGE_INDICATION_WIDTH)
+   	else if (event_x > HD_COMP_MGR_LANDSCAPE_WIDTH - HD_EDGE_INDICATION_WIDTH)
     	priv->move_applet_right = TRUE;
 	}
 	else
 	{
     if(hd_home_get_vertical_scrolling (priv->home))
       {
-    	  if (event->y < HD_EDGE_INDICATION_WIDTH + HD_COMP_MGR_TOP_MARGIN)
+    	  if (event_y < HD_EDGE_INDICATION_WIDTH + HD_COMP_MGR_TOP_MARGIN)
     	    priv->move_applet_left = TRUE;
-    	  else if (event->y > HD_COMP_MGR_PORTRAIT_HEIGHT - HD_EDGE_INDICATION_WIDTH)
+    	  else if (event_y > HD_COMP_MGR_PORTRAIT_HEIGHT - HD_EDGE_INDICATION_WIDTH)
     	    priv->move_applet_right = TRUE;
       }
     else
       {
-    	  if (event->x < HD_EDGE_INDICATION_WIDTH)
+    	  if (event_x < HD_EDGE_INDICATION_WIDTH)
     	    priv->move_applet_left = TRUE;
-    	  else if (event->x > HD_COMP_MGR_PORTRAIT_WIDTH - HD_EDGE_INDICATION_WIDTH)
+    	  else if (event_x > HD_COMP_MGR_PORTRAIT_WIDTH - HD_EDGE_INDICATION_WIDTH)
     	    priv->move_applet_right = TRUE;
       }
 	}
 
   hd_home_highlight_edge_indication (priv->home, priv->move_applet_left, priv->move_applet_right);
+}
+
+static gboolean
+hd_home_view_applet_motion_idle (gpointer data)
+{
+  HdHomeView *view = data;
+  HdHomeViewPrivate *priv = view->priv;
+
+  priv->applet_motion_idle = 0;
+  hd_recorder_input_handled (priv->applet_motion_received,
+                             priv->applet_motion_events);
+  priv->applet_motion_events = 0;
+
+  /* Unless it's been removed meanwhile. */
+  if (g_hash_table_lookup (priv->applets, priv->applet_motion))
+    hd_home_view_do_applet_motion (view, priv->applet_motion,
+                                   priv->applet_motion_x,
+                                   priv->applet_motion_y);
+
+  return FALSE;
+}
+
+/* Handles the pending motion of the dragged applet now, if any. */
+static void
+hd_home_view_flush_applet_motion (HdHomeView *view)
+{
+  HdHomeViewPrivate *priv = view->priv;
+
+  if (priv->applet_motion_idle)
+    {
+      g_source_remove (priv->applet_motion_idle);
+      hd_home_view_applet_motion_idle (view);
+    }
+}
+
+/* The applet follows the pointer, so only the last motion before a frame
+ * needs to be handled. */
+static gboolean
+hd_home_view_applet_motion (ClutterActor       *applet,
+			    ClutterMotionEvent *event,
+			    HdHomeView         *view)
+{
+  HdHomeViewPrivate *priv = view->priv;
+
+  priv->applet_motion = applet;
+  priv->applet_motion_x = event->x;
+  priv->applet_motion_y = event->y;
+  if (!priv->applet_motion_events++)
+    priv->applet_motion_received = g_get_monotonic_time ();
+
+  if (!priv->applet_motion_idle)
+    priv->applet_motion_idle = g_idle_add_full (CLUTTER_PRIORITY_REDRAW - 2,
+                                           hd_home_view_applet_motion_idle,
+                                           view, NULL);
 
   return FALSE;
 }
@@ -1068,6 +1206,9 @@ hd_home_view_applet_press (ClutterActor       *applet,
                               &priv->applet_motion_start_position_y);
 
   priv->applet_motion_tap = TRUE;
+  if (priv->applet_motion_idle)
+    priv->applet_motion_idle = (g_source_remove (priv->applet_motion_idle), 0);
+  priv->applet_motion_events = 0;
 
   priv->move_applet_left = FALSE;
   priv->move_applet_right = FALSE;
@@ -1112,6 +1253,24 @@ snap_widget_to_grid (ClutterActor *widget)
   clutter_actor_set_position (widget, c_geom.x, c_geom.y);
 }
 
+/* Returns the actors of all applets of @view; free the list. */
+static GSList *
+hd_home_view_get_applet_actors (HdHomeView *view)
+{
+  GSList *applets = NULL;
+  GHashTableIter iter;
+  gpointer tmp;
+
+  g_hash_table_iter_init (&iter, view->priv->applets);
+  while (g_hash_table_iter_next (&iter, NULL, &tmp))
+    {
+      HdHomeViewAppletData *value = tmp;
+      applets = g_slist_prepend (applets, value->actor);
+    }
+
+  return applets;
+}
+
 static void
 hd_home_view_store_applet_position (HdHomeView   *view,
                                     ClutterActor *applet,
@@ -1232,6 +1391,7 @@ hd_home_view_applet_release (ClutterActor       *applet,
       g_signal_handler_disconnect (applet, data->motion_cb);
       data->motion_cb = 0;
     }
+  hd_home_view_flush_applet_motion (view);
 
   /*
    * If this was a simple press/release, with no intervening pointer motion,
@@ -1268,6 +1428,12 @@ hd_home_view_applet_release (ClutterActor       *applet,
         }
       else
         {
+          GSList *applets = hd_home_view_get_applet_actors (view);
+
+          /* Don't let it cover the others if there's room elsewhere. */
+          hd_home_view_layout_drop_applet (priv->layout, applets, applet);
+          g_slist_free (applets);
+
           /*
            * Applet should be moved in this view
            * Move the underlying window to match the actor's position
@@ -1378,17 +1544,7 @@ hd_home_view_load_applet_position (HdHomeView           *view,
     }
   else
     {
-      GSList *applets = NULL;
-      GHashTableIter iter;
-      gpointer tmp;
-
-      /* Get a list of all applets */
-      g_hash_table_iter_init (&iter, priv->applets);
-      while (g_hash_table_iter_next (&iter, NULL, &tmp))
-        {
-          HdHomeViewAppletData *value = tmp;
-          applets = g_slist_prepend (applets, value->actor);
-        }
+      GSList *applets = hd_home_view_get_applet_actors (view);
 
       hd_home_view_layout_arrange_applet (priv->layout,
                                           applets,
@@ -1562,6 +1718,10 @@ hd_home_view_add_applet (HdHomeView   *view,
                                       old_y);
   hd_home_view_applet_resize (applet, NULL, view);
 
+  /* It may be coming from a view which was showing. */
+  hd_home_view_track_applet_damage (data,
+                                    CLUTTER_ACTOR_IS_VISIBLE (view));
+
   desktop = hd_comp_mgr_get_desktop_client (HD_COMP_MGR (priv->comp_mgr));
   if (desktop)
     { /* Synchronize here, we may not come from clutter_x11_event_filter()
@@ -1731,6 +1891,8 @@ hd_home_view_update_state (HdHomeView *view)
 
   priv = view->priv;
 
+  hd_home_view_update_applet_cache (view);
+
   /* Iterate over all applets */
   g_hash_table_iter_init (&iter, priv->applets);
   while (g_hash_table_iter_next (&iter, NULL, &value))
@@ -1754,6 +1916,19 @@ hd_home_view_update_state (HdHomeView *view)
     }
 }
 
+/* Applets are cached when they are idle, but not in edit mode, where
+ * they are moved around and have buttons. */
+static void
+hd_home_view_update_applet_cache (HdHomeView *view)
+{
+  HdHomeViewPrivate *priv = view->priv;
+  gint idle;
+
+  idle = STATE_IN_EDIT_MODE (hd_render_manager_get_state ())
+    ? 0 : HD_HOME_VIEW_APPLET_CACHE_IDLE;
+  tidy_cached_group_set_auto_cache (priv->applets_container, MAX (idle, 0));
+}
+
 static HdHomeViewAppletData *
 applet_data_new (ClutterActor *actor)
 {
@@ -88,6 +88,7 @@ void hd_home_view_set_live_bg (HdHomeView *view,
                                gboolean above_applets);
 void hd_home_view_load_background (HdHomeView *view);
 void hd_home_view_update_state (HdHomeView *view);
+void hd_home_view_update_applets_damage (HdHomeView *view);
 
 void hd_home_view_change_applets_position (HdHomeView *view);
 void hd_home_view_change_wallpaper(HdHomeView *view);
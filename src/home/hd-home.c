@@ -42,6 +42,8 @@
 #include "hd-launcher-app.h"
 #include "hd-dbus.h"
 #include "hd-title-bar.h"
+#include "hd-profiler.h"
+#include "hd-recorder.h"
 
 #include <clutter/clutter.h>
 #include <clutter/x11/clutter-x11.h>
@@ -167,6 +169,13 @@ struct _HdHomePrivate
   /* List of HdHomeDrag - history of mouse events used to work out an
    * average velocity */
 
+  /* Motion waiting to be handled, see hd_home_desktop_queue_motion() */
+  guint                  motion_idle;
+  gint                   motion_x;
+  gint                   motion_y;
+  guint                  motion_events;
+  gint64                 motion_received;
+
   gboolean               moved_over_threshold : 1;
   gboolean               long_press : 1;
   guint                  press_timeout;
@@ -497,6 +506,54 @@ hd_home_desktop_do_motion (HdHome *home,
     }
 }
 
+static gboolean
+hd_home_desktop_motion_idle (gpointer data)
+{
+  HdHome *home = data;
+  HdHomePrivate *priv = home->priv;
+
+  priv->motion_idle = 0;
+  hd_recorder_input_handled (priv->motion_received, priv->motion_events);
+  priv->motion_events = 0;
+  hd_home_desktop_do_motion (home, priv->motion_x, priv->motion_y);
+
+  return FALSE;
+}
+
+/* Motion events come much faster than we can repaint, so only the last
+ * one before a frame is handled.  hd_home_desktop_do_motion() works with
+ * the distance and time since the previous one, so the panning speed is
+ * the same. */
+static void
+hd_home_desktop_queue_motion (HdHome *home, int x, int y)
+{
+  HdHomePrivate *priv = home->priv;
+
+  priv->motion_x = x;
+  priv->motion_y = y;
+  if (!priv->motion_events++)
+    priv->motion_received = g_get_monotonic_time ();
+
+  /* Before hd-damage hands the damage to the stage. */
+  if (!priv->motion_idle)
+    priv->motion_idle = g_idle_add_full (CLUTTER_PRIORITY_REDRAW - 2,
+                                         hd_home_desktop_motion_idle,
+                                         home, NULL);
+}
+
+/* Handles the pending motion now, if there is any. */
+static void
+hd_home_desktop_flush_motion (HdHome *home)
+{
+  HdHomePrivate *priv = home->priv;
+
+  if (priv->motion_idle)
+    {
+      g_source_remove (priv->motion_idle);
+      hd_home_desktop_motion_idle (home);
+    }
+}
+
 static void
 hd_home_desktop_motion (XButtonEvent *xev, void *userdata)
 {
@@ -504,7 +561,7 @@ hd_home_desktop_motion (XButtonEvent *xev, void *userdata)
 
   g_debug ("%s. (x, y) = (%d, %d)", __FUNCTION__, xev->x, xev->y);
 
-  hd_home_desktop_do_motion (home, xev->x, xev->y);
+  hd_home_desktop_queue_motion (home, xev->x, xev->y);
 }
 
 static void
@@ -629,6 +686,11 @@ hd_home_desktop_do_press (HdHome *home,
       priv->desktop_motion_cb = 0;
     }
 
+  /* Whatever motion is left over belongs to the previous drag. */
+  if (priv->motion_idle)
+    priv->motion_idle = (g_source_remove (priv->motion_idle), 0);
+  priv->motion_events = 0;
+
   /* if the press landed outside all focus-wanting applets, set focus to the
    * desktop window, unfocusing any applet */
   applets = hd_home_view_get_all_applets (
@@ -709,7 +771,8 @@ hd_home_desktop_release (XButtonEvent *xev, void *userdata)
 
   g_debug ("%s. (x, y) = (%d, %d)", __FUNCTION__, xev->x, xev->y);
 
-  hd_home_desktop_do_motion (home, xev->x, xev->y);
+  hd_home_desktop_queue_motion (home, xev->x, xev->y);
+  hd_home_desktop_flush_motion (home);
   hd_home_desktop_do_release (home);
 
   live_bg = hd_home_view_container_get_live_bg (
@@ -1660,6 +1723,9 @@ hd_home_dispose (GObject *object)
   if (priv->press_timeout)
     priv->press_timeout = (g_source_remove (priv->press_timeout), 0);
 
+  if (priv->motion_idle)
+    priv->motion_idle = (g_source_remove (priv->motion_idle), 0);
+
   G_OBJECT_CLASS (hd_home_parent_class)->dispose (object);
 }
 
@@ -2190,6 +2256,7 @@ hd_home_applet_release (ClutterActor       *applet,
   g_debug ("%s. (x, y) = (%d, %d)", __FUNCTION__, event->x, event->y);
 
   do_home_applet_motion (home, applet, event->x, event->y);
+  hd_home_desktop_flush_motion (home);
   do_applet_release (home, applet, event);
 
   return TRUE;
@@ -2211,7 +2278,7 @@ do_home_applet_motion (HdHome       *home,
   if (STATE_IN_EDIT_MODE (hd_render_manager_get_state ()))
     return FALSE;
 
-  hd_home_desktop_do_motion (home, x, y);
+  hd_home_desktop_queue_motion (home, x, y);
 
   /*
    * If the pointer was moved over the threshold the initial_x and initial_y is
@@ -2767,6 +2834,19 @@ hd_home_update_applets_position (HdHome *home)
     }
 }
 
+void
+hd_home_update_applets_damage (HdHome *home)
+{
+  HdHomePrivate *priv = home->priv;
+  int i;
+
+  for (i = 0; i < MAX_VIEWS; i++)
+    {
+      ClutterActor *view = hd_home_view_container_get_view (HD_HOME_VIEW_CONTAINER (priv->view_container), i);
+      hd_home_view_update_applets_damage (HD_HOME_VIEW (view));
+    }
+}
+
 void
 hd_home_update_wallpaper(HdHome *home)
 {
@@ -2817,3 +2897,8 @@ hd_home_is_desktop_in_portrait_mode (void)
 	return STATE_IS_PORTRAIT (hd_render_manager_get_state ());
 }
 
+gchar *
+hd_home_get_frame_stats (HdHome *home)
+{
+  return hd_profiler_get_report ();
+}
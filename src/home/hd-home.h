@@ -104,6 +104,7 @@ void hd_home_unregister_applet (HdHome       *home,
 void hd_home_set_live_background (HdHome *home, MBWindowManagerClient *client);
 
 void hd_home_update_applets_position (HdHome *home);
+void hd_home_update_applets_damage (HdHome *home);
 
 gboolean hd_home_is_portrait_capable (void);
 void hd_home_update_wallpaper (HdHome *home);
@@ -113,6 +114,9 @@ gboolean hd_home_is_portrait_wallpaper_enabled (HdHome *home);
 
 gboolean hd_home_is_desktop_in_portrait_mode (void);
 
+/* Paint profiler report, empty unless built with --enable-profiler. */
+gchar *hd_home_get_frame_stats (HdHome *home);
+
 extern gboolean in_alt_tab;
 
 G_END_DECLS
@@ -46,6 +46,7 @@
 #include "hd-app.h"
 #include "hd-dialog.h"
 #include "hd-app-menu.h"
+#include "hd-recorder.h"
 
 #include <matchbox/core/mb-wm.h>
 #include <matchbox/theme-engines/mb-wm-theme.h>
@@ -1335,6 +1336,62 @@ ClutterActor *hd_render_manager_get_title_bar(void)
   return CLUTTER_ACTOR(render_manager->priv->title_bar);
 }
 
+/* The orientation hd_render_manager_prepare_orientation() is preparing. */
+static guint Prepare_orientation_id;
+static gboolean Prepare_portrait;
+
+static gboolean
+hd_render_manager_prepare_orientation_idle(gpointer unused)
+{
+  HdRenderManagerPrivate *priv = render_manager->priv;
+
+  Prepare_orientation_id = 0;
+  if (!Prepare_portrait == !hd_comp_mgr_is_portrait())
+    {
+      /* Changed our mind or the screen has already rotated. */
+      hd_launcher_cancel_orientation();
+      return FALSE;
+    }
+
+  hd_launcher_prepare_orientation(Prepare_portrait);
+  hd_task_navigator_prepare_orientation(Prepare_portrait);
+  hd_title_bar_prepare_orientation(priv->title_bar);
+  return FALSE;
+}
+
+/*
+ * We're likely to rotate to @portrait soon.  Let everyone who needs to
+ * relayout or load something for that do what they can in advance, so
+ * that the screen is blank only while the root window is reconfigured.
+ * It's done in an idle, so it can be called from anywhere.
+ */
+void hd_render_manager_prepare_orientation(gboolean portrait)
+{
+  if (!render_manager)
+    return;
+
+  Prepare_portrait = portrait;
+  if (!Prepare_orientation_id)
+    Prepare_orientation_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+                               hd_render_manager_prepare_orientation_idle,
+                               NULL, NULL);
+}
+
+/* The rotation hd_render_manager_prepare_orientation() was called for
+ * won't happen after all, so what was loaded for it can go. */
+void hd_render_manager_cancel_orientation(void)
+{
+  if (!render_manager)
+    return;
+
+  if (Prepare_orientation_id)
+    {
+      g_source_remove(Prepare_orientation_id);
+      Prepare_orientation_id = 0;
+    }
+  hd_launcher_cancel_orientation();
+}
+
 ClutterActor *hd_render_manager_get_status_area(void)
 {
   return CLUTTER_ACTOR(render_manager->priv->status_area);
@@ -1390,6 +1447,7 @@ void hd_render_manager_set_state(HDRMStateEnum state)
 
   priv = render_manager->priv;
   cmgr = MB_WM_COMP_MGR (priv->comp_mgr);
+  hd_comp_mgr_portrait_invalidate ();
 
   if (hd_debug_mode_set)
     g_warning("%s -> %s", hd_render_manager_state_str(priv->state),
@@ -1531,9 +1589,12 @@ void hd_render_manager_set_state(HDRMStateEnum state)
               if (mb_wm_comp_mgr_clutter_client_is_unredirected (c->cm_client))
                 mb_wm_comp_mgr_clutter_set_client_redirection (c->cm_client,
                                                                TRUE);
-              mb_wm_comp_mgr_clutter_client_track_damage (
-                    MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client), True);
+              /* The applets of hidden views stay untracked. */
+              if (HD_WM_CLIENT_CLIENT_TYPE (c) != HdWmClientTypeHomeApplet)
+                mb_wm_comp_mgr_clutter_client_track_damage (
+                      MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client), True);
             }
+          hd_home_update_applets_damage (priv->home);
 
           /* this is needed, otherwise task switcher background can remain
            * black (NB#140378) */
@@ -1862,6 +1923,7 @@ void hd_render_manager_set_state(HDRMStateEnum state)
 out:
   if (hd_debug_mode_set)
     g_warning("Set state complete %s ",	hd_render_manager_state_str(priv->state));
+  hd_recorder_state_changed (hd_render_manager_state_str(priv->state));
 
   priv->in_set_state = FALSE;
 }
@@ -2139,6 +2201,7 @@ void hd_render_manager_restack()
   ClutterActor *child;
 
   wm = MB_WM_COMP_MGR(priv->comp_mgr)->wm;
+  hd_recorder_restacked ();
   /* Add all actors currently in the home_blur group */
 
   for (i = 0,
@@ -2785,6 +2848,7 @@ void hd_render_manager_set_visibilities()
   MBWindowManagerClient *c;
 
   priv = render_manager->priv;
+  hd_comp_mgr_portrait_invalidate ();
 
   /* shortcut for non-composited mode */
   if (STATE_IS_NON_COMP (priv->state))
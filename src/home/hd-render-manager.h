@@ -303,6 +303,11 @@ gboolean hd_render_manager_actor_is_visible(ClutterActor *actor);
 
 void hd_render_manager_set_visibilities(void);
 
+/* Called when the screen is likely to be rotated to @portrait. */
+void hd_render_manager_prepare_orientation(gboolean portrait);
+/* Called when it won't be after all. */
+void hd_render_manager_cancel_orientation(void);
+
 void hd_render_manager_update_blur_state(void);
 void hd_render_manager_pause_blur_animation(void);
 
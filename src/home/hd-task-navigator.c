@@ -67,6 +67,7 @@
 #include "hd-util.h"
 #include "hd-gtk-style.h"
 #include "hd-app-mgr.h"
+#include "hd-profiler.h"
 /* }}} */
 
 /* Standard definitions {{{ */
@@ -503,7 +504,15 @@ typedef struct
   void (*clip)    (ClutterActor *actor, gint appgw, gint appwh);
 } Flyops;
 
-/* For linear_effect(), resize_effect() and turnoff_effect(). */
+/* What fade() should do when the effect completes. */
+enum final_fade_action_t
+{
+  FINALLY_REST,   /* Nothing is necessary. */
+  FINALLY_HIDE,   /* Hide @another_actor. */
+  FINALLY_REMOVE, /* Remove the faded actor from @another_actor. */
+};
+
+/* For resize_effect() on __armel__ and turnoff_effect(). */
 typedef struct
 {
   /*
@@ -527,45 +536,6 @@ typedef struct
   /* Effect-specific context */
   union
   {
-    /* For linear_effect()s. */
-    struct
-    {
-      /*
-       * In each frame a number of properties of @actor is changed lineraly,
-       * such as width and height.  Each property has its own structure.
-       * The number of properties that can be controlled by such an effect
-       * is limited by the the number of elements in the array.
-       */
-      struct
-      {
-        /*
-         * @init:             The property's value at the start of the effect.
-         * @diff:             By the end of effect how much the property should
-         *                    be different with regards to @init.
-         */
-        gfloat init, diff;
-      } linear[2];
-
-      /* Auxiliary instruction for linear_effect()s. */
-      union
-      {
-        /* For fade(). */
-        struct
-        {
-          /* What to do when the effect completes. */
-          enum final_fade_action_t
-          {
-            FINALLY_REST,   /* Nothing is necessary. */
-            FINALLY_HIDE,   /* Hide @another_actor. */
-            FINALLY_REMOVE, /* Remove EffectClosure::actor
-                             * from @another_actor. */
-          } finally;
-
-          ClutterActor *another_actor;
-        };
-      };
-    };
-
     /* This is used by resize_effect() on __armel__. */
     struct
     { /* The final dimensions of @actor. */
@@ -605,6 +575,60 @@ typedef struct
   gpointer                     funparam;
   gulong                       handler_id;
 } EffectCompleteClosure;
+
+/* The properties tween() can animate. */
+typedef enum
+{
+  TWEEN_MOVE,
+  TWEEN_RESIZE,
+  TWEEN_SCALE,
+  TWEEN_ROTATE_Z,
+  TWEEN_CLIP,
+  TWEEN_FADE,
+  TWEEN_KINDS,
+} TweenKind;
+
+/*
+ * The tweens driven by a %ClutterTimeline, in parallel arrays indexed
+ * by tween, so that a frame is a single pass over them.
+ *
+ * @timeline:                   The timeline (refed) whose progress the
+ *                              tweens follow, and @new_frame_cb_id and
+ *                              @completed_cb_id are our handlers on it.
+ * @n, @size:                   The number of tweens and the capacity of
+ *                              the arrays.
+ * @actor, @kind:               What the tween animates.  @actor is refed.
+ * @init, @diff:                Two lines per tween, for the two values
+ *                              of the property.  The value at progress
+ *                              @t is @init + @diff*@t.
+ * @finally, @another_actor:    For %TWEEN_FADE:s, what to do with
+ *                              @another_actor (refed) when completed.
+ * @busy:                       Set while the tweens are being advanced
+ *                              or completed, when the batch mustn't be
+ *                              freed even if it's emptied.
+ */
+typedef struct
+{
+  ClutterTimeline *timeline;
+  gulong new_frame_cb_id, completed_cb_id;
+
+  guint n, size;
+  ClutterActor **actor;
+  guint8 *kind;
+  gfloat *init, *diff;
+  guint8 *finally;
+  ClutterActor **another_actor;
+
+  gboolean busy;
+} TweenBatch;
+
+/* Where the tweens of an actor are, by %TweenKind.
+ * An actor has at most one tween of each kind. */
+typedef struct
+{
+  TweenBatch *batch[TWEEN_KINDS];
+  guint index[TWEEN_KINDS];
+} TweenRef;
 /* Clutter effect data structures }}} */
 /* Type definitions }}} */
 
@@ -749,13 +773,19 @@ static ClutterEffectTemplate *Fly_effect, *Zoom_effect;
 
 /*
  * The list of currently running effects created with new_effect().
- * Practically these are all effects used for flying.  Used to learn
- * if a particular effect is already running and if so change it,
- * rather than dumbly adding a new effect and create races between
- * then two of them.  Contains pointers to %EffectClosure:s.
+ * Used to learn if a particular effect is already running and if so
+ * change it, rather than dumbly adding a new effect and create races
+ * between then two of them.  Contains pointers to %EffectClosure:s.
+ * Flying and fading is done with tween()s instead.
  */
 static GPtrArray *Effects;
 
+/*
+ * The running tween()s: @Tween_batches maps %ClutterTimeline:s to their
+ * %TweenBatch, and @Tweens maps %ClutterActor:s to their %TweenRef.
+ */
+static GHashTable *Tween_batches, *Tweens;
+
 /* gtkrc articles */
 static const gchar *LargeSystemFont, *SystemFont, *SmallSystemFont;
 static ClutterColor DefaultTextColor;
@@ -1124,40 +1154,289 @@ free_effect (ClutterTimeline * timeline, EffectClosure * closure)
 }
 /* General }}} */
 
-/* Linear effects {{{ */
+/* Tweens {{{ */
 /*
- * Start or continue a linear effect on @actor during which one or more
- * properties of @actor are changed linearly depending on the current
- * progress of @timeline.  If @actor doesn't have a @frame_fun effect yet,
- * it starts a new one.  The named parameters have the same meaning as
- * in new_effect().  The varadic argument list should be pairs of %gdouble:s
- * teminated by a NAN.  Each pair describes the endpoint values of a property.
- * If an effect is already running it is altered such that by the end of
- * @timline the properties will reach their final intended values without
- * jumping.  In @frame_fun the current value of the properties can be
- * queried with linear_effect_value().
+ * A tween changes two values of a property of an actor linearly, following
+ * the progress of a %ClutterTimeline.  The tweens of a timeline are kept
+ * together in a %TweenBatch, which has a single ::new-frame and ::completed
+ * handler, so flying a lot of thumbnails costs two signal emissions per
+ * frame rather than two per thumbnail.
  */
-static EffectClosure *
-linear_effect (ClutterTimeline * timeline, ClutterActor * actor,
-               void (*frame_fun)(ClutterTimeline *, gint, EffectClosure *),
-               void (*complete_fun)(ClutterTimeline *, EffectClosure *),
-               ...)
+static void
+free_tween_ref (gpointer ref)
+{
+  g_slice_free (TweenRef, ref);
+}
+
+/* Returns the batch of @actor's @kind of tween and its index in @ip,
+ * or %NULL if @actor doesn't have such a tween. */
+static TweenBatch *
+tween_find (ClutterActor * actor, TweenKind kind, guint * ip)
+{
+  TweenRef *ref;
+
+  if (!Tweens || !(ref = g_hash_table_lookup (Tweens, actor))
+      || !ref->batch[kind])
+    return NULL;
+  if (ip)
+    *ip = ref->index[kind];
+  return ref->batch[kind];
+}
+
+static inline gboolean
+has_tween (ClutterActor * actor, TweenKind kind)
+{
+  return tween_find (actor, kind, NULL) != NULL;
+}
+
+/* Removes the @i:th tween from @batch by moving the last one in its place.
+ * It doesn't release the references the tween holds. */
+static void
+tween_unlink (TweenBatch * batch, guint i)
+{
+  TweenRef *ref;
+  guint last;
+
+  ref = g_hash_table_lookup (Tweens, batch->actor[i]);
+  ref->batch[batch->kind[i]] = NULL;
+  if (!ref->batch[TWEEN_MOVE]     && !ref->batch[TWEEN_RESIZE]
+      && !ref->batch[TWEEN_SCALE] && !ref->batch[TWEEN_ROTATE_Z]
+      && !ref->batch[TWEEN_CLIP]  && !ref->batch[TWEEN_FADE])
+    g_hash_table_remove (Tweens, batch->actor[i]);
+
+  last = --batch->n;
+  if (i == last)
+    return;
+
+  batch->actor[i]           = batch->actor[last];
+  batch->kind[i]            = batch->kind[last];
+  batch->init[2*i]          = batch->init[2*last];
+  batch->init[2*i+1]        = batch->init[2*last+1];
+  batch->diff[2*i]          = batch->diff[2*last];
+  batch->diff[2*i+1]        = batch->diff[2*last+1];
+  batch->finally[i]         = batch->finally[last];
+  batch->another_actor[i]   = batch->another_actor[last];
+
+  ref = g_hash_table_lookup (Tweens, batch->actor[i]);
+  ref->index[batch->kind[i]] = i;
+}
+
+static void
+free_tween_batch (TweenBatch * batch)
+{
+  g_assert (!batch->n);
+  g_hash_table_remove (Tween_batches, batch->timeline);
+  g_signal_handler_disconnect (batch->timeline, batch->new_frame_cb_id);
+  g_signal_handler_disconnect (batch->timeline, batch->completed_cb_id);
+  g_object_unref (batch->timeline);
+
+  g_free (batch->actor);
+  g_free (batch->kind);
+  g_free (batch->init);
+  g_free (batch->diff);
+  g_free (batch->finally);
+  g_free (batch->another_actor);
+  g_slice_free (TweenBatch, batch);
+}
+
+/* Cancels @actor's @kind of tween if it has one, leaving the property
+ * where it is now. */
+static void
+cancel_tween (ClutterActor * actor, TweenKind kind)
 {
+  TweenBatch *batch;
+  ClutterActor *another_actor;
   guint i;
-  va_list list;
-  gfloat init, final;
-  EffectClosure *closure;
 
-  va_start (list, complete_fun);
-  if (G_LIKELY (!(closure = has_effect (actor, frame_fun))))
+  if (!(batch = tween_find (actor, kind, &i)))
+    return;
+
+  another_actor = batch->another_actor[i];
+  tween_unlink (batch, i);
+  if (another_actor)
+    g_object_unref (another_actor);
+  g_object_unref (actor);
+
+  if (!batch->n && !batch->busy)
+    free_tween_batch (batch);
+}
+
+/* %ClutterTimeline::new-frame handler of a %TweenBatch: advances all
+ * its tweens in one go. */
+static void
+tween_batch_frame (ClutterTimeline * timeline, gint frame,
+                   TweenBatch * batch)
+{
+  const gfloat *init, *diff;
+  gfloat now, v1, v2;
+  guint i;
+
+  now = clutter_timeline_get_progress (timeline);
+  batch->busy = TRUE;
+  for (i = 0; i < batch->n; i++)
+    {
+      init = &batch->init[2*i];
+      diff = &batch->diff[2*i];
+      v1 = init[0] + diff[0]*now;
+      v2 = init[1] + diff[1]*now;
+
+      switch (batch->kind[i])
+        {
+          case TWEEN_MOVE:
+            clutter_actor_set_position (batch->actor[i], v1, v2);
+            break;
+          case TWEEN_RESIZE:
+            clutter_actor_set_size (batch->actor[i], v1, v2);
+            break;
+          case TWEEN_SCALE:
+            clutter_actor_set_scale (batch->actor[i], v1, v2);
+            break;
+          case TWEEN_ROTATE_Z:
+            clutter_actor_set_rotation_z (batch->actor[i], v1, v2);
+            break;
+          case TWEEN_CLIP:
+            set_clip (batch->actor[i], v1, v2);
+            break;
+          case TWEEN_FADE:
+            clutter_actor_set_opacity (batch->actor[i], v1);
+            break;
+        }
+    }
+  batch->busy = FALSE;
+
+  if (!batch->n)
+    free_tween_batch (batch);
+}
+
+/* %ClutterTimeline::completed handler of a %TweenBatch: finishes all its
+ * tweens.  They are taken off first, so the %FINALLY_HIDE and
+ * %FINALLY_REMOVE actions can start new tweens on the same timeline. */
+static void
+tween_batch_completed (ClutterTimeline * timeline, TweenBatch * batch)
+{
+  ClutterActor **actors, **others;
+  guint8 *kinds, *finally;
+  guint i, n;
+
+  if (!(n = batch->n))
     {
+      free_tween_batch (batch);
+      return;
+    }
+
+  actors  = g_memdup (batch->actor, n * sizeof (*actors));
+  others  = g_memdup (batch->another_actor, n * sizeof (*others));
+  kinds   = g_memdup (batch->kind, n * sizeof (*kinds));
+  finally = g_memdup (batch->finally, n * sizeof (*finally));
+
+  batch->busy = TRUE;
+  for (i = 0; i < n; i++)
+    tween_unlink (batch, batch->n - 1);
+
+  for (i = 0; i < n; i++)
+    {
+      if (kinds[i] == TWEEN_FADE)
+        {
+          if (finally[i] == FINALLY_HIDE)
+            clutter_actor_hide (others[i]);
+          else if (finally[i] == FINALLY_REMOVE)
+            clutter_container_remove_actor (CLUTTER_CONTAINER (others[i]),
+                                            actors[i]);
+        }
+      if (others[i])
+        g_object_unref (others[i]);
+      g_object_unref (actors[i]);
+    }
+  batch->busy = FALSE;
+
+  g_free (actors);
+  g_free (others);
+  g_free (kinds);
+  g_free (finally);
+
+  if (!batch->n)
+    free_tween_batch (batch);
+}
+
+/* Returns the %TweenBatch of @timeline, creating it if necessary. */
+static TweenBatch *
+tween_batch (ClutterTimeline * timeline)
+{
+  TweenBatch *batch;
+
+  if (G_UNLIKELY (!Tween_batches))
+    {
+      Tween_batches = g_hash_table_new (g_direct_hash, g_direct_equal);
+      Tweens = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, free_tween_ref);
+    }
+  else if ((batch = g_hash_table_lookup (Tween_batches, timeline)) != NULL)
+    return batch;
+
+  batch = g_slice_new0 (TweenBatch);
+  batch->timeline = g_object_ref (timeline);
+  batch->new_frame_cb_id = g_signal_connect (timeline, "new-frame",
+                                        G_CALLBACK (tween_batch_frame),
+                                        batch);
+  batch->completed_cb_id = g_signal_connect (timeline, "completed",
+                                        G_CALLBACK (tween_batch_completed),
+                                        batch);
+  g_hash_table_insert (Tween_batches, timeline, batch);
+  return batch;
+}
+
+/*
+ * Start or continue tweening @kind of property of @actor from
+ * (@init1, @init2) to (@final1, @final2) during @timeline.
+ * If @actor already has such a tween it is altered such that by the
+ * end of its timeline the property will reach its final intended value
+ * without jumping.  Returns the batch of the tween and its index in @ip.
+ */
+static TweenBatch *
+tween (ClutterTimeline * timeline, ClutterActor * actor, TweenKind kind,
+       gfloat init1, gfloat final1, gfloat init2, gfloat final2,
+       guint * ip)
+{
+  TweenBatch *batch;
+  TweenRef *ref;
+  guint i;
+
+  if (G_LIKELY (!(batch = tween_find (actor, kind, &i))))
+    {
+      batch = tween_batch (timeline);
+      if (batch->n == batch->size)
+        {
+          batch->size = batch->size ? batch->size * 2 : 16;
+          batch->actor   = g_renew (ClutterActor *, batch->actor,
+                                    batch->size);
+          batch->kind    = g_renew (guint8, batch->kind, batch->size);
+          batch->init    = g_renew (gfloat, batch->init, 2*batch->size);
+          batch->diff    = g_renew (gfloat, batch->diff, 2*batch->size);
+          batch->finally = g_renew (guint8, batch->finally, batch->size);
+          batch->another_actor = g_renew (ClutterActor *,
+                                          batch->another_actor,
+                                          batch->size);
+        }
+
       /* @init and @diff are parameters of the line. */
-      closure = new_effect (timeline, actor, frame_fun, complete_fun);
-      for (i = 0; !isnanf (init = va_arg (list, gdouble)); i++)
-        { g_assert (i < G_N_ELEMENTS (closure->linear));
-          closure->linear[i].init = init;
-          closure->linear[i].diff = va_arg (list, gdouble) - init;
+      i = batch->n++;
+      batch->actor[i]         = g_object_ref (actor);
+      batch->kind[i]          = kind;
+      batch->init[2*i]        = init1;
+      batch->diff[2*i]        = final1 - init1;
+      batch->init[2*i+1]      = init2;
+      batch->diff[2*i+1]      = final2 - init2;
+      batch->finally[i]       = FINALLY_REST;
+      batch->another_actor[i] = NULL;
+
+      if (!(ref = g_hash_table_lookup (Tweens, actor)))
+        {
+          ref = g_slice_new0 (TweenRef);
+          g_hash_table_insert (Tweens, actor, ref);
         }
+      ref->batch[kind] = batch;
+      ref->index[kind] = i;
+      clutter_timeline_start (timeline);
     }
   else
     {
@@ -1168,26 +1447,18 @@ linear_effect (ClutterTimeline * timeline, ClutterActor * actor,
        *
        * As @timeline may not be the already running one ignore it.
        */
-      gfloat now = clutter_timeline_get_progress (closure->timeline);
-      for (i = 0; !isnanf (init = va_arg (list, gdouble)); i++)
-        { g_assert (i < G_N_ELEMENTS (closure->linear));
-          final = va_arg (list, gdouble);
-          closure->linear[i].diff = (final-init) / (1-now);
-          closure->linear[i].init = final - closure->linear[i].diff;
-        }
+      gfloat now = clutter_timeline_get_progress (batch->timeline);
+      batch->diff[2*i]   = (final1-init1) / (1-now);
+      batch->init[2*i]   = final1 - batch->diff[2*i];
+      batch->diff[2*i+1] = (final2-init2) / (1-now);
+      batch->init[2*i+1] = final2 - batch->diff[2*i+1];
     }
-  va_end (list);
-
-  return closure;
-}
 
-/* Return the value of @which property at @now. */
-static inline gfloat __attribute__((pure))
-linear_effect_value (const EffectClosure * closure, guint which, gfloat now)
-{ g_assert (which < G_N_ELEMENTS (closure->linear));
-  return closure->linear[which].init + closure->linear[which].diff*now;
+  if (ip)
+    *ip = i;
+  return batch;
 }
-/* Linear effects }}} */
+/* Tweens }}} */
 
 /* Effect closures {{{ */
 /* add_effect_closure()'s #ClutterTimeline::completed handler. */
@@ -1230,7 +1501,7 @@ add_effect_closure (ClutterTimeline * timeline,
  * In purpose they are similar to clutter_effect_move() etc.
  * but additionally their destination can be changed on the go,
  * allowing for smooth animations.  This is permitted by the
- * linear_effect() machinery.
+ * tween() machinery.
  *
  * Here we define:
  * -- check_and_move(),   move(),   move_effect()
@@ -1254,19 +1525,8 @@ add_effect_closure (ClutterTimeline * timeline,
 /* This beautiful macro defines effect() and effect_effect().
  * @clutter_get_fun must have a signature (#ClutterActor, ptype*, ptype*),
  * while @clutter_set_fun is (#ClutterActor, ptype, ptype). */
-#define DEFINE_RMS_EFFECT(effect, ptype,                            \
+#define DEFINE_RMS_EFFECT(effect, kind, ptype,                      \
                           clutter_get_fun, clutter_set_fun)         \
-/* @effect's %ClutterTimeline::new-frame callback. */               \
-static void                                                         \
-effect##_effect_frame (ClutterTimeline * timeline, gint frame,      \
-                       EffectClosure * closure)                     \
-{                                                                   \
-  gfloat now = clutter_timeline_get_progress (timeline);            \
-  clutter_set_fun (closure->actor,                                  \
-                   linear_effect_value (closure, 0, now),           \
-                   linear_effect_value (closure, 1, now));          \
-}                                                                   \
-                                                                    \
 static void                                                         \
 effect##_effect (ClutterTimeline * timeline, ClutterActor * actor,  \
                  ptype final1, ptype final2)                        \
@@ -1274,11 +1534,7 @@ effect##_effect (ClutterTimeline * timeline, ClutterActor * actor,  \
   ptype init1, init2;                                               \
                                                                     \
   clutter_get_fun (actor, &init1, &init2);                          \
-  linear_effect (timeline, actor,                                   \
-                 effect##_effect_frame, free_effect,                \
-                 (gdouble)init1, (gdouble)final1,                   \
-                 (gdouble)init2, (gdouble)final2,                   \
-                 NAN);                                              \
+  tween (timeline, actor, kind, init1, final1, init2, final2, NULL);\
 }                                                                   \
                                                                     \
 static void                                                         \
@@ -1290,38 +1546,36 @@ effect (ClutterActor * actor, ptype final1, ptype final2)           \
     clutter_set_fun (actor, final1, final2);                        \
 }
 
-DEFINE_RMS_EFFECT(move, gint,
+DEFINE_RMS_EFFECT(move, TWEEN_MOVE, gint,
                   clutter_actor_get_position, clutter_actor_set_position);
 static void
 check_and_move (ClutterActor * actor, gint xpos_new, gint ypos_new)
 {
-  EffectClosure *closure;
   gint xpos_now, ypos_now;
 
   clutter_actor_get_position (actor, &xpos_now, &ypos_now);
   if (xpos_now != xpos_new || ypos_now != ypos_new)
     move (actor, xpos_new, ypos_new);
-  else if ((closure = has_effect (actor, move_effect_frame)) != NULL)
-    free_effect (closure->timeline, closure);
+  else
+    cancel_tween (actor, TWEEN_MOVE);
 }
 
 /* On the gadget (or maybe in general if we're accelerated) we can't
  * resize continously because it blocks all effects and doesn't come
  * about anyway.  It's so even if we don't clip_on_resize(). */
 #ifdef __i386__
-DEFINE_RMS_EFFECT(resize, guint,
+DEFINE_RMS_EFFECT(resize, TWEEN_RESIZE, guint,
                   clutter_actor_get_size, clutter_actor_set_size);
 static void
 check_and_resize (ClutterActor * actor, gint width_new, gint height_new)
 {
-  EffectClosure *closure;
   guint width_now, height_now;
 
   clutter_actor_get_size (actor, &width_now, &height_now);
   if (width_now != width_new || height_now != height_new)
     resize (actor, width_new, height_new);
-  else if ((closure = has_effect (actor, resize_effect_frame)) != NULL)
-    free_effect (closure->timeline, closure);
+  else
+    cancel_tween (actor, TWEEN_RESIZE);
 }
 #else /* __armel__ */
 static void resize_effect_complete (ClutterTimeline * timeline,
@@ -1389,29 +1643,27 @@ check_and_resize (ClutterActor * actor, gint width_new, gint height_new)
 }
 #endif /* __armel__ */
 
-DEFINE_RMS_EFFECT(scale, gdouble,
+DEFINE_RMS_EFFECT(scale, TWEEN_SCALE, gdouble,
                   clutter_actor_get_scale, clutter_actor_set_scale);
 static void
 check_and_scale (ClutterActor * actor, gdouble sx_new, gdouble sy_new)
 {
-  EffectClosure *closure;
   gdouble sx_now, sy_now;
 
   /* Beware the rounding errors. */
   clutter_actor_get_scale (actor, &sx_now, &sy_now);
   if (fabs (sx_now - sx_new) > 0.0001 || fabs (sy_now - sy_new) > 0.0001)
     scale (actor, sx_new, sy_new);
-  else if ((closure = has_effect (actor, scale_effect_frame)) != NULL)
-    free_effect (closure->timeline, closure);
+  else
+    cancel_tween (actor, TWEEN_SCALE);
 }
 
-DEFINE_RMS_EFFECT(rotate_z, gfloat,
+DEFINE_RMS_EFFECT(rotate_z, TWEEN_ROTATE_Z, gfloat,
                   clutter_actor_get_rotation_z, clutter_actor_set_rotation_z)
 
 static void
 check_and_rotate_z (ClutterActor * actor, gfloat angle_new, gfloat z_new)
 {
-  EffectClosure *closure;
   gfloat angle_now;
   gint z_now;
 
@@ -1420,8 +1672,8 @@ check_and_rotate_z (ClutterActor * actor, gfloat angle_new, gfloat z_new)
 
   if (angle_now != angle_new || z_now != z_new)
     rotate_z (actor, angle_new, z_new);
-  else if ((closure = has_effect (actor, rotate_z_effect_frame)) != NULL)
-    free_effect (closure->timeline, closure);
+  else
+    cancel_tween (actor, TWEEN_ROTATE_Z);
 }
 
 static void
@@ -1439,12 +1691,11 @@ clutter_actor_get_rotation_z(ClutterActor * actor, gfloat * angle, gfloat * z)
     *z=_z;
 }
 
-DEFINE_RMS_EFFECT(clip, gint, get_clip, set_clip)
+DEFINE_RMS_EFFECT(clip, TWEEN_CLIP, gint, get_clip, set_clip)
 
 static void
 check_and_clip (ClutterActor * actor, gint appwgw, gint appwgh)
 {
-  EffectClosure *closure;
   gint appwgw_now,appwgh_now;
 
   if (!actor)
@@ -1454,8 +1705,8 @@ check_and_clip (ClutterActor * actor, gint appwgw, gint appwgh)
 
   if (appwgw_now != appwgw || appwgh_now != appwgh)
     clip (actor, appwgw, appwgh);
-  else if ((closure = has_effect (actor, clip_effect_frame)) != NULL)
-    free_effect (closure->timeline, closure);
+  else
+    cancel_tween (actor, TWEEN_CLIP);
 }
 
 static void
@@ -1476,70 +1727,45 @@ get_clip(ClutterActor * actor, gint * appwgw, gint * appwgh)
 /* RMS effects }}} */
 
 /* Fading effect {{{ */
-/* frame_fun of fade() */
-static void
-fade_frame (ClutterTimeline * timeline, gint frame, EffectClosure * closure)
-{
-  clutter_actor_set_opacity (closure->actor, linear_effect_value (closure, 0,
-    clutter_timeline_get_progress (timeline)));
-}
-
-/* complete_fun of fade() */
-static void
-fade_complete (ClutterTimeline * timeline, EffectClosure * closure)
-{
-  if (closure->finally == FINALLY_HIDE)
-    clutter_actor_hide (closure->another_actor);
-  else if (closure->finally == FINALLY_REMOVE)
-    clutter_container_remove_actor (CLUTTER_CONTAINER (closure->another_actor),
-                                    closure->actor);
-  if (closure->another_actor)
-    g_object_unref (closure->another_actor);
-  free_effect (timeline, closure);
-}
-
 /*
  * Starts fading @actor to @opacity, and do @finally something to
  * @another_actor when it's complete.  If there's already such an
  * effect in progress it's overridden together with its @finally
  * action.
  */
-static EffectClosure *
+static void
 fade (ClutterTimeline * timeline, ClutterActor * actor, guint opacity,
       enum final_fade_action_t finally, ClutterActor * another_actor)
 {
-  EffectClosure *closure;
+  TweenBatch *batch;
+  guint i;
 
   g_assert ((finally == FINALLY_REST) == (another_actor == NULL));
-  closure = linear_effect (timeline, actor, fade_frame, fade_complete,
-                           (gdouble)clutter_actor_get_opacity(actor),
-                           (gdouble)opacity, NAN);
+  batch = tween (timeline, actor, TWEEN_FADE,
+                 clutter_actor_get_opacity (actor), opacity, 0, 0, &i);
 
-  closure->finally = finally;
+  batch->finally[i] = finally;
   if (another_actor)
     g_object_ref (another_actor);
-  if (closure->another_actor)
-    g_object_unref (closure->another_actor);
-  closure->another_actor = another_actor;
+  if (batch->another_actor[i])
+    g_object_unref (batch->another_actor[i]);
+  batch->another_actor[i] = another_actor;
 
   clutter_timeline_start (timeline);
-  return closure;
 }
 
 /* The same as fade() except that it creates an independent disposable
  * %ClutterTimeline for $msecs for the effect. */
-static EffectClosure *
+static void
 fade_for_duration (guint msecs, ClutterActor * actor, guint opacity,
                    enum final_fade_action_t finally,
                    ClutterActor * another_actor)
 {
-  EffectClosure *closure;
   ClutterTimeline *timeline;
 
   timeline = clutter_timeline_new_for_duration (msecs);
-  closure = fade (timeline, actor, opacity, finally, another_actor);
+  fade (timeline, actor, opacity, finally, another_actor);
   g_object_unref (timeline);
-  return closure;
 }
 
 /* Cancels the ongoing fade() effect on @actor if there one.
@@ -1547,10 +1773,7 @@ fade_for_duration (guint msecs, ClutterActor * actor, guint opacity,
 static void
 reset_opacity (ClutterActor * actor, guint opacity, gboolean be_shown)
 {
-  EffectClosure *closure;
-
-  if ((closure = has_effect (actor, fade_frame)) != NULL)
-    free_effect (closure->timeline, closure);
+  cancel_tween (actor, TWEEN_FADE);
   clutter_actor_set_opacity (actor, opacity);
   if (be_shown)
     clutter_actor_show (actor);
@@ -1798,7 +2021,7 @@ show_when_complete (ClutterActor * actor)
 static void
 fade_in_when_complete (ClutterActor * actor, gpointer msecs)
 {
-  if (has_effect (actor, fade_frame))
+  if (has_tween (actor, TWEEN_FADE))
     /* A fade-out by free_thumb() must be in progress, don't override it. */
     return;
   clutter_actor_set_opacity (actor, 0);
@@ -2493,6 +2716,7 @@ create_thwin (Thumbnail * thumb, ClutterActor * prison)
 
   clutter_actor_set_name (thumb->thwin, "thumbnail");
   clutter_actor_set_reactive (thumb->thwin, TRUE);
+  hd_profiler_watch_actor (thumb->thwin, HD_PROFILER_THUMBNAIL);
   clutter_container_add (CLUTTER_CONTAINER (thumb->thwin),
                          prison, thumb->plate, NULL);
   clutter_container_add_actor (CLUTTER_CONTAINER (Grid), thumb->thwin);
@@ -2735,7 +2959,7 @@ adopt_notification (Thumbnail * apthumb, TNote * tnote)
     }
   else
     { /* Make sure all opacities are reset to the normal values. */
-      g_assert (!has_effect (tnote->notwin, fade_frame));
+      g_assert (!has_tween (tnote->notwin, TWEEN_FADE));
       clutter_actor_hide (apthumb->prison);
       reset_opacity (apthumb->frame.all, 0, FALSE);
       reset_opacity (apthumb->close_notif_icon, 255, TRUE);
@@ -4608,6 +4832,21 @@ hd_task_navigator_rotate(int mode)
   layout (NULL, FALSE);
 }
 
+/* Finds out which application thumbnails can be shown in portrait
+ * before the rotation, rather than in the layout after it. */
+void
+hd_task_navigator_prepare_orientation (gboolean portrait)
+{
+  const GList *li;
+
+  if (!portrait || IS_PORTRAIT)
+    return;
+
+  for (li = Thumbnails; li; li = li->next)
+    if (thumb_is_application ((Thumbnail *)li->data))
+      hd_task_navigator_app_portrait_capable (li->data);
+}
+
 void
 hd_task_navigator_update_orientation(gboolean portrait)
 {
@@ -86,6 +86,7 @@ void hd_task_navigator_rotate_thumbs(void);
 int hd_task_navigator_mode(void);
 
 void hd_task_navigator_rotate(int mode);
+void hd_task_navigator_prepare_orientation (gboolean portrait);
 void hd_task_navigator_update_orientation(gboolean portrait);
 void hd_task_navigator_update_win_orientation(Window xwindow,gboolean portrait);
 gboolean hd_task_navigator_get_disable_portrait(MBWindowManagerClient *c);
@@ -1284,6 +1284,15 @@ hd_title_bar_update_now(HdTitleBar *bar)
   priv->state = (priv->state & ~HDTB_VIS_SMALL_BUTTONS) | prev_button_size;
 }
 
+/* Does a pending update now rather than while we're blanked for the
+ * rotation. */
+void
+hd_title_bar_prepare_orientation(HdTitleBar *bar)
+{
+  if (bar->priv->update_title_bar)
+    hd_title_bar_update_now(bar);
+}
+
 /* Is the given decor one we should consider for a title bar? */
 gboolean
 hd_title_bar_is_title_bar_decor(HdTitleBar *bar, MBWMDecor *decor)
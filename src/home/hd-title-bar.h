@@ -86,6 +86,7 @@ void hd_title_bar_set_state(HdTitleBar *bar,
 HdTitleBarVisEnum hd_title_bar_get_state(HdTitleBar *bar);
 void hd_title_bar_update(HdTitleBar *bar);
 void hd_title_bar_update_now(HdTitleBar *bar);
+void hd_title_bar_prepare_orientation(HdTitleBar *bar);
 
 void hd_title_bar_set_loading_title   (HdTitleBar *bar,
                                        const char *title);
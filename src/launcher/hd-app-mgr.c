@@ -134,6 +134,16 @@ struct _HdAppMgrPrivate
   gboolean disable_callui;
   gboolean ui_can_rotate;
   gboolean accel_enabled;
+
+  /* The orientation the accelerometer last reported, which becomes
+   * @portrait when it has settled (@orientation_id), and when @portrait
+   * last changed.  See hd_app_mgr_orientation_reported(). */
+  gboolean reported_portrait;
+  guint orientation_id;
+  gint64 orientation_changed;
+
+  /* hd_app_mgr_update_portraitness() is done in this idle. */
+  guint portraitness_id;
 };
 
 #define HD_APP_MGR_GET_PRIVATE(obj) (hd_app_mgr_get_instance_private (obj))
@@ -293,6 +303,8 @@ static gboolean hd_app_mgr_init_done_timeout (HdAppMgr *self);
 
 static void hd_app_mgr_kill_all_prestarted (void);
 
+static HdAppMgrOrientationStats Orientation_stats;
+
 /* The HdLauncher singleton */
 static HdAppMgr *the_app_mgr = NULL;
 
@@ -627,6 +639,11 @@ hd_app_mgr_dispose (GObject *gobject)
   HdAppMgr *self = HD_APP_MGR (gobject);
   HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (self);
 
+  if (priv->orientation_id)
+    priv->orientation_id = (g_source_remove (priv->orientation_id), 0);
+  if (priv->portraitness_id)
+    priv->portraitness_id = (g_source_remove (priv->portraitness_id), 0);
+
   if (priv->dbus_proxy)
     {
       g_object_unref (priv->dbus_proxy);
@@ -2012,6 +2029,24 @@ _hd_app_mgr_dbus_check_value (DBusMessage *msg,
   return FALSE;
 }
 
+static gboolean
+hd_app_mgr_portraitness_idle (HdAppMgr *self)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (self);
+  HdCompMgr *hmgr = hd_comp_mgr_get ();
+
+  priv->portraitness_id = 0;
+  if (hmgr)
+    {
+      Orientation_stats.evaluations++;
+      hd_comp_mgr_portrait_or_not_portrait (MB_WM_COMP_MGR (hmgr), NULL);
+    }
+  return FALSE;
+}
+
+/* Tells the comp-mgr what the accelerometer and the slide say and lets it
+ * reconsider the portraitness of the stack.  That walks the stack, so when
+ * the inputs change in a burst it's done only once, after the burst. */
 static void
 hd_app_mgr_update_portraitness(HdAppMgr *self)
 {
@@ -2025,7 +2060,118 @@ hd_app_mgr_update_portraitness(HdAppMgr *self)
   hd_comp_mgr_set_pip_flags (hmgr,
       priv->accel_enabled,
       priv->portrait && priv->slide_closed);
-  hd_comp_mgr_portrait_or_not_portrait (MB_WM_COMP_MGR (hmgr), NULL);
+
+  Orientation_stats.updates++;
+  if (!priv->portraitness_id)
+    priv->portraitness_id = g_idle_add_full (G_PRIORITY_DEFAULT,
+                          (GSourceFunc)hd_app_mgr_portraitness_idle,
+                          self, NULL);
+}
+
+/* Acts on a change of @priv->portrait. */
+static void
+hd_app_mgr_orientation_changed (HdAppMgr *self)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (self);
+
+  /* CallUI shouldn't appear when in LAUNCHER AND TL can rotate, but
+   * should appear when TL cannot rotate. */
+  if (hd_app_mgr_check_show_callui ())
+    {
+      hd_app_mgr_update_portraitness(self);
+    }
+  else if (hd_app_mgr_ui_can_rotate () &&
+      STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
+    {
+      /* we can go to portrait only if device's portraited and the HKB
+       * slide is closed. */
+      HDRMStateEnum state = (priv->portrait && priv->slide_closed ?
+          HDRM_STATE_LAUNCHER_PORTRAIT : HDRM_STATE_LAUNCHER);
+
+      hd_render_manager_set_state (state);
+    }
+  else if ( STATE_IS_TASK_NAV (hd_render_manager_get_state ()))
+    {
+      /* we can go to portrait only if device's portraited and the HKB
+       * slide is closed. */
+      HDRMStateEnum state = (priv->portrait && priv->slide_closed ?
+          HDRM_STATE_TASK_NAV_PORTRAIT : HDRM_STATE_TASK_NAV);
+
+      hd_render_manager_set_state (state);
+    }
+  else
+    {
+      hd_app_mgr_update_portraitness(self);
+    }
+}
+
+static gboolean
+hd_app_mgr_orientation_settled (HdAppMgr *self)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (self);
+
+  priv->orientation_id = 0;
+  if (priv->reported_portrait != priv->portrait)
+    {
+      priv->portrait = priv->reported_portrait;
+      priv->orientation_changed = g_get_monotonic_time ();
+      Orientation_stats.changes++;
+      hd_app_mgr_orientation_changed (self);
+    }
+  return FALSE;
+}
+
+/* Whether the screen would follow if the device stayed @portrait, so that
+ * getting ready for it is worth the trouble. */
+static gboolean
+hd_app_mgr_may_rotate_to (gboolean portrait)
+{
+  HdCompMgr *hmgr = hd_comp_mgr_get ();
+
+  if (!hmgr)
+    return FALSE;
+  return portrait ? hd_comp_mgr_can_be_portrait (hmgr)
+                  : hd_comp_mgr_is_portrait ();
+}
+
+/*
+ * The accelerometer reports the orientation several times while the device
+ * is being turned, and it may flap back and forth around the threshold.
+ * Only take it when it has been the same for "settle_ms", and not sooner
+ * than "hold_ms" after the last change, so we don't rotate to and fro.
+ * If it goes back to the current orientation meanwhile nothing happens.
+ */
+static void
+hd_app_mgr_orientation_reported (HdAppMgr *self, gboolean portrait)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (self);
+  gint64 since;
+  gint delay;
+
+  Orientation_stats.signals++;
+  priv->reported_portrait = portrait;
+  if (priv->orientation_id)
+    {
+      priv->orientation_id = (g_source_remove (priv->orientation_id), 0);
+      if (portrait == priv->portrait)
+        /* It flapped back before settling; we aren't rotating. */
+        hd_render_manager_cancel_orientation ();
+    }
+  if (portrait == priv->portrait)
+    return;
+
+  /* Likely to rotate; let the UI warm up while we wait for it to settle. */
+  if (priv->slide_closed && hd_app_mgr_may_rotate_to (portrait))
+    hd_render_manager_prepare_orientation (portrait);
+
+  since = (g_get_monotonic_time () - priv->orientation_changed) / 1000;
+  delay = MAX (hd_transition_get_int ("orientation", "settle_ms", 200),
+               hd_transition_get_int ("orientation", "hold_ms", 600) - since);
+  if (delay > 0)
+    priv->orientation_id = g_timeout_add (delay,
+                          (GSourceFunc)hd_app_mgr_orientation_settled, self);
+  else
+    hd_app_mgr_orientation_settled (self);
 }
 
 static DBusHandlerResult
@@ -2073,41 +2219,10 @@ hd_app_mgr_dbus_signal_handler (DBusConnection *conn,
                                   MCE_DEVICE_ORIENTATION_SIG) &&
                !_hd_app_mgr_dbus_check_value (msg,MCE_ORIENTATION_UNKNOWN) )
         {
-          if (hd_orientation_lock_is_locked_to_portrait ())
-            priv->portrait = TRUE;
-          else
-            priv->portrait = _hd_app_mgr_dbus_check_value (msg,
-                                             MCE_ORIENTATION_PORTRAIT);
-
-          /* CallUI shouldn't appear when in LAUNCHER AND TL can rotate, but
-           * should appear when TL cannot rotate. */
-          if (hd_app_mgr_check_show_callui ())
-            {
-              hd_app_mgr_update_portraitness(self);
-            }
-          else if (hd_app_mgr_ui_can_rotate () &&
-              STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
-            {
-              /* we can go to portrait only if device's portraited and the HKB
-               * slide is closed. */
-              HDRMStateEnum state = (priv->portrait && priv->slide_closed ?
-                  HDRM_STATE_LAUNCHER_PORTRAIT : HDRM_STATE_LAUNCHER);
-
-              hd_render_manager_set_state (state);
-            }
-          else if ( STATE_IS_TASK_NAV (hd_render_manager_get_state ()))
-            {
-              /* we can go to portrait only if device's portraited and the HKB
-               * slide is closed. */
-              HDRMStateEnum state = (priv->portrait && priv->slide_closed ?
-                  HDRM_STATE_TASK_NAV_PORTRAIT : HDRM_STATE_TASK_NAV);
-
-              hd_render_manager_set_state (state);
-            }
-          else
-            {
-              hd_app_mgr_update_portraitness(self);
-            }
+          hd_app_mgr_orientation_reported (self,
+                    hd_orientation_lock_is_locked_to_portrait ()
+                    || _hd_app_mgr_dbus_check_value (msg,
+                                                 MCE_ORIENTATION_PORTRAIT));
         }
     }
 
@@ -2212,6 +2327,12 @@ hd_app_mgr_mce_activate_accel_if_needed (gboolean update_portraitness)
                 priv->portrait = _hd_app_mgr_dbus_check_value (reply,
                                                     MCE_ORIENTATION_PORTRAIT);
             }
+          /* It's the current orientation, no need to wait for it to
+           * settle. */
+          priv->reported_portrait = priv->portrait;
+          if (priv->orientation_id)
+            priv->orientation_id = (g_source_remove (priv->orientation_id),
+                                    0);
           dbus_message_unref (reply);
         }
       else
@@ -2266,6 +2387,9 @@ hd_app_mgr_gconf_value_changed (GConfClient *client,
                   GCONF_SLIDE_OPEN_KEY))
     {
       priv->slide_closed = !value;
+      if (hd_app_mgr_may_rotate_to (priv->portrait && priv->slide_closed))
+        hd_render_manager_prepare_orientation (priv->portrait
+                                               && priv->slide_closed);
 
       /* Should UI be able to rotate?
        * Related to the orientation lock (locking to portrait mode). */
@@ -2483,7 +2607,27 @@ hd_app_mgr_get_tree ()
 
 void hd_app_mgr_update_orientation()
 {
+    HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (the_app_mgr);
+
+    /* Our callers want it done now. */
     hd_app_mgr_update_portraitness(the_app_mgr);
+    if (priv->portraitness_id)
+      {
+        g_source_remove (priv->portraitness_id);
+        hd_app_mgr_portraitness_idle (the_app_mgr);
+      }
+}
+
+void
+hd_app_mgr_get_orientation_stats (HdAppMgrOrientationStats *stats)
+{
+  *stats = Orientation_stats;
+}
+
+void
+hd_app_mgr_reset_orientation_stats (void)
+{
+  memset (&Orientation_stats, 0, sizeof (Orientation_stats));
 }
 
 #ifndef G_DEBUG_DISABLE
@@ -114,6 +114,18 @@ gboolean hd_app_mgr_slide_is_open (void);
 gboolean hd_app_mgr_ui_can_rotate (void);
 void hd_app_mgr_update_orientation(void);
 
+/* How many orientation signals the accelerometer sent (@signals), how many
+ * times the orientation was taken (@changes), and how many times the
+ * portraitness of the stack was asked to be reconsidered (@updates) and
+ * actually was (@evaluations). */
+typedef struct
+{
+  guint signals, changes, updates, evaluations;
+} HdAppMgrOrientationStats;
+
+void hd_app_mgr_get_orientation_stats (HdAppMgrOrientationStats *stats);
+void hd_app_mgr_reset_orientation_stats (void);
+
 G_END_DECLS
 
 #endif /* __HD_APP_MGR_H__ */
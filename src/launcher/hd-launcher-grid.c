@@ -45,6 +45,7 @@
 #include "hd-comp-mgr.h"
 #include "hd-util.h"
 #include "hd-transition.h"
+#include "hd-idle-work.h"
 
 #define I_(str) (g_intern_static_string ((str)))
 
@@ -90,6 +91,26 @@ struct _HdLauncherGridPrivate
   /* an internal status indicating how to relayout the grid (which usually is
    * the same of the real device orientation, but may not be in sync with it) */
   gboolean is_portrait;
+
+  guint n_tiles;
+  /* The rows whose tiles are shown (the window); empty if first > last. */
+  gint first_row, last_row;
+  /* hd_idle_work job loading the tiles of the window, and how far it
+   * has got: @load_cursor is the @load_index:th link of @tiles, or NULL
+   * to start over from the top of the window. */
+  guint load_work;
+  GList *load_cursor;
+  gint load_index;
+  /* hd_idle_work job preparing the tiles of the other orientation's
+   * window, from the @prepare_next:th tile up to @prepare_end;
+   * @prepare_cursor is like @load_cursor. */
+  guint prepare_work;
+  GList *prepare_cursor;
+  gint prepare_next, prepare_end;
+  /* Whether tiles outside the window may hold icons prefetched by
+   * the above for @prepare_portrait, see
+   * hd_launcher_grid_cancel_prepare(). */
+  gboolean prepared, prepare_portrait;
 };
 
 enum
@@ -116,9 +137,14 @@ static gboolean _hd_launcher_grid_blocker_release_cb (ClutterActor *actor,
                                         gpointer *data);
 
 static gboolean      hd_launcher_grid_is_portrait (HdLauncherGrid *self);
+static void hd_launcher_grid_update_window (HdLauncherGrid *grid,
+                                            gboolean force);
 #define HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE (int)(HD_COMP_MGR_LANDSCAPE_WIDTH/160)
 #define HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT (int)(HD_COMP_MGR_PORTRAIT_WIDTH/160)
 
+/* How many rows to keep loaded above and below the visible ones. */
+#define HD_LAUNCHER_GRID_OVERSCAN_ROWS 2
+
 #define HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_LANDSCAPE (HD_LAUNCHER_LEFT_MARGIN)
 #define HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_LANDSCAPE (HD_LAUNCHER_RIGHT_MARGIN)
 #define HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_PORTRAIT (64)
@@ -241,6 +267,7 @@ adjustment_value_notify (GObject    *gobject,
   clutter_actor_set_anchor_point(grid,
                              0,
                              tidy_adjustment_get_value(priv->v_adjustment));
+  hd_launcher_grid_update_window (HD_LAUNCHER_GRID (grid), FALSE);
 }
 
 static void
@@ -355,8 +382,12 @@ hd_launcher_grid_actor_added (ClutterContainer *container,
   if (HD_IS_LAUNCHER_TILE(actor))
     {
       priv->tiles = g_list_append (priv->tiles, g_object_ref(actor));
+      priv->n_tiles++;
+      priv->load_cursor = priv->prepare_cursor = NULL;
 
-      /* relayout moved to the traversal code */
+      /* Shown by the next layout if it's in the window.
+       * The relayout itself moved to the traversal code. */
+      clutter_actor_hide (actor);
     }
 
   g_object_unref (actor);
@@ -373,6 +404,8 @@ hd_launcher_grid_actor_removed (ClutterContainer *container,
   if (HD_IS_LAUNCHER_TILE(actor))
     {
       priv->tiles = g_list_remove (priv->tiles, actor);
+      priv->n_tiles--;
+      priv->load_cursor = priv->prepare_cursor = NULL;
       g_object_unref(actor);
 
       /* relayout moved to the traversal code */
@@ -381,94 +414,294 @@ hd_launcher_grid_actor_removed (ClutterContainer *container,
   g_object_unref (actor);
 }
 
+static guint
+hd_launcher_grid_columns_for (gboolean portrait)
+{
+  return portrait
+    ? HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT
+    : HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE;
+}
+
+static guint
+hd_launcher_grid_columns (HdLauncherGrid *grid)
+{
+  return hd_launcher_grid_columns_for (hd_launcher_grid_is_portrait (grid));
+}
+
+static guint
+hd_launcher_grid_count_rows (HdLauncherGrid *grid)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns = hd_launcher_grid_columns (grid);
+
+  return (priv->n_tiles + columns - 1) / columns;
+}
+
+/* Where the first row starts. */
+static guint
+hd_launcher_grid_top_for (gboolean portrait)
+{
+  return portrait ? HD_LAUNCHER_PAGE_XMARGIN : HD_LAUNCHER_PAGE_YMARGIN;
+}
+
+static guint
+hd_launcher_grid_top (HdLauncherGrid *grid)
+{
+  return hd_launcher_grid_top_for (hd_launcher_grid_is_portrait (grid));
+}
+
+/* Works out which rows can be seen at the current scroll position
+ * (@visible_first..@visible_last) and which should be in the window
+ * (@first..@last) if @grid is laid out @portrait. */
 static void
-_hd_launcher_grid_count_children_and_rows (HdLauncherGrid *grid,
-                                           guint *children,
-                                           guint *rows)
+hd_launcher_grid_window_for (HdLauncherGrid *grid, gboolean portrait,
+                             gint *visible_first, gint *visible_last,
+                             gint *first, gint *last)
 {
-  HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID_GET_PRIVATE (grid);
-  GList *l;
+  HdLauncherGridPrivate *priv = grid->priv;
+  gint rows, pitch, y;
+  guint columns, screen_height;
+
+  columns = hd_launcher_grid_columns_for (portrait);
+  rows = (priv->n_tiles + columns - 1) / columns;
+  pitch = HD_LAUNCHER_TILE_HEIGHT + (portrait
+                                     ? HD_LAUNCHER_GRID_ROW_SPACING_PORTRAIT
+                                     : HD_LAUNCHER_GRID_ROW_SPACING_LANDSCAPE);
+  screen_height = portrait
+    ? HD_COMP_MGR_PORTRAIT_HEIGHT : HD_COMP_MGR_LANDSCAPE_HEIGHT;
+  y = priv->v_adjustment ? tidy_adjustment_get_value (priv->v_adjustment) : 0;
+  y -= hd_launcher_grid_top_for (portrait);
+
+  *visible_first = MAX (y, 0) / pitch;
+  *visible_last = MAX (y + (gint)screen_height, 0) / pitch;
+  *first = MAX (*visible_first - HD_LAUNCHER_GRID_OVERSCAN_ROWS, 0);
+  *last  = MIN (*visible_last + HD_LAUNCHER_GRID_OVERSCAN_ROWS, rows - 1);
+}
 
-  *children = 0;
-  for (l = priv->tiles; l != NULL; l = l->next)
-    {
-      ClutterActor *child = l->data;
+/* Positions the @nth tile. */
+static void
+hd_launcher_grid_place_tile (HdLauncherGrid *grid, ClutterActor *tile,
+                             guint nth)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns = hd_launcher_grid_columns (grid);
+  guint icons_width, x, y;
 
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          ++(*children);
-        }
-    }
+  /* Figure out the starting X position needed to centre the icons */
+  icons_width = HD_LAUNCHER_TILE_WIDTH * columns + priv->h_spacing * (columns-1);
+  if (hd_launcher_grid_is_portrait (grid))
+    x = (HD_LAUNCHER_PAGE_HEIGHT - icons_width) / 2;
+  else
+    x = (HD_LAUNCHER_PAGE_WIDTH - icons_width) / 2;
+
+  x += (nth % columns) * (HD_LAUNCHER_TILE_WIDTH + priv->h_spacing);
+  y  = hd_launcher_grid_top (grid)
+    + (nth / columns) * (HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing);
+  clutter_actor_set_position (tile, x, y);
+}
+
+/* Adds a 'blocker' actor under @row that will grab the clicks that
+ * would have gone between it and the next row and dismissed the
+ * launcher. */
+static void
+hd_launcher_grid_add_blocker (HdLauncherGrid *grid, guint row)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  ClutterActor *blocker = clutter_group_new();
+  guint y;
+
+  y = hd_launcher_grid_top (grid)
+    + row * (HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing)
+    + HD_LAUNCHER_TILE_HEIGHT;
+
+  clutter_actor_set_name(blocker, "HdLauncherGrid::blocker");
+  clutter_actor_show(blocker);
+  clutter_container_add_actor(CLUTTER_CONTAINER(grid), blocker);
+  clutter_actor_set_reactive(blocker, TRUE);
+  g_signal_connect (blocker, "button-release-event",
+                    G_CALLBACK (_hd_launcher_grid_blocker_release_cb),
+                    NULL);
 
-  if (*children > 0)
+  if (hd_launcher_grid_is_portrait (grid))
     {
-      if (hd_launcher_grid_is_portrait (grid))
-        *rows = (*children / HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT) +
-          (*children % HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT ? 1 : 0);
-      else
-        *rows = (*children / HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE) +
-          (*children % HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE ? 1 : 0);
+      clutter_actor_set_position(blocker, HD_LAUNCHER_BOTTOM_MARGIN, y);
+      clutter_actor_set_size(blocker,
+          HD_LAUNCHER_GRID_WIDTH_PORTRAIT -
+          (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_PORTRAIT +
+           HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_PORTRAIT),
+          priv->v_spacing);
     }
   else
     {
-      *rows = 0;
+      clutter_actor_set_position(blocker, HD_LAUNCHER_LEFT_MARGIN, y);
+      clutter_actor_set_size(blocker,
+          HD_LAUNCHER_GRID_WIDTH_LANDSCAPE -
+          (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_LANDSCAPE +
+           HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_LANDSCAPE),
+          priv->v_spacing);
     }
+  priv->blockers = g_list_prepend(priv->blockers, blocker);
 }
 
-
-/**
- * Allocates a number of tiles in a row, starting at cur_y.
- * Returns the remaining children list (ie still to allocate).
+/*
+ * Only the tiles in the rows which can be seen, and a few more around
+ * them (the window), are shown and have their icon and label loaded.
+ * The rest are hidden and empty, so a category with hundreds of
+ * applications costs about as much as one with a screenful.
  *
- * @grid: the HdLauncherGrid instance
- * @l: list of tiles still to be inserted in the layout
- * @remaining is a memory address containing a pointer to the number of
- * children still to insert into the grid.
- * @cur_y: the current y position of the grid, from where to begin placing
- * tiles
- * @h_spacing is the icon horizonal spacing.
+ * The window is warmed up in the background: the icons are decoded by
+ * worker threads as soon as the tiles enter it, then they are uploaded
+ * one by one in idle time, along with their labels, which are rendered
+ * by hd_clutter_cache_get_label().  So by the time the page transitions
+ * in, even for the first time after boot or a theme change, there's
+ * nothing left to do.
  */
-static GList *
-_hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
-                                GList *l,
-                                guint *remaining,
-                                guint cur_y,
-                                guint h_spacing)
+
+/* Loads the next tile of the window which isn't loaded yet.
+ * Returns FALSE if there was nothing to do. */
+static gboolean
+hd_launcher_grid_load_next (HdLauncherGrid *grid)
 {
-  ClutterActor *child;
-  guint allocated;
-  guint cur_x;
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns = hd_launcher_grid_columns (grid);
+  GList *l;
 
-  /* Figure out the starting X position needed to centre the icons */
-  if (hd_launcher_grid_is_portrait (grid))
+  if (priv->first_row > priv->last_row)
+    return FALSE;
+
+  if (!priv->load_cursor)
     {
-      guint icons_width = HD_LAUNCHER_TILE_WIDTH * HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT +
-                            h_spacing * (HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT-1);
+      priv->load_index = priv->first_row * columns;
+      priv->load_cursor = g_list_nth (priv->tiles, priv->load_index);
+    }
 
-      cur_x = (HD_LAUNCHER_PAGE_HEIGHT - icons_width) / 2;
-      allocated = MIN (HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT, *remaining);
+  while ((l = priv->load_cursor) != NULL
+         && (gint)(priv->load_index / columns) <= priv->last_row)
+    {
+      priv->load_cursor = l->next;
+      priv->load_index++;
+      if (!hd_launcher_tile_is_loaded (l->data))
+        {
+          hd_launcher_tile_set_loaded (l->data, TRUE);
+          return TRUE;
+        }
     }
-  else
+
+  return FALSE;
+}
+
+static gboolean
+hd_launcher_grid_load_step (gpointer data)
+{
+  HdLauncherGrid *grid = data;
+
+  if (hd_launcher_grid_load_next (grid))
+    return TRUE;
+
+  grid->priv->load_work = 0;
+  return FALSE;
+}
+
+/* Loads all tiles of the window now. */
+static void
+hd_launcher_grid_load_window (HdLauncherGrid *grid)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+
+  if (priv->load_work)
     {
-      guint icons_width = HD_LAUNCHER_TILE_WIDTH * HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE +
-                            h_spacing * (HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE-1);
+      hd_idle_work_remove (priv->load_work);
+      priv->load_work = 0;
+    }
+  while (hd_launcher_grid_load_next (grid))
+    ;
+}
 
-      cur_x = (HD_LAUNCHER_PAGE_WIDTH - icons_width) / 2;
-      allocated = MIN (HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE, *remaining);
+/* Works out which rows should be shown at the current scroll position
+ * and shows, hides, loads and unloads tiles accordingly.  If not
+ * @force, the tiles are known to be where they were last time and only
+ * those moving in or out of the window are touched. */
+static void
+hd_launcher_grid_update_window (HdLauncherGrid *grid, gboolean force)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  gint first, last, visible_first, visible_last, rows, i;
+  guint columns;
+  gboolean pending = FALSE;
+  GList *l;
+
+  columns = hd_launcher_grid_columns (grid);
+  rows = hd_launcher_grid_count_rows (grid);
+  hd_launcher_grid_window_for (grid, hd_launcher_grid_is_portrait (grid),
+                               &visible_first, &visible_last, &first, &last);
+
+  /* Leave the window alone until the rows next to the visible ones
+   * aren't in it anymore, then make room for some more scrolling. */
+  if (!force
+      && priv->first_row <= MAX (visible_first - 1, 0)
+      && priv->last_row  >= MIN (visible_last + 1, rows - 1))
+    return;
+
+  if (force)
+    {
+      i = 0;
+      l = priv->tiles;
+    }
+  else
+    {
+      /* Only the rows in the old or the new window can change. */
+      i = MIN (first, priv->first_row) * columns;
+      l = g_list_nth (priv->tiles, i);
     }
 
-  /* for each icon in the row... */
-  for (int i = 0; i < allocated; i++)
+  for (; l; l = l->next, i++)
     {
-      child = l->data;
+      ClutterActor *tile = l->data;
+      gint row = i / columns;
+      gboolean was_in = row >= priv->first_row && row <= priv->last_row;
 
-      clutter_actor_set_position(child, cur_x, cur_y);
-      cur_x += HD_LAUNCHER_TILE_WIDTH + h_spacing;
+      if (!force && row > last && row > priv->last_row)
+        break;
 
-      l = l->next;
+      if (row >= first && row <= last)
+        {
+          if (force || !was_in)
+            {
+              hd_launcher_grid_place_tile (grid, tile, i);
+              /* It may have been hidden in the middle of a transition. */
+              clutter_actor_set_depthu (tile, 0);
+              clutter_actor_set_opacity (tile, 255);
+              clutter_actor_show (tile);
+            }
+          if (!hd_launcher_tile_is_loaded (HD_LAUNCHER_TILE (tile)))
+            {
+              hd_launcher_tile_prefetch (HD_LAUNCHER_TILE (tile));
+              pending = TRUE;
+            }
+        }
+      else if (force || was_in)
+        {
+          clutter_actor_hide (tile);
+          hd_launcher_tile_set_loaded (HD_LAUNCHER_TILE (tile), FALSE);
+        }
     }
-  *remaining -= allocated;
-  return l;
+
+  /* The blockers are only needed between the rows we show. */
+  g_list_foreach(priv->blockers,
+                 (GFunc)clutter_actor_destroy,
+                 NULL);
+  g_list_free(priv->blockers);
+  priv->blockers = NULL;
+  for (i = first; i < last; i++)
+    hd_launcher_grid_add_blocker (grid, i);
+
+  priv->first_row = first;
+  priv->last_row = last;
+  priv->load_cursor = NULL;
+
+  if (pending && !priv->load_work)
+    priv->load_work = hd_idle_work_add (hd_launcher_grid_load_step, NULL,
+                                        grid, NULL);
 }
 
 /* hd_launcher_grid_layout:
@@ -488,71 +721,11 @@ _hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
 void hd_launcher_grid_layout (HdLauncherGrid *grid)
 {
   HdLauncherGridPrivate *priv = grid->priv;
-  GList *l;
-  guint cur_height, n_visible_launchers, n_rows;
+  guint cur_height;
 
-  /* Free our list of 'blocker' actors that we use to block mouse clicks.
-   * TODO: just check we have 'nrows' worth */
-  g_list_foreach(priv->blockers,
-                 (GFunc)clutter_actor_destroy,
-                 NULL);
-  g_list_free(priv->blockers);
-  priv->blockers = NULL;
-
-  _hd_launcher_grid_count_children_and_rows (grid,
-      &n_visible_launchers, &n_rows);
-
-  if (hd_launcher_grid_is_portrait (grid))
-    cur_height = HD_LAUNCHER_PAGE_XMARGIN;
-  else
-    cur_height = HD_LAUNCHER_PAGE_YMARGIN;
-
-  l = priv->tiles;
-  while (l) {
-    /* Allocate all icons on this row */
-    l = _hd_launcher_grid_layout_row(grid, l, &n_visible_launchers,
-                                       cur_height, priv->h_spacing);
-    if (l)
-      {
-        /* If there is another row, we must create an actor that
-         * goes between the two rows that will grab the clicks that
-         * would have gone between them and dismissed the launcher  */
-        ClutterActor *blocker = clutter_group_new();
-        clutter_actor_set_name(blocker, "HdLauncherGrid::blocker");
-        clutter_actor_show(blocker);
-        clutter_container_add_actor(CLUTTER_CONTAINER(grid), blocker);
-        clutter_actor_set_reactive(blocker, TRUE);
-        g_signal_connect (blocker, "button-release-event",
-                          G_CALLBACK (_hd_launcher_grid_blocker_release_cb),
-                          NULL);
-
-        if (hd_launcher_grid_is_portrait (grid))
-          {
-            clutter_actor_set_position(blocker,
-                HD_LAUNCHER_BOTTOM_MARGIN,
-                cur_height + HD_LAUNCHER_TILE_HEIGHT);
-            clutter_actor_set_size(blocker,
-                HD_LAUNCHER_GRID_WIDTH_PORTRAIT -
-                (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_PORTRAIT +
-                 HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_PORTRAIT),
-                priv->v_spacing);
-          }
-        else
-          {
-            clutter_actor_set_position(blocker,
-                HD_LAUNCHER_LEFT_MARGIN,
-                cur_height + HD_LAUNCHER_TILE_HEIGHT);
-            clutter_actor_set_size(blocker,
-                HD_LAUNCHER_GRID_WIDTH_LANDSCAPE -
-                (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_LANDSCAPE +
-                 HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_LANDSCAPE),
-                priv->v_spacing);
-          }
-        priv->blockers = g_list_prepend(priv->blockers, blocker);
-      }
-
-    cur_height += HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing;
-  }
+  cur_height = hd_launcher_grid_top (grid)
+    + hd_launcher_grid_count_rows (grid)
+      * (HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing);
 
   if (hd_launcher_grid_is_portrait (grid))
     clutter_actor_set_size(CLUTTER_ACTOR(grid),
@@ -569,6 +742,103 @@ void hd_launcher_grid_layout (HdLauncherGrid *grid)
 
   if (priv->v_adjustment)
     hd_launcher_grid_refresh_v_adjustment (grid);
+
+  hd_launcher_grid_update_window (grid, TRUE);
+}
+
+static gboolean
+hd_launcher_grid_prepare_step (gpointer data)
+{
+  HdLauncherGrid *grid = data;
+  HdLauncherGridPrivate *priv = grid->priv;
+  GList *l;
+
+  if (!priv->prepare_cursor)
+    priv->prepare_cursor = g_list_nth (priv->tiles, priv->prepare_next);
+
+  if (priv->prepare_next <= priv->prepare_end
+      && (l = priv->prepare_cursor) != NULL)
+    {
+      hd_launcher_tile_prepare (l->data);
+      priv->prepare_cursor = l->next;
+      priv->prepare_next++;
+      return TRUE;
+    }
+
+  priv->prepare_work = 0;
+  return FALSE;
+}
+
+/* hd_launcher_grid_prepare_orientation:
+ * @grid: launcher's grid
+ * @portrait: the orientation the screen may be rotated to
+ *
+ * Gets the tiles which would be shown if @grid were laid out @portrait
+ * but aren't loaded ready in the background, so that the layout after
+ * the rotation only needs to upload them.  If it doesn't rotate after
+ * all, hd_launcher_grid_cancel_prepare() lets go of them.
+ */
+void
+hd_launcher_grid_prepare_orientation (HdLauncherGrid *grid,
+                                      gboolean portrait)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  gint first, last, visible_first, visible_last;
+  guint columns;
+
+  /* What was prepared for the other orientation is no use anymore. */
+  if (priv->prepared && priv->prepare_portrait != portrait)
+    hd_launcher_grid_cancel_prepare (grid);
+  if (portrait == hd_launcher_grid_is_portrait (grid) || !priv->n_tiles)
+    return;
+
+  columns = hd_launcher_grid_columns_for (portrait);
+  hd_launcher_grid_window_for (grid, portrait,
+                               &visible_first, &visible_last, &first, &last);
+  priv->prepare_next = first * columns;
+  priv->prepare_end  = (last + 1) * columns - 1;
+  priv->prepare_cursor = NULL;
+  priv->prepared = TRUE;
+  priv->prepare_portrait = portrait;
+  if (!priv->prepare_work)
+    priv->prepare_work = hd_idle_work_add (hd_launcher_grid_prepare_step,
+                                           NULL, grid, NULL);
+}
+
+/* hd_launcher_grid_cancel_prepare:
+ * @grid: launcher's grid
+ *
+ * The rotation hd_launcher_grid_prepare_orientation() was called for
+ * won't happen after all.  Stops preparing and lets go of the icons
+ * decoded for tiles which aren't in the window.
+ */
+void
+hd_launcher_grid_cancel_prepare (HdLauncherGrid *grid)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns;
+  GList *l;
+  gint i;
+
+  if (priv->prepare_work)
+    {
+      hd_idle_work_remove (priv->prepare_work);
+      priv->prepare_work = 0;
+    }
+  if (!priv->prepared)
+    return;
+  priv->prepared = FALSE;
+
+  /* The tiles of the window will be loaded, and unloading the others
+   * only drops what they've prefetched. */
+  columns = hd_launcher_grid_columns (grid);
+  for (l = priv->tiles, i = 0; l; l = l->next, i++)
+    {
+      gint row = i / columns;
+
+      if (row < priv->first_row || row > priv->last_row)
+        hd_launcher_tile_set_loaded (l->data, FALSE);
+    }
 }
 
 static void
@@ -576,6 +846,18 @@ hd_launcher_grid_dispose (GObject *gobject)
 {
   HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID (gobject)->priv;
 
+  if (priv->prepare_work)
+    {
+      hd_idle_work_remove (priv->prepare_work);
+      priv->prepare_work = 0;
+    }
+
+  if (priv->load_work)
+    {
+      hd_idle_work_remove (priv->load_work);
+      priv->load_work = 0;
+    }
+
   g_list_foreach (priv->tiles,
                   (GFunc) clutter_actor_destroy,
                   NULL);
@@ -728,6 +1010,8 @@ hd_launcher_grid_init (HdLauncherGrid *launcher)
 
   /* set grid's orientation and h/v_spacing values to landscape by default */
   hd_launcher_grid_set_portrait (launcher, FALSE);
+  priv->first_row = 0;
+  priv->last_row = -1;
 
   clutter_actor_set_reactive (CLUTTER_ACTOR (launcher), FALSE);
 
@@ -764,6 +1048,16 @@ hd_launcher_grid_clear (HdLauncherGrid *grid)
     }
 }
 
+/* Reorders the tiles of @grid by @func, for the next layout. */
+void
+hd_launcher_grid_sort_tiles (HdLauncherGrid *grid, GCompareFunc func)
+{
+  g_return_if_fail (HD_IS_LAUNCHER_GRID (grid));
+
+  grid->priv->tiles = g_list_sort (grid->priv->tiles, func);
+  grid->priv->load_cursor = grid->priv->prepare_cursor = NULL;
+}
+
 /* Reset the grid before it is shown */
 void
 hd_launcher_grid_reset(HdLauncherGrid *grid, gboolean hard)
@@ -828,6 +1122,9 @@ hd_launcher_grid_transition_begin(HdLauncherGrid *grid,
 
       if (priv->v_adjustment)
         tidy_adjustment_set_valuex (priv->v_adjustment, 0);
+
+      /* Don't let the icons pop in while we're coming in. */
+      hd_launcher_grid_load_window (grid);
     }
 }
 
@@ -885,7 +1182,8 @@ hd_launcher_grid_transition(HdLauncherGrid *grid,
     {
       ClutterActor *child = l->data;
       l = l->next;
-      if (HD_IS_LAUNCHER_TILE(child))
+      /* Those out of the window will be reset when they're shown. */
+      if (HD_IS_LAUNCHER_TILE(child) && CLUTTER_ACTOR_IS_VISIBLE(child))
       {
         HdLauncherTile *tile = HD_LAUNCHER_TILE(child);
         ClutterActor *tile_icon = 0;
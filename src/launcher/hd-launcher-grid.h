@@ -65,6 +65,8 @@ GType         hd_launcher_grid_get_type (void) G_GNUC_CONST;
 ClutterActor *hd_launcher_grid_new      (void);
 
 void          hd_launcher_grid_clear    (HdLauncherGrid *grid);
+void          hd_launcher_grid_sort_tiles (HdLauncherGrid *grid,
+                                           GCompareFunc    func);
 void          hd_launcher_grid_reset_v_adjustment (HdLauncherGrid *grid);
 
 void          hd_launcher_grid_transition_begin(HdLauncherGrid *grid,
@@ -79,6 +81,9 @@ void          hd_launcher_grid_layout(HdLauncherGrid *grid);
 void          hd_launcher_grid_relayout (HdLauncherGrid *grid);
 void          hd_launcher_grid_set_portrait (HdLauncherGrid *self,
                                           gboolean portraited);
+void          hd_launcher_grid_prepare_orientation (HdLauncherGrid *grid,
+                                                 gboolean portrait);
+void          hd_launcher_grid_cancel_prepare (HdLauncherGrid *grid);
 
 
 void hd_launcher_grid_activate(ClutterActor *actor, int p);
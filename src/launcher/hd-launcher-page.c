@@ -530,6 +530,25 @@ ClutterFixed hd_launcher_page_get_scroll_y(HdLauncherPage *page)
   return tidy_adjustment_get_valuex( adjust );
 }
 
+/* Scrolls by @dy pixels without kinetics, as far as it can go. */
+void hd_launcher_page_scroll_by(HdLauncherPage *page, gint dy)
+{
+  HdLauncherPagePrivate *priv;
+  ClutterActor *bar;
+  TidyAdjustment *adjust;
+
+  if (!HD_IS_LAUNCHER_PAGE(page))
+    return;
+
+  priv = HD_LAUNCHER_PAGE_GET_PRIVATE (page);
+
+  tidy_finger_scroll_stop (TIDY_FINGER_SCROLL(priv->scroller));
+  bar = tidy_scroll_view_get_vscroll_bar (TIDY_SCROLL_VIEW(priv->scroller));
+  adjust = tidy_scroll_bar_get_adjustment (TIDY_SCROLL_BAR(bar));
+  tidy_adjustment_set_value (adjust,
+                             tidy_adjustment_get_value (adjust) + dy);
+}
+
 ClutterActor *hd_launcher_page_get_scroller(HdLauncherPage *page)
 {
   return page->priv->scroller;
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 
 #include "hd-gtk-style.h"
+#include "hd-clutter-cache.h"
 #include "tidy/tidy-highlight.h"
 #include "hd-transition.h"
 
@@ -49,6 +50,23 @@
 
 #define HD_LAUNCHER_TILE_LONG_PRESS_DUR (1000)
 
+/* How many threads decode icons for hd_launcher_tile_prefetch(). */
+#define HD_LAUNCHER_TILE_DECODE_THREADS (2)
+
+/* An icon being decoded by a worker thread.  Only @lock protects
+ * anything; @tile is only touched in the main thread. */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gboolean done;
+
+  gchar *fname;
+  GdkPixbuf *pixbuf;
+
+  HdLauncherTile *tile; /* NULL if it doesn't want it anymore */
+} HdLauncherTileDecode;
+
 struct _HdLauncherTilePrivate
 {
   gchar *icon_name;
@@ -67,6 +85,14 @@ struct _HdLauncherTilePrivate
   /* We need to know if there's been scrolling. */
   guint    press_timeout;
   gboolean is_pressed;
+
+  /* Whether the icon and the label are there, see set_loaded(). */
+  gboolean loaded;
+
+  /* The icon from hd_launcher_tile_prefetch(), while it's being
+   * decoded and when it's done. */
+  HdLauncherTileDecode *decode;
+  GdkPixbuf *icon_pixbuf;
 };
 
 enum
@@ -87,6 +113,10 @@ enum
 
 static guint launcher_tile_signals[LAST_SIGNAL] = { 0, };
 
+/* How many tiles hold a prefetched icon, see
+ * hd_launcher_tile_count_prefetched(). */
+static guint Prefetched;
+
 /* Forward declarations */
 /*   GObject */
 static void hd_launcher_tile_dispose (GObject *gobject);
@@ -109,6 +139,10 @@ static void hd_launcher_on_glow_frame(ClutterTimeline *timeline,
 static void hd_launcher_tile_allocate (ClutterActor          *self,
                                        const ClutterActorBox *box,
                                        gboolean       absolute_origin_changed);
+static void hd_launcher_tile_load_icon (HdLauncherTile *tile);
+static void hd_launcher_tile_drop_prefetch (HdLauncherTile *tile);
+static ClutterActor *hd_launcher_tile_new_label (HdLauncherTile *tile);
+static void hd_launcher_tile_load_label (HdLauncherTile *tile);
 
 G_DEFINE_TYPE_WITH_CODE (HdLauncherTile,
                          hd_launcher_tile,
@@ -281,10 +315,6 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
                                 const gchar *icon_name)
 {
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
-  GtkIconTheme *icon_theme;
-  GdkPixbuf *pixbuf;
-  GtkIconInfo *info = NULL;
-  const gchar *fname;
 
   if (priv->icon_name)
     {
@@ -296,65 +326,81 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
     /* Set the default if none was passed. */
     priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
 
-  fname = priv->icon_name;
+  hd_launcher_tile_drop_prefetch (tile);
+  if (priv->loaded)
+    hd_launcher_tile_load_icon (tile);
+}
 
-  /* Recreate the icon actor */
-  if (priv->icon)
-    {
-      clutter_actor_destroy (priv->icon);
-      priv->icon = NULL;
-    }
+/* Finds the file of our icon and returns it, or NULL, after which
+ * there's no point trying again. */
+static gchar *
+hd_launcher_tile_lookup_icon (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  GtkIconTheme *icon_theme;
+  GtkIconInfo *info = NULL;
+  gchar *fname;
+
+  /* It failed to load before. */
+  if (!priv->icon_name)
+    return NULL;
 
   /* The desktop file contains path to the icon. */
-  if (g_file_test (fname, G_FILE_TEST_EXISTS)
+  if (g_file_test (priv->icon_name, G_FILE_TEST_EXISTS)
         && (g_strrstr (priv->icon_name, ".png") != NULL))
+    return g_strdup (priv->icon_name);
+
+  /* Try to get the 64x64 icon. */
+  icon_theme = gtk_icon_theme_get_default();
+  info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
+                                    HD_LAUNCHER_TILE_ICON_REAL_SIZE,
+                                    GTK_ICON_LOOKUP_NO_SVG);
+
+  if (info == NULL)
     {
-      fname = priv->icon_name;
+      /* Try to get the Harmattan (80x80) icon. The icon will be scaled 
+       * down to 64x64. */
+      info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
+                                        HD_LAUNCHER_TILE_ICON_REAL_SIZE_HARMATTAN_COMP,
+                                        GTK_ICON_LOOKUP_NO_SVG);
     }
-  else
+
+  if (info == NULL)
     {
-      /* Try to get the 64x64 icon. */
-      icon_theme = gtk_icon_theme_get_default();
+      /* Try to get the default icon. */
+      g_free (priv->icon_name);
+      priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
       info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
                                         HD_LAUNCHER_TILE_ICON_REAL_SIZE,
                                         GTK_ICON_LOOKUP_NO_SVG);
+    }
+
+  if (info == NULL)
+    {
+      g_warning ("%s: couldn't find icon %s\n", __FUNCTION__, priv->icon_name);
+      g_free (priv->icon_name); 
+      priv->icon_name = NULL;
+      return NULL;
+    }
 
-      if (info == NULL)
-        {
-          /* Try to get the Harmattan (80x80) icon. The icon will be scaled 
-           * down to 64x64. */
-          info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
-                                            HD_LAUNCHER_TILE_ICON_REAL_SIZE_HARMATTAN_COMP,
-                                            GTK_ICON_LOOKUP_NO_SVG);
-        }
-
-      if (info == NULL)
-        {
-          /* Try to get the default icon. */
-          g_free (priv->icon_name);
-          priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
-          info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
-                                            HD_LAUNCHER_TILE_ICON_REAL_SIZE,
-                                            GTK_ICON_LOOKUP_NO_SVG);
-        }
-
-      if (info == NULL)
-        {
-          g_warning ("%s: couldn't find icon %s\n", __FUNCTION__, priv->icon_name);
-          g_free (priv->icon_name); 
-          priv->icon_name = NULL;
-          return;
-        }
-
-      fname = gtk_icon_info_get_filename(info);
-      if (fname == NULL)
-        {
-          g_warning ("%s: couldn't get icon %s\n", __FUNCTION__, priv->icon_name);
-          g_free (priv->icon_name);
-          priv->icon_name = NULL;
-          return;
-        }
+  fname = g_strdup (gtk_icon_info_get_filename(info));
+  gtk_icon_info_free(info);
+  if (fname == NULL)
+    {
+      g_warning ("%s: couldn't get icon %s\n", __FUNCTION__, priv->icon_name);
+      g_free (priv->icon_name);
+      priv->icon_name = NULL;
     }
+  return fname;
+}
+
+/* Loads @fname as an icon.  Doesn't touch anything but its arguments,
+ * so it's safe to call from any thread. */
+static GdkPixbuf *
+hd_launcher_tile_decode_icon (const gchar *fname)
+{
+  GdkPixbuf *pixbuf, *pixbufb;
+  gint w, h;
 
   /* We must expand these images so there is a 1 pixel transparent
    * border around them, or the glow effect won't work properly. We use
@@ -362,35 +408,218 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
    * isn't actually guaranteed to be the correct size.  */
   pixbuf = gdk_pixbuf_new_from_file_at_size(fname,
       HD_LAUNCHER_TILE_ICON_REAL_SIZE, HD_LAUNCHER_TILE_ICON_REAL_SIZE, 0);
+  if (!pixbuf)
+    return NULL;
+
+  w = gdk_pixbuf_get_width(pixbuf);
+  h = gdk_pixbuf_get_height(pixbuf);
+  pixbufb = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, w+2, h+2);
+
+  gdk_pixbuf_fill(pixbufb, 0);
+  gdk_pixbuf_copy_area(pixbuf, 0, 0, w, h,
+                       pixbufb, 1, 1);
+  g_object_unref(pixbuf);
+  return pixbufb;
+}
 
-  if (pixbuf)
+/* Runs in the main thread after hd_launcher_tile_decode_thread(). */
+static gboolean
+hd_launcher_tile_decode_done (gpointer data)
+{
+  HdLauncherTileDecode *decode = data;
+
+  if (decode->tile)
+    {
+      HdLauncherTilePrivate *priv =
+        HD_LAUNCHER_TILE_GET_PRIVATE (decode->tile);
+
+      priv->decode = NULL;
+      priv->icon_pixbuf = decode->pixbuf;
+      if (!priv->icon_pixbuf)
+        /* Nothing to hold on to after all. */
+        Prefetched--;
+    }
+  else if (decode->pixbuf)
+    g_object_unref (decode->pixbuf);
+
+  g_free (decode->fname);
+  g_mutex_clear (&decode->lock);
+  g_cond_clear (&decode->cond);
+  g_slice_free (HdLauncherTileDecode, decode);
+  return FALSE;
+}
+
+static void
+hd_launcher_tile_decode_thread (gpointer data, gpointer unused)
+{
+  HdLauncherTileDecode *decode = data;
+  GdkPixbuf *pixbuf;
+
+  pixbuf = hd_launcher_tile_decode_icon (decode->fname);
+
+  g_mutex_lock (&decode->lock);
+  decode->pixbuf = pixbuf;
+  decode->done = TRUE;
+  g_cond_signal (&decode->cond);
+  g_mutex_unlock (&decode->lock);
+
+  g_idle_add (hd_launcher_tile_decode_done, decode);
+}
+
+/* Forgets about the prefetched icon, eg. because it's a different one
+ * now. */
+static void
+hd_launcher_tile_drop_prefetch (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  if (priv->decode || priv->icon_pixbuf)
+    Prefetched--;
+  if (priv->decode)
+    {
+      /* hd_launcher_tile_decode_done() will free it. */
+      priv->decode->tile = NULL;
+      priv->decode = NULL;
+    }
+  if (priv->icon_pixbuf)
+    {
+      g_object_unref (priv->icon_pixbuf);
+      priv->icon_pixbuf = NULL;
+    }
+}
+
+/* Returns the prefetched icon, waiting for it if it's being decoded,
+ * or NULL if there isn't one. */
+static GdkPixbuf *
+hd_launcher_tile_take_prefetch (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  GdkPixbuf *pixbuf;
+
+  if (priv->decode || priv->icon_pixbuf)
+    Prefetched--;
+  if (priv->decode)
     {
-      gint w = gdk_pixbuf_get_width(pixbuf);
-      gint h = gdk_pixbuf_get_height(pixbuf);
-      GdkPixbuf *pixbufb = gdk_pixbuf_new(
-          GDK_COLORSPACE_RGB, TRUE, 8, w+2, h+2);
+      HdLauncherTileDecode *decode = priv->decode;
+
+      g_mutex_lock (&decode->lock);
+      while (!decode->done)
+        g_cond_wait (&decode->cond, &decode->lock);
+      g_mutex_unlock (&decode->lock);
+
+      priv->icon_pixbuf = decode->pixbuf;
+      decode->pixbuf = NULL;
+      decode->tile = NULL;
+      priv->decode = NULL;
+    }
+
+  pixbuf = priv->icon_pixbuf;
+  priv->icon_pixbuf = NULL;
+  return pixbuf;
+}
 
-      gdk_pixbuf_fill(pixbufb, 0);
-      gdk_pixbuf_copy_area(pixbuf, 0, 0, w, h,
-                           pixbufb, 1, 1);
+/* hd_launcher_tile_prefetch:
+ * @tile: the tile which will be loaded soon
+ *
+ * Starts decoding the icon of @tile in a worker thread, so
+ * hd_launcher_tile_set_loaded() only has to upload it.
+ */
+void
+hd_launcher_tile_prefetch (HdLauncherTile *tile)
+{
+  static GThreadPool *pool;
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  HdLauncherTileDecode *decode;
+  gchar *fname;
 
+  if (priv->loaded || priv->decode || priv->icon_pixbuf)
+    return;
+
+  /* GtkIconTheme is not thread-safe, only the decoding is done
+   * elsewhere. */
+  if (!(fname = hd_launcher_tile_lookup_icon (tile)))
+    return;
+
+  if (!pool)
+    pool = g_thread_pool_new (hd_launcher_tile_decode_thread, NULL,
+                              HD_LAUNCHER_TILE_DECODE_THREADS, FALSE, NULL);
+
+  decode = g_slice_new0 (HdLauncherTileDecode);
+  g_mutex_init (&decode->lock);
+  g_cond_init (&decode->cond);
+  decode->fname = fname;
+  decode->tile = tile;
+  priv->decode = decode;
+  Prefetched++;
+  g_thread_pool_push (pool, decode, NULL);
+}
+
+/* Returns how many tiles hold an icon hd_launcher_tile_prefetch()ed
+ * for them, decoded or not, which they haven't loaded yet. */
+guint
+hd_launcher_tile_count_prefetched (void)
+{
+  return Prefetched;
+}
+
+/* hd_launcher_tile_prepare:
+ * @tile: a tile which may be loaded soon
+ *
+ * Like hd_launcher_tile_prefetch(), but also renders the label, which
+ * the label cache keeps for hd_launcher_tile_set_loaded() for a while.
+ */
+void
+hd_launcher_tile_prepare (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  if (priv->loaded)
+    return;
+
+  hd_launcher_tile_prefetch (tile);
+  clutter_actor_destroy (hd_launcher_tile_new_label (tile));
+}
+
+static void
+hd_launcher_tile_load_icon (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  GdkPixbuf *pixbuf;
+  gchar *fname;
+
+  /* Recreate the icon actor */
+  if (priv->icon)
+    {
+      clutter_actor_destroy (priv->icon);
+      priv->icon = NULL;
+    }
+
+  if (!(pixbuf = hd_launcher_tile_take_prefetch (tile)))
+    {
+      if (!(fname = hd_launcher_tile_lookup_icon (tile)))
+        return;
+      pixbuf = hd_launcher_tile_decode_icon (fname);
+      g_free (fname);
+    }
+
+  if (pixbuf)
+    {
       priv->icon = clutter_texture_new();
       clutter_texture_set_from_rgb_data(
           CLUTTER_TEXTURE(priv->icon),
-          gdk_pixbuf_get_pixels(pixbufb),
-          gdk_pixbuf_get_has_alpha(pixbufb),
-          gdk_pixbuf_get_width(pixbufb),
-          gdk_pixbuf_get_height(pixbufb),
-          gdk_pixbuf_get_rowstride(pixbufb),
-          gdk_pixbuf_get_n_channels(pixbufb), 0, 0);
-      g_object_unref(pixbufb);
+          gdk_pixbuf_get_pixels(pixbuf),
+          gdk_pixbuf_get_has_alpha(pixbuf),
+          gdk_pixbuf_get_width(pixbuf),
+          gdk_pixbuf_get_height(pixbuf),
+          gdk_pixbuf_get_rowstride(pixbuf),
+          gdk_pixbuf_get_n_channels(pixbuf), 0, 0);
+      g_object_unref(pixbuf);
     }
-  if (pixbuf)
-    g_object_unref(pixbuf);
 
   if (!priv->icon)
   {
-    g_warning ("%s: couldn't create texture for %s\n", __FUNCTION__, fname);
+    g_warning ("%s: couldn't create texture for %s\n", __FUNCTION__,
+               priv->icon_name);
     g_free (priv->icon_name);
     priv->icon_name = NULL;
     return;
@@ -419,19 +648,13 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
   clutter_actor_lower_bottom(CLUTTER_ACTOR(priv->icon_glow));
 
   clutter_actor_hide(CLUTTER_ACTOR(priv->icon_glow));
-
-  gtk_icon_info_free(info);
 }
 
 void
 hd_launcher_tile_set_text (HdLauncherTile *tile,
                            const gchar *text)
 {
-  ClutterColor text_color = {0xFF, 0xFF, 0xFF, 0xFF};
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
-  ClutterUnit label_width;
-  guint label_height, label_width_px;
-  gchar *tile_font = NULL;
 
   if (!text)
     return;
@@ -442,46 +665,55 @@ hd_launcher_tile_set_text (HdLauncherTile *tile,
     }
   priv->text = g_strdup (text);
 
+  if (priv->loaded)
+    hd_launcher_tile_load_label (tile);
+}
+
+static ClutterActor *
+hd_launcher_tile_new_label (HdLauncherTile *tile)
+{
+  ClutterColor text_color = {0xFF, 0xFF, 0xFF, 0xFF};
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  ClutterActor *label;
+  gchar *tile_font;
+
+  tile_font = hd_transition_get_string("task_nav", "tile_font", "Nokia Sans 15");
+
+  /* The same names come and go as the grid is scrolled and rebuilt,
+   * so let the cache lay them out and render them only once.  Too long
+   * names are broken up anywhere and the rest is clipped below. */
+  label = hd_clutter_cache_get_label (priv->text, tile_font,
+                                      &text_color,
+                                      HD_LAUNCHER_TILE_WIDTH,
+                                      PANGO_ELLIPSIZE_NONE);
+  g_free (tile_font);
+  return label;
+}
+
+static void
+hd_launcher_tile_load_label (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  guint label_height, label_width_px;
+
   /* Recreate the label actor */
   if (priv->label)
     {
       clutter_actor_destroy (priv->label);
     }
-
-  tile_font = hd_transition_get_string("task_nav", "tile_font", "Nokia Sans 15");
-
-  priv->label = clutter_label_new_full (tile_font, priv->text, &text_color);
-  g_free (tile_font);
-  clutter_actor_set_name(priv->label, "HdLauncherTile::label");
-
-  /* FIXME: This is a huge work-around because clutter/pango do not
-   * support setting ellipsize to NONE and wrap to FALSE.
-   */
-  clutter_label_set_line_wrap (CLUTTER_LABEL (priv->label), TRUE);
-  clutter_label_set_ellipsize (CLUTTER_LABEL (priv->label),
-                               PANGO_ELLIPSIZE_NONE);
-  clutter_label_set_alignment (CLUTTER_LABEL (priv->label),
-                               PANGO_ALIGN_CENTER);
-  clutter_label_set_line_wrap_mode (CLUTTER_LABEL (priv->label),
-                                    PANGO_WRAP_CHAR);
+  priv->label = hd_launcher_tile_new_label (tile);
 
   label_height = HD_LAUNCHER_TILE_HEIGHT - (64 + HILDON_MARGIN_HALF);
+  label_width_px = clutter_actor_get_width (priv->label);
 
-  clutter_actor_get_preferred_width (priv->label,
-    CLUTTER_UNITS_FROM_DEVICE(label_height),
-                              NULL, &label_width);
-  label_width_px = MIN (CLUTTER_UNITS_TO_DEVICE(label_width),
-                        HD_LAUNCHER_TILE_WIDTH);
-
-  clutter_actor_set_size(priv->label, label_width_px, label_height);
   clutter_actor_set_position(priv->label,
       (HD_LAUNCHER_TILE_WIDTH - label_width_px) / 2,
       HD_LAUNCHER_TILE_HEIGHT - label_height);
   clutter_container_add_actor (CLUTTER_CONTAINER(tile), priv->label);
 
-  if (CLUTTER_UNITS_TO_DEVICE(label_width) > HD_LAUNCHER_TILE_WIDTH)
+  if (clutter_actor_get_height (priv->label) > label_height)
     clutter_actor_set_clip (priv->label, 0, 0,
-                  HD_LAUNCHER_TILE_WIDTH, label_height);
+                  label_width_px, label_height);
 }
 
 static void
@@ -651,6 +883,7 @@ hd_launcher_tile_dispose (GObject *gobject)
 {
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (gobject);
 
+  hd_launcher_tile_drop_prefetch (HD_LAUNCHER_TILE (gobject));
   if (priv->press_timeout)
     {
       g_source_remove (priv->press_timeout);
@@ -719,6 +952,58 @@ hd_launcher_tile_allocate (ClutterActor          *self,
       self, box, absolute_origin_changed);
 }
 
+/* hd_launcher_tile_set_loaded:
+ * @tile: a launcher tile
+ * @loaded: whether @tile should have its icon and label
+ *
+ * New tiles only know the name of their icon and their text; the actors
+ * showing them are only created when the tile is loaded, and destroyed
+ * when it is unloaded again.  It's up to the grid to keep loaded only
+ * the tiles which can be seen.
+ */
+void
+hd_launcher_tile_set_loaded (HdLauncherTile *tile, gboolean loaded)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  /* It may have been prefetched and unloaded before it got loaded. */
+  if (!loaded)
+    hd_launcher_tile_drop_prefetch (tile);
+  if (priv->loaded == loaded)
+    return;
+  priv->loaded = loaded;
+
+  if (loaded)
+    {
+      hd_launcher_tile_load_icon (tile);
+      hd_launcher_tile_load_label (tile);
+      return;
+    }
+
+  hd_launcher_tile_reset (tile, TRUE);
+  if (priv->label)
+    {
+      clutter_actor_destroy (priv->label);
+      priv->label = NULL;
+    }
+  if (priv->icon_glow)
+    {
+      clutter_actor_destroy (CLUTTER_ACTOR (priv->icon_glow));
+      priv->icon_glow = NULL;
+    }
+  if (priv->icon)
+    {
+      clutter_actor_destroy (priv->icon);
+      priv->icon = NULL;
+    }
+}
+
+gboolean
+hd_launcher_tile_is_loaded (HdLauncherTile *tile)
+{
+  return HD_LAUNCHER_TILE_GET_PRIVATE (tile)->loaded;
+}
+
 /* Reset this tile to the state it should be in when first shown */
 void hd_launcher_tile_reset(HdLauncherTile *tile, gboolean hard)
 {
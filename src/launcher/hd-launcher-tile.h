@@ -74,6 +74,11 @@ void hd_launcher_tile_set_text      (HdLauncherTile *tile,
 ClutterActor *hd_launcher_tile_get_icon (HdLauncherTile *tile);
 ClutterActor *hd_launcher_tile_get_label (HdLauncherTile *tile);
 
+void hd_launcher_tile_set_loaded (HdLauncherTile *tile, gboolean loaded);
+gboolean hd_launcher_tile_is_loaded (HdLauncherTile *tile);
+void hd_launcher_tile_prefetch (HdLauncherTile *tile);
+guint hd_launcher_tile_count_prefetched (void);
+void hd_launcher_tile_prepare (HdLauncherTile *tile);
 void hd_launcher_tile_reset(HdLauncherTile *tile, gboolean hard);
 
 void hd_launcher_tile_activate(ClutterActor       *actor);
@@ -8,6 +8,7 @@
 #include "hd-gtk-style.h"
 
 #include <sys/stat.h>
+#include <locale.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,6 +49,10 @@ struct _HdLauncherTreePrivate
 
   WalkThreadData *active_walk;
 
+  /* The LC_MESSAGES the items were last read in, NULL until the
+   * first walk. */
+  gchar *locale;
+
   gboolean theme_changed_signal_connected : 1;
 };
 
@@ -286,6 +291,9 @@ hd_launcher_tree_finalize (GObject *gobject)
       priv->tree = NULL;
     }
 
+  g_free (priv->locale);
+  priv->locale = NULL;
+
   G_OBJECT_CLASS (hd_launcher_tree_parent_class)->finalize (gobject);
 }
 
@@ -338,6 +346,7 @@ hd_launcher_tree_handle_tree_changed (GMenuTree *menu_tree,
   HdLauncherTreePrivate *priv = HD_LAUNCHER_TREE_GET_PRIVATE (self);
   WalkThreadData *data;
   GMenuTreeDirectory *root;
+  const gchar *locale;
   GError *error = NULL;
 
   if (!gmenu_tree_load_sync (menu_tree, &error))
@@ -361,9 +370,15 @@ hd_launcher_tree_handle_tree_changed (GMenuTree *menu_tree,
       priv->active_walk->cancelled = TRUE;
       priv->active_walk = NULL;
     }
-  else
+
+  /* Only signal starting for the first walking and when every name
+   * has changed language.  Otherwise clients can merge the new items
+   * into what they have when we're finished. */
+  locale = setlocale (LC_MESSAGES, NULL);
+  if (g_strcmp0 (priv->locale, locale))
     {
-      /* Only signal starting for the first walking. */
+      g_free (priv->locale);
+      priv->locale = g_strdup (locale);
       g_signal_emit (self, tree_signals[STARTING], 0);
     }
 
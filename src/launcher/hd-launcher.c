@@ -52,6 +52,7 @@
 #include "hd-title-bar.h"
 #include "hd-transition.h"
 #include "hd-util.h"
+#include "hd-idle-work.h"
 #include "tidy/tidy-sub-texture.h"
 
 #include <hildon/hildon-banner.h>
@@ -73,6 +74,13 @@ typedef struct
 {
   GList *items;
   gboolean cancelled;
+
+  /* The tiles not yet matched to any of @items, by item id quark. */
+  GHashTable *old_tiles;
+  /* Pages whose tiles changed since they were last laid out. */
+  GHashTable *dirty_pages;
+  /* Position of the next item in the menu. */
+  guint position;
 } HdLauncherTraverseData;
 
 struct _HdLauncherPrivate
@@ -152,10 +160,15 @@ static void hd_launcher_transition_new_frame(ClutterTimeline *timeline,
  * which wants to #define _GNU_SOURCE unconditionally, but we already
  * have it in -D and they clash.  XXX */
 extern void hd_transition_play_sound(const gchar *fname);
+/* Likewise hd-comp-mgr.h. */
+extern void hd_comp_mgr_portrait_invalidate (void);
 
 /* The HdLauncher singleton */
 static HdLauncher *the_launcher = NULL;
 
+/* What the menu changes have cost, for hd-recorder. */
+static HdLauncherStats Launcher_stats;
+
 HdLauncher *
 hd_launcher_get (void)
 {
@@ -344,6 +357,57 @@ hd_launcher_update_orientation (gboolean portraited)
       _hd_launcher_update_orientation_cb, GBOOLEAN_TO_POINTER (portraited));
 }
 
+/* hd_launcher_prepare_orientation:
+ *
+ * Gets the page the user sees (or will see first) ready to be shown
+ * @portraited, see hd_launcher_grid_prepare_orientation().
+ */
+void
+hd_launcher_prepare_orientation (gboolean portraited)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  ClutterActor *page;
+
+  if (priv->portraited == portraited)
+    {
+      hd_launcher_cancel_orientation ();
+      return;
+    }
+
+  page = priv->active_page;
+  if (!page)
+    page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY);
+  if (page)
+    hd_launcher_grid_prepare_orientation (
+              HD_LAUNCHER_GRID (hd_launcher_page_get_grid (
+                                          HD_LAUNCHER_PAGE (page))),
+              portraited);
+}
+
+static void
+_hd_launcher_cancel_prepare_cb (GQuark key_id,
+    gpointer data,
+    gpointer user_data)
+{
+  hd_launcher_grid_cancel_prepare (
+              HD_LAUNCHER_GRID (hd_launcher_page_get_grid (
+                                          HD_LAUNCHER_PAGE (data))));
+}
+
+/* hd_launcher_cancel_orientation:
+ *
+ * The rotation hd_launcher_prepare_orientation() was called for won't
+ * happen, so the icons it has decoded for it can go.
+ */
+void
+hd_launcher_cancel_orientation (void)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+
+  /* The active page may have changed since. */
+  g_datalist_foreach (&priv->pages, _hd_launcher_cancel_prepare_cb, NULL);
+}
+
 /* hd_launcher_show:
  *
  * When the is_top_page is TRUE, the active_page private variable is set to top_page.
@@ -561,6 +625,7 @@ _hd_launcher_editor_destroyed (GtkWidget  *widget,
 
   priv->editor_done = FALSE;
   priv->is_editor_in_landscape = FALSE;
+  hd_comp_mgr_portrait_invalidate ();
 
   /* Reset the launcher's layout. */
   if (STATE_IS_PORTRAIT (hd_render_manager_get_state ()))
@@ -637,6 +702,7 @@ hd_launcher_application_tile_long_clicked (HdLauncherTile *tile,
                     launcher);
 
   priv->is_editor_in_landscape = !STATE_IS_PORTRAIT (hd_render_manager_get_state ());
+  hd_comp_mgr_portrait_invalidate ();
 
   hd_launcher_editor_show (priv->editor);
   hd_launcher_editor_select (HD_LAUNCHER_EDITOR (priv->editor),
@@ -670,6 +736,12 @@ hd_launcher_populate_tree_starting (HdLauncherTree *tree, gpointer data)
   HdLauncher *launcher = HD_LAUNCHER (data);
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (launcher);
 
+  /* This is either the very first population, a theme change or
+   * a locale change, after which every icon or label has to be
+   * reloaded anyway, so throw everything away.  Ordinary menu
+   * changes only come with "finished" and are merged into what
+   * we have. */
+  Launcher_stats.rebuilds++;
   if (STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
     {
       if (priv->portraited)
@@ -697,49 +769,277 @@ hd_launcher_populate_tree_starting (HdLauncherTree *tree, gpointer data)
 
 /*
  * Creating the pages and tiles
+ *
+ * Every tile remembers the item it was made for, the page it is on
+ * and its position in the menu.  When the tree changes, the new items
+ * are matched to the existing tiles by id, and only the tiles which
+ * are new, moved or look different are touched.
  */
 
+#define HD_LAUNCHER_TILE_ITEM     "HD-LauncherItem"
+#define HD_LAUNCHER_TILE_PAGE     "HD-LauncherPage"
+#define HD_LAUNCHER_TILE_POSITION "HD-LauncherPosition"
+
 static void
 hd_launcher_create_page (HdLauncherItem *item, gpointer data)
 {
   ClutterActor *self = CLUTTER_ACTOR (hd_launcher_get ());
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (self);
+  HdLauncherTraverseData *tdata = data;
   ClutterActor *newpage;
 
   if (hd_launcher_item_get_item_type (item) != HD_CATEGORY_LAUNCHER)
     return;
+  if (g_datalist_id_get_data (&priv->pages,
+                              hd_launcher_item_get_id_quark (item)))
+    return;
 
   newpage = hd_launcher_page_new ();
 
   clutter_actor_hide (newpage);
   clutter_container_add_actor (CLUTTER_CONTAINER (self), newpage);
   g_datalist_set_data_full (&priv->pages, hd_launcher_item_get_id (item), newpage, (GDestroyNotify) clutter_actor_destroy);
+  g_hash_table_insert (tdata->dirty_pages, newpage, newpage);
+}
+
+/* Adds the page of every category in @items to @categories. */
+static void
+_hd_launcher_list_categories (HdLauncherItem *item, gpointer categories)
+{
+  if (hd_launcher_item_get_item_type (item) == HD_CATEGORY_LAUNCHER)
+    g_hash_table_insert (categories,
+                 GUINT_TO_POINTER (hd_launcher_item_get_id_quark (item)),
+                 item);
 }
 
+static void
+_hd_launcher_list_pages (GQuark key_id, gpointer data, gpointer user_data)
+{
+  GSList **pages = user_data;
+  *pages = g_slist_prepend (*pages, GUINT_TO_POINTER (key_id));
+}
+
+/* Destroys the pages of categories which aren't in @items anymore.
+ * Returns whether the active page was one of them. */
 static gboolean
-hd_launcher_lazy_traverse_tree (gpointer data)
+hd_launcher_remove_old_pages (GList *items)
 {
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
-  HdLauncherTraverseData *tdata = data;
-  HdLauncherItem *item;
-  HdLauncherTile *tile;
-  HdLauncherPage *page = NULL;
-  guint i;
+  GHashTable *categories;
+  GSList *pages = NULL, *l;
+  gboolean active_removed = FALSE;
+
+  categories = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_list_foreach (items, (GFunc) _hd_launcher_list_categories, categories);
+  g_hash_table_insert (categories,
+                 GUINT_TO_POINTER (g_quark_from_static_string (
+                                             HD_LAUNCHER_ITEM_TOP_CATEGORY)),
+                 NULL);
+
+  g_datalist_foreach (&priv->pages, _hd_launcher_list_pages, &pages);
+  for (l = pages; l; l = l->next)
+    {
+      GQuark id = GPOINTER_TO_UINT (l->data);
 
-  if (!tdata ||
-      tdata->cancelled ||
-      tdata != priv->current_traversal)
-    /* This traversal is no longer current, go to cleanup. */
-    return FALSE;
+      if (g_hash_table_lookup_extended (categories, l->data, NULL, NULL))
+        continue;
+      if (priv->active_page == g_datalist_id_get_data (&priv->pages, id))
+        {
+          priv->active_page = NULL;
+          active_removed = TRUE;
+        }
+      g_datalist_id_remove_data (&priv->pages, id);
+    }
 
-  /* We're called back with huge latency so let's batch the work
-   * to cut the overall population time. */
-  for (i = 0; i < 5; i++)
+  g_slist_free (pages);
+  g_hash_table_destroy (categories);
+  return active_removed;
+}
+
+/* Indexes the tiles of a page by the id of their item. */
+static void
+_hd_launcher_collect_tiles (GQuark key_id, gpointer data, gpointer user_data)
+{
+  GHashTable *tiles = user_data;
+  ClutterActor *grid = hd_launcher_page_get_grid (HD_LAUNCHER_PAGE (data));
+  GList *children, *l;
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (grid));
+  for (l = children; l; l = l->next)
     {
-      if (!tdata->items || !tdata->items->data)
-        return FALSE;
-      item = tdata->items->data;
+      HdLauncherItem *item;
+      gpointer key;
+
+      if (!HD_IS_LAUNCHER_TILE (l->data))
+        continue;
+      item = g_object_get_data (G_OBJECT (l->data), HD_LAUNCHER_TILE_ITEM);
+      if (!item)
+        continue;
+
+      /* The same item can appear more than once. */
+      key = GUINT_TO_POINTER (hd_launcher_item_get_id_quark (item));
+      g_hash_table_insert (tiles, key,
+                           g_slist_prepend (g_hash_table_lookup (tiles, key),
+                                            l->data));
+    }
+  g_list_free (children);
+}
+
+static gint
+hd_launcher_tile_cmp_position (gconstpointer a, gconstpointer b)
+{
+  guint pa = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (a),
+                                                  HD_LAUNCHER_TILE_POSITION));
+  guint pb = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (b),
+                                                  HD_LAUNCHER_TILE_POSITION));
+  return pa < pb ? -1 : pa > pb;
+}
+
+static void
+_hd_launcher_layout_dirty_page (gpointer key, gpointer page,
+                                gpointer user_data)
+{
+  hd_launcher_grid_sort_tiles (
+                 HD_LAUNCHER_GRID (hd_launcher_page_get_grid (page)),
+                 hd_launcher_tile_cmp_position);
+  _hd_launcher_layout_page (0, page, NULL);
+}
+
+static void
+hd_launcher_layout_dirty_pages (HdLauncherTraverseData *tdata)
+{
+  g_hash_table_foreach (tdata->dirty_pages,
+                        _hd_launcher_layout_dirty_page, NULL);
+  g_hash_table_remove_all (tdata->dirty_pages);
+}
+
+static void
+_hd_launcher_remove_old_tiles (gpointer key, gpointer tiles,
+                               gpointer user_data)
+{
+  HdLauncherTraverseData *tdata = user_data;
+  GSList *l;
+
+  for (l = tiles; l; l = l->next)
+    {
+      gpointer page = g_object_get_data (G_OBJECT (l->data),
+                                         HD_LAUNCHER_TILE_PAGE);
+
+      g_hash_table_insert (tdata->dirty_pages, page, page);
+      clutter_actor_destroy (CLUTTER_ACTOR (l->data));
+      Launcher_stats.tiles_destroyed++;
+    }
+}
+
+/* Points the tile's signal handlers to @item. */
+static void
+hd_launcher_bind_tile (HdLauncherTile *tile, HdLauncherItem *item)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+
+  g_signal_handlers_disconnect_matched (tile, G_SIGNAL_MATCH_FUNC, 0, 0,
+                  NULL, hd_launcher_category_tile_clicked, NULL);
+  g_signal_handlers_disconnect_matched (tile, G_SIGNAL_MATCH_FUNC, 0, 0,
+                  NULL, hd_launcher_application_tile_clicked, NULL);
+  g_signal_handlers_disconnect_matched (tile, G_SIGNAL_MATCH_FUNC, 0, 0,
+                  NULL, hd_launcher_application_tile_long_clicked, NULL);
+
+  if (hd_launcher_item_get_item_type(item) == HD_CATEGORY_LAUNCHER)
+    {
+      g_signal_connect (tile, "clicked",
+                        G_CALLBACK (hd_launcher_category_tile_clicked),
+                        g_datalist_get_data (&priv->pages,
+                          hd_launcher_item_get_id (item)));
+    }
+  else if (hd_launcher_item_get_item_type(item) == HD_APPLICATION_LAUNCHER)
+    {
+      g_signal_connect (tile, "clicked",
+                        G_CALLBACK (hd_launcher_application_tile_clicked),
+                        item);
+    }
+
+  g_signal_connect (tile, "long-clicked",
+                G_CALLBACK (hd_launcher_application_tile_long_clicked),
+                item);
+
+  g_object_set_data_full (G_OBJECT (tile), HD_LAUNCHER_TILE_ITEM,
+                          g_object_ref (item), g_object_unref);
+}
+
+/* Makes sure @item has an up-to-date tile at the right place. */
+static void
+hd_launcher_update_tile (HdLauncherTraverseData *tdata, HdLauncherItem *item)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  HdLauncherTile *tile = NULL;
+  HdLauncherItem *old_item;
+  HdLauncherPage *page;
+  gpointer key, position;
+  GSList *tiles;
+
+  /* Find in which page it goes */
+  page = g_datalist_get_data (&priv->pages,
+                              hd_launcher_item_get_category (item));
+  if (!page)
+    /* Put it in the top level. */
+    page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY);
+
+  /* If we don't have a top level, we're in deep trouble, but we still
+   * check just in case.
+   */
+  if (!page)
+    {
+      g_warning ("%s: Couldn't find any page to accept entry %s",
+          __FUNCTION__, hd_launcher_item_get_id (item));
+      return;
+    }
 
+  /* Do we have it already? */
+  key = GUINT_TO_POINTER (hd_launcher_item_get_id_quark (item));
+  if ((tiles = g_hash_table_lookup (tdata->old_tiles, key)) != NULL)
+    {
+      tile = tiles->data;
+      tiles = g_slist_delete_link (tiles, tiles);
+      if (tiles)
+        g_hash_table_insert (tdata->old_tiles, key, tiles);
+      else
+        g_hash_table_remove (tdata->old_tiles, key);
+
+      old_item = g_object_get_data (G_OBJECT (tile), HD_LAUNCHER_TILE_ITEM);
+      if (g_object_get_data (G_OBJECT (tile), HD_LAUNCHER_TILE_PAGE) != page
+          || hd_launcher_item_get_item_type (old_item)
+             != hd_launcher_item_get_item_type (item))
+        {
+          /* Moved to another category, start over. */
+          gpointer old_page = g_object_get_data (G_OBJECT (tile),
+                                                 HD_LAUNCHER_TILE_PAGE);
+
+          g_hash_table_insert (tdata->dirty_pages, old_page, old_page);
+          clutter_actor_destroy (CLUTTER_ACTOR (tile));
+          Launcher_stats.tiles_destroyed++;
+          tile = NULL;
+        }
+      else
+        {
+          if (g_strcmp0 (hd_launcher_item_get_local_name (old_item),
+                         hd_launcher_item_get_local_name (item)))
+            {
+              hd_launcher_tile_set_text (tile,
+                  hd_launcher_item_get_local_name (item));
+              Launcher_stats.tiles_changed++;
+            }
+          if (g_strcmp0 (hd_launcher_item_get_icon_name (old_item),
+                         hd_launcher_item_get_icon_name (item)))
+            {
+              hd_launcher_tile_set_icon_name (tile,
+                  hd_launcher_item_get_icon_name (item));
+              Launcher_stats.tiles_changed++;
+            }
+        }
+    }
+
+  if (!tile)
+    {
       tile = hd_launcher_tile_new (
           hd_launcher_item_get_icon_name (item),
           hd_launcher_item_get_local_name (item));
@@ -748,71 +1048,92 @@ hd_launcher_lazy_traverse_tree (gpointer data)
       if (tdata->cancelled)
         {
           g_object_unref (tile);
-          return FALSE;
+          return;
         }
 
-      /* Find in which page it goes */
-      page = g_datalist_get_data (&priv->pages,
-                                  hd_launcher_item_get_category (item));
-      if (!page)
-        /* Put it in the top level. */
-        page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY);
+      hd_launcher_page_add_tile (page, tile);
+      g_object_set_data (G_OBJECT (tile), HD_LAUNCHER_TILE_PAGE, page);
+      Launcher_stats.tiles_created++;
+      g_hash_table_insert (tdata->dirty_pages, page, page);
+    }
 
-      /* If we don't have a top level, we're in deep trouble, but we still
-       * check just in case.
-       */
-      if (!page)
-        {
-          g_warning ("%s: Couldn't find any page to accept entry %s",
-              __FUNCTION__, hd_launcher_item_get_id (item));
-          g_object_unref (tile);
-        }
-      else
-        {
-          hd_launcher_page_add_tile (page, tile);
+  /* Positions start from 1 so that 0 can mean "not yet known". */
+  position = GUINT_TO_POINTER (++tdata->position);
+  if (g_object_get_data (G_OBJECT (tile), HD_LAUNCHER_TILE_POSITION)
+      != position)
+    {
+      g_object_set_data (G_OBJECT (tile), HD_LAUNCHER_TILE_POSITION,
+                         position);
+      g_hash_table_insert (tdata->dirty_pages, page, page);
+    }
 
-          if (hd_launcher_item_get_item_type(item) == HD_CATEGORY_LAUNCHER)
-            {
-              g_signal_connect (tile, "clicked",
-                                G_CALLBACK (hd_launcher_category_tile_clicked),
-                                g_datalist_get_data (&priv->pages,
-                                  hd_launcher_item_get_id (item)));
-            }
-          else if (hd_launcher_item_get_item_type(item) == HD_APPLICATION_LAUNCHER)
-            {
-              g_signal_connect (tile, "clicked",
-                                G_CALLBACK (hd_launcher_application_tile_clicked),
-                                item);
-            }
+  hd_launcher_bind_tile (tile, item);
+}
 
-          g_signal_connect (tile, "long-clicked",
-                        G_CALLBACK (hd_launcher_application_tile_long_clicked),
-                        item);
-        }
+/* Puts the next item of the traversal in place.  It's run as idle work,
+ * as many times per slice as fits into the frame budget. */
+static gboolean
+hd_launcher_lazy_traverse_tree (gpointer data)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  HdLauncherTraverseData *tdata = data;
+  HdLauncherItem *item;
+
+  if (!tdata ||
+      tdata->cancelled ||
+      tdata != priv->current_traversal)
+    /* This traversal is no longer current, go to cleanup. */
+    return FALSE;
+
+  if (tdata->items)
+    {
+      if (!tdata->items->data)
+        return FALSE;
+      item = tdata->items->data;
+
+      hd_launcher_update_tile (tdata, item);
+      if (tdata->cancelled)
+        return FALSE;
 
       g_object_unref (G_OBJECT (item));
       tdata->items = g_list_delete_link (tdata->items, tdata->items);
-      if (!tdata->items)
-        {
-          g_datalist_foreach(&priv->pages, _hd_launcher_layout_page, NULL);
+      if (tdata->items)
+        return TRUE;
+    }
 
-          /* This traversal has finished. */
-          priv->current_traversal = NULL;
+  /* Whatever wasn't matched isn't in the menu anymore. */
+  g_hash_table_foreach (tdata->old_tiles,
+                        _hd_launcher_remove_old_tiles, tdata);
+  g_hash_table_remove_all (tdata->old_tiles);
+  return FALSE;
+}
 
-          /* If the changes came when an editor is present, switch back to
-           * launcher
-           */
-          if (priv->editor && priv->editor_done)
-            {
-              hd_render_manager_set_state (HDRM_STATE_LAUNCHER);
-            }
-          return FALSE;
-        }
-    }
+/* Lays out what the last slice of the traversal changed. */
+static void
+hd_launcher_lazy_traverse_flush (gpointer data)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  HdLauncherTraverseData *tdata = data;
 
-  g_datalist_foreach(&priv->pages, _hd_launcher_layout_page, NULL);
+  /* The pages may be gone if it was cancelled. */
+  if (tdata->cancelled || tdata != priv->current_traversal)
+    return;
 
-  return TRUE;
+  hd_launcher_layout_dirty_pages (tdata);
+
+  if (!tdata->items)
+    {
+      /* This traversal has finished. */
+      priv->current_traversal = NULL;
+
+      /* If the changes came when an editor is present, switch back to
+       * launcher
+       */
+      if (priv->editor && priv->editor_done)
+        {
+          hd_render_manager_set_state (HDRM_STATE_LAUNCHER);
+        }
+    }
 }
 
 static void
@@ -828,6 +1149,8 @@ hd_launcher_lazy_traverse_cleanup (gpointer data)
       g_list_free (tdata->items);
       tdata->items = NULL;
     }
+  g_hash_table_destroy (tdata->old_tiles);
+  g_hash_table_destroy (tdata->dirty_pages);
 
   g_free (data);
 }
@@ -838,12 +1161,16 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
   HdLauncher *launcher = HD_LAUNCHER (data);
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (launcher);
   HdLauncherTraverseData *tdata = g_new0 (HdLauncherTraverseData, 1);
+  ClutterActor *top_page;
 
   /* As we'll be adding these in an idle loop, we need to ensure that they
    * won't disappear while we do this, so we copy the list and ref all the
    * items. */
   tdata->items = g_list_copy(hd_launcher_tree_get_items(tree));
   g_list_foreach (tdata->items, (GFunc)g_object_ref, NULL);
+  tdata->old_tiles = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            NULL, (GDestroyNotify) g_slist_free);
+  tdata->dirty_pages = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   if (priv->current_traversal)
     {
@@ -851,10 +1178,10 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
     }
   priv->current_traversal = tdata;
 
-  /* if after traversal starts, the user switches to LAUNCHER,
-   * we can get empty launcher (the old page) that gets stuck on
-   * the screen until the user opens the power menu */
-  if (STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
+  /* Drop the categories which are gone.  If the user is looking at
+   * one of them, there's nothing sensible to show instead. */
+  if (hd_launcher_remove_old_pages (tdata->items)
+      && STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
     {
       if (priv->portraited)
         hd_render_manager_set_state (HDRM_STATE_HOME_PORTRAIT);
@@ -862,23 +1189,30 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
         hd_render_manager_set_state (HDRM_STATE_HOME);
     }
 
-  /* First we traverse the list and create all the categories,
+  /* First we make sure all the categories have a page,
    * so that apps can be correctly put into them.
    */
-  ClutterActor *top_page = hd_launcher_page_new ();
-  clutter_container_add_actor (CLUTTER_CONTAINER (launcher),
-                               top_page);
-  clutter_actor_hide (top_page);
-  priv->active_page = NULL;
-  g_datalist_set_data_full (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY, top_page, (GDestroyNotify) clutter_actor_destroy);
+  top_page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY);
+  if (!top_page)
+    {
+      top_page = hd_launcher_page_new ();
+      clutter_container_add_actor (CLUTTER_CONTAINER (launcher),
+                                   top_page);
+      clutter_actor_hide (top_page);
+      g_datalist_set_data_full (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY, top_page, (GDestroyNotify) clutter_actor_destroy);
+      g_hash_table_insert (tdata->dirty_pages, top_page, top_page);
+    }
 
-  g_list_foreach (tdata->items, (GFunc) hd_launcher_create_page, NULL);
+  g_list_foreach (tdata->items, (GFunc) hd_launcher_create_page, tdata);
 
-  /* Then we add the tiles to them in a idle callback. */
-  clutter_threads_add_idle_full (CLUTTER_PRIORITY_REDRAW + 20,
-                                 hd_launcher_lazy_traverse_tree,
-                                 tdata,
-                                 hd_launcher_lazy_traverse_cleanup);
+  /* Then we see what we have already and update the tiles
+   * in the background. */
+  g_datalist_foreach (&priv->pages, _hd_launcher_collect_tiles,
+                      tdata->old_tiles);
+  hd_idle_work_add (hd_launcher_lazy_traverse_tree,
+                    hd_launcher_lazy_traverse_flush,
+                    tdata,
+                    hd_launcher_lazy_traverse_cleanup);
 }
 
 /* handle clicks to the fake launch image. If we've been up this long the
@@ -1317,3 +1651,29 @@ hd_launcher_is_portrait (void)
 
   return priv->portraited;
 }
+
+void
+hd_launcher_get_stats (HdLauncherStats *stats)
+{
+  *stats = Launcher_stats;
+  stats->tiles_prefetched = hd_launcher_tile_count_prefetched ();
+}
+
+void
+hd_launcher_reset_stats (void)
+{
+  memset (&Launcher_stats, 0, sizeof (Launcher_stats));
+}
+
+void
+hd_launcher_scroll_by (gint dy)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+
+  if (!STATE_IS_LAUNCHER (hd_render_manager_get_state ()))
+    hd_render_manager_set_state (
+                  STATE_IS_PORTRAIT (hd_render_manager_get_state ())
+                  ? HDRM_STATE_LAUNCHER_PORTRAIT : HDRM_STATE_LAUNCHER);
+  if (priv->active_page)
+    hd_launcher_page_scroll_by (HD_LAUNCHER_PAGE (priv->active_page), dy);
+}
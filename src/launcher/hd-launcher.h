@@ -93,10 +93,31 @@ void hd_launcher_stop_loading_transition (void);
 
 void hd_launcher_activate(int p);
 void hd_launcher_update_orientation (gboolean portraited);
+void hd_launcher_prepare_orientation (gboolean portraited);
+void hd_launcher_cancel_orientation (void);
 
 gboolean hd_launcher_is_editor_in_landscape (void);
 gboolean hd_launcher_is_portrait (void);
 
+/* How many times the pages were rebuilt from scratch, and how many
+ * tiles menu changes have created, relabelled or re-iconed, and
+ * destroyed since the last reset.  @tiles_prefetched is how many tiles
+ * hold an icon decoded for them but not loaded right now, which resets
+ * don't affect. */
+typedef struct
+{
+  guint rebuilds;
+  guint tiles_created, tiles_changed, tiles_destroyed;
+  guint tiles_prefetched;
+} HdLauncherStats;
+
+void hd_launcher_get_stats (HdLauncherStats *stats);
+void hd_launcher_reset_stats (void);
+
+/* Shows the launcher if it isn't shown and scrolls its current page by
+ * @dy pixels, for benchmarks. */
+void hd_launcher_scroll_by (gint dy);
+
 /* left/right/top/bottom margin that is clicked on to go back */
 #define HD_LAUNCHER_LEFT_MARGIN (68) /* layout guide F */
 #define HD_LAUNCHER_RIGHT_MARGIN (68) /* layout guide F */
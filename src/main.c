@@ -56,6 +56,8 @@
 #include "hd-home.h"
 #include "hd-shortcuts.h"
 #include "hd-xinput.h"
+#include "hd-profiler.h"
+#include "hd-recorder.h"
 
 #ifndef DISABLE_A11Y
 #include "hildon-desktop-a11y.h"
@@ -418,6 +420,7 @@ main (int argc, char **argv)
   /* Use software-based selection, which is much faster on SGX than rendering
    * with 'GL and reading back */
   clutter_set_software_selection(TRUE);
+  hd_profiler_init (clutter_stage_get_default ());
 
 #ifndef DISABLE_A11Y
   hildon_desktop_a11y_init ();
@@ -453,6 +456,7 @@ main (int argc, char **argv)
   hd_enumerate_input_devices (dpy);
   hd_rotate_input_devices (dpy);
 
+  hd_recorder_init (dpy, clutter_stage_get_default ());
   clutter_x11_add_filter (hd_clutter_x11_event_filter, wm);
 
   app_mgr = hd_app_mgr_get ();
@@ -482,6 +486,7 @@ main (int argc, char **argv)
    * so everything *should* be covered this way. */
   gtk_main ();
 
+  hd_recorder_finish ();
   hd_close_input_devices (dpy);
 
   mb_wm_object_unref (MB_WM_OBJECT (wm));
@@ -23,9 +23,15 @@
 
 #include "hd-animation-actor.h"
 #include "hd-comp-mgr.h"
+#include "hd-atom-dispatch.h"
 #include "hd-wm.h"
 
+#include "hd-animation-ring.h"
+
+#include <string.h>
 #include <sys/time.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
 #include <time.h>
 
 #define CLIENT_MESSAGE_DEBUG 0//1
@@ -36,15 +42,7 @@
 #    define CM_DEBUG(format, args...)
 #endif
 
-static Atom show_atom;
-static Atom position_atom;
-static Atom rotation_atom;
-static Atom scale_atom;
-static Atom anchor_atom;
-static Atom ready_atom;
-static Atom parent_atom;
-
-static gboolean atoms_initialized = 0;
+static Atom ready_atom, ring_tail_atom;
 
 void
 hd_animation_actor_show (MBWindowManagerClient *client);
@@ -53,16 +51,17 @@ hd_animation_actor_request_geometry (MBWindowManagerClient *client,
 				     MBGeometry            *new_geometry,
 				     MBWMClientReqGeomType  flags);
 
-static void
-hd_animation_actor_client_message (XClientMessageEvent *xev, void *userdata)
+/* Returns the actor ClientMessage:s to @self should change,
+ * or NULL if it's not there. */
+static ClutterActor *
+hd_animation_actor_message_target (HdAnimationActor *self)
 {
-  HdAnimationActor         *self = HD_ANIMATION_ACTOR (userdata);
   MBWindowManagerClient    *client = MB_WM_CLIENT (self);
 
   if (!client->window)
   {
       g_warning ("Stray client message: no window!\n");
-      return;
+      return NULL;
   }
 
   MBWMCompMgrClutterClient *cclient = MB_WM_COMP_MGR_CLUTTER_CLIENT (client->cm_client);
@@ -71,168 +70,468 @@ hd_animation_actor_client_message (XClientMessageEvent *xev, void *userdata)
   if (!CLUTTER_IS_ACTOR(actor))
   {
       g_warning ("Stray client message: no actor!\n");
-      return;
+      return NULL;
   }
 
-  if (xev->message_type == show_atom)
-  {
-      gboolean show = (gboolean) xev->data.l[0];
-      guint    opacity = (guint) xev->data.l[1] & 0xff;
+  return actor;
+}
+
+static Bool
+hd_animation_actor_show_message (XClientMessageEvent *xev,
+				 HdAnimationActor *self)
+{
+  ClutterActor *actor = hd_animation_actor_message_target (self);
+  gboolean show = (gboolean) xev->data.l[0];
+  guint    opacity = (guint) xev->data.l[1] & 0xff;
 
-      CM_DEBUG ("AnimationActor %p: show(show=%d, opacity=%d)\n",
-	       	self, show, opacity);
+  if (!actor)
+      return True;
 
-      self->show = show;
+  CM_DEBUG ("AnimationActor %p: show(show=%d, opacity=%d)\n",
+	    self, show, opacity);
 
-      if (show)
-          clutter_actor_show (actor);
-      else
-          clutter_actor_hide (actor);
+  self->show = show;
 
-      clutter_actor_set_opacity (actor, opacity);
+  if (show)
+      clutter_actor_show (actor);
+  else
+      clutter_actor_hide (actor);
+
+  clutter_actor_set_opacity (actor, opacity);
+  return True;
+}
+
+static Bool
+hd_animation_actor_position_message (XClientMessageEvent *xev,
+				     HdAnimationActor *self)
+{
+  ClutterActor *actor = hd_animation_actor_message_target (self);
+  gint x = (gint) xev->data.l[0];
+  gint y = (gint) xev->data.l[1];
+  gint depth = (gint) xev->data.l[2];
+
+  if (!actor)
+      return True;
+
+  CM_DEBUG ("AnimationActor %p: position(x=%d, y=%d, depth=%d)\n",
+	    self, x, y, depth);
+  clutter_actor_set_position (actor, x, y);
+  clutter_actor_set_depth (actor, depth);
+  return True;
+}
 
+static Bool
+hd_animation_actor_rotation_message (XClientMessageEvent *xev,
+				     HdAnimationActor *self)
+{
+  ClutterActor *actor = hd_animation_actor_message_target (self);
+  guint  axis    = (guint)  xev->data.l[0];
+  gint32 degrees = (gint32) xev->data.l[1];
+  gint   x       = (gint)   xev->data.l[2];
+  gint   y       = (gint)   xev->data.l[3];
+  gint   z       = (gint)   xev->data.l[4];
+  ClutterRotateAxis clutter_axis;
+
+  if (!actor)
+      return True;
+
+  CM_DEBUG ("AnimationActor %p: rotation(axis=%d, deg=%d, x=%d, y=%d, z=%d)\n",
+	    self, axis, degrees, x, y, z);
+
+  switch (axis) {
+      case 0: clutter_axis = CLUTTER_X_AXIS; break;
+      case 1: clutter_axis = CLUTTER_Y_AXIS; break;
+      default: clutter_axis = CLUTTER_Z_AXIS;
   }
-  else if (xev->message_type == position_atom)
+
+  clutter_actor_set_rotationx (actor,
+			       clutter_axis,
+			       degrees,
+			       x, y, z);
+  return True;
+}
+
+static Bool
+hd_animation_actor_scale_message (XClientMessageEvent *xev,
+				  HdAnimationActor *self)
+{
+  ClutterActor *actor = hd_animation_actor_message_target (self);
+  gint32 x_scale = (gint32) xev->data.l[0];
+  gint32 y_scale = (gint32) xev->data.l[1];
+
+  if (!actor)
+      return True;
+
+  CM_DEBUG ("AnimationActor %p: scale(x_scale=%u, y_scale=%u)\n",
+	    self, x_scale, y_scale);
+  clutter_actor_set_scalex (actor, x_scale, y_scale);
+  return True;
+}
+
+static Bool
+hd_animation_actor_anchor_message (XClientMessageEvent *xev,
+				   HdAnimationActor *self)
+{
+  ClutterActor *actor = hd_animation_actor_message_target (self);
+  guint gravity = (guint) xev->data.l[0];
+  gint  x       = (gint)  xev->data.l[1];
+  gint  y       = (gint)  xev->data.l[2];
+  ClutterGravity clutter_gravity;
+
+  if (!actor)
+      return True;
+
+  CM_DEBUG ("AnimationActor %p: anchor(gravity=%u, x=%d, y=%d)\n",
+	    self, gravity, x, y);
+
+  switch (gravity)
   {
-      gint x = (gint) xev->data.l[0];
-      gint y = (gint) xev->data.l[1];
-      gint depth = (gint) xev->data.l[2];
-
-      CM_DEBUG ("AnimationActor %p: position(x=%d, y=%d, depth=%d)\n",
-	       	self, x, y, depth);
-      clutter_actor_set_position (actor, x, y);
-      clutter_actor_set_depth (actor, depth);
+      case 1: clutter_gravity = CLUTTER_GRAVITY_NORTH; break;
+      case 2: clutter_gravity = CLUTTER_GRAVITY_NORTH_EAST; break;
+      case 3: clutter_gravity = CLUTTER_GRAVITY_EAST; break;
+      case 4: clutter_gravity = CLUTTER_GRAVITY_SOUTH_EAST; break;
+      case 5: clutter_gravity = CLUTTER_GRAVITY_SOUTH; break;
+      case 6: clutter_gravity = CLUTTER_GRAVITY_SOUTH_WEST; break;
+      case 7: clutter_gravity = CLUTTER_GRAVITY_WEST; break;
+      case 8: clutter_gravity = CLUTTER_GRAVITY_NORTH_WEST; break;
+      case 9: clutter_gravity = CLUTTER_GRAVITY_CENTER; break;
+
+      default: clutter_gravity = CLUTTER_GRAVITY_NONE; break;
   }
-  else if (xev->message_type == rotation_atom)
-  {
-      guint  axis    = (guint)  xev->data.l[0];
-      gint32 degrees = (gint32) xev->data.l[1];
-      gint   x       = (gint)   xev->data.l[2];
-      gint   y       = (gint)   xev->data.l[3];
-      gint   z       = (gint)   xev->data.l[4];
-
-      CM_DEBUG ("AnimationActor %p: rotation(axis=%d, deg=%d, x=%d, y=%d, z=%d)\n",
-               self, axis, degrees, x, y, z);
-
-      ClutterRotateAxis clutter_axis;
-      switch (axis) {
-          case 0: clutter_axis = CLUTTER_X_AXIS; break;
-          case 1: clutter_axis = CLUTTER_Y_AXIS; break;
-          default: clutter_axis = CLUTTER_Z_AXIS;
-      }
 
-      clutter_actor_set_rotationx (actor,
-                                   clutter_axis,
-                                   degrees,
-                                   x, y, z);
+  if (clutter_gravity == CLUTTER_GRAVITY_NONE)
+  {
+      clutter_actor_move_anchor_point (actor, x, y);
   }
-  else if (xev->message_type == scale_atom)
+  else
   {
-      gint32 x_scale = (gint32) xev->data.l[0];
-      gint32 y_scale = (gint32) xev->data.l[1];
-
-      CM_DEBUG ("AnimationActor %p: scale(x_scale=%u, y_scale=%u)\n",
-	       self, x_scale, y_scale);
-      clutter_actor_set_scalex (actor, x_scale, y_scale);
+      clutter_actor_move_anchor_point_from_gravity
+	  (actor, clutter_gravity);
   }
-  else if (xev->message_type == anchor_atom)
+  return True;
+}
+
+static Bool
+hd_animation_actor_parent_message (XClientMessageEvent *xev,
+				   HdAnimationActor *self)
+{
+  MBWindowManagerClient *client = MB_WM_CLIENT (self);
+  ClutterActor *actor = hd_animation_actor_message_target (self);
+  Window win = (Window) xev->data.l[0];
+  ClutterActor *parent;
+
+  if (!actor)
+      return True;
+
+  CM_DEBUG ("AnimationActor %p: parent(win=%lu)\n",
+	    self, win);
+
+  /* Unparent the actor */
+  parent = clutter_actor_get_parent (actor);
+  if (parent)
+    {
+      clutter_container_remove_actor (CLUTTER_CONTAINER (parent),
+				      actor);
+    }
+
+  if (win != 0)
   {
-      guint gravity = (guint) xev->data.l[0];
-      gint  x       = (gint)  xev->data.l[1];
-      gint  y       = (gint)  xev->data.l[2];
+      /* re-parent the actor to another actor */
 
-      CM_DEBUG ("AnimationActor %p: anchor(gravity=%u, x=%d, y=%d)\n",
-               self, gravity, x, y);
+      MBWindowManagerClient *parent_client = NULL;
+      MBWMCompMgrClutterClient *parent_cclient = NULL;
+      parent = NULL;
 
-      ClutterGravity clutter_gravity;
+      /* Many things can go wrong if the parent X window is not
+       * mapped yet (WM client or clutter compositing client or
+       * clutter actor may be missing). Silently bail out if
+       * any of this happens. */
 
-      switch (gravity)
-      {
-	  case 1: clutter_gravity = CLUTTER_GRAVITY_NORTH; break;
-	  case 2: clutter_gravity = CLUTTER_GRAVITY_NORTH_EAST; break;
-	  case 3: clutter_gravity = CLUTTER_GRAVITY_EAST; break;
-	  case 4: clutter_gravity = CLUTTER_GRAVITY_SOUTH_EAST; break;
-	  case 5: clutter_gravity = CLUTTER_GRAVITY_SOUTH; break;
-	  case 6: clutter_gravity = CLUTTER_GRAVITY_SOUTH_WEST; break;
-	  case 7: clutter_gravity = CLUTTER_GRAVITY_WEST; break;
-	  case 8: clutter_gravity = CLUTTER_GRAVITY_NORTH_WEST; break;
-	  case 9: clutter_gravity = CLUTTER_GRAVITY_CENTER; break;
-
-	  default: clutter_gravity = CLUTTER_GRAVITY_NONE; break;
-      }
+      parent_client =
+	  mb_wm_managed_client_from_xwindow (client->wmref, win);
 
-      if (clutter_gravity == CLUTTER_GRAVITY_NONE)
-      {
-	  clutter_actor_move_anchor_point (actor, x, y);
-      }
-      else
+      if (parent_client)
+	  parent_cclient =
+	      MB_WM_COMP_MGR_CLUTTER_CLIENT (parent_client->cm_client);
+
+      if (parent_cclient)
+	  parent = mb_wm_comp_mgr_clutter_client_get_actor (parent_cclient);
+
+      if (parent)
       {
-	  clutter_actor_move_anchor_point_from_gravity
-	      (actor, clutter_gravity);
+	clutter_container_add_actor (CLUTTER_CONTAINER (parent),
+				     actor);
       }
   }
-  else if (xev->message_type == parent_atom)
-  {
-      Window win = (Window) xev->data.l[0];
 
-      CM_DEBUG ("AnimationActor %p: parent(win=%lu)\n",
-               self, win);
+  if (self->show)
+      clutter_actor_show (actor);
+  else
+      clutter_actor_hide (actor);
+  return True;
+}
 
-       /* Unparent the actor */
-      ClutterActor *parent = clutter_actor_get_parent (actor);
-      if (parent)
-        {
-          clutter_container_remove_actor (CLUTTER_CONTAINER (parent),
-                                        actor);
-        }
+static Bool
+hd_animation_actor_ring_message (XClientMessageEvent *xev,
+				 HdAnimationActor *self);
+static Bool
+hd_animation_actor_frame_message (XClientMessageEvent *xev,
+				  HdAnimationActor *self);
 
-      if (win != 0)
+/* The HildonAnimationActor ClientMessage interface.  The first ones
+ * are in the order of HdAnimationRingCommandType, so ring commands
+ * are executed by the same functions. */
+static const struct
+{
+  HdAtoms        atom;
+  MBWMXEventFunc func;
+} hd_animation_actor_messages[] =
+{
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_SHOW,
+    (MBWMXEventFunc)hd_animation_actor_show_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_POSITION,
+    (MBWMXEventFunc)hd_animation_actor_position_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_ROTATION,
+    (MBWMXEventFunc)hd_animation_actor_rotation_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_SCALE,
+    (MBWMXEventFunc)hd_animation_actor_scale_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_ANCHOR,
+    (MBWMXEventFunc)hd_animation_actor_anchor_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT,
+    (MBWMXEventFunc)hd_animation_actor_parent_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_RING,
+    (MBWMXEventFunc)hd_animation_actor_ring_message },
+  { HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_FRAME,
+    (MBWMXEventFunc)hd_animation_actor_frame_message },
+};
+
+/* A command ring (see hd-animation-ring.h) attached to by actors. */
+struct HdAnimationActorRing
+{
+  key_t            key;
+  /* Attached read-only. */
+  const HdAnimationRing *shm;
+  /* Copied, so the client can't make us read past the segment. */
+  guint32          n_commands;
+  /* How far we have consumed, and where we tell the client. */
+  guint32          tail;
+  Window           tail_window;
+  /* Of the segment. */
+  uid_t            uid;
+  guint            refs;
+};
+
+/* Window -> HdAnimationActor, of the realized actors. */
+static GHashTable *actors;
+/* The HdAnimationActorRing:s in use. */
+static GList *rings;
+static guint drain_id;
+
+/* Finds out who runs @self's client, from _NET_WM_PID. */
+static gboolean
+hd_animation_actor_get_owner (HdAnimationActor *self, uid_t *uid)
+{
+  MBWindowManagerClient *client = MB_WM_CLIENT (self);
+  gchar path[32];
+  struct stat st;
+
+  if (!client->window || client->window->pid <= 0)
+    return FALSE;
+  g_snprintf (path, sizeof (path), "/proc/%d", client->window->pid);
+  if (stat (path, &st) < 0)
+    return FALSE;
+  *uid = st.st_uid;
+  return TRUE;
+}
+
+static HdAnimationActorRing *
+hd_animation_actor_ring_ref (HdAnimationActor *self, key_t key)
+{
+  HdAnimationActorRing *ring;
+  const HdAnimationRing *shm;
+  struct shmid_ds ds;
+  uid_t uid;
+  int shm_id;
+  GList *li;
+
+  /* Don't let anyone make us read someone else's segment. */
+  if (!hd_animation_actor_get_owner (self, &uid))
+    {
+      g_warning ("%s: don't know who the client is", __FUNCTION__);
+      return NULL;
+    }
+
+  for (li = rings; li; li = li->next)
+    if (((HdAnimationActorRing *)li->data)->key == key)
       {
-	  /* re-parent the actor to another actor */
+	ring = li->data;
+	if (ring->uid != uid)
+	  {
+	    g_warning ("%s: ring %d is not the client's", __FUNCTION__, key);
+	    return NULL;
+	  }
+	ring->refs++;
+	return ring;
+      }
 
-	  MBWindowManagerClient *parent_client = NULL;
-	  MBWMCompMgrClutterClient *parent_cclient = NULL;
-	  parent = NULL;
+  if ((shm_id = shmget (key, 0, 0)) < 0
+      || shmctl (shm_id, IPC_STAT, &ds) < 0)
+    {
+      g_warning ("%s: shmget failed: %m", __FUNCTION__);
+      return NULL;
+    }
+  if (ds.shm_perm.uid != uid || ds.shm_perm.cuid != uid)
+    {
+      g_warning ("%s: ring %d is not the client's", __FUNCTION__, key);
+      return NULL;
+    }
+  if (ds.shm_segsz < HD_ANIMATION_RING_SIZE (0))
+    {
+      g_warning ("%s: segment too small", __FUNCTION__);
+      return NULL;
+    }
+  if ((shm = shmat (shm_id, NULL, SHM_RDONLY)) == (void *)-1)
+    {
+      g_warning ("%s: shmat failed: %m", __FUNCTION__);
+      return NULL;
+    }
 
-	  /* Many things can go wrong if the parent X window is not
-	   * mapped yet (WM client or clutter compositing client or
-	   * clutter actor may be missing). Silently bail out if
-	   * any of this happens. */
+  if (shm->magic != HD_ANIMATION_RING_MAGIC
+      || !shm->n_commands || (shm->n_commands & (shm->n_commands - 1))
+      || HD_ANIMATION_RING_SIZE (shm->n_commands) > ds.shm_segsz)
+    {
+      g_warning ("%s: not a command ring", __FUNCTION__);
+      shmdt (shm);
+      return NULL;
+    }
 
-	  parent_client =
-	      mb_wm_managed_client_from_xwindow (client->wmref, win);
+  ring = g_slice_new (HdAnimationActorRing);
+  ring->key = key;
+  ring->shm = shm;
+  ring->n_commands = shm->n_commands;
+  ring->tail = 0;
+  ring->tail_window = None;
+  ring->uid = uid;
+  ring->refs = 1;
+  rings = g_list_prepend (rings, ring);
+  return ring;
+}
 
-	  if (parent_client)
-	      parent_cclient =
-		  MB_WM_COMP_MGR_CLUTTER_CLIENT (parent_client->cm_client);
+/* Detaches @self from its ring, if it has one. */
+static void
+hd_animation_actor_ring_unref (HdAnimationActor *self)
+{
+  HdAnimationActorRing *ring = self->ring;
+
+  if (!ring)
+    return;
+  self->ring = NULL;
+  if (ring->tail_window == self->message_window)
+    ring->tail_window = None;
+  if (--ring->refs)
+    return;
+
+  rings = g_list_remove (rings, ring);
+  if (shmdt (ring->shm) == -1)
+    g_critical ("%s: shmdt: %p is not the data segment start address "
+		"of a shared memory segment", __FUNCTION__, ring->shm);
+  g_slice_free (HdAnimationActorRing, ring);
+}
 
-	  if (parent_cclient)
-	      parent = mb_wm_comp_mgr_clutter_client_get_actor (parent_cclient);
+/* Executes the commands of the complete frames in @ring. */
+static void
+hd_animation_actor_ring_drain (HdAnimationActorRing *ring)
+{
+  guint32 head, tail;
 
-	  if (parent)
-          {
-            clutter_container_add_actor (CLUTTER_CONTAINER (parent),
-                                         actor);
-         }
-      }
+  head = g_atomic_int_get ((gint *)&ring->shm->head);
+  tail = ring->tail;
+  if (head - tail > ring->n_commands)
+    {
+      g_warning ("AnimationActor ring %d: head %u is out of bounds",
+		 ring->key, head);
+      tail = head;
+    }
 
-      if (self->show)
-          clutter_actor_show (actor);
-      else
-          clutter_actor_hide (actor);
-  }
-  else
-  {
-      CM_DEBUG ("AnimationActor %p: UNKNOWN MESSAGE %lu (%lu,%lu,%lu,%lu,%lu)\n",
-	       self,
-	       xev->message_type,
-	       xev->data.l[0],
-	       xev->data.l[1],
-	       xev->data.l[2],
-	       xev->data.l[3],
-	       xev->data.l[4]);
-      return;
-  }
+  for (; tail != head; tail++)
+    {
+      const HdAnimationRingCommand *cmd;
+      HdAnimationActor *self;
+      XClientMessageEvent xev;
+      guint i;
+
+      cmd = &ring->shm->commands[tail & (ring->n_commands - 1)];
+      if (cmd->type > HD_ANIMATION_RING_PARENT)
+	continue;
+      self = g_hash_table_lookup (actors, GUINT_TO_POINTER (cmd->window));
+      if (!self || self->ring != ring)
+	continue;
+
+      memset (&xev, 0, sizeof (xev));
+      xev.type = ClientMessage;
+      xev.window = cmd->window;
+      xev.format = 32;
+      for (i = 0; i < G_N_ELEMENTS (cmd->args); i++)
+	xev.data.l[i] = cmd->args[i];
+      hd_animation_actor_messages[cmd->type].func (&xev, self);
+    }
+
+  ring->tail = tail;
+
+  /* Let the client reuse the slots. */
+  if (ring->tail_window)
+    {
+      Display *dpy = clutter_x11_get_default_display ();
+      long val = tail;
+
+      mb_wm_util_async_trap_x_errors (dpy);
+      XChangeProperty (dpy, ring->tail_window, ring_tail_atom,
+		       XA_CARDINAL, 32, PropModeReplace,
+		       (unsigned char *) &val, 1);
+      mb_wm_util_async_untrap_x_errors ();
+    }
+}
+
+static gboolean
+hd_animation_actor_drain_rings (gpointer unused)
+{
+  GList *li;
+
+  drain_id = 0;
+  for (li = rings; li; li = li->next)
+    hd_animation_actor_ring_drain (li->data);
+  return FALSE;
+}
+
+static Bool
+hd_animation_actor_ring_message (XClientMessageEvent *xev,
+				 HdAnimationActor *self)
+{
+  key_t key = (key_t) xev->data.l[0];
+
+  CM_DEBUG ("AnimationActor %p: ring(key=%d)\n", self, key);
+
+  hd_animation_actor_ring_unref (self);
+  if (key)
+    self->ring = hd_animation_actor_ring_ref (self, key);
+  return True;
+}
+
+static Bool
+hd_animation_actor_frame_message (XClientMessageEvent *xev,
+				  HdAnimationActor *self)
+{
+  CM_DEBUG ("AnimationActor %p: frame(%lu)\n", self, xev->data.l[0]);
+
+  if (self->ring)
+    self->ring->tail_window = self->message_window;
+
+  /* Execute the commands of all frames which are complete by the time
+   * the stage is redrawn, all at once. */
+  if (self->ring && !drain_id)
+    drain_id = g_idle_add_full (CLUTTER_PRIORITY_REDRAW - 1,
+				hd_animation_actor_drain_rings, NULL, NULL);
+  return True;
 }
 
 void
@@ -259,42 +558,31 @@ hd_animation_actor_realize (MBWindowManagerClient *client)
     MBWindowManager          *wm = client->wmref;
     MBWMClientWindow         *win = client->window;
     Window                   window = win->xwindow;
+    HdCompMgr                *hmgr = HD_COMP_MGR (wm->comp_mgr);
+    guint                    i;
 
-    /* This is a bit of a hack, but for the sake of optimization,
-     * we cache all atoms used by the HildonAnimationActor ClientMessage
-     * interface in our static variables. */
-
-    if (!atoms_initialized)
-    {
-	HdCompMgr             *hmgr = HD_COMP_MGR (wm->comp_mgr);
-
-	show_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_SHOW);
-	position_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_POSITION);
-	rotation_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_ROTATION);
-	scale_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_SCALE);
-	anchor_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_ANCHOR);
-	parent_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT);
+    if (!ready_atom)
 	ready_atom = hd_comp_mgr_get_atom
 	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_READY);
-
-	atoms_initialized = 1;
-    }
-
-  /* Install a ClientMessage event handler */
-
-  self->client_message_handler_id =
-      mb_wm_main_context_x_event_handler_add (wm->main_ctx,
-					      window,
-					      ClientMessage,
-					      (MBWMXEventFunc)
-					      hd_animation_actor_client_message,
-					      client);
+    if (!ring_tail_atom)
+	ring_tail_atom = hd_comp_mgr_get_atom
+	    (hmgr, HD_ATOM_HILDON_ANIMATION_CLIENT_RING_TAIL);
+
+  /* Route our ClientMessages to us by message type and window. */
+
+  for (i = 0; i < G_N_ELEMENTS (hd_animation_actor_messages); i++)
+      hd_atom_dispatch_add (ClientMessage,
+			    hd_comp_mgr_get_atom
+			      (hmgr, hd_animation_actor_messages[i].atom),
+			    window,
+			    (HdAtomHandlerFunc)
+			    hd_animation_actor_messages[i].func,
+			    client);
+  self->message_window = window;
+
+  if (!actors)
+      actors = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_insert (actors, GUINT_TO_POINTER (window), self);
 
   /* Force StructureNotifyMask event input on the window.
    *
@@ -313,7 +601,7 @@ hd_animation_actor_realize (MBWindowManagerClient *client)
 
   /* Set the ready atom on the window -- everything is in place to receive
    * ClientMessage events. */
-  long val = 1;
+  long val = HD_ANIMATION_READY | HD_ANIMATION_READY_RING;
   XChangeProperty (wm->xdpy, window,
 		   ready_atom,
 		   XA_ATOM, 32, PropModeReplace,
@@ -345,15 +633,17 @@ static void
 hd_animation_actor_destroy (MBWMObject *this)
 {
     HdAnimationActor      *self = HD_ANIMATION_ACTOR (this);
-    MBWindowManagerClient *client = MB_WM_CLIENT (this);
-    MBWindowManager       *wm = client->wmref;
 
-    if (self->client_message_handler_id)
-    {
-        mb_wm_main_context_x_event_handler_remove (wm->main_ctx,
-                                                   ClientMessage,
-                                                   self->client_message_handler_id);
-    }
+    if (self->message_window)
+      {
+        hd_atom_dispatch_remove_window (self->message_window);
+        if (g_hash_table_lookup (actors,
+                                 GUINT_TO_POINTER (self->message_window))
+            == self)
+          g_hash_table_remove (actors,
+                               GUINT_TO_POINTER (self->message_window));
+      }
+    hd_animation_actor_ring_unref (self);
 }
 
 static int
@@ -29,6 +29,7 @@
 
 typedef struct HdAnimationActor      HdAnimationActor;
 typedef struct HdAnimationActorClass HdAnimationActorClass;
+typedef struct HdAnimationActorRing  HdAnimationActorRing;
 
 #define HD_ANIMATION_ACTOR(c)       ((HdAnimationActor*)(c))
 #define HD_ANIMATION_ACTOR_CLASS(c) ((HdAnimationActorClass*)(c))
@@ -41,7 +42,8 @@ struct HdAnimationActor
 
   unsigned int     show : 1;
 
-  unsigned long    client_message_handler_id;
+  Window           message_window;
+  HdAnimationActorRing *ring;
   unsigned long    actor_destroy_handler_id;
 };
 
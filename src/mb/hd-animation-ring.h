@@ -0,0 +1,97 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Shared-memory command ring of HildonAnimationActor:s.
+ *
+ * Instead of sending a ClientMessage for every property change of every
+ * actor, a client can write the changes into a ring in shared memory
+ * and send one _HILDON_ANIMATION_CLIENT_MESSAGE_FRAME per frame.  We
+ * apply everything written up to then at once, just before the next
+ * redraw.
+ *
+ * _HILDON_ANIMATION_CLIENT_READY has HD_ANIMATION_READY_RING set if we
+ * support this.  The client then creates a System V shared memory
+ * segment holding an HdAnimationRing, and attaches actors to it with
+ * _HILDON_ANIMATION_CLIENT_MESSAGE_RING (l[0] is the key of the segment
+ * or 0 to detach).  An actor only obeys commands of the ring it's
+ * attached to; any number of actors of the client can share one ring.
+ *
+ * The client fills the commands of a frame starting at @head, then
+ * advances @head past all of them (with a memory barrier before) and
+ * sends _HILDON_ANIMATION_CLIENT_MESSAGE_FRAME (l[0] is the frame
+ * number) to any of the attached actors.  The segment must belong to
+ * the owner of the client, and we only ever read it.  Instead, after
+ * consuming commands we set _HILDON_ANIMATION_CLIENT_RING_TAIL (a
+ * CARDINAL) on the actor the last frame was sent to, to how far we got;
+ * the ring is full when @head - that == @n_commands.  Both counters run
+ * freely; a command's slot is the counter modulo @n_commands, which must
+ * be a power of two.
+ *
+ * This header is shared with the clients, so it doesn't depend on
+ * anything else.
+ */
+
+#ifndef __HD_ANIMATION_RING_H__
+#define __HD_ANIMATION_RING_H__
+
+#include <stdint.h>
+
+#define HD_ANIMATION_RING_MAGIC         0x48444152 /* HDAR */
+
+/* The bits of _HILDON_ANIMATION_CLIENT_READY. */
+#define HD_ANIMATION_READY              (1 << 0)
+#define HD_ANIMATION_READY_RING         (1 << 1)
+
+/* What a command does.  Its @args are the same as the data.l[] of the
+ * corresponding _HILDON_ANIMATION_CLIENT_MESSAGE_*. */
+typedef enum
+{
+  HD_ANIMATION_RING_SHOW = 0,
+  HD_ANIMATION_RING_POSITION,
+  HD_ANIMATION_RING_ROTATION,
+  HD_ANIMATION_RING_SCALE,
+  HD_ANIMATION_RING_ANCHOR,
+  HD_ANIMATION_RING_PARENT,
+} HdAnimationRingCommandType;
+
+typedef struct
+{
+  uint32_t window;      /* of the actor */
+  uint32_t frame;
+  uint32_t type;        /* HdAnimationRingCommandType */
+  int32_t  args[5];
+} HdAnimationRingCommand;
+
+typedef struct
+{
+  uint32_t          magic;
+  uint32_t          n_commands;
+  volatile uint32_t head;
+  uint32_t          reserved[5];
+  HdAnimationRingCommand commands[];
+} HdAnimationRing;
+
+/* How big the segment of a ring of @n commands must be. */
+#define HD_ANIMATION_RING_SIZE(n) \
+  (sizeof (HdAnimationRing) + (n) * sizeof (HdAnimationRingCommand))
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-atom-dispatch.h"
+
+typedef struct Slot Slot;
+
+typedef struct
+{
+  gulong             id;
+  Slot              *slot;
+  Window             xwin;
+  HdAtomHandlerFunc  func;
+  void              *userdata;
+} Handler;
+
+/* Everything registered for an atom. */
+struct Slot
+{
+  int         type;
+  Atom        atom;
+
+  /* Handlers of any window and Window -> GList of handlers of that
+   * window, both in the order of registration. */
+  GList      *any;
+  GHashTable *windows;
+
+  guint       events;
+};
+
+/* Atom -> Slot, of PropertyNotify:s and ClientMessage:s respectively. */
+static GHashTable *Slots[2];
+/* Id -> Handler */
+static GHashTable *Handlers;
+static gulong Last_id;
+static guint Dropped;
+
+static MBWindowManager *Wm;
+static unsigned long Mb_handlers[2];
+
+#define SLOTS_OF(type) Slots[(type) == ClientMessage]
+
+static Bool
+call (GList *li, XEvent *xev)
+{
+  GList *next;
+
+  /* Let handlers remove themselves. */
+  for (; li; li = next)
+    {
+      Handler *h = li->data;
+
+      next = li->next;
+      if (!h->func (xev, h->userdata))
+        return False;
+    }
+
+  return True;
+}
+
+static Bool
+dispatch (XEvent *xev, void *unused)
+{
+  Slot *slot;
+  GList *li;
+  Atom atom;
+
+  atom = xev->type == PropertyNotify
+    ? xev->xproperty.atom : xev->xclient.message_type;
+  slot = g_hash_table_lookup (SLOTS_OF (xev->type), GUINT_TO_POINTER (atom));
+  if (!slot)
+    {
+      Dropped++;
+      return True;
+    }
+
+  slot->events++;
+  if (slot->windows
+      && (li = g_hash_table_lookup (slot->windows,
+                                    GUINT_TO_POINTER (xev->xany.window)))
+      && !call (li, xev))
+    return False;
+
+  return call (slot->any, xev);
+}
+
+static void
+free_window_handlers (gpointer xwin, gpointer list, gpointer unused)
+{
+  g_list_free (list);
+}
+
+static void
+free_slot (Slot *slot)
+{
+  g_list_free (slot->any);
+  if (slot->windows)
+    {
+      /* The lists are modified in place, so the table can't own them. */
+      g_hash_table_foreach (slot->windows, free_window_handlers, NULL);
+      g_hash_table_destroy (slot->windows);
+    }
+  g_slice_free (Slot, slot);
+}
+
+static void
+free_handler (Handler *h)
+{
+  g_slice_free (Handler, h);
+}
+
+void
+hd_atom_dispatch_init (MBWindowManager *wm)
+{
+  Wm = wm;
+  Slots[0] = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                    (GDestroyNotify)free_slot);
+  Slots[1] = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                    (GDestroyNotify)free_slot);
+  Handlers = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                    (GDestroyNotify)free_handler);
+
+  Mb_handlers[0] = mb_wm_main_context_x_event_handler_add (wm->main_ctx,
+                          None, PropertyNotify,
+                          (MBWMXEventFunc)dispatch, NULL);
+  Mb_handlers[1] = mb_wm_main_context_x_event_handler_add (wm->main_ctx,
+                          None, ClientMessage,
+                          (MBWMXEventFunc)dispatch, NULL);
+}
+
+void
+hd_atom_dispatch_fini (void)
+{
+  if (!Wm)
+    return;
+
+  mb_wm_main_context_x_event_handler_remove (Wm->main_ctx, PropertyNotify,
+                                             Mb_handlers[0]);
+  mb_wm_main_context_x_event_handler_remove (Wm->main_ctx, ClientMessage,
+                                             Mb_handlers[1]);
+  g_hash_table_destroy (Slots[0]);
+  g_hash_table_destroy (Slots[1]);
+  g_hash_table_destroy (Handlers);
+  Slots[0] = Slots[1] = Handlers = NULL;
+  Wm = NULL;
+}
+
+gulong
+hd_atom_dispatch_add (int type, Atom atom, Window xwin,
+                      HdAtomHandlerFunc func, void *userdata)
+{
+  GHashTable *slots;
+  Slot *slot;
+  Handler *h;
+  GList *list;
+
+  g_return_val_if_fail (Wm != NULL, 0);
+  g_return_val_if_fail (type == PropertyNotify || type == ClientMessage, 0);
+
+  slots = SLOTS_OF (type);
+  if (!(slot = g_hash_table_lookup (slots, GUINT_TO_POINTER (atom))))
+    {
+      slot = g_slice_new0 (Slot);
+      slot->type = type;
+      slot->atom = atom;
+      g_hash_table_insert (slots, GUINT_TO_POINTER (atom), slot);
+    }
+
+  h = g_slice_new (Handler);
+  h->id = ++Last_id;
+  h->slot = slot;
+  h->xwin = xwin;
+  h->func = func;
+  h->userdata = userdata;
+  g_hash_table_insert (Handlers, GSIZE_TO_POINTER (h->id), h);
+
+  if (xwin == None)
+    slot->any = g_list_append (slot->any, h);
+  else
+    {
+      if (!slot->windows)
+        slot->windows = g_hash_table_new (g_direct_hash, g_direct_equal);
+      list = g_hash_table_lookup (slot->windows, GUINT_TO_POINTER (xwin));
+      g_hash_table_insert (slot->windows, GUINT_TO_POINTER (xwin),
+                           g_list_append (list, h));
+    }
+
+  return h->id;
+}
+
+/* Takes @h out of its slot, but not out of Handlers.  The slot itself
+ * stays even if it's empty; there are only so many atoms. */
+static void
+unlink_handler (Handler *h)
+{
+  Slot *slot = h->slot;
+  GList *list;
+
+  if (h->xwin == None)
+    {
+      slot->any = g_list_remove (slot->any, h);
+      return;
+    }
+
+  list = g_hash_table_lookup (slot->windows, GUINT_TO_POINTER (h->xwin));
+  if ((list = g_list_remove (list, h)) != NULL)
+    g_hash_table_insert (slot->windows, GUINT_TO_POINTER (h->xwin), list);
+  else
+    g_hash_table_remove (slot->windows, GUINT_TO_POINTER (h->xwin));
+}
+
+void
+hd_atom_dispatch_remove (gulong id)
+{
+  Handler *h;
+
+  if (!Handlers
+      || !(h = g_hash_table_lookup (Handlers, GSIZE_TO_POINTER (id))))
+    return;
+
+  unlink_handler (h);
+  g_hash_table_remove (Handlers, GSIZE_TO_POINTER (id));
+}
+
+static gboolean
+unlink_if_of_window (gpointer id, gpointer h, gpointer xwin)
+{
+  if (((Handler *)h)->xwin != GPOINTER_TO_UINT (xwin))
+    return FALSE;
+
+  unlink_handler (h);
+  return TRUE;
+}
+
+void
+hd_atom_dispatch_remove_window (Window xwin)
+{
+  if (Handlers && xwin != None)
+    g_hash_table_foreach_remove (Handlers, unlink_if_of_window,
+                                 GUINT_TO_POINTER (xwin));
+}
+
+static void
+foreach_slot_stat (gpointer atom, gpointer slot, gpointer args)
+{
+  HdAtomDispatchStatFunc func = ((gpointer *)args)[0];
+
+  func (((Slot *)slot)->type, ((Slot *)slot)->atom, ((Slot *)slot)->events,
+        ((gpointer *)args)[1]);
+}
+
+void
+hd_atom_dispatch_foreach_stat (HdAtomDispatchStatFunc func, void *userdata)
+{
+  gpointer args[] = { func, userdata };
+
+  if (!Wm)
+    return;
+  g_hash_table_foreach (Slots[0], foreach_slot_stat, args);
+  g_hash_table_foreach (Slots[1], foreach_slot_stat, args);
+}
+
+guint
+hd_atom_dispatch_get_dropped (void)
+{
+  return Dropped;
+}
+
+static void
+reset_slot_stat (gpointer atom, gpointer slot, gpointer unused)
+{
+  ((Slot *)slot)->events = 0;
+}
+
+void
+hd_atom_dispatch_reset_stats (void)
+{
+  Dropped = 0;
+  if (!Wm)
+    return;
+  g_hash_table_foreach (Slots[0], reset_slot_stat, NULL);
+  g_hash_table_foreach (Slots[1], reset_slot_stat, NULL);
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Routes PropertyNotify and ClientMessage events to the handlers
+ * registered for their atom (property or message type) in a hash table,
+ * so an event costs one lookup no matter how many atoms we care about.
+ * Events of atoms nobody registered for are passed on to matchbox right
+ * away, before anyone goes looking for the client of the window.
+ *
+ * A handler is registered for every window (@xwin == None) or for a
+ * single one; the latter are kept in a table by window, so per-window
+ * handlers (eg. those of HdAnimationActor) don't slow each other down.
+ * Handlers return False to stop the event like MBWMXEventFunc:s do.
+ */
+
+#ifndef __HD_ATOM_DISPATCH_H__
+#define __HD_ATOM_DISPATCH_H__
+
+#include <matchbox/core/mb-wm.h>
+
+typedef Bool (*HdAtomHandlerFunc) (XEvent *xev, void *userdata);
+
+void hd_atom_dispatch_init (MBWindowManager *wm);
+void hd_atom_dispatch_fini (void);
+
+/* @type is PropertyNotify or ClientMessage.  Returns an id for
+ * hd_atom_dispatch_remove(). */
+gulong hd_atom_dispatch_add (int type, Atom atom, Window xwin,
+                             HdAtomHandlerFunc func, void *userdata);
+void hd_atom_dispatch_remove (gulong id);
+
+/* Removes all handlers registered for @xwin. */
+void hd_atom_dispatch_remove_window (Window xwin);
+
+/* How many events of each atom were routed, and how many were dropped
+ * because nobody was interested, since the last reset. */
+typedef void (*HdAtomDispatchStatFunc) (int type, Atom atom, guint events,
+                                        void *userdata);
+void hd_atom_dispatch_foreach_stat (HdAtomDispatchStatFunc func,
+                                    void *userdata);
+guint hd_atom_dispatch_get_dropped (void);
+void hd_atom_dispatch_reset_stats (void);
+
+#endif
@@ -63,7 +63,10 @@ hd_atoms_init (Display * xdpy, Atom * atoms)
     "_HILDON_ANIMATION_CLIENT_MESSAGE_SCALE",
     "_HILDON_ANIMATION_CLIENT_MESSAGE_ANCHOR",
     "_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT",
+    "_HILDON_ANIMATION_CLIENT_MESSAGE_RING",
+    "_HILDON_ANIMATION_CLIENT_MESSAGE_FRAME",
     "_HILDON_ANIMATION_CLIENT_READY",
+    "_HILDON_ANIMATION_CLIENT_RING_TAIL",
 
     "_HILDON_TEXTURE_CLIENT_MESSAGE_SHM",
     "_HILDON_TEXTURE_CLIENT_MESSAGE_DAMAGE",
@@ -87,6 +90,9 @@ hd_atoms_init (Display * xdpy, Atom * atoms)
     "_MAEMO_ROTATION_TRANSITION",
     "_MAEMO_ROTATION_PATIENCE",
     "_MAEMO_SCREEN_SIZE",
+    /* Used to know when clients have redrawn after rotation */
+    "_NET_WM_SYNC_REQUEST",
+    "_NET_WM_SYNC_REQUEST_COUNTER",
   };
 
   XInternAtoms (xdpy,
@@ -58,7 +58,10 @@ typedef enum HdAtoms
   HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_SCALE,
   HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_ANCHOR,
   HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT,
+  HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_RING,
+  HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_FRAME,
   HD_ATOM_HILDON_ANIMATION_CLIENT_READY,
+  HD_ATOM_HILDON_ANIMATION_CLIENT_RING_TAIL,
 
   HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHM,
   HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_DAMAGE,
@@ -82,6 +85,9 @@ typedef enum HdAtoms
   HD_ATOM_MAEMO_ROTATION_PATIENCE,
   HD_ATOM_MAEMO_SCREEN_SIZE,
 
+  HD_ATOM_NET_WM_SYNC_REQUEST,
+  HD_ATOM_NET_WM_SYNC_REQUEST_COUNTER,
+
   _HD_ATOM_LAST
 } HdAtoms;
 
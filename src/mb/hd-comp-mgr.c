@@ -28,6 +28,7 @@
 #include "hd-home.h"
 #include "hd-dbus.h"
 #include "hd-atoms.h"
+#include "hd-atom-dispatch.h"
 #include "hd-util.h"
 #include "hd-transition.h"
 #include "hd-wm.h"
@@ -41,6 +42,7 @@
 #include "hd-orientation-lock.h"
 #include "launcher/hd-app-mgr.h"
 #include "launcher/hd-launcher-editor.h"
+#include "hd-profiler.h"
 
 #include <matchbox/core/mb-wm.h>
 #include <matchbox/core/mb-window-manager.h>
@@ -49,11 +51,13 @@
 
 #include <X11/extensions/Xcomposite.h>
 #include <X11/extensions/shape.h>
+#include <X11/Xatom.h>
 
 #include <clutter/clutter.h>
 #include <clutter/x11/clutter-x11.h>
 
 #include "../tidy/tidy-blur-group.h"
+#include "../tidy/tidy-cached-group.h"
 
 #include <dbus/dbus-glib-bindings.h>
 #include <mce/dbus-names.h>
@@ -108,7 +112,6 @@ struct HdCompMgrPrivate
   HdCompMgrClient       *current_hclient;
 
   /* Track changes to the PORTRAIT properties. */
-  unsigned long          property_changed_cb_id;
 
   /* MCE D-Bus Proxy */
   DBusGProxy            *mce_proxy;
@@ -142,6 +145,28 @@ struct HdCompMgrClientPrivate
 extern gboolean hd_dbus_display_is_off;
 static guint portrait_freshness_counter;
 
+/* What the portrait decisions need to know about a client which only
+ * changes with its WM_CLASS, so we don't need to ask the server every
+ * time.  Kept in @Portrait_info until the client is unregistered. */
+typedef struct
+{
+  gchar *res_name, *res_class;
+
+  /* Whether the application has X-CSSU-Force-Landscape, or -1 if we
+   * couldn't match it with an application yet. */
+  gint forced_landscape;
+} HdPortraitInfo;
+
+static GHashTable *Portrait_info;
+
+/* hd_comp_mgr_may_be_portrait()'s view of the stack, valid as long as
+ * @Portrait_cached == @Portrait_stamp.  Anything which may change it
+ * bumps the stamp with hd_comp_mgr_portrait_invalidate(). */
+static guint Portrait_stamp = 1, Portrait_cached;
+static gboolean Portrait_requests, Portrait_supports;
+
+static HdCompMgrPortraitStats Portrait_stats;
+
 HdRunningApp *hd_comp_mgr_client_get_app_key (HdCompMgrClient *client,
                                                HdCompMgr *hmgr);
 
@@ -445,8 +470,7 @@ static void hd_comp_mgr_unmap_notify
 static void hd_comp_mgr_turn_on (MBWMCompMgr *mgr);
 static void hd_comp_mgr_effect (MBWMCompMgr *mgr, MBWindowManagerClient *c,
                                 MBWMCompMgrClientEvent event);
-static Bool hd_comp_mgr_client_property_changed (XPropertyEvent *event,
-                                                 HdCompMgr *hmgr);
+static void hd_comp_mgr_register_property_handlers (HdCompMgr *hmgr);
 
 int
 hd_comp_mgr_class_type ()
@@ -603,10 +627,9 @@ hd_comp_mgr_init (MBWMObject *obj, va_list vap)
 			   NULL,
                (GDestroyNotify)mb_wm_object_unref);
 
-  /* Be notified about all X window property changes around here. */
-  priv->property_changed_cb_id = mb_wm_main_context_x_event_handler_add (
-                   cmgr->wm->main_ctx, None, PropertyNotify,
-                   (MBWMXEventFunc)hd_comp_mgr_client_property_changed, cmgr);
+  /* Be notified about the X window property changes we care about. */
+  hd_atom_dispatch_init (wm);
+  hd_comp_mgr_register_property_handlers (hmgr);
 
   if (hd_orientation_lock_is_locked_to_portrait ())
     hd_render_manager_set_state(HDRM_STATE_HOME_PORTRAIT);
@@ -650,10 +673,7 @@ hd_comp_mgr_destroy (MBWMObject *obj)
     }
   g_object_unref( priv->render_manager );
 
-  mb_wm_main_context_x_event_handler_remove (
-                                     MB_WM_COMP_MGR (obj)->wm->main_ctx,
-                                     PropertyNotify,
-                                     priv->property_changed_cb_id);
+  hd_atom_dispatch_fini ();
 
   if (priv->mce_proxy)
     {
@@ -685,215 +705,215 @@ hd_comp_mgr_client_prefers_compositing (MBWindowManagerClient *c)
   return !(HD_IS_APP (c) && hd_comp_mgr_is_non_composited (c, FALSE));
 }
 
-/* Called on #PropertyNotify to handle changes to
- * _HILDON_PORTRAIT_MODE_SUPPORT and _HILDON_PORTRAIT_MODE_REQUEST
- * and _HILDON_APP_KILLABLE and _HILDON_ABLE_TO_HIBERNATE
- * and _HILDON_DO_NOT_DISTURB and _HILDON_NOTIFICATION_THREAD. */
-Bool
-hd_comp_mgr_client_property_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+/* PropertyNotify handlers, registered with hd_atom_dispatch_add() for
+ * their atom in hd_comp_mgr_init().  Like any MBWMXEventFunc, they return
+ * False if nobody else needs to see the event. */
+
+static Bool
+live_background_changed (XPropertyEvent *event, HdCompMgr *hmgr)
 {
-  Atom killable, able_to_hibernate, dnd, nothread;
-  gboolean non_comp_changed;
-  gint value;
-  MBWindowManager *wm;
-  HdCompMgrClient *cc;
+  HdCompMgrPrivate *priv = hmgr->priv;
   MBWindowManagerClient *c;
 
-  if (event->type != PropertyNotify)
-    return True;
-
-  killable = hd_comp_mgr_get_atom (hmgr, HD_ATOM_HILDON_APP_KILLABLE);
-  able_to_hibernate = hd_comp_mgr_get_atom (hmgr,
-                          HD_ATOM_HILDON_ABLE_TO_HIBERNATE);
-  dnd = hd_comp_mgr_get_atom (hmgr, HD_ATOM_HILDON_DO_NOT_DISTURB);
-
-  wm = MB_WM_COMP_MGR (hmgr)->wm;
+  c = mb_wm_managed_client_from_xwindow (MB_WM_COMP_MGR (hmgr)->wm,
+                                         event->window);
+  if (c)
+    {
+      /* TODO: handle zero value */
+      ClutterActor *actor;
+      MBWMCompMgrClutterClient *cclient =
+            MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client);
+      actor = mb_wm_comp_mgr_clutter_client_get_actor (cclient);
+      /*g_printerr ("%s: client '%s' now has live-bg value %d\n", __func__,
+                  mb_wm_client_get_name (c),
+                  c->window->live_background);*/
+      mb_wm_comp_mgr_clutter_client_set_flags (cclient,
+                               MBWMCompMgrClutterClientDontPosition);
+      /* remove it from the switcher */
+      if (hd_task_navigator_has_window (hd_task_navigator, actor))
+        hd_switcher_remove_window_actor (priv->switcher_group,
+                                         actor, cclient);
+      hd_home_set_live_background (HD_HOME (priv->home), c);
+      if(STATE_IS_PORTRAIT (hd_render_manager_get_state ()))
+        hd_render_manager_set_state (HDRM_STATE_HOME_PORTRAIT);
+      else
+        hd_render_manager_set_state (HDRM_STATE_HOME);
+      hd_launcher_hide ();
+    }
+  return False;
+}
 
-  if (event->atom == wm->atoms[MBWM_ATOM_HILDON_LIVE_DESKTOP_BACKGROUND])
+/* _HILDON_WM_WINDOW_PROGRESS_INDICATOR and _HILDON_WM_WINDOW_MENU_INDICATOR */
+static Bool
+title_indicator_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  /* Redraw the title to display/remove the progress indicator or app
+   * menu indicator. The title itself will check what the new state should
+   * be. NOTE: we have to redo dialog titles here too, so we can't just
+   * use hd_title_bar_update. */
+  MBWindowManagerClient *top;
+  /* previous mb_wm_client_decor_mark_dirty didn't actually cause a redraw,
+   * so mark the decor itself dirty */
+  top = mb_wm_managed_client_from_xwindow(MB_WM_COMP_MGR (hmgr)->wm,
+                                          event->window);
+  if (top)
     {
-      HdCompMgrPrivate *priv = hmgr->priv;
-      c = mb_wm_managed_client_from_xwindow (wm, event->window);
-      if (c)
+      MBWMList *l = top->decor;
+      while (l)
         {
-          /* TODO: handle zero value */
-          ClutterActor *actor;
-          MBWMCompMgrClutterClient *cclient =
-                MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client);
-          actor = mb_wm_comp_mgr_clutter_client_get_actor (cclient);
-          /*g_printerr ("%s: client '%s' now has live-bg value %d\n", __func__,
-                      mb_wm_client_get_name (c),
-                      c->window->live_background);*/
-          mb_wm_comp_mgr_clutter_client_set_flags (cclient,
-                                   MBWMCompMgrClutterClientDontPosition);
-          /* remove it from the switcher */
-          if (hd_task_navigator_has_window (hd_task_navigator, actor))
-            hd_switcher_remove_window_actor (priv->switcher_group,
-                                             actor, cclient);
-          hd_home_set_live_background (HD_HOME (priv->home), c);
-          if(STATE_IS_PORTRAIT (hd_render_manager_get_state ()))
-            hd_render_manager_set_state (HDRM_STATE_HOME_PORTRAIT);
-          else
-            hd_render_manager_set_state (HDRM_STATE_HOME);
-          hd_launcher_hide ();
-        }
-      return False;
-    }
-
-  if (event->atom==
-    hd_comp_mgr_get_atom (hmgr, HD_ATOM_HILDON_WM_WINDOW_PROGRESS_INDICATOR) ||
-      event->atom==
-    hd_comp_mgr_get_atom (hmgr, HD_ATOM_HILDON_WM_WINDOW_MENU_INDICATOR))
-    {
-      /* Redraw the title to display/remove the progress indicator or app
-       * menu indicator. The title itself will check what the new state should
-       * be. NOTE: we have to redo dialog titles here too, so we can't just
-       * use hd_title_bar_update. */
-      MBWindowManagerClient *top;
-      /* previous mb_wm_client_decor_mark_dirty didn't actually cause a redraw,
-       * so mark the decor itself dirty */
-      top = mb_wm_managed_client_from_xwindow(MB_WM_COMP_MGR (hmgr)->wm,
-                                              event->window);
-      if (top)
-        {
-          MBWMList *l = top->decor;
-          while (l)
-            {
-              MBWMDecor *decor = l->data;
-              if (decor->type == MBWMDecorTypeNorth)
-                mb_wm_decor_mark_dirty (decor);
-              l = l->next;
-            }
+          MBWMDecor *decor = l->data;
+          if (decor->type == MBWMDecorTypeNorth)
+            mb_wm_decor_mark_dirty (decor);
+          l = l->next;
         }
     }
+  return True;
+}
+
+/* _NET_WM_STATE and _HILDON_NON_COMPOSITED_WINDOW */
+static Bool
+non_composited_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  MBWindowManager *wm = MB_WM_COMP_MGR (hmgr)->wm;
+  MBWindowManagerClient *c;
+  gboolean non_comp_changed;
 
   non_comp_changed = event->atom ==
         hd_comp_mgr_get_atom (hmgr, HD_ATOM_HILDON_NON_COMPOSITED_WINDOW);
-  if (event->atom == wm->atoms[MBWM_ATOM_NET_WM_STATE] || non_comp_changed)
+  c = mb_wm_managed_client_from_xwindow (wm, event->window);
+  if (c && HD_IS_APP (c))
     {
-      c = mb_wm_managed_client_from_xwindow (wm, event->window);
-      if (c && HD_IS_APP (c))
-        {
-          gboolean client_non_comp;
-          MBWindowManagerClient *tmp;
-          gboolean found = FALSE;
-          /* check if there is a window above that needs compositing */
-          for (tmp = c->stacked_above; tmp; tmp = tmp->stacked_above)
-            if (mb_wm_client_is_map_confirmed (tmp) &&
-                hd_comp_mgr_client_prefers_compositing (tmp))
-              {
-                found = TRUE;
-                break;
-              }
-          client_non_comp = hd_comp_mgr_is_non_composited (c, non_comp_changed);
-          if (hd_render_manager_get_state () == HDRM_STATE_NON_COMPOSITED &&
-	      !client_non_comp)
-            hd_render_manager_set_state (HDRM_STATE_APP);
-          else if (hd_render_manager_get_state () == HDRM_STATE_NON_COMP_PORT
-                   && !client_non_comp)
-            hd_render_manager_set_state (HDRM_STATE_APP_PORTRAIT);
-          else if (hd_render_manager_get_state () == HDRM_STATE_APP &&
-                   !hd_transition_is_rotating () &&
-	           client_non_comp && !found)
-            hd_render_manager_set_state (HDRM_STATE_NON_COMPOSITED);
-          else if (hd_render_manager_get_state () == HDRM_STATE_APP_PORTRAIT &&
-                   !hd_transition_is_rotating () &&
-	           client_non_comp && !found)
-            hd_render_manager_set_state (HDRM_STATE_NON_COMP_PORT);
-        }
+      gboolean client_non_comp;
+      MBWindowManagerClient *tmp;
+      gboolean found = FALSE;
+      /* check if there is a window above that needs compositing */
+      for (tmp = c->stacked_above; tmp; tmp = tmp->stacked_above)
+        if (mb_wm_client_is_map_confirmed (tmp) &&
+            hd_comp_mgr_client_prefers_compositing (tmp))
+          {
+            found = TRUE;
+            break;
+          }
+      client_non_comp = hd_comp_mgr_is_non_composited (c, non_comp_changed);
+      if (hd_render_manager_get_state () == HDRM_STATE_NON_COMPOSITED &&
+          !client_non_comp)
+        hd_render_manager_set_state (HDRM_STATE_APP);
+      else if (hd_render_manager_get_state () == HDRM_STATE_NON_COMP_PORT
+               && !client_non_comp)
+        hd_render_manager_set_state (HDRM_STATE_APP_PORTRAIT);
+      else if (hd_render_manager_get_state () == HDRM_STATE_APP &&
+               !hd_transition_is_rotating () &&
+               client_non_comp && !found)
+        hd_render_manager_set_state (HDRM_STATE_NON_COMPOSITED);
+      else if (hd_render_manager_get_state () == HDRM_STATE_APP_PORTRAIT &&
+               !hd_transition_is_rotating () &&
+               client_non_comp && !found)
+        hd_render_manager_set_state (HDRM_STATE_NON_COMP_PORT);
     }
-  /* Check for changes to the hibernable state. */
-  if (event->atom == killable ||
-      event->atom == able_to_hibernate)
-    {
-      HdRunningApp *app, *current_app;
-      c = mb_wm_managed_client_from_xwindow (wm, event->window);
-      if (!c || !c->cm_client)
-        return False;
-      cc = HD_COMP_MGR_CLIENT (c->cm_client);
-      if (event->state == PropertyNewValue)
-        cc->priv->can_hibernate = TRUE;
-      else
-        cc->priv->can_hibernate = FALSE;
+  return True;
+}
 
-      /* Change the hibernable state of the app only if it's not the
-       * current app.
-       */
-      app = cc->priv->app;
-      if (!app)
-        return False;
-      current_app =
-        hd_comp_mgr_client_get_app (hd_comp_mgr_get_current_client (hmgr));
-      if (!current_app || app == current_app)
-        return False;
-
-      if (event->state == PropertyNewValue)
-        hd_app_mgr_hibernatable(app, TRUE);
-      else
-        hd_app_mgr_hibernatable (app, FALSE);
+/* _HILDON_APP_KILLABLE and _HILDON_ABLE_TO_HIBERNATE */
+static Bool
+hibernable_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  HdRunningApp *app, *current_app;
+  MBWindowManagerClient *c;
+  HdCompMgrClient *cc;
 
-      return False;
-    }
+  c = mb_wm_managed_client_from_xwindow (MB_WM_COMP_MGR (hmgr)->wm,
+                                         event->window);
+  if (!c || !c->cm_client)
+    return False;
+  cc = HD_COMP_MGR_CLIENT (c->cm_client);
+  if (event->state == PropertyNewValue)
+    cc->priv->can_hibernate = TRUE;
+  else
+    cc->priv->can_hibernate = FALSE;
 
-  if (event->atom == dnd)
-    {
-      hd_comp_mgr_check_do_not_disturb_flag (hmgr);
-      return FALSE;
-    }
+  /* Change the hibernable state of the app only if it's not the
+   * current app.
+   */
+  app = cc->priv->app;
+  if (!app)
+    return False;
+  current_app =
+    hd_comp_mgr_client_get_app (hd_comp_mgr_get_current_client (hmgr));
+  if (!current_app || app == current_app)
+    return False;
+
+  if (event->state == PropertyNewValue)
+    hd_app_mgr_hibernatable(app, TRUE);
+  else
+    hd_app_mgr_hibernatable (app, FALSE);
 
-  nothread = hd_comp_mgr_get_atom (hmgr, HD_ATOM_NOTIFICATION_THREAD);
-  if (event->atom == nothread)
-    {
-      char *str;
-      ClutterActor *a;
+  return False;
+}
 
-      c = mb_wm_managed_client_from_xwindow (wm, event->window);
-      if (!c || !c->cm_client)
-        return False;
-      a = mb_wm_comp_mgr_clutter_client_get_actor (
-                          MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client));
-      str = event->state == PropertyNewValue
-        ? hd_util_get_x_window_string_property (wm, c->window->xwindow,
-                                                HD_ATOM_NOTIFICATION_THREAD)
-        : NULL;
-      if (event->state != PropertyNewValue || str)
-        /* Otherwise don't mess up more. */
-        hd_task_navigator_notification_thread_changed (hd_task_navigator,
-                                                       a, str);
-      return False;
-    }
+static Bool
+do_not_disturb_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  hd_comp_mgr_check_do_not_disturb_flag (hmgr);
+  return False;
+}
 
-  /* Process XVIDEO flag. If this changed then we'll want to look again at
-   * how we should blur. */
-  if (event->atom == hd_comp_mgr_get_atom (hmgr, HD_ATOM_OMAP_VIDEO_OVERLAY))
-    {
-      c = mb_wm_managed_client_from_xwindow (wm, event->window);
+static Bool
+notification_thread_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  MBWindowManager *wm = MB_WM_COMP_MGR (hmgr)->wm;
+  MBWindowManagerClient *c;
+  char *str;
+  ClutterActor *a;
+
+  c = mb_wm_managed_client_from_xwindow (wm, event->window);
+  if (!c || !c->cm_client)
+    return False;
+  a = mb_wm_comp_mgr_clutter_client_get_actor (
+                      MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client));
+  str = event->state == PropertyNewValue
+    ? hd_util_get_x_window_string_property (wm, c->window->xwindow,
+                                            HD_ATOM_NOTIFICATION_THREAD)
+    : NULL;
+  if (event->state != PropertyNewValue || str)
+    /* Otherwise don't mess up more. */
+    hd_task_navigator_notification_thread_changed (hd_task_navigator,
+                                                   a, str);
+  return False;
+}
 
-      if (c && (cc = HD_COMP_MGR_CLIENT(c->cm_client)))
-        {
-          cc->priv->has_video_overlay = hd_util_client_has_video_overlay(c);
-          hd_render_manager_update_blur_state();
-        }
-    }
+/* Process XVIDEO flag. If this changed then we'll want to look again at
+ * how we should blur. */
+static Bool
+video_overlay_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  MBWindowManagerClient *c;
+  HdCompMgrClient *cc;
 
-  /* Process PORTRAIT flags */
-  if (event->atom == wm->atoms[MBWM_ATOM_HILDON_PORTRAIT_MODE_SUPPORT])
+  c = mb_wm_managed_client_from_xwindow (MB_WM_COMP_MGR (hmgr)->wm,
+                                         event->window);
+  if (c && (cc = HD_COMP_MGR_CLIENT(c->cm_client)))
     {
-      if (!(c = mb_wm_managed_client_from_xwindow (wm, event->window)))
-        return False;
-
-      value = c->window->portrait_supported;
-      hd_task_navigator_update_win_orientation(event->window, value);
+      cc->priv->has_video_overlay = hd_util_client_has_video_overlay(c);
+      hd_render_manager_update_blur_state();
     }
-  else if (event->atom == wm->atoms[MBWM_ATOM_HILDON_PORTRAIT_MODE_REQUEST])
-    {
-      if (!(c = mb_wm_managed_client_from_xwindow (wm, event->window)))
-        return False;
+  return True;
+}
 
-      value = c->window->portrait_requested;
-      hd_task_navigator_update_win_orientation(event->window, value);
-    }
-  else
-    return True;
+/* _HILDON_PORTRAIT_MODE_SUPPORT and _HILDON_PORTRAIT_MODE_REQUEST */
+static Bool
+portrait_flags_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  MBWindowManager *wm = MB_WM_COMP_MGR (hmgr)->wm;
+  MBWindowManagerClient *c;
+  gint value;
+
+  if (!(c = mb_wm_managed_client_from_xwindow (wm, event->window)))
+    return False;
+
+  hd_comp_mgr_portrait_invalidate ();
+  value = event->atom == wm->atoms[MBWM_ATOM_HILDON_PORTRAIT_MODE_SUPPORT]
+    ? c->window->portrait_supported : c->window->portrait_requested;
+  hd_task_navigator_update_win_orientation(event->window, value);
 
   /* Switch HDRM state if we need to.  Don't consider changing the state if
    * it is approved by the new value of the property.  We must reconsider
@@ -917,6 +937,83 @@ hd_comp_mgr_client_property_changed (XPropertyEvent *event, HdCompMgr *hmgr)
   return False;
 }
 
+/* WM_CLASS, WM_TRANSIENT_FOR and _NET_WM_STATE change what we think of
+ * the portraitness of the window. */
+static Bool
+portrait_inputs_changed (XPropertyEvent *event, HdCompMgr *hmgr)
+{
+  MBWindowManagerClient *c;
+
+  if (event->atom == XA_WM_CLASS && Portrait_info
+      && (c = mb_wm_managed_client_from_xwindow (MB_WM_COMP_MGR (hmgr)->wm,
+                                                 event->window)))
+    g_hash_table_remove (Portrait_info, c);
+  hd_comp_mgr_portrait_invalidate ();
+  return True;
+}
+
+/* Registers the handlers of the window properties we're interested in. */
+static void
+hd_comp_mgr_register_property_handlers (HdCompMgr *hmgr)
+{
+  static const struct
+  {
+    HdAtoms        atom;
+    MBWMXEventFunc func;
+  } hd_props[] =
+  {
+    { HD_ATOM_HILDON_WM_WINDOW_PROGRESS_INDICATOR,
+      (MBWMXEventFunc)title_indicator_changed },
+    { HD_ATOM_HILDON_WM_WINDOW_MENU_INDICATOR,
+      (MBWMXEventFunc)title_indicator_changed },
+    { HD_ATOM_HILDON_NON_COMPOSITED_WINDOW,
+      (MBWMXEventFunc)non_composited_changed },
+    { HD_ATOM_HILDON_APP_KILLABLE,
+      (MBWMXEventFunc)hibernable_changed },
+    { HD_ATOM_HILDON_ABLE_TO_HIBERNATE,
+      (MBWMXEventFunc)hibernable_changed },
+    { HD_ATOM_HILDON_DO_NOT_DISTURB,
+      (MBWMXEventFunc)do_not_disturb_changed },
+    { HD_ATOM_NOTIFICATION_THREAD,
+      (MBWMXEventFunc)notification_thread_changed },
+    { HD_ATOM_OMAP_VIDEO_OVERLAY,
+      (MBWMXEventFunc)video_overlay_changed },
+  };
+  static const struct
+  {
+    int            atom;
+    MBWMXEventFunc func;
+  } mb_props[] =
+  {
+    { MBWM_ATOM_HILDON_LIVE_DESKTOP_BACKGROUND,
+      (MBWMXEventFunc)live_background_changed },
+    { MBWM_ATOM_NET_WM_STATE,
+      (MBWMXEventFunc)non_composited_changed },
+    { MBWM_ATOM_HILDON_PORTRAIT_MODE_SUPPORT,
+      (MBWMXEventFunc)portrait_flags_changed },
+    { MBWM_ATOM_HILDON_PORTRAIT_MODE_REQUEST,
+      (MBWMXEventFunc)portrait_flags_changed },
+  };
+  MBWindowManager *wm = MB_WM_COMP_MGR (hmgr)->wm;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (hd_props); i++)
+    hd_atom_dispatch_add (PropertyNotify,
+                          hd_comp_mgr_get_atom (hmgr, hd_props[i].atom),
+                          None, (HdAtomHandlerFunc)hd_props[i].func, hmgr);
+  for (i = 0; i < G_N_ELEMENTS (mb_props); i++)
+    hd_atom_dispatch_add (PropertyNotify, wm->atoms[mb_props[i].atom],
+                          None, (HdAtomHandlerFunc)mb_props[i].func, hmgr);
+
+  hd_atom_dispatch_add (PropertyNotify, XA_WM_CLASS, None,
+                        (HdAtomHandlerFunc)portrait_inputs_changed, hmgr);
+  hd_atom_dispatch_add (PropertyNotify, XA_WM_TRANSIENT_FOR, None,
+                        (HdAtomHandlerFunc)portrait_inputs_changed, hmgr);
+  hd_atom_dispatch_add (PropertyNotify, wm->atoms[MBWM_ATOM_NET_WM_STATE],
+                        None, (HdAtomHandlerFunc)portrait_inputs_changed,
+                        hmgr);
+}
+
 static void
 hd_comp_mgr_turn_on (MBWMCompMgr *mgr)
 {
@@ -1208,6 +1305,10 @@ hd_comp_mgr_unregister_client (MBWMCompMgr *mgr, MBWindowManagerClient *c)
   g_debug ("%s, c=%p ctype=%d", __FUNCTION__, c, MB_WM_CLIENT_CLIENT_TYPE (c));
   actor = mb_wm_comp_mgr_clutter_client_get_actor (cclient);
 
+  if (Portrait_info)
+    g_hash_table_remove (Portrait_info, c);
+  hd_comp_mgr_portrait_invalidate ();
+
   /* Check if it's the last window for the app. */
   if (hclient->priv->app)
     {
@@ -1491,6 +1592,9 @@ hd_comp_mgr_texture_update_area(HdCompMgr *hmgr,
           if (tidy_blur_group_source_buffered(parent))
             blur_update = TRUE;
         }
+      /* and groups caching by themselves that they aren't idle */
+      else if (tidy_cached_group_get_auto_cache(parent))
+        tidy_cached_group_changed(parent);
       parent = clutter_actor_get_parent(parent);
     }
 
@@ -2066,6 +2170,7 @@ hd_comp_mgr_map_notify (MBWMCompMgr *mgr, MBWindowManagerClient *c)
            c && c->window ? c->window->xwindow : 0,
            mb_wm_client_get_name (c));
   create_stampfile();
+  hd_comp_mgr_portrait_invalidate ();
 
   /* Log the time this window was mapped */
   gettimeofday(&priv->last_map_time, NULL);
@@ -2798,6 +2903,7 @@ hd_comp_mgr_unmap_notify (MBWMCompMgr *mgr, MBWindowManagerClient *c)
   g_debug ("%s: 0x%lx '%s'\n", __FUNCTION__,
            c && c->window ? c->window->xwindow : 0,
            mb_wm_client_get_name (c));
+  hd_comp_mgr_portrait_invalidate ();
 
   if (c->window->live_background)
     {
@@ -3075,6 +3181,7 @@ hd_comp_mgr_restack (MBWMCompMgr * mgr)
     MB_WM_COMP_MGR_CLASS (MB_WM_OBJECT_GET_PARENT_CLASS(MB_WM_OBJECT(mgr)));
 
   /* g_debug ("%s", __FUNCTION__); */
+  hd_comp_mgr_portrait_invalidate ();
 
   /*
    * We use the parent class restack() method to do the stacking, but as our
@@ -3256,11 +3363,11 @@ hd_comp_mgr_kill_all_apps (HdCompMgr *hmgr)
   hd_app_mgr_kill_all ();
 }
 
-/* Does any visible client request portrait mode? Or if assume_requested==TRUE
- * we only return false if someone doesn't support portrait mode.
- * Are all of them concerned prepared for it? */
+/* Walks the stack from the top to see whether any visible client requests
+ * portrait mode and whether all of them concerned are prepared for it.
+ * Returns the former and sets *@supportsp to the latter. */
 static gboolean
-hd_comp_mgr_may_be_portrait (HdCompMgr *hmgr, gboolean assume_requested)
+hd_comp_mgr_stack_may_be_portrait (HdCompMgr *hmgr, gboolean *supportsp)
 {
   MBWindowManager *wm;
   MBWindowManagerClient *c;
@@ -3273,7 +3380,7 @@ hd_comp_mgr_may_be_portrait (HdCompMgr *hmgr, gboolean assume_requested)
   portrait_freshness_counter++;
 
   PORTRAIT ("SHOULD BE PORTRAIT?");
-  any_supports = any_requests = FALSE;
+  *supportsp = any_supports = any_requests = FALSE;
   wm = MB_WM_COMP_MGR (hmgr)->wm;
 
   for (c = wm->stack_top; c && c != wm->desktop; c = c->stacked_below)
@@ -3423,11 +3530,52 @@ hd_comp_mgr_may_be_portrait (HdCompMgr *hmgr, gboolean assume_requested)
           break;
         }
     }
-  any_requests |= assume_requested && any_supports;
+  *supportsp = any_supports;
   PORTRAIT ("SHOULD BE: %d", any_requests);
   return any_requests;
 }
 
+/* Does any visible client request portrait mode? Or if assume_requested==TRUE
+ * we only return false if someone doesn't support portrait mode.
+ * Are all of them concerned prepared for it?  The stack is only walked
+ * if it may have changed since the last time. */
+static gboolean
+hd_comp_mgr_may_be_portrait (HdCompMgr *hmgr, gboolean assume_requested)
+{
+  guint stamp;
+
+  Portrait_stats.queries++;
+  if (Portrait_cached != Portrait_stamp)
+    {
+      /* Whatever changes during the walk is not reflected in the result. */
+      stamp = Portrait_stamp;
+      Portrait_stats.walks++;
+      Portrait_requests = hd_comp_mgr_stack_may_be_portrait (hmgr,
+                                                       &Portrait_supports);
+      Portrait_cached = stamp;
+    }
+
+  return Portrait_requests || (assume_requested && Portrait_supports);
+}
+
+void
+hd_comp_mgr_portrait_invalidate (void)
+{
+  Portrait_stamp++;
+}
+
+void
+hd_comp_mgr_get_portrait_stats (HdCompMgrPortraitStats *stats)
+{
+  *stats = Portrait_stats;
+}
+
+void
+hd_comp_mgr_reset_portrait_stats (void)
+{
+  memset (&Portrait_stats, 0, sizeof (Portrait_stats));
+}
+
 void hd_comp_mgr_set_pip_flags (HdCompMgr *hmgr,
                                 gboolean enabled, gboolean portrait)
 {
@@ -3811,6 +3959,7 @@ hd_comp_mgr_dump_debug_info (const gchar *tag)
 
   dump_clutter_actor_tree (clutter_stage_get_default (), NULL);
   hd_app_mgr_dump_app_list (TRUE);
+  hd_profiler_dump ();
 #endif
 }
 
@@ -3899,32 +4048,39 @@ hd_comp_mgr_update_applets_on_current_desktop_property (HdCompMgr *hmgr)
   mb_wm_util_async_untrap_x_errors ();
 }
 
-gboolean
-hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
+static void
+free_portrait_info (HdPortraitInfo *info)
 {
-  gchar *whitelist;
+  g_free (info->res_name);
+  g_free (info->res_class);
+  g_slice_free (HdPortraitInfo, info);
+}
+
+/* Returns what we know of @c, asking for its WM_CLASS if we don't yet. */
+static HdPortraitInfo *
+hd_comp_mgr_portrait_info (MBWindowManager *wm, MBWindowManagerClient *c)
+{
+  HdPortraitInfo *info;
   XClassHint class_hint;
   Status ret;
-  gchar *wname = NULL;
-  gboolean is_on_whitelist = FALSE;
 
-  if ((!c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
-    return FALSE;
+  if (!Portrait_info)
+    Portrait_info = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                  NULL, (GDestroyNotify)free_portrait_info);
+  else if ((info = g_hash_table_lookup (Portrait_info, c)) != NULL)
+    return info;
 
-  if (c->portrait_supported || c->portrait_requested)
-  {
-      PORTRAIT ("Whitelist: Portrait mode is already supported.");
-      return FALSE;
-  }
+  info = g_slice_new0 (HdPortraitInfo);
+  info->forced_landscape = -1;
 
-  whitelist = g_strdup(hd_transition_get_string("thp_tweaks", "whitelist", ""));
-  memset(&class_hint, 0, sizeof(XClassHint));
+  memset (&class_hint, 0, sizeof (XClassHint));
   mb_wm_util_async_trap_x_errors (wm->xdpy);
   ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
   mb_wm_util_async_untrap_x_errors ();
 
   if (ret && class_hint.res_class)
-    wname = g_strdup(class_hint.res_name);
+    info->res_name = g_strdup (class_hint.res_name);
+  info->res_class = g_strdup (class_hint.res_class);
 
   if (class_hint.res_class)
     XFree(class_hint.res_class);
@@ -3932,8 +4088,32 @@ hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
   if (class_hint.res_name)
     XFree(class_hint.res_name);
 
-  if (g_strrstr(whitelist, wname))
+  g_hash_table_insert (Portrait_info, c, info);
+  return info;
+}
+
+gboolean
+hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
+{
+  gchar *whitelist;
+  const gchar *wname;
+  gboolean is_on_whitelist = FALSE;
+
+  if ((!c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
+    return FALSE;
+
+  if (c->portrait_supported || c->portrait_requested)
+  {
+      PORTRAIT ("Whitelist: Portrait mode is already supported.");
+      return FALSE;
+  }
+
+  whitelist = hd_transition_get_string("thp_tweaks", "whitelist", "");
+  wname = hd_comp_mgr_portrait_info (wm, c)->res_name;
+
+  if (wname && g_strrstr(whitelist, wname))
     is_on_whitelist = TRUE;
+  g_free(whitelist);
 
   PORTRAIT ("Whitelist: WName %s; Supp: %d; Req: %d; SuppInh: %d, ReqInh: %d", wname, c->portrait_supported, c->portrait_requested, c->portrait_supported_inherited, c->portrait_requested_inherited);
 #ifdef DEBUG_WINDOWS
@@ -3941,9 +4121,6 @@ hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
       PORTRAIT("Whitelist: Parent Sup: %d Req: %d", c->transient_for->portrait_supported, c->transient_for->portrait_requested);
 #endif
 
-  g_free(whitelist);
-  g_free(wname);
-
   return is_on_whitelist;
 }
 
@@ -3951,49 +4128,35 @@ gboolean
 hd_comp_mgr_is_blacklisted(MBWindowManager *wm, MBWindowManagerClient *c)
 {
   gchar *blacklist;
-  XClassHint class_hint;
-  Status ret;
-  gchar *wname = NULL;
+  HdPortraitInfo *info;
   gboolean blacklisted = FALSE;
-  gboolean blacklisted_by_desktopfile = FALSE;
   gboolean forcerotation = hd_transition_get_int("thp_tweaks", "forcerotation", 0);
 
   if ((!c) || !HD_IS_APP (c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
 
-  blacklist = g_strdup (hd_transition_get_string ("thp_tweaks", "blacklist", ""));
-  memset (&class_hint, 0, sizeof (XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup (class_hint.res_name);
-
-  /* Check, if X-CSSU-Force-Landscape=true. */
-  blacklisted_by_desktopfile = hd_comp_mgr_is_blacklisted_parse_desktop_file (wname, class_hint.res_class, c->window->pid);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (!blacklisted_by_desktopfile)
-    {
-      if (g_strrstr(blacklist, wname))
-        blacklisted = TRUE;
-
-      if (c->stacked_below && (wname == NULL))
-        if (hd_comp_mgr_is_blacklisted (wm, c->stacked_below))
-          blacklisted = TRUE;
-    }
+  info = hd_comp_mgr_portrait_info (wm, c);
+
+  /* Check, if X-CSSU-Force-Landscape=true.  Until the window is matched
+   * with an application we need to look again next time. */
+  if (info->forced_landscape < 0
+      && hd_app_mgr_match_window (info->res_name, info->res_class,
+                                  c->window->pid))
+    info->forced_landscape =
+      hd_comp_mgr_is_blacklisted_parse_desktop_file (info->res_name,
+                                                     info->res_class,
+                                                     c->window->pid);
+  if (info->forced_landscape > 0)
+    return TRUE;
 
+  blacklist = hd_transition_get_string ("thp_tweaks", "blacklist", "");
+  if (info->res_name && g_strrstr(blacklist, info->res_name))
+    blacklisted = TRUE;
   g_free (blacklist);
-  g_free (wname);
 
-  if (blacklisted_by_desktopfile)
-    return TRUE;
+  if (c->stacked_below && (info->res_name == NULL))
+    if (hd_comp_mgr_is_blacklisted (wm, c->stacked_below))
+      blacklisted = TRUE;
 
   /* Do not lock to landscape a window which supports portrait mode. */
   if (c->portrait_supported || c->portrait_requested)
@@ -4034,34 +4197,13 @@ gboolean
 hd_comp_mgr_is_callui_window (MBWindowManager *wm, MBWindowManagerClient *c)
 {
   gchar *whitelist = "rtcom-call-ui";
-  XClassHint class_hint;
-  Status ret;
-  gchar *wname = NULL;
-  gboolean is_callui_window = FALSE;
+  const gchar *wname;
 
   if ((!c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
 
-  memset(&class_hint, 0, sizeof(XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup(class_hint.res_name);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (g_strrstr(whitelist, wname))
-    is_callui_window = TRUE;
-
-  g_free(wname);
-
-  return is_callui_window;
+  wname = hd_comp_mgr_portrait_info (wm, c)->res_name;
+  return wname && g_strrstr(whitelist, wname);
 }
 
 gboolean
@@ -143,6 +143,21 @@ void     hd_comp_mgr_portrait_or_not_portrait (MBWMCompMgr *mgr,
 gboolean hd_comp_mgr_client_supports_portrait (MBWindowManagerClient *mbwmc);
 gboolean hd_comp_mgr_client_requests_portrait (MBWindowManagerClient *mbwmc);
 
+/* To be called when something hd_comp_mgr_should_be_portrait() and
+ * hd_comp_mgr_can_be_portrait() depend on (stacking, visibility, window
+ * properties, orientation lock) may have changed. */
+void hd_comp_mgr_portrait_invalidate (void);
+
+/* How many times the stack's portraitness was asked for and how many
+ * times the stack had to be walked to tell it. */
+typedef struct
+{
+  guint queries, walks;
+} HdCompMgrPortraitStats;
+
+void hd_comp_mgr_get_portrait_stats (HdCompMgrPortraitStats *stats);
+void hd_comp_mgr_reset_portrait_stats (void);
+
 Atom hd_comp_mgr_get_atom (HdCompMgr *hmgr, HdAtoms id);
 Atom hd_comp_mgr_wm_get_atom (MBWindowManager *wm, HdAtoms id);
 
@@ -27,6 +27,7 @@
 
 #include "hd-orientation-lock.h"
 #include "hd-render-manager.h"
+#include "hd-comp-mgr.h"
 
 #include <gconf/gconf-client.h>
 
@@ -142,6 +143,7 @@ hd_orientation_lock_gconf_value_changed (GConfClient *client,
 
   if (!entry)
     return;
+  hd_comp_mgr_portrait_invalidate ();
 
   gvalue = gconf_entry_get_value (entry);
 
@@ -23,6 +23,7 @@
 
 #include "hd-remote-texture.h"
 #include "hd-comp-mgr.h"
+#include "hd-atom-dispatch.h"
 #include "hd-wm.h"
 #include "tidy/tidy-mem-texture.h"
 
@@ -38,15 +39,7 @@
 #    define CM_DEBUG(format, args...)
 #endif
 
-static guint32 shm_atom;
-static guint32 damage_atom;
-static guint32 show_atom;
-static guint32 position_atom;
-static guint32 offset_atom;
-static guint32 scale_atom;
-static guint32 parent_atom;
 static guint32 ready_atom;
-static gboolean atoms_initialized = 0;
 
 void
 hd_remote_texture_show (MBWindowManagerClient *client);
@@ -58,175 +51,236 @@ static void
 hd_remote_texture_set_shm(HdRemoteTexture *tex, key_t key,
                           guint width, guint height, guint bpp);
 
-static Bool
-hd_remote_texture_client_message (XClientMessageEvent *xev, void *userdata)
+/* Returns the actor ClientMessage:s to @self should change,
+ * or NULL if it's not there. */
+static ClutterActor *
+hd_remote_texture_message_target (HdRemoteTexture *self)
 {
-  HdRemoteTexture         *self = HD_REMOTE_TEXTURE (userdata);
   MBWindowManagerClient    *client = MB_WM_CLIENT (self);
 
   if (!client->window)
   {
       g_warning ("Stray client message: no window!\n");
-      return False;
+      return NULL;
   }
 
   MBWMCompMgrClutterClient *cclient = MB_WM_COMP_MGR_CLUTTER_CLIENT (client->cm_client);
   ClutterActor             *actor = mb_wm_comp_mgr_clutter_client_get_actor (cclient);
 
   if (!actor)
-  {
       g_warning ("Stray client message: no actor!\n");
+
+  return actor;
+}
+
+static Bool
+hd_remote_texture_shm_message (XClientMessageEvent *xev,
+                               HdRemoteTexture *self)
+{
+  key_t shm_key = (key_t) xev->data.l[0];
+  guint shm_width = (guint) xev->data.l[1];
+  guint shm_height = (guint) xev->data.l[2];
+  guint shm_bpp = (guint) xev->data.l[3];
+
+  if (!hd_remote_texture_message_target (self))
       return False;
-  }
 
-  if (xev->message_type == shm_atom)
-    {
-        key_t shm_key = (key_t) xev->data.l[0];
-        guint shm_width = (guint) xev->data.l[1];
-        guint shm_height = (guint) xev->data.l[2];
-        guint shm_bpp = (guint) xev->data.l[3];
-
-        hd_remote_texture_set_shm(self, shm_key,
-            shm_width,
-            shm_height,
-            shm_bpp);
-
-        CM_DEBUG ("RemoteTexture %p: shm(key=%d, width=%d, height=%d, bpp=%d)\n",
-                  self, shm_key,
-                  shm_width, shm_height, shm_bpp);
-    }
-  else if (xev->message_type == damage_atom)
-    {
-        gint x = (gint) xev->data.l[0];
-        gint y = (gint) xev->data.l[1];
-        gint width = (gint) xev->data.l[2];
-        gint height = (gint) xev->data.l[3];
-
-        CM_DEBUG ("RemoteTexture %p: "
-                  "damage(x=%d, y=%d, width=%d, height=%d)\n",
-                  self, x, y, width, height);
-        tidy_mem_texture_damage(self->texture, x, y, width, height);
-    }
-  else if (xev->message_type == show_atom)
-  {
-      gboolean show = (gboolean) xev->data.l[0];
-      guint    opacity = (guint) xev->data.l[1] & 0xff;
+  hd_remote_texture_set_shm(self, shm_key,
+      shm_width,
+      shm_height,
+      shm_bpp);
 
-      CM_DEBUG ("RemoteTexture %p: show(show=%d, opacity=%d)\n",
-	       	self, show, opacity);
-      if (show)
-          clutter_actor_show (actor);
-      else
-          clutter_actor_hide (actor);
+  CM_DEBUG ("RemoteTexture %p: shm(key=%d, width=%d, height=%d, bpp=%d)\n",
+            self, shm_key,
+            shm_width, shm_height, shm_bpp);
+  return True;
+}
 
-      clutter_actor_set_opacity (CLUTTER_ACTOR(self->texture), opacity);
+static Bool
+hd_remote_texture_damage_message (XClientMessageEvent *xev,
+                                  HdRemoteTexture *self)
+{
+  gint x = (gint) xev->data.l[0];
+  gint y = (gint) xev->data.l[1];
+  gint width = (gint) xev->data.l[2];
+  gint height = (gint) xev->data.l[3];
 
-  }
-  else if (xev->message_type == position_atom)
-  {
-    gint x = (gint) xev->data.l[0];
-    gint y = (gint) xev->data.l[1];
-    gint width = (gint) xev->data.l[2];
-    gint height = (gint) xev->data.l[3];
-
-    CM_DEBUG ("AnimationActor %p: position(x=%d, y=%d, width=%d, height=%d)\n",
-               self, x, y, width, height);
-    clutter_actor_set_position (actor, x, y);
-    clutter_actor_set_size (actor, width, height);
-    clutter_actor_set_size (CLUTTER_ACTOR(self->texture), width, height);
-    clutter_actor_set_clip(CLUTTER_ACTOR(self->texture),
-                           0, 0,
-                           width, height);
-  }
-  else if (xev->message_type == offset_atom)
-    {
-        ClutterFixed x = (ClutterFixed) xev->data.l[0];
-        ClutterFixed y = (ClutterFixed) xev->data.l[1];
+  if (!hd_remote_texture_message_target (self))
+      return False;
 
-        CM_DEBUG ("RemoteTexture %p: position(x=%d, y=%d)\n",
-                  self, x, y);
-        tidy_mem_texture_set_offset(self->texture, x, y);
-    }
+  CM_DEBUG ("RemoteTexture %p: "
+            "damage(x=%d, y=%d, width=%d, height=%d)\n",
+            self, x, y, width, height);
+  tidy_mem_texture_damage(self->texture, x, y, width, height);
+  return True;
+}
 
-  else if (xev->message_type == scale_atom)
-  {
-      ClutterFixed x_scale = (ClutterFixed) xev->data.l[0];
-      ClutterFixed y_scale = (ClutterFixed) xev->data.l[1];
+static Bool
+hd_remote_texture_show_message (XClientMessageEvent *xev,
+                                HdRemoteTexture *self)
+{
+  ClutterActor *actor = hd_remote_texture_message_target (self);
+  gboolean show = (gboolean) xev->data.l[0];
+  guint    opacity = (guint) xev->data.l[1] & 0xff;
 
-      CM_DEBUG ("RemoteTexture %p: scale(x_scale=%u, y_scale=%u)\n",
-	       self, x_scale, y_scale);
-      tidy_mem_texture_set_scale(self->texture, x_scale, y_scale);
-  }
-  else if (xev->message_type == parent_atom)
-  {
-      Window win = (Window) xev->data.l[0];
+  if (!actor)
+      return False;
 
-      CM_DEBUG ("RemoteTexture %p: parent(win=%lu)\n",
-               self, win);
+  CM_DEBUG ("RemoteTexture %p: show(show=%d, opacity=%d)\n",
+            self, show, opacity);
+  if (show)
+      clutter_actor_show (actor);
+  else
+      clutter_actor_hide (actor);
 
-      /* perserve actor's visibility over the unparenting/reparenting */
+  clutter_actor_set_opacity (CLUTTER_ACTOR(self->texture), opacity);
+  return True;
+}
 
-      gboolean show = CLUTTER_ACTOR_IS_VISIBLE (actor);
+static Bool
+hd_remote_texture_position_message (XClientMessageEvent *xev,
+                                    HdRemoteTexture *self)
+{
+  ClutterActor *actor = hd_remote_texture_message_target (self);
+  gint x = (gint) xev->data.l[0];
+  gint y = (gint) xev->data.l[1];
+  gint width = (gint) xev->data.l[2];
+  gint height = (gint) xev->data.l[3];
 
-      /* unparent the actor */
+  if (!actor)
+      return False;
 
-      ClutterActor *parent = clutter_actor_get_parent (actor);
-      if (parent)
-	  clutter_container_remove_actor (CLUTTER_CONTAINER (parent),
-					  actor);
+  CM_DEBUG ("AnimationActor %p: position(x=%d, y=%d, width=%d, height=%d)\n",
+            self, x, y, width, height);
+  clutter_actor_set_position (actor, x, y);
+  clutter_actor_set_size (actor, width, height);
+  clutter_actor_set_size (CLUTTER_ACTOR(self->texture), width, height);
+  clutter_actor_set_clip(CLUTTER_ACTOR(self->texture),
+                         0, 0,
+                         width, height);
+  return True;
+}
 
-      if (win != 0)
-      {
-	  /* re-parent the actor to another actor */
+static Bool
+hd_remote_texture_offset_message (XClientMessageEvent *xev,
+                                  HdRemoteTexture *self)
+{
+  ClutterFixed x = (ClutterFixed) xev->data.l[0];
+  ClutterFixed y = (ClutterFixed) xev->data.l[1];
 
-	  MBWindowManagerClient *parent_client = NULL;
-	  MBWMCompMgrClutterClient *parent_cclient = NULL;
-	  parent = NULL;
+  if (!hd_remote_texture_message_target (self))
+      return False;
 
-	  /* Many things can go wrong if the parent X window is not
-	   * mapped yet (WM client or clutter compositing client or
-	   * clutter actor may be missing). Silently bail out if
-	   * any of this happens. */
+  CM_DEBUG ("RemoteTexture %p: position(x=%d, y=%d)\n",
+            self, x, y);
+  tidy_mem_texture_set_offset(self->texture, x, y);
+  return True;
+}
 
-	  parent_client =
-	      mb_wm_managed_client_from_xwindow (client->wmref, win);
+static Bool
+hd_remote_texture_scale_message (XClientMessageEvent *xev,
+                                 HdRemoteTexture *self)
+{
+  ClutterFixed x_scale = (ClutterFixed) xev->data.l[0];
+  ClutterFixed y_scale = (ClutterFixed) xev->data.l[1];
 
-	  if (parent_client)
-	      parent_cclient =
-		  MB_WM_COMP_MGR_CLUTTER_CLIENT (parent_client->cm_client);
+  if (!hd_remote_texture_message_target (self))
+      return False;
 
-	  if (parent_cclient)
-	      parent = mb_wm_comp_mgr_clutter_client_get_actor (parent_cclient);
+  CM_DEBUG ("RemoteTexture %p: scale(x_scale=%u, y_scale=%u)\n",
+            self, x_scale, y_scale);
+  tidy_mem_texture_set_scale(self->texture, x_scale, y_scale);
+  return True;
+}
 
-	  if (parent)
-	      clutter_container_add_actor (CLUTTER_CONTAINER (parent),
-					   actor);
+static Bool
+hd_remote_texture_parent_message (XClientMessageEvent *xev,
+                                  HdRemoteTexture *self)
+{
+  MBWindowManagerClient *client = MB_WM_CLIENT (self);
+  ClutterActor *actor = hd_remote_texture_message_target (self);
+  Window win = (Window) xev->data.l[0];
+  ClutterActor *parent;
+  gboolean show;
 
-          clutter_container_add_actor (CLUTTER_CONTAINER (actor),
-                                       CLUTTER_ACTOR(self->texture));
-      }
+  if (!actor)
+      return False;
 
-      if (show)
-          clutter_actor_show (actor);
-      else
-          clutter_actor_hide (actor);
-  }
-  else
+  CM_DEBUG ("RemoteTexture %p: parent(win=%lu)\n",
+            self, win);
+
+  /* perserve actor's visibility over the unparenting/reparenting */
+
+  show = CLUTTER_ACTOR_IS_VISIBLE (actor);
+
+  /* unparent the actor */
+
+  parent = clutter_actor_get_parent (actor);
+  if (parent)
+      clutter_container_remove_actor (CLUTTER_CONTAINER (parent),
+                                      actor);
+
+  if (win != 0)
   {
-      CM_DEBUG ("RemoteTexture %p: UNKNOWN MESSAGE %lu (%lu,%lu,%lu,%lu,%lu)\n",
-	       self,
-	       xev->message_type,
-	       xev->data.l[0],
-	       xev->data.l[1],
-	       xev->data.l[2],
-	       xev->data.l[3],
-	       xev->data.l[4]);
-      return False;
+      /* re-parent the actor to another actor */
+
+      MBWindowManagerClient *parent_client = NULL;
+      MBWMCompMgrClutterClient *parent_cclient = NULL;
+      parent = NULL;
+
+      /* Many things can go wrong if the parent X window is not
+       * mapped yet (WM client or clutter compositing client or
+       * clutter actor may be missing). Silently bail out if
+       * any of this happens. */
+
+      parent_client =
+          mb_wm_managed_client_from_xwindow (client->wmref, win);
+
+      if (parent_client)
+          parent_cclient =
+              MB_WM_COMP_MGR_CLUTTER_CLIENT (parent_client->cm_client);
+
+      if (parent_cclient)
+          parent = mb_wm_comp_mgr_clutter_client_get_actor (parent_cclient);
+
+      if (parent)
+          clutter_container_add_actor (CLUTTER_CONTAINER (parent),
+                                       actor);
+
+      clutter_container_add_actor (CLUTTER_CONTAINER (actor),
+                                   CLUTTER_ACTOR(self->texture));
   }
 
+  if (show)
+      clutter_actor_show (actor);
+  else
+      clutter_actor_hide (actor);
   return True;
 }
 
+/* The HildonRemoteTexture ClientMessage interface. */
+static const struct
+{
+  HdAtoms        atom;
+  MBWMXEventFunc func;
+} hd_remote_texture_messages[] =
+{
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHM,
+    (MBWMXEventFunc)hd_remote_texture_shm_message },
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_DAMAGE,
+    (MBWMXEventFunc)hd_remote_texture_damage_message },
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHOW,
+    (MBWMXEventFunc)hd_remote_texture_show_message },
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_POSITION,
+    (MBWMXEventFunc)hd_remote_texture_position_message },
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_OFFSET,
+    (MBWMXEventFunc)hd_remote_texture_offset_message },
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SCALE,
+    (MBWMXEventFunc)hd_remote_texture_scale_message },
+  { HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_PARENT,
+    (MBWMXEventFunc)hd_remote_texture_parent_message },
+};
+
 void
 hd_remote_texture_show (MBWindowManagerClient *client)
 {
@@ -249,44 +303,24 @@ hd_remote_texture_realize (MBWindowManagerClient *client)
     MBWindowManager          *wm = client->wmref;
     MBWMClientWindow         *win = client->window;
     Window                   window = win->xwindow;
+    HdCompMgr               *hmgr = HD_COMP_MGR (wm->comp_mgr);
+    guint                    i;
 
-    /* This is a bit of a hack, but for the sake of optimization,
-     * we cache all atoms used by the HildonRemoteTexture ClientMessage
-     * interface in our static variables. */
-
-    if (!atoms_initialized)
-    {
-	HdCompMgr             *hmgr = HD_COMP_MGR (wm->comp_mgr);
-
-	shm_atom = hd_comp_mgr_get_atom
-            (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHM);
-        damage_atom = hd_comp_mgr_get_atom
-            (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_DAMAGE);
-	show_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHOW);
-	position_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_POSITION);
-	offset_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_OFFSET);
-	scale_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SCALE);
-	parent_atom = hd_comp_mgr_get_atom
-	    (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_PARENT);
+    if (!ready_atom)
 	ready_atom = hd_comp_mgr_get_atom
 	    (hmgr, HD_ATOM_HILDON_TEXTURE_CLIENT_READY);
 
-	atoms_initialized = 1;
-    }
-
-  /* Install a ClientMessage event handler */
+  /* Route our ClientMessages to us by message type and window. */
 
-  self->client_message_handler_id =
-      mb_wm_main_context_x_event_handler_add (wm->main_ctx,
-					      window,
-					      ClientMessage,
-					      (MBWMXEventFunc)
-					      hd_remote_texture_client_message,
-					      client);
+  for (i = 0; i < G_N_ELEMENTS (hd_remote_texture_messages); i++)
+      hd_atom_dispatch_add (ClientMessage,
+                            hd_comp_mgr_get_atom
+                              (hmgr, hd_remote_texture_messages[i].atom),
+                            window,
+                            (HdAtomHandlerFunc)
+                            hd_remote_texture_messages[i].func,
+                            client);
+  self->message_window = window;
 
   /* Force StructureNotifyMask event input on the window.
    *
@@ -338,15 +372,9 @@ static void
 hd_remote_texture_destroy (MBWMObject *this)
 {
   HdRemoteTexture      *self = HD_REMOTE_TEXTURE (this);
-  MBWindowManagerClient *client = MB_WM_CLIENT (this);
-  MBWindowManager       *wm = client->wmref;
 
-  if (self->client_message_handler_id)
-  {
-      mb_wm_main_context_x_event_handler_remove (wm->main_ctx,
-                                                 ClientMessage,
-                                                 self->client_message_handler_id);
-  }
+  if (self->message_window)
+      hd_atom_dispatch_remove_window (self->message_window);
   /* unattach ourselves if we were attached */
   hd_remote_texture_set_shm(self, 0, 0, 0, 0);
   /* free our texture */
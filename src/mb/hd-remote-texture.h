@@ -41,7 +41,7 @@ struct HdRemoteTexture
   MBWMClientApp    parent;
 
   /* Private */
-  unsigned long    client_message_handler_id;
+  Window           message_window;
   TidyMemTexture  *texture;
 
   key_t         shm_key;
@@ -507,6 +507,7 @@ hd_wm_current_app_is (MBWindowManager *wm, Window xid)
   mb_wm_util_async_untrap_x_errors ();
 
   last = xid;
+  hd_comp_mgr_portrait_invalidate ();
 
   g_debug ("CURRENT_APP_WINDOW => 0x%lx", xid);
   return last;
@@ -8,6 +8,7 @@
 
 #include "tidy-blur-group.h"
 #include "tidy-util.h"
+#include "tidy-offscreen-pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -21,14 +22,11 @@
 #include <locale.h>
 
 #include "util/hd-transition.h"
+#include "util/hd-profiler.h"
 
 /* #define it something sane */
 #define TIDY_IS_SANE_BLUR_GROUP(obj)    ((obj) != NULL)
 
-/* This destroys and re-allocates the texture if the actor size changes
- * (eg. screen rotation). We may not want to do this as it takes some time. */
-#define RESIZE_TEXTURE 0
-
 /* This fixes the bug where the SGX GLSL compiler uses the current locale for
  * numbers - so '1.0' in a shader will not work when the locale says that ','
  * is a decimal separator.
@@ -139,13 +137,11 @@ struct _TidyBlurGroupPrivate
   /* Internal TidyBlurGroup stuff */
   ClutterShader *shader_blur;
   ClutterShader *shader_saturate;
-  CoglHandle tex_a;
-  CoglHandle fbo_a;
-  CoglHandle tex_b;
-  CoglHandle fbo_b;
+  /* Leased from the offscreen pool while we're buffered. */
+  TidyOffscreen *buf_a;
+  TidyOffscreen *buf_b;
   CoglHandle tex_chequer; /* chequer texture used for dimming video overlays */
   gboolean current_is_a;
-  gboolean current_is_rotated;
 
   gboolean use_shader;
   float saturation; /* 0->1 how much colour there is */
@@ -243,69 +239,48 @@ static void tidy_blur_group_check_shader(TidyBlurGroup *group,
    }
 }
 
-/* Allocate @priv->fbo_[ab]. */
+/* Give @priv->buf_[ab] back to the pool. */
 static void
-tidy_blur_group_allocate_textures (TidyBlurGroup *self)
+tidy_blur_group_release_textures (TidyBlurGroup *self)
 {
   TidyBlurGroupPrivate *priv = self->priv;
-  guint tex_width, tex_height;
-
-#ifdef __i386__
-  if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
-    /* Don't try to allocate FBOs. */
-    return;
-#endif
 
-#if !RESIZE_TEXTURE
-  if (priv->fbo_a && priv->fbo_b)
-    /* Rotate in _paint() rather than resize. */
-    return;
-#endif
-
-  /* Free the textures. */
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
-  if (priv->fbo_b)
+  if (priv->buf_a)
     {
-      cogl_offscreen_unref(priv->fbo_b);
-      cogl_texture_unref(priv->tex_b);
-      priv->fbo_b = 0;
-      priv->tex_b = 0;
+      tidy_offscreen_release(priv->buf_a);
+      tidy_offscreen_release(priv->buf_b);
+      priv->buf_a = priv->buf_b = NULL;
     }
+  priv->current_blur_step = 0;
+  priv->source_changed = TRUE;
+}
 
-  /* (Re)create the textures + offscreen buffers.  Downsample by 2.
-   * We can specify mipmapping here, but we don't need it. */
-  clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
+/* Lease @priv->buf_[ab] for a @width x @height group, unless we have
+ * the right ones already. */
+static void
+tidy_blur_group_lease_textures (TidyBlurGroup *self, gint width, gint height)
+{
+  TidyBlurGroupPrivate *priv = self->priv;
+  CoglPixelFormat format;
 
-  /* if we want blurless desaturation, don't downsample (downsampling
-   * makes the image look a bit blurry even with blurring disabled) */
+  /* Downsample by 2, unless we want blurless desaturation
+   * (downsampling makes the image look a bit blurry even with
+   * blurring disabled). */
   if (!priv->tweaks_blurless)
     {
-      tex_width  /= 2;
-      tex_height /= 2;
+      width  /= 2;
+      height /= 2;
     }
+  format = priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888
+                           : COGL_PIXEL_FORMAT_RGB_565;
 
-  priv->tex_a = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                              COGL_PIXEL_FORMAT_RGB_565);
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_a = cogl_offscreen_new_to_texture(priv->tex_a);
-
-  priv->tex_b = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                              COGL_PIXEL_FORMAT_RGB_565);
-  cogl_texture_set_filters(priv->tex_b, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_b = cogl_offscreen_new_to_texture(priv->tex_b);
+  if (tidy_offscreen_fits(priv->buf_a, width, height, format))
+    return;
 
-  priv->current_blur_step = 0;
-  priv->source_changed = TRUE;
+  /* Resized (eg. rotated) or it's the first time. */
+  tidy_blur_group_release_textures(self);
+  priv->buf_a = tidy_offscreen_lease(width, height, format);
+  priv->buf_b = tidy_offscreen_lease(width, height, format);
 }
 
 static gboolean
@@ -338,7 +313,7 @@ tidy_blur_group_fallback_blur(TidyBlurGroup *group, int tex_width, int tex_heigh
   ClutterColor    col = { 0x3f, 0x3f, 0x3f, 0x3f };
 
   TidyBlurGroupPrivate *priv = group->priv;
-  CoglHandle tex = priv->current_is_a ? priv->tex_a : priv->tex_b;
+  CoglHandle tex = priv->current_is_a ? priv->buf_a->tex : priv->buf_b->tex;
   ClutterFixed diffx, diffy;
   diffx = CLUTTER_FLOAT_TO_FIXED(1.0f / tex_width);
   diffy = CLUTTER_FLOAT_TO_FIXED(1.0f / tex_height);
@@ -441,10 +416,10 @@ tidy_blur_group_paint (ClutterActor *actor)
   CoglHandle                   current_tex;
   ClutterActorBox              box;
   gint                         width, height, tex_width, tex_height;
-  gboolean                     rotate_90;
   ClutterColor                 col;
   GArray                      *filters;
   const ClutterTextureQuality *filters_array;
+  HD_PROFILER_SCOPE (HD_PROFILER_BLUR_GROUP);
 
   if (!TIDY_IS_SANE_BLUR_GROUP(actor))
     return;
@@ -458,9 +433,8 @@ tidy_blur_group_paint (ClutterActor *actor)
   if (!tidy_blur_group_source_buffered(actor) ||
       !tidy_blur_group_children_visible(group))
     {
-      /* set our buffer as damaged, so next time it gets re-created */
-      priv->current_blur_step = 0;
-      priv->source_changed = TRUE;
+      /* nobody needs our buffers until we blur again */
+      tidy_blur_group_release_textures(container);
       /* render direct */
       CLUTTER_ACTOR_CLASS(tidy_blur_group_parent_class)->paint(actor);
       tidy_blur_group_do_chequer(container, width, height);
@@ -482,35 +456,17 @@ tidy_blur_group_paint (ClutterActor *actor)
     }
 #endif
 
-  tex_width  = cogl_texture_get_width(priv->tex_a);
-  tex_height = cogl_texture_get_height(priv->tex_a);
-
-  /* It may be that we have resized, but the texture has not.
-   * If so, try and keep blurring 'nice' by rotating so that
-   * we don't have a texture that is totally the wrong aspect ratio */
-  /* If rotation has changed, trigger a redraw */
-  rotate_90 = (tex_width > tex_height) != (width > height);
-  if (priv->current_is_rotated != rotate_90)
-    {
-      priv->current_is_rotated = rotate_90;
-      priv->source_changed = TRUE;
-      priv->current_blur_step = 0;
-    }
+  tidy_blur_group_lease_textures(container, width, height);
+  tex_width  = priv->buf_a->width;
+  tex_height = priv->buf_a->height;
 
   /* Draw children into an offscreen buffer */
   if (priv->source_changed && priv->current_blur_step==0)
     {
       cogl_push_matrix();
-      tidy_util_cogl_push_offscreen_buffer(priv->fbo_a);
-
-      if (rotate_90) {
-        cogl_scale(CFX_ONE*tex_width/height, CFX_ONE*tex_height/width);
-        cogl_translatex(CFX_ONE*height/2, CFX_ONE*width/2, 0);
-        cogl_rotate(90, 0, 0, 1);
-        cogl_translatex(-CFX_ONE*width/2, -CFX_ONE*height/2, 0);
-      } else {
-        cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
-      }
+      tidy_util_cogl_push_offscreen_buffer(priv->buf_a->fbo);
+
+      cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
 
       /* translate a bit to let bilinear filter smooth out intermediate pixels */
       if (!priv->tweaks_blurless)
@@ -546,7 +502,8 @@ tidy_blur_group_paint (ClutterActor *actor)
     {
       /* blur one texture into the other */
       tidy_util_cogl_push_offscreen_buffer(
-                       priv->current_is_a ? priv->fbo_b : priv->fbo_a);
+                       priv->current_is_a ? priv->buf_b->fbo
+                                          : priv->buf_a->fbo);
 
       if (priv->use_shader && priv->shader_blur)
         {
@@ -568,7 +525,8 @@ tidy_blur_group_paint (ClutterActor *actor)
         {
           cogl_blend_func(CGL_ONE, CGL_ZERO);
           cogl_color (&white);
-          cogl_texture_rectangle (priv->current_is_a ? priv->tex_a : priv->tex_b,
+          cogl_texture_rectangle (priv->current_is_a ? priv->buf_a->tex
+                                                     : priv->buf_b->tex,
                                   0, 0,
                                   CLUTTER_INT_TO_FIXED (tex_width),
                                   CLUTTER_INT_TO_FIXED (tex_height),
@@ -702,18 +660,9 @@ skip_progress:
 
   cogl_color (&col);
 
-  if (rotate_90)
-    {
-      cogl_push_matrix();
-      cogl_translatex(CFX_ONE*width/2, CFX_ONE*height/2, 0);
-      cogl_rotate(90, 0, 0, 1);
-      cogl_scale(-CFX_ONE*height/width, -CFX_ONE*width/height);
-      cogl_translatex(-CFX_ONE*width/2, -CFX_ONE*height/2, 0);
-    }
-
   /* Set the blur texture to linear interpolation - so we draw it smoothly
    * Onto the screen */
-  current_tex = priv->current_is_a ? priv->tex_a : priv->tex_b;
+  current_tex = priv->current_is_a ? priv->buf_a->tex : priv->buf_b->tex;
   cogl_texture_set_filters(current_tex, CGL_LINEAR, CGL_LINEAR);
 
   if ((priv->zoom >= 1) || !priv->use_mirror)
@@ -833,11 +782,6 @@ skip_progress:
   /* Reset the filters on the current texture ready for normal blurring */
   cogl_texture_set_filters(current_tex, CGL_NEAREST, CGL_NEAREST);
 
-  if (rotate_90)
-    {
-      cogl_pop_matrix();
-    }
-
   if (priv->use_shader && priv->shader_saturate)
     clutter_shader_set_is_enabled (priv->shader_saturate, FALSE);
 
@@ -850,20 +794,7 @@ tidy_blur_group_dispose (GObject *gobject)
   TidyBlurGroup *container = TIDY_BLUR_GROUP(gobject);
   TidyBlurGroupPrivate *priv = container->priv;
 
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
-  if (priv->fbo_b)
-    {
-      cogl_offscreen_unref(priv->fbo_b);
-      cogl_texture_unref(priv->tex_b);
-      priv->fbo_b = 0;
-      priv->tex_b = 0;
-    }
+  tidy_blur_group_release_textures(container);
   if (priv->tex_chequer)
     {
       cogl_texture_unref(priv->tex_chequer);
@@ -915,12 +846,9 @@ tidy_blur_group_init (TidyBlurGroup *self)
   priv->shader_blur = 0;
   priv->shader_saturate = 0;
 
-  priv->tex_a = 0;
-  priv->fbo_a = 0;
-  priv->tex_b = 0;
-  priv->fbo_b = 0;
+  priv->buf_a = NULL;
+  priv->buf_b = NULL;
   priv->current_is_a = TRUE;
-  priv->current_is_rotated = FALSE;
   /* dimming for the vignette */
   for (i=0;i<VIGNETTE_COLOURS;i++)
     priv->vignette_colours[i] = 255;
@@ -962,9 +890,6 @@ tidy_blur_group_init (TidyBlurGroup *self)
 
   tidy_blur_group_check_shader(self, &priv->shader_saturate,
                                SATURATE_FRAGMENT_SHADER, 0);
-
-  g_signal_connect(self, "notify::allocation",
-                   G_CALLBACK(tidy_blur_group_allocate_textures), NULL);
 }
 
 /*
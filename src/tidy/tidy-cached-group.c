@@ -6,6 +6,7 @@
 
 #include "tidy-cached-group.h"
 #include "tidy-util.h"
+#include "tidy-offscreen-pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -18,15 +19,15 @@
 #include <string.h>
 #include <locale.h>
 
+#include "util/hd-profiler.h"
+
 #define TIDY_CACHED_GROUP_DEFAULT_DOWNSAMPLING  2.0
 
 struct _TidyCachedGroupPrivate
 {
   /* Internal TidyCachedGroup stuff */
-  CoglHandle tex;
-  CoglHandle fbo;
-  /* When we rendered to this texture, did we render rotated? */
-  gboolean rotated;
+  /* Leased from the offscreen pool while we're caching. */
+  TidyOffscreen *buf;
 
   gboolean use_alpha; /* whether to use an alpha channel in our textures */
 
@@ -36,6 +37,12 @@ struct _TidyCachedGroupPrivate
   gboolean source_changed;
   /* how much quality loss you can afford when rendering cached texture */
   float downsample;
+
+  /* If not 0, use the cache only when nothing has changed for this
+   * long (ms), see tidy_cached_group_set_auto_cache(). */
+  guint auto_idle;
+  guint auto_timeout;
+  gboolean auto_hooked;
 };
 
 G_DEFINE_TYPE_WITH_CODE (TidyCachedGroup,
@@ -43,6 +50,14 @@ G_DEFINE_TYPE_WITH_CODE (TidyCachedGroup,
                          CLUTTER_TYPE_GROUP,
                          G_ADD_PRIVATE (TidyCachedGroup));
 
+static void
+tidy_cached_group_free_cache (TidyCachedGroupPrivate *priv)
+{
+  tidy_offscreen_release(priv->buf);
+  priv->buf = NULL;
+  priv->source_changed = TRUE;
+}
+
 /* An implementation for the ClutterGroup::paint() vfunc,
    painting all the child actors: */
 static void
@@ -52,7 +67,8 @@ tidy_cached_group_paint (ClutterActor *actor)
   ClutterColor    bgcol = { 0x00, 0x00, 0x00, 0xff };
   ClutterColor    col = { 0xff, 0xff, 0xff, 0xff };
   gint            x_1, y_1, x_2, y_2;
-  gboolean        rotate_90;
+  CoglPixelFormat format;
+  HD_PROFILER_SCOPE (HD_PROFILER_CACHED_GROUP);
 
   if (!TIDY_IS_CACHED_GROUP(actor))
     return;
@@ -71,7 +87,9 @@ tidy_cached_group_paint (ClutterActor *actor)
   if (priv->cache_amount < 0.01 ||
       width==0 || height==0)
     {
-      /* render direct */
+      /* render direct; whoever raises cache_amount again calls
+       * tidy_cached_group_changed() first anyway */
+      tidy_cached_group_free_cache(priv);
       CLUTTER_ACTOR_CLASS (tidy_cached_group_parent_class)->paint(actor);
       return;
     }
@@ -84,73 +102,45 @@ tidy_cached_group_paint (ClutterActor *actor)
     }
 #endif
 
-  int exp_width = width/priv->downsample;
-  int exp_height = height/priv->downsample;
-  int tex_width = 0;
-  int tex_height = 0;
+  int tex_width = width/priv->downsample;
+  int tex_height = height/priv->downsample;
 
-  /* check sizes */
-  if (priv->tex)
-    {
-      tex_width = cogl_texture_get_width(priv->tex);
-      tex_height = cogl_texture_get_height(priv->tex);
-    }
-#if RESIZE_TEXTURE
-  /* free texture if the size is wrong */
-  if (tex_width!=exp_width || tex_height!=exp_height) {
-    if (priv->fbo)
-      {
-        cogl_offscreen_unref(priv->fbo);
-        cogl_texture_unref(priv->tex);
-        priv->fbo = 0;
-        priv->tex = 0;
-      }
-    priv->source_changed = TRUE;
-  }
-#endif
-  /* create the texture + offscreen buffer if they didn't exist. */
-  if (!priv->tex)
-    {
-      tex_width = exp_width;
-      tex_height = exp_height;
-
-      priv->tex = cogl_texture_new_with_size(
-                tex_width, tex_height, 0, FALSE /*mipmap*/,
-                priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                                  COGL_PIXEL_FORMAT_RGB_565);
-      cogl_texture_set_filters(priv->tex, CGL_NEAREST, CGL_NEAREST);
-      priv->fbo = cogl_offscreen_new_to_texture (priv->tex);
-    }
-  /* It may be that we have resized, but the texture has not.
-   * If so, try and keep screen looking 'nice' by rotating so that
-   * we don't have a texture that is totally the wrong aspect ratio */
-  rotate_90 = (tex_width > tex_height) != (width > height);
-  /* If rotation has changed, trigger a redraw */
-  if (priv->rotated != rotate_90)
+  /* (re)lease the texture + offscreen buffer if we didn't have one of
+   * the right size (eg. after a rotation) */
+  format = priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888
+                           : COGL_PIXEL_FORMAT_RGB_565;
+  if (!tidy_offscreen_fits(priv->buf, tex_width, tex_height, format))
     {
-      priv->rotated = rotate_90;
-      priv->source_changed = TRUE;
+      tidy_cached_group_free_cache(priv);
+      priv->buf = tidy_offscreen_lease(tex_width, tex_height, format);
     }
+  tex_width = priv->buf->width;
+  tex_height = priv->buf->height;
 
   /* Draw children into an offscreen buffer */
   if (priv->source_changed)
     {
       cogl_push_matrix();
-      tidy_util_cogl_push_offscreen_buffer(priv->fbo);
+      tidy_util_cogl_push_offscreen_buffer(priv->buf->fbo);
       /* translate a bit to let bilinear filter smooth out intermediate pixels */
       cogl_translatex(CFX_ONE/2,CFX_ONE/2,0);
-      if (rotate_90) {
-        cogl_scale(CFX_ONE*tex_width/height, CFX_ONE*tex_height/width);
-        cogl_translatex(CFX_ONE*height/2, CFX_ONE*width/2, 0);
-        cogl_rotate(90, 0, 0, 1);
-        cogl_translatex(-CFX_ONE*width/2, -CFX_ONE*height/2, 0);
-      } else {
-        cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
-      }
-
+      cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
+
+      if (priv->use_alpha)
+        {
+          /* Start from transparent, and accumulate coverage in the
+           * alpha channel rather than alpha squared, so the cache
+           * comes out premultiplied. */
+          bgcol.alpha = 0;
+          tidy_util_cogl_push_blend_func_separate(
+                                   CGL_SRC_ALPHA, CGL_ONE_MINUS_SRC_ALPHA,
+                                   CGL_ONE, CGL_ONE_MINUS_SRC_ALPHA);
+        }
       cogl_paint_init(&bgcol);
       cogl_color (&white);
       CLUTTER_ACTOR_CLASS (tidy_cached_group_parent_class)->paint(actor);
+      if (priv->use_alpha)
+        tidy_util_cogl_pop_blend_func();
 
       tidy_util_cogl_pop_offscreen_buffer();
       cogl_pop_matrix();
@@ -175,25 +165,19 @@ tidy_cached_group_paint (ClutterActor *actor)
     }
 
   /* Now we render the image we have... */
-  cogl_color (&col);
-
-  if (rotate_90)
-    {
-      cogl_push_matrix();
-      cogl_translatex(CFX_ONE*width/2, CFX_ONE*height/2, 0);
-      cogl_rotate(90, 0, 0, 1);
-      cogl_scale(-CFX_ONE*height/width, -CFX_ONE*width/height);
-      cogl_translatex(-CFX_ONE*width/2, -CFX_ONE*height/2, 0);
+  if (priv->use_alpha)
+    { /* premultiplied */
+      col.red = col.green = col.blue = col.alpha;
+      cogl_blend_func(CGL_ONE, CGL_ONE_MINUS_SRC_ALPHA);
     }
-  cogl_texture_rectangle (priv->tex,
+  cogl_color (&col);
+  cogl_texture_rectangle (priv->buf->tex,
                           0, 0,
                           CLUTTER_INT_TO_FIXED (width),
                           CLUTTER_INT_TO_FIXED (height),
                           0, 0, CFX_ONE, CFX_ONE);
-  if (rotate_90)
-    {
-      cogl_pop_matrix();
-    }
+  if (priv->use_alpha)
+    cogl_blend_func(CGL_SRC_ALPHA, CGL_ONE_MINUS_SRC_ALPHA);
 }
 
 static void
@@ -202,13 +186,9 @@ tidy_cached_group_dispose (GObject *gobject)
   TidyCachedGroup *container = TIDY_CACHED_GROUP(gobject);
   TidyCachedGroupPrivate *priv = container->priv;
 
-  if (priv->fbo)
-    {
-      cogl_offscreen_unref(priv->fbo);
-      cogl_texture_unref(priv->tex);
-      priv->fbo = 0;
-      priv->tex = 0;
-    }
+  if (priv->auto_timeout)
+    priv->auto_timeout = (g_source_remove(priv->auto_timeout), 0);
+  tidy_cached_group_free_cache(priv);
 
   G_OBJECT_CLASS (tidy_cached_group_parent_class)->dispose (gobject);
 }
@@ -236,8 +216,36 @@ tidy_cached_group_init (TidyCachedGroup *self)
   priv->use_alpha = FALSE;
   priv->source_changed = TRUE;
 
-  priv->tex = 0;
-  priv->fbo = 0;
+  priv->buf = NULL;
+}
+
+static gboolean
+tidy_cached_group_auto_timeout (gpointer data)
+{
+  TidyCachedGroupPrivate *priv = TIDY_CACHED_GROUP(data)->priv;
+
+  /* Baked in the next paint, whenever that comes; until then the
+   * screen is right as it is. */
+  priv->auto_timeout = 0;
+  priv->cache_amount = 1;
+  priv->source_changed = TRUE;
+  return FALSE;
+}
+
+static void
+tidy_cached_group_auto_changed (ClutterActor *cached_group)
+{
+  if (TIDY_CACHED_GROUP(cached_group)->priv->auto_idle)
+    tidy_cached_group_changed(cached_group);
+}
+
+static void
+tidy_cached_group_auto_hidden (ClutterActor *cached_group)
+{
+  TidyCachedGroupPrivate *priv = TIDY_CACHED_GROUP(cached_group)->priv;
+
+  if (priv->auto_idle)
+    tidy_cached_group_free_cache(priv);
 }
 
 /*
@@ -305,6 +313,85 @@ void tidy_cached_group_changed(ClutterActor *cached_group)
 
   priv = TIDY_CACHED_GROUP(cached_group)->priv;
   priv->source_changed = TRUE;
+
+  if (priv->auto_idle)
+    {
+      /* Paint directly until things settle down again. */
+      priv->cache_amount = 0;
+      if (priv->auto_timeout)
+        g_source_remove(priv->auto_timeout);
+      priv->auto_timeout = g_timeout_add(priv->auto_idle,
+                                         tidy_cached_group_auto_timeout,
+                                         cached_group);
+    }
+}
+
+/* Whether the caching is automatic, and so whoever changes the
+ * contents needs to call tidy_cached_group_changed(). */
+gboolean tidy_cached_group_get_auto_cache(ClutterActor *cached_group)
+{
+  return TIDY_IS_CACHED_GROUP(cached_group)
+    && TIDY_CACHED_GROUP(cached_group)->priv->auto_idle;
+}
+
+/**
+ * Makes the group use its cache by itself when its contents haven't
+ * changed for @idle_ms, and paint directly after a change until then.
+ * Adding and removing children counts as a change; anything else needs
+ * tidy_cached_group_changed().  The cache is dropped when the group is
+ * hidden.  0 turns it off.
+ */
+void tidy_cached_group_set_auto_cache(ClutterActor *cached_group,
+                                      guint idle_ms)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  if (priv->auto_idle == idle_ms)
+    return;
+
+  if (!priv->auto_hooked)
+    {
+      g_signal_connect(cached_group, "actor-added",
+                       G_CALLBACK(tidy_cached_group_auto_changed), NULL);
+      g_signal_connect(cached_group, "actor-removed",
+                       G_CALLBACK(tidy_cached_group_auto_changed), NULL);
+      g_signal_connect(cached_group, "hide",
+                       G_CALLBACK(tidy_cached_group_auto_hidden), NULL);
+      priv->auto_hooked = TRUE;
+    }
+
+  priv->auto_idle = idle_ms;
+  if (idle_ms)
+    tidy_cached_group_changed(cached_group);
+  else
+    {
+      if (priv->auto_timeout)
+        priv->auto_timeout = (g_source_remove(priv->auto_timeout), 0);
+      tidy_cached_group_set_render_cache(cached_group, 0);
+      tidy_cached_group_free_cache(priv);
+    }
+}
+
+/* Whether the cached image has an alpha channel, so the group can be
+ * cached on top of something else.  Off by default. */
+void tidy_cached_group_set_use_alpha(ClutterActor *cached_group,
+                                     gboolean use_alpha)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  if (priv->use_alpha != use_alpha)
+    {
+      priv->use_alpha = use_alpha;
+      tidy_cached_group_free_cache(priv);
+    }
 }
 
 
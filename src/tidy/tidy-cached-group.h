@@ -38,6 +38,11 @@ void tidy_cached_group_set_render_cache(ClutterActor *cached_group, float amount
 void tidy_cached_group_set_downsampling_factor(ClutterActor *cached_group,
                                                float downsample);
 void tidy_cached_group_changed(ClutterActor *cached_group);
+void tidy_cached_group_set_auto_cache(ClutterActor *cached_group,
+                                      guint idle_ms);
+gboolean tidy_cached_group_get_auto_cache(ClutterActor *cached_group);
+void tidy_cached_group_set_use_alpha(ClutterActor *cached_group,
+                                     gboolean use_alpha);
 
 
 G_END_DECLS
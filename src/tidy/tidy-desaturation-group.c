@@ -9,6 +9,7 @@
 
 #include "tidy-desaturation-group.h"
 #include "tidy-util.h"
+#include "tidy-offscreen-pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -22,6 +23,7 @@
 #include <locale.h>
 
 #include "util/hd-transition.h"
+#include "util/hd-profiler.h"
 
 /* #define it something sane */
 #define TIDY_IS_SANE_DESATURATION_GROUP(obj)    ((obj) != NULL)
@@ -89,8 +91,8 @@ struct _TidyDesaturationGroupPrivate
 {
   /* Internal TidyDesaturationGroup stuff */
   ClutterShader *shader_saturate;
-  CoglHandle tex_a;
-  CoglHandle fbo_a;
+  /* Leased from the offscreen pool while we're buffered. */
+  TidyOffscreen *buf_a;
 
   gboolean use_shader;
   gboolean undo_desaturation;
@@ -176,38 +178,31 @@ static void tidy_desaturation_group_check_shader(TidyDesaturationGroup *group,
 }
 
 static void
-tidy_desaturation_group_allocate_textures (TidyDesaturationGroup *self)
+tidy_desaturation_group_release_textures (TidyDesaturationGroup *self)
 {
   TidyDesaturationGroupPrivate *priv = self->priv;
-  guint tex_width, tex_height;
 
-#ifdef __i386__
-  if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
-    /* Don't try to allocate FBOs. */
-    return;
-#endif
-
-  /* Free the texture. */
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
+  tidy_offscreen_release(priv->buf_a);
+  priv->buf_a = NULL;
+  priv->current_desaturation_step = 0;
+  priv->source_changed = TRUE;
+}
 
-  /* (Re)create the texture and offscreen buffer.
-   * We can specify mipmapping here, but we don't need it. */
-  clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
+/* Lease @priv->buf_a for a @width x @height group, unless we have
+ * the right one already. */
+static void
+tidy_desaturation_group_lease_textures (TidyDesaturationGroup *self,
+                                        gint width, gint height)
+{
+  TidyDesaturationGroupPrivate *priv = self->priv;
 
-  priv->tex_a = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            COGL_PIXEL_FORMAT_RGBA_8888);
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_a = cogl_offscreen_new_to_texture(priv->tex_a);
+  if (tidy_offscreen_fits(priv->buf_a, width, height,
+                          COGL_PIXEL_FORMAT_RGBA_8888))
+    return;
 
-  priv->current_desaturation_step = 0;
-  priv->source_changed = TRUE;
+  tidy_desaturation_group_release_textures(self);
+  priv->buf_a = tidy_offscreen_lease(width, height,
+                                     COGL_PIXEL_FORMAT_RGBA_8888);
 }
 
 static gboolean
@@ -284,6 +279,7 @@ tidy_desaturation_group_paint (ClutterActor *actor)
   ClutterColor                 col;
   GArray                      *filters;
   const ClutterTextureQuality *filters_array;
+  HD_PROFILER_SCOPE (HD_PROFILER_DESATURATION_GROUP);
 
   if (!TIDY_IS_SANE_DESATURATION_GROUP(actor))
     return;
@@ -297,9 +293,8 @@ tidy_desaturation_group_paint (ClutterActor *actor)
   if (!tidy_desaturation_group_source_buffered(actor) ||
       !tidy_desaturation_group_children_visible(group))
     {
-      /* set our buffer as damaged, so next time it gets re-created */
-      priv->current_desaturation_step = 0;
-      priv->source_changed = TRUE;
+      /* nobody needs our buffer until we desaturate again */
+      tidy_desaturation_group_release_textures(container);
       CLUTTER_ACTOR_CLASS(tidy_desaturation_group_parent_class)->paint(actor);
       return;
     }
@@ -309,14 +304,15 @@ tidy_desaturation_group_paint (ClutterActor *actor)
       return;
 #endif
 
-  tex_width  = cogl_texture_get_width(priv->tex_a);
-  tex_height = cogl_texture_get_height(priv->tex_a);
+  tidy_desaturation_group_lease_textures(container, width, height);
+  tex_width  = priv->buf_a->width;
+  tex_height = priv->buf_a->height;
 
   /* Draw children into an offscreen buffer */
   if (priv->source_changed && priv->current_desaturation_step==0)
     {
       cogl_push_matrix();
-      tidy_util_cogl_push_offscreen_buffer(priv->fbo_a);
+      tidy_util_cogl_push_offscreen_buffer(priv->buf_a->fbo);
 
       cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
 
@@ -368,15 +364,15 @@ tidy_desaturation_group_paint (ClutterActor *actor)
 
   /* Set the desaturation texture to linear interpolation - so we draw it smoothly
    * Onto the screen */
-  cogl_texture_set_filters(priv->tex_a, CGL_LINEAR, CGL_LINEAR);
+  cogl_texture_set_filters(priv->buf_a->tex, CGL_LINEAR, CGL_LINEAR);
 
-  cogl_texture_rectangle (priv->tex_a,
+  cogl_texture_rectangle (priv->buf_a->tex,
                           mx-zx, my-zy,
                           mx+zx, my+zy,
                           0, 0, CFX_ONE, CFX_ONE);
 
-  /* Reset the filters on the tex_a texture ready for normal desaturating */
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
+  /* Reset the filters on the texture ready for normal desaturating */
+  cogl_texture_set_filters(priv->buf_a->tex, CGL_NEAREST, CGL_NEAREST);
 
   if (priv->use_shader && priv->shader_saturate && !priv->undo_desaturation)
     clutter_shader_set_is_enabled (priv->shader_saturate, FALSE);
@@ -387,15 +383,8 @@ static void
 tidy_desaturation_group_dispose (GObject *gobject)
 {
   TidyDesaturationGroup *container = TIDY_DESATURATION_GROUP(gobject);
-  TidyDesaturationGroupPrivate *priv = container->priv;
 
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
+  tidy_desaturation_group_release_textures(container);
 
   G_OBJECT_CLASS (tidy_desaturation_group_parent_class)->dispose (gobject);
 }
@@ -430,14 +419,10 @@ tidy_desaturation_group_init (TidyDesaturationGroup *self)
 #endif
   priv->shader_saturate = 0;
 
-  priv->tex_a = 0;
-  priv->fbo_a = 0;
+  priv->buf_a = NULL;
 
   tidy_desaturation_group_check_shader(self, &priv->shader_saturate,
                                DESATURATE_SATURATE_FRAGMENT_SHADER, 0);
-
-  g_signal_connect(self, "notify::allocation",
-                   G_CALLBACK(tidy_desaturation_group_allocate_textures), NULL);
 }
 
 /*
@@ -471,8 +456,9 @@ void tidy_desaturation_group_desaturate(ClutterActor *desaturation_group)
 
   priv = TIDY_DESATURATION_GROUP(desaturation_group)->priv;
 
-  tidy_desaturation_group_allocate_textures(TIDY_DESATURATION_GROUP(desaturation_group));
-
+  /* Render the source again, with whatever target fits by then. */
+  priv->source_changed = TRUE;
+  priv->current_desaturation_step = 0;
   priv->undo_desaturation = FALSE;
   priv->desaturation_step = 1;
   clutter_actor_queue_redraw(desaturation_group);
@@ -38,6 +38,11 @@
 #define TIDY_FINGER_SCROLL_FADE_SCROLLBAR_IN_TIME (250)
 #define TIDY_FINGER_SCROLL_FADE_SCROLLBAR_OUT_TIME (500)
 #define TIDY_FINGER_SCROLL_DRAG_TRASHOLD (25)
+/* How many motion events are remembered by default (about 100ms worth
+ * when they come once a frame) and how old ones (ms) are still used to
+ * estimate the velocity of a fling. */
+#define TIDY_FINGER_SCROLL_MOTION_BUFFER (6)
+#define TIDY_FINGER_SCROLL_VELOCITY_WINDOW (100)
 
 typedef struct {
   /* Units to store the origin of a click when scrolling */
@@ -56,8 +61,11 @@ struct _TidyFingerScrollPrivate
   gboolean               move;
   ClutterFixed           first_x, first_y;
 
+  /* Ring buffer of the latest motions; @last_motion is the index of the
+   * newest one and @n_motions is how many of them there are. */
   GArray                *motion_buffer;
   guint                  last_motion;
+  guint                  n_motions;
 
   /* Variables for storing acceleration information for kinetic mode */
   ClutterTimeline       *deceleration_timeline;
@@ -129,9 +137,19 @@ tidy_finger_scroll_set_property (GObject *object, guint property_id,
       g_object_notify (object, "mode");
       break;
     case PROP_BUFFER :
-      g_array_set_size (priv->motion_buffer, g_value_get_uint (value));
-      g_object_notify (object, "motion-buffer");
-      break;
+      {
+        TidyFingerScrollMotion latest;
+
+        /* Only keep the newest, its place in the ring is going away. */
+        latest = g_array_index (priv->motion_buffer, TidyFingerScrollMotion,
+                                priv->last_motion);
+        g_array_set_size (priv->motion_buffer, g_value_get_uint (value));
+        g_array_index (priv->motion_buffer, TidyFingerScrollMotion, 0) = latest;
+        priv->last_motion = 0;
+        priv->n_motions = MIN (priv->n_motions, 1);
+        g_object_notify (object, "motion-buffer");
+        break;
+      }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -208,10 +226,89 @@ tidy_finger_scroll_class_init (TidyFingerScrollClass *klass)
                                                       "Motion buffer",
                                                       "Amount of motion "
                                                       "events to buffer",
-                                                      1, G_MAXUINT, 3,
+                                                      1, G_MAXUINT,
+                                                      TIDY_FINGER_SCROLL_MOTION_BUFFER,
                                                       G_PARAM_READWRITE));
 }
 
+/* Adds a motion to the ring buffer, overwriting the oldest one if full. */
+static TidyFingerScrollMotion *
+push_motion (TidyFingerScrollPrivate *priv, ClutterUnit x, ClutterUnit y)
+{
+  TidyFingerScrollMotion *motion;
+
+  if (priv->n_motions)
+    priv->last_motion = (priv->last_motion + 1) % priv->motion_buffer->len;
+  else
+    priv->last_motion = 0;
+  if (priv->n_motions < priv->motion_buffer->len)
+    priv->n_motions++;
+
+  motion = &g_array_index (priv->motion_buffer,
+                           TidyFingerScrollMotion, priv->last_motion);
+  motion->x = x;
+  motion->y = y;
+  g_get_current_time (&motion->time);
+  return motion;
+}
+
+/* Milliseconds from @now back to @then. */
+static gdouble
+motion_age (const GTimeVal *now, const GTimeVal *then)
+{
+  return (now->tv_sec - then->tv_sec) * 1000.0
+    + (now->tv_usec - then->tv_usec) / 1000.0;
+}
+
+/* Estimates the velocity of the pointer at the time it was released at
+ * @x, @y in units per ms, by fitting a line to the recent motions with
+ * least squares.  Returns FALSE if it can't be told. */
+static gboolean
+estimate_velocity (TidyFingerScrollPrivate *priv,
+                   ClutterUnit x, ClutterUnit y, const GTimeVal *now,
+                   gdouble *vx, gdouble *vy)
+{
+  gdouble st, sx, sy, stt, stx, sty, n, d;
+  guint i, idx;
+
+  /* The release point is at t=0, the buffered motions before it. */
+  n = 1;
+  st = stt = stx = sty = 0;
+  sx = CLUTTER_UNITS_TO_FLOAT (x);
+  sy = CLUTTER_UNITS_TO_FLOAT (y);
+  for (i = 0, idx = priv->last_motion; i < priv->n_motions; i++)
+    {
+      const TidyFingerScrollMotion *motion =
+        &g_array_index (priv->motion_buffer, TidyFingerScrollMotion, idx);
+      gdouble t = -motion_age (now, &motion->time);
+      gdouble mx = CLUTTER_UNITS_TO_FLOAT (motion->x);
+      gdouble my = CLUTTER_UNITS_TO_FLOAT (motion->y);
+
+      /* Always use the newest one, so a finger which stopped before
+       * it was lifted is seen to have stopped. */
+      if (i > 0 && -t > TIDY_FINGER_SCROLL_VELOCITY_WINDOW)
+        break;
+      n++;
+      st += t;
+      sx += mx;
+      sy += my;
+      stt += t * t;
+      stx += t * mx;
+      sty += t * my;
+
+      idx = idx ? idx - 1 : priv->motion_buffer->len - 1;
+    }
+
+  /* The slope of the line fitted to (t, x) and (t, y). */
+  d = n * stt - st * st;
+  if (d <= 0)
+    return FALSE;
+
+  *vx = (n * stx - st * sx) / d;
+  *vy = (n * sty - st * sy) / d;
+  return TRUE;
+}
+
 static gboolean
 motion_event_cb (ClutterActor *actor,
                  ClutterMotionEvent *event,
@@ -226,12 +323,12 @@ motion_event_cb (ClutterActor *actor,
                                            CLUTTER_UNITS_FROM_DEVICE(event->y),
                                            &x, &y))
     {
-      TidyFingerScrollMotion *motion;
       ClutterActor *child =
         tidy_scroll_view_get_child (TIDY_SCROLL_VIEW(scroll));
 
       if (child)
         {
+          TidyFingerScrollMotion *motion;
           ClutterFixed dx, dy;
           TidyAdjustment *hadjust, *vadjust;
 
@@ -266,19 +363,7 @@ motion_event_cb (ClutterActor *actor,
             }
         }
 
-      priv->last_motion ++;
-      if (priv->last_motion == priv->motion_buffer->len)
-        {
-          priv->motion_buffer = g_array_remove_index (priv->motion_buffer, 0);
-          g_array_set_size (priv->motion_buffer, priv->last_motion);
-          priv->last_motion --;
-        }
-
-      motion = &g_array_index (priv->motion_buffer,
-                               TidyFingerScrollMotion, priv->last_motion);
-      motion->x = x;
-      motion->y = y;
-      g_get_current_time (&motion->time);
+      push_motion (priv, x, y);
     }
 
   return FALSE;
@@ -579,53 +664,21 @@ button_release_event_cb (ClutterActor *actor,
                                                CLUTTER_UNITS_FROM_DEVICE(event->y),
                                                &x, &y))
         {
-          ClutterUnit frac, x_origin, y_origin;
           GTimeVal release_time;
-          int64_t motion_time_sec = 0;
-          int32_t motion_time_usec = 0;
           TidyAdjustment *hadjust, *vadjust;
-          glong time_diff;
-          gint i;
+          gdouble vx, vy;
 
-          /* Get time delta */
           g_get_current_time (&release_time);
 
-          /* Get average position/time of last x mouse events */
-          priv->last_motion ++;
-          x_origin = y_origin = 0;
-          for (i = 0; i < priv->last_motion; i++)
+          /* See how many units to move in 1/60th of a second; the
+           * finger moves one way and the contents the other. */
+          if (estimate_velocity (priv, x, y, &release_time, &vx, &vy))
             {
-              TidyFingerScrollMotion *motion =
-                &g_array_index (priv->motion_buffer, TidyFingerScrollMotion, i);
-              x_origin += motion->x;
-              y_origin += motion->y;
-              motion_time_sec += motion->time.tv_sec;
-              motion_time_usec+= motion->time.tv_usec;
+              priv->dx = CLUTTER_UNITS_FROM_FLOAT (-vx * 1000.0 / 60.0);
+              priv->dy = CLUTTER_UNITS_FROM_FLOAT (-vy * 1000.0 / 60.0);
             }
-          x_origin = CLUTTER_UNITS_FROM_FIXED (
-            clutter_qdivx (CLUTTER_UNITS_TO_FIXED (x_origin),
-                           CLUTTER_INT_TO_FIXED (priv->last_motion)));
-          y_origin = CLUTTER_UNITS_FROM_FIXED (
-            clutter_qdivx (CLUTTER_UNITS_TO_FIXED (y_origin),
-                           CLUTTER_INT_TO_FIXED (priv->last_motion)));
-          motion_time_sec /= priv->last_motion;
-          motion_time_usec /= priv->last_motion;
-
-         if (motion_time_sec == release_time.tv_sec)
-            time_diff = release_time.tv_usec - motion_time_usec;
-         else
-            time_diff = release_time.tv_usec +
-                          (G_USEC_PER_SEC - motion_time_usec);
-
-          /* Work out the fraction of 1/60th of a second that has elapsed */
-          frac = clutter_qdivx (CLUTTER_FLOAT_TO_FIXED (time_diff/1000.0),
-                                CLUTTER_FLOAT_TO_FIXED (1000.0/60.0));
-
-          /* See how many units to move in 1/60th of a second */
-          priv->dx = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
-                     CLUTTER_UNITS_TO_FIXED(x_origin - x), frac));
-          priv->dy = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
-                     CLUTTER_UNITS_TO_FIXED(y_origin - y), frac));
+          else
+            priv->dx = priv->dy = 0;
 
           /* Get adjustments to do step-increment snapping */
           tidy_scrollable_get_adjustments (TIDY_SCROLLABLE (child),
@@ -737,7 +790,7 @@ button_release_event_cb (ClutterActor *actor,
     }
 
   /* Reset motion event buffer */
-  priv->last_motion = 0;
+  priv->n_motions = 0;
 
   if (!decelerating)
     _tidy_finger_scroll_hide_scrollbars_later (scroll);
@@ -785,8 +838,9 @@ captured_event_cb (ClutterActor     *actor,
       TidyFingerScrollMotion *motion;
       ClutterButtonEvent *bevent = (ClutterButtonEvent *)event;
 
-      /* Reset motion buffer */
+      /* Reset motion buffer; the press is the first motion. */
       priv->last_motion = 0;
+      priv->n_motions = 1;
       motion = &g_array_index (priv->motion_buffer, TidyFingerScrollMotion, 0);
 
       if ((bevent->button == 1) &&
@@ -894,8 +948,9 @@ tidy_finger_scroll_init (TidyFingerScroll *self)
   guint i;
 
   priv->motion_buffer = g_array_sized_new (FALSE, TRUE,
-                                           sizeof (TidyFingerScrollMotion), 3);
-  g_array_set_size (priv->motion_buffer, 3);
+                                           sizeof (TidyFingerScrollMotion),
+                                           TIDY_FINGER_SCROLL_MOTION_BUFFER);
+  g_array_set_size (priv->motion_buffer, TIDY_FINGER_SCROLL_MOTION_BUFFER);
   priv->decel_rate = CLUTTER_FLOAT_TO_FIXED (
        hd_transition_get_double("launcher", "deceleration_rate", 0.99));
   priv->bouncing_decel_rate = CLUTTER_FLOAT_TO_FIXED (
@@ -11,6 +11,8 @@
 
 #include "cogl/cogl.h"
 
+#include "util/hd-profiler.h"
+
 enum
 {
   PROP_0,
@@ -151,6 +153,7 @@ tidy_highlight_paint (ClutterActor *self)
   guint                        tex_width, tex_height;
   ClutterFixed                 overlapx, overlapy;
   CoglTextureVertex            verts[4];
+  HD_PROFILER_SCOPE (HD_PROFILER_HIGHLIGHT);
 
   priv = TIDY_HIGHLIGHT (self)->priv;
 
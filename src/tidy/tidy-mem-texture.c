@@ -13,6 +13,8 @@
 #include <string.h>
 #include "cogl/cogl.h"
 
+#include "util/hd-profiler.h"
+
 #define EXACT_ROW_LENGTH 0
 /* We can only turn this off (which will be much quicker) when we have the
  * GLES driver/clutter that supports UNPACK_ROW_LENGTH */
@@ -96,6 +98,7 @@ tidy_mem_texture_paint (ClutterActor *self)
 
   gint                        width, height;
   GList                       *tiles;
+  HD_PROFILER_SCOPE (HD_PROFILER_MEM_TEXTURE);
 
   priv = TIDY_MEM_TEXTURE (self)->priv;
 
@@ -286,6 +289,7 @@ tidy_mem_texture_update_modified(TidyMemTexture *texture,
                  (tile->pos.x + tile->modified.x +
                  (tile->pos.y + tile->modified.y)*priv->texture_width) *
                  priv->texture_bpp];
+  HD_PROFILER_SCOPE (HD_PROFILER_TEXTURE_UPLOAD);
 
 #if EXACT_ROW_LENGTH
   for (y=0;y<tile->modified.height;y++)
@@ -0,0 +1,196 @@
+#include "tidy-offscreen-pool.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "util/hd-transition.h"
+
+/* Targets nobody has leased, most recently released first. */
+static GList *Pooled;
+static guint Trim_id;
+
+/* Tunables, read on first use. */
+static gsize Max_bytes;
+static guint Keep_ms;
+
+static TidyOffscreenPoolStats Stats;
+
+static void
+init (void)
+{
+  if (Keep_ms)
+    return;
+
+  /* The default holds the two half-size blur targets of both
+   * orientations plus a full-screen cache. */
+  Max_bytes = MAX (hd_transition_get_int ("offscreen_pool", "max_kb",
+                                          4096), 0) * 1024;
+  Keep_ms = MAX (hd_transition_get_int ("offscreen_pool", "keep_ms",
+                                        5000), 1);
+}
+
+static gsize
+target_size (guint width, guint height, CoglPixelFormat format)
+{
+  switch (format)
+    {
+      case COGL_PIXEL_FORMAT_RGB_565:
+      case COGL_PIXEL_FORMAT_RGBA_4444:
+      case COGL_PIXEL_FORMAT_RGBA_5551:
+        return width * height * 2;
+      default:
+        return width * height * 4;
+    }
+}
+
+static void
+free_target (TidyOffscreen *target)
+{
+  Stats.pooled_bytes -= target_size (target->width, target->height,
+                                     target->format);
+  cogl_offscreen_unref (target->fbo);
+  cogl_texture_unref (target->tex);
+  g_slice_free (TidyOffscreen, target);
+}
+
+/* Frees the least recently released targets until @needed more bytes
+ * fit under the cap. */
+static void
+make_room (gsize needed)
+{
+  GList *last;
+
+  while (Pooled && Stats.leased_bytes + Stats.pooled_bytes + needed
+                     > Max_bytes)
+    {
+      last = g_list_last (Pooled);
+      free_target (last->data);
+      Pooled = g_list_delete_link (Pooled, last);
+      Stats.evictions++;
+    }
+}
+
+/* Frees the targets which haven't been leased for Keep_ms. */
+static gboolean
+trim_old (gpointer unused)
+{
+  gint64 now = g_get_monotonic_time ();
+  GList *li, *next;
+
+  for (li = Pooled; li; li = next)
+    {
+      TidyOffscreen *target = li->data;
+
+      next = li->next;
+      if (now - target->released >= (gint64)Keep_ms * 1000)
+        {
+          free_target (target);
+          Pooled = g_list_delete_link (Pooled, li);
+        }
+    }
+
+  if (Pooled)
+    return TRUE;
+  Trim_id = 0;
+  return FALSE;
+}
+
+TidyOffscreen *
+tidy_offscreen_lease (guint width, guint height, CoglPixelFormat format)
+{
+  TidyOffscreen *target;
+  gsize size;
+  GList *li;
+
+  init ();
+  width  = MAX (width, 1);
+  height = MAX (height, 1);
+  size = target_size (width, height, format);
+  Stats.leases++;
+
+  for (li = Pooled; li; li = li->next)
+    if (tidy_offscreen_fits (li->data, width, height, format))
+      {
+        target = li->data;
+        Pooled = g_list_delete_link (Pooled, li);
+        Stats.pooled_bytes -= size;
+        Stats.leased_bytes += size;
+        Stats.hits++;
+        return target;
+      }
+
+  make_room (size);
+
+  target = g_slice_new0 (TidyOffscreen);
+  target->width  = width;
+  target->height = height;
+  target->format = format;
+  /* We can specify mipmapping here, but we don't need it. */
+  target->tex = cogl_texture_new_with_size (width, height, 0,
+                                            FALSE /* mipmap */, format);
+  cogl_texture_set_filters (target->tex, CGL_NEAREST, CGL_NEAREST);
+  target->fbo = cogl_offscreen_new_to_texture (target->tex);
+
+  Stats.allocations++;
+  Stats.leased_bytes += size;
+  Stats.peak_bytes = MAX (Stats.peak_bytes,
+                          Stats.leased_bytes + Stats.pooled_bytes);
+  return target;
+}
+
+void
+tidy_offscreen_release (TidyOffscreen *target)
+{
+  gsize size;
+
+  if (!target)
+    return;
+
+  size = target_size (target->width, target->height, target->format);
+  Stats.leased_bytes -= size;
+
+  /* It may have been left filtering linearly. */
+  cogl_texture_set_filters (target->tex, CGL_NEAREST, CGL_NEAREST);
+  target->released = g_get_monotonic_time ();
+  Pooled = g_list_prepend (Pooled, target);
+  Stats.pooled_bytes += size;
+  make_room (0);
+
+  if (Pooled && !Trim_id)
+    Trim_id = g_timeout_add (Keep_ms, trim_old, NULL);
+}
+
+gboolean
+tidy_offscreen_fits (const TidyOffscreen *target,
+                     guint width, guint height, CoglPixelFormat format)
+{
+  return target && target->width == MAX (width, 1)
+    && target->height == MAX (height, 1) && target->format == format;
+}
+
+void
+tidy_offscreen_pool_trim (void)
+{
+  while (Pooled)
+    {
+      free_target (Pooled->data);
+      Pooled = g_list_delete_link (Pooled, Pooled);
+    }
+  if (Trim_id)
+    Trim_id = (g_source_remove (Trim_id), 0);
+}
+
+void
+tidy_offscreen_pool_get_stats (TidyOffscreenPoolStats *stats)
+{
+  *stats = Stats;
+}
+
+/* Only the counters and the peak; the byte counts are the state. */
+void
+tidy_offscreen_pool_reset_stats (void)
+{
+  Stats.leases = Stats.hits = Stats.allocations = Stats.evictions = 0;
+  Stats.peak_bytes = Stats.leased_bytes + Stats.pooled_bytes;
+}
@@ -0,0 +1,56 @@
+/*
+ * Offscreen render targets shared by the groups which paint their
+ * children into a texture (TidyBlurGroup, TidyCachedGroup and
+ * TidyDesaturationGroup).  A group leases a target of the exact size and
+ * format it needs while it is buffered and returns it when it goes back
+ * to painting directly.  Returned targets are kept for a while so the
+ * next lease of the same kind (eg. the other orientation after a
+ * rotation) doesn't need to allocate, as long as everything together
+ * stays under a memory cap.
+ */
+
+#ifndef _TIDY_OFFSCREEN_POOL
+#define _TIDY_OFFSCREEN_POOL
+
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+typedef struct _TidyOffscreen TidyOffscreen;
+
+struct _TidyOffscreen
+{
+  CoglHandle tex;
+  CoglHandle fbo;
+  guint width, height;
+  CoglPixelFormat format;
+
+  /*< private >*/
+  gint64 released;
+};
+
+typedef struct
+{
+  guint leases, hits, allocations, evictions;
+  gsize leased_bytes, pooled_bytes, peak_bytes;
+} TidyOffscreenPoolStats;
+
+/* Returns a target of @width x @height (at least 1x1) in @format.
+ * Its contents are undefined. */
+TidyOffscreen *tidy_offscreen_lease (guint width, guint height,
+                                     CoglPixelFormat format);
+
+/* Gives @target back to the pool.  Safe to call with NULL. */
+void tidy_offscreen_release (TidyOffscreen *target);
+
+/* Whether @target is @width x @height in @format. */
+gboolean tidy_offscreen_fits (const TidyOffscreen *target,
+                              guint width, guint height,
+                              CoglPixelFormat format);
+
+/* Frees every target nobody has leased. */
+void tidy_offscreen_pool_trim (void);
+
+void tidy_offscreen_pool_get_stats (TidyOffscreenPoolStats *stats);
+void tidy_offscreen_pool_reset_stats (void);
+
+#endif
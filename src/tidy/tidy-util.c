@@ -70,3 +70,40 @@ void tidy_util_cogl_pop_offscreen_buffer(void)
   cogl_draw_buffer (obe->fbo ? COGL_OFFSCREEN_BUFFER : COGL_WINDOW_BUFFER,
                     obe->fbo);
 }
+
+/* Likewise for the blend function, which cogl can only set for colour and
+ * alpha together.  We need them separate to render into transparent
+ * offscreen buffers, so we save what's there and put it back exactly,
+ * so that cogl's idea of the state stays right. */
+/* ------------------------------------------------ */
+typedef struct {
+  GLint src_rgb, dst_rgb, src_alpha, dst_alpha;
+} BlendStackEntry;
+
+static BlendStackEntry blend_func_stack[4];
+static int blend_func_idx = 0;
+/* ------------------------------------------------  */
+
+void tidy_util_cogl_push_blend_func_separate(COGLenum src_rgb,
+                                             COGLenum dst_rgb,
+                                             COGLenum src_alpha,
+                                             COGLenum dst_alpha)
+{
+  g_assert(blend_func_idx < G_N_ELEMENTS(blend_func_stack));
+  BlendStackEntry *bse = &blend_func_stack[blend_func_idx++];
+
+  glGetIntegerv (GL_BLEND_SRC_RGB, &bse->src_rgb);
+  glGetIntegerv (GL_BLEND_DST_RGB, &bse->dst_rgb);
+  glGetIntegerv (GL_BLEND_SRC_ALPHA, &bse->src_alpha);
+  glGetIntegerv (GL_BLEND_DST_ALPHA, &bse->dst_alpha);
+  glBlendFuncSeparate (src_rgb, dst_rgb, src_alpha, dst_alpha);
+}
+
+void tidy_util_cogl_pop_blend_func(void)
+{
+  g_assert(blend_func_idx > 0);
+  BlendStackEntry *bse = &blend_func_stack[--blend_func_idx];
+
+  glBlendFuncSeparate (bse->src_rgb, bse->dst_rgb,
+                       bse->src_alpha, bse->dst_alpha);
+}
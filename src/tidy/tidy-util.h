@@ -8,4 +8,12 @@
 void tidy_util_cogl_push_offscreen_buffer(CoglHandle fbo);
 void tidy_util_cogl_pop_offscreen_buffer(void);
 
+/* Sets separate blend functions for colour and alpha until the matching
+ * pop, which restores the previous ones. */
+void tidy_util_cogl_push_blend_func_separate(COGLenum src_rgb,
+                                             COGLenum dst_rgb,
+                                             COGLenum src_alpha,
+                                             COGLenum dst_alpha);
+void tidy_util_cogl_pop_blend_func(void);
+
 #endif
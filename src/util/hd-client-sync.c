@@ -0,0 +1,260 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-client-sync.h"
+
+#include <string.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/sync.h>
+
+#include "hd-util.h"
+#include "mb/hd-comp-mgr.h"
+#include "home/hd-render-manager.h"
+
+static Display *Dpy;
+/* -1 until we know whether the server has the extension, 0 if not. */
+static int Sync_event_base = -1;
+
+/* The alarms of the clients we're waiting for. */
+static GArray *Waiters;
+static HdClientSyncDone Done;
+static gpointer Done_data;
+
+static gboolean
+init (Display *dpy)
+{
+  int error_base, major, minor;
+
+  if (Sync_event_base >= 0)
+    return Sync_event_base > 0;
+
+  Dpy = dpy;
+  Waiters = g_array_new (FALSE, FALSE, sizeof (XSyncAlarm));
+  if (XSyncQueryExtension (dpy, &Sync_event_base, &error_base)
+      && XSyncInitialize (dpy, &major, &minor))
+    return TRUE;
+
+  g_warning ("XSync is not supported, can't synchronize with clients");
+  Sync_event_base = 0;
+  return FALSE;
+}
+
+/* Returns @c's update counter if it takes _NET_WM_SYNC_REQUEST:s. */
+static XSyncCounter
+get_counter (MBWindowManager *wm, MBWindowManagerClient *c)
+{
+  HdCompMgr *hmgr = HD_COMP_MGR (wm->comp_mgr);
+  Atom sync_request, *protos;
+  XSyncCounter counter;
+  gulong *prop;
+  int i, n;
+
+  sync_request = hd_comp_mgr_get_atom (hmgr, HD_ATOM_NET_WM_SYNC_REQUEST);
+  counter = None;
+  if (XGetWMProtocols (wm->xdpy, c->window->xwindow, &protos, &n))
+    {
+      for (i = 0; i < n; i++)
+        if (protos[i] == sync_request)
+          break;
+      XFree (protos);
+      if (i == n)
+        return None;
+    }
+  else
+    return None;
+
+  /* There may be an extended counter too, which we don't use. */
+  prop = hd_util_get_win_prop_data_and_validate (wm->xdpy,
+                c->window->xwindow,
+                hd_comp_mgr_get_atom (hmgr,
+                                      HD_ATOM_NET_WM_SYNC_REQUEST_COUNTER),
+                XA_CARDINAL, 32, 0, &n);
+  if (prop)
+    {
+      if (n > 0)
+        counter = prop[0];
+      XFree (prop);
+    }
+
+  return counter;
+}
+
+/* Asks @c to bump its @counter after its next frame and sets up @alarmp
+ * to tell us when it did.  Returns whether it worked. */
+static gboolean
+send_request (MBWindowManager *wm, MBWindowManagerClient *c,
+              XSyncCounter counter, XSyncAlarm *alarmp)
+{
+  XSyncAlarmAttributes attrs;
+  XSyncValue value, one;
+  XEvent xev;
+  int overflow;
+
+  /* The new value must be above the current one or the alarm would go
+   * off right away. */
+  if (!XSyncQueryCounter (wm->xdpy, counter, &value))
+    return FALSE;
+  XSyncIntToValue (&one, 1);
+  XSyncValueAdd (&value, value, one, &overflow);
+
+  memset (&xev, 0, sizeof (xev));
+  xev.xclient.type = ClientMessage;
+  xev.xclient.window = c->window->xwindow;
+  xev.xclient.message_type = wm->atoms[MBWM_ATOM_WM_PROTOCOLS];
+  xev.xclient.format = 32;
+  xev.xclient.data.l[0] = hd_comp_mgr_get_atom (HD_COMP_MGR (wm->comp_mgr),
+                                                HD_ATOM_NET_WM_SYNC_REQUEST);
+  xev.xclient.data.l[1] = CurrentTime;
+  xev.xclient.data.l[2] = XSyncValueLow32 (value);
+  xev.xclient.data.l[3] = XSyncValueHigh32 (value);
+  XSendEvent (wm->xdpy, c->window->xwindow, False, NoEventMask, &xev);
+
+  /* The request applies to the next configuration the client gets.
+   * It may be the one it already has, so tell it again (a synthetic
+   * ConfigureNotify is always allowed, ICCCM 4.1.5). */
+  memset (&xev, 0, sizeof (xev));
+  xev.xconfigure.type = ConfigureNotify;
+  xev.xconfigure.event = c->window->xwindow;
+  xev.xconfigure.window = c->window->xwindow;
+  xev.xconfigure.x = c->window->geometry.x;
+  xev.xconfigure.y = c->window->geometry.y;
+  xev.xconfigure.width = c->window->geometry.width;
+  xev.xconfigure.height = c->window->geometry.height;
+  xev.xconfigure.above = None;
+  XSendEvent (wm->xdpy, c->window->xwindow, False, StructureNotifyMask,
+              &xev);
+
+  attrs.trigger.counter = counter;
+  attrs.trigger.value_type = XSyncAbsolute;
+  attrs.trigger.wait_value = value;
+  attrs.trigger.test_type = XSyncPositiveComparison;
+  XSyncIntToValue (&attrs.delta, 0);
+  attrs.events = True;
+  *alarmp = XSyncCreateAlarm (wm->xdpy,
+                              XSyncCACounter | XSyncCAValueType
+                              | XSyncCAValue | XSyncCATestType
+                              | XSyncCADelta | XSyncCAEvents,
+                              &attrs);
+  return *alarmp != None;
+}
+
+guint
+hd_client_sync_request (MBWindowManager *wm,
+                        HdClientSyncDone done, gpointer data,
+                        guint *n_others)
+{
+  MBWindowManagerClient *c;
+  XSyncAlarm alarm;
+
+  *n_others = 0;
+  hd_client_sync_cancel ();
+  if (!init (wm->xdpy))
+    {
+      for (c = wm->stack_top; c && c != wm->desktop; c = c->stacked_below)
+        if (c->window && hd_render_manager_is_client_visible (c))
+          (*n_others)++;
+      return 0;
+    }
+
+  mb_wm_util_async_trap_x_errors (wm->xdpy);
+  for (c = wm->stack_top; c && c != wm->desktop; c = c->stacked_below)
+    {
+      XSyncCounter counter;
+
+      if (!c->window || !hd_render_manager_is_client_visible (c))
+        continue;
+
+      if ((counter = get_counter (wm, c)) != None
+          && send_request (wm, c, counter, &alarm))
+        g_array_append_val (Waiters, alarm);
+      else
+        (*n_others)++;
+    }
+  XSync (wm->xdpy, False);
+  mb_wm_util_async_untrap_x_errors ();
+
+  if (Waiters->len)
+    {
+      Done = done;
+      Done_data = data;
+    }
+
+  g_debug ("%s: waiting for %u clients, %u can't tell", __FUNCTION__,
+           Waiters->len, *n_others);
+  return Waiters->len;
+}
+
+guint
+hd_client_sync_pending (void)
+{
+  return Waiters ? Waiters->len : 0;
+}
+
+void
+hd_client_sync_cancel (void)
+{
+  guint i;
+
+  if (!Waiters || !Waiters->len)
+    return;
+
+  mb_wm_util_async_trap_x_errors (Dpy);
+  for (i = 0; i < Waiters->len; i++)
+    XSyncDestroyAlarm (Dpy, g_array_index (Waiters, XSyncAlarm, i));
+  mb_wm_util_async_untrap_x_errors ();
+
+  g_array_set_size (Waiters, 0);
+  Done = NULL;
+  Done_data = NULL;
+}
+
+void
+hd_client_sync_x_event (const XEvent *xev)
+{
+  const XSyncAlarmNotifyEvent *aev;
+  HdClientSyncDone done;
+  guint i;
+
+  if (Sync_event_base <= 0 || !Waiters->len
+      || xev->type != Sync_event_base + XSyncAlarmNotify)
+    return;
+
+  /* The counter reached our value, or it was destroyed along with the
+   * client.  Either way there's nothing more to wait for. */
+  aev = (const XSyncAlarmNotifyEvent *)xev;
+  for (i = 0; i < Waiters->len; i++)
+    if (g_array_index (Waiters, XSyncAlarm, i) == aev->alarm)
+      break;
+  if (i == Waiters->len)
+    return;
+
+  mb_wm_util_async_trap_x_errors (Dpy);
+  XSyncDestroyAlarm (Dpy, aev->alarm);
+  mb_wm_util_async_untrap_x_errors ();
+  g_array_remove_index_fast (Waiters, i);
+
+  if (!Waiters->len && Done)
+    {
+      done = Done;
+      Done = NULL;
+      done (Done_data);
+    }
+}
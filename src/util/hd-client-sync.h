@@ -0,0 +1,59 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Frame synchronization with clients through _NET_WM_SYNC_REQUEST.
+ * Clients which support it get a request with a new value for their
+ * update counter followed by a ConfigureNotify, and set the counter to
+ * that value once they have handled the configuration and drawn the
+ * result.  We watch the counters with XSync alarms, so we know exactly
+ * when the last one is done instead of guessing from its damage.
+ */
+
+#ifndef __HD_CLIENT_SYNC_H__
+#define __HD_CLIENT_SYNC_H__
+
+#include <glib.h>
+#include <X11/Xlib.h>
+#include <matchbox/core/mb-wm.h>
+
+/* Called when every client asked has drawn its frame. */
+typedef void (*HdClientSyncDone) (gpointer data);
+
+/* Asks the visible clients of @wm which support it to tell when they
+ * have drawn a complete frame in their current geometry, and calls @done
+ * when all of them did.  Requests already in progress are cancelled.
+ * Returns how many clients were asked; @n_others is set to the number
+ * of visible clients which can't be asked. */
+guint hd_client_sync_request (MBWindowManager *wm,
+                              HdClientSyncDone done, gpointer data,
+                              guint *n_others);
+
+/* The number of clients we're still waiting for. */
+guint hd_client_sync_pending (void);
+
+/* Stops waiting, without calling @done. */
+void hd_client_sync_cancel (void);
+
+/* Feed all X events here. */
+void hd_client_sync_x_event (const XEvent *xev);
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-damage.h"
+
+#include <string.h>
+
+/* How many separate rectangles we keep before merging the closest ones. */
+#define MAX_RECTS                 8
+/* Merge two rectangles if their bounding box has at most this many
+ * pixels more than the two of them. */
+#define MERGE_SLACK               (64*64)
+/* Paint rectangles in the same frame if their bounding box is covered
+ * by them at least this much (percent). */
+#define GROUP_COVERAGE            50
+/* Repaint everything if the damage covers more of the stage than this
+ * (percent).  At this point scissoring doesn't save anything. */
+#define FULL_COVERAGE             75
+
+/* What is waiting to be painted. */
+static ClutterGeometry Pending[MAX_RECTS];
+static guint N_pending;
+static gboolean Pending_full;
+
+/* What the current frame paints.  Only valid if Frame_ours. */
+static ClutterGeometry Frame[MAX_RECTS];
+static guint N_frame;
+static gboolean Frame_ours;
+
+static guint Flush_id;
+static gulong Paint_handler;
+
+static inline guint
+area (const ClutterGeometry *r)
+{
+  return r->width * r->height;
+}
+
+static void
+bbox (ClutterGeometry *dst, const ClutterGeometry *a,
+      const ClutterGeometry *b)
+{
+  gint x1 = MIN (a->x, b->x), y1 = MIN (a->y, b->y);
+  gint x2 = MAX (a->x + (gint)a->width, b->x + (gint)b->width);
+  gint y2 = MAX (a->y + (gint)a->height, b->y + (gint)b->height);
+
+  dst->x = x1;
+  dst->y = y1;
+  dst->width = x2 - x1;
+  dst->height = y2 - y1;
+}
+
+static guint
+overlap (const ClutterGeometry *a, const ClutterGeometry *b)
+{
+  gint w = MIN (a->x + (gint)a->width, b->x + (gint)b->width)
+    - MAX (a->x, b->x);
+  gint h = MIN (a->y + (gint)a->height, b->y + (gint)b->height)
+    - MAX (a->y, b->y);
+
+  return w > 0 && h > 0 ? w * h : 0;
+}
+
+/* How many pixels would be painted needlessly if @a and @b were
+ * replaced by their bounding box. */
+static guint
+merge_waste (const ClutterGeometry *a, const ClutterGeometry *b)
+{
+  ClutterGeometry u;
+  guint covered;
+
+  bbox (&u, a, b);
+  covered = area (a) + area (b) - overlap (a, b);
+  return area (&u) - covered;
+}
+
+/* Keeps the order, so the oldest damage is always first. */
+static void
+remove_pending (guint i)
+{
+  N_pending--;
+  memmove (&Pending[i], &Pending[i+1], (N_pending - i) * sizeof (Pending[0]));
+}
+
+static void
+add_rect (ClutterGeometry r)
+{
+  guint i, j, best_i, best_j, best;
+
+  /* Absorb whatever @r can be merged with cheaply, repeatedly,
+   * because the result may be mergeable with something else. */
+  for (i = 0; i < N_pending; )
+    if (merge_waste (&Pending[i], &r) <= MERGE_SLACK)
+      {
+        bbox (&r, &Pending[i], &r);
+        remove_pending (i);
+        i = 0;
+      }
+    else
+      i++;
+
+  if (N_pending < MAX_RECTS)
+    {
+      Pending[N_pending++] = r;
+      return;
+    }
+
+  /* Full, merge the two which waste the least and try again. */
+  best = G_MAXUINT;
+  best_i = 0;
+  best_j = 1;
+  for (i = 0; i < N_pending; i++)
+    for (j = i + 1; j < N_pending; j++)
+      {
+        guint waste = merge_waste (&Pending[i], &Pending[j]);
+        if (waste < best)
+          {
+            best = waste;
+            best_i = i;
+            best_j = j;
+          }
+      }
+  bbox (&Pending[best_i], &Pending[best_i], &Pending[best_j]);
+  remove_pending (best_j);
+  add_rect (r);
+}
+
+/* Moves the rectangles to be painted in this frame from Pending to Frame
+ * and returns their bounding box. */
+static ClutterGeometry
+take_frame (void)
+{
+  ClutterGeometry box;
+  guint i, covered;
+
+  /* Start with the oldest damage, so nothing is postponed forever. */
+  box = Pending[0];
+  covered = area (&box);
+  N_frame = 0;
+  Frame[N_frame++] = box;
+  remove_pending (0);
+
+  /* Take along everything that keeps the box covered well enough. */
+  for (i = 0; i < N_pending; )
+    {
+      ClutterGeometry u;
+
+      bbox (&u, &box, &Pending[i]);
+      if ((covered + area (&Pending[i])) * 100 >= area (&u) * GROUP_COVERAGE)
+        {
+          box = u;
+          covered += area (&Pending[i]);
+          Frame[N_frame++] = Pending[i];
+          remove_pending (i);
+        }
+      else
+        i++;
+    }
+
+  /* Don't let damage lag behind for more than a frame though;
+   * if it's that scattered, paint it all at once. */
+  if (N_pending > 1)
+    {
+      for (i = 0; i < N_pending; i++)
+        {
+          bbox (&box, &box, &Pending[i]);
+          Frame[N_frame++] = Pending[i];
+        }
+      N_pending = 0;
+    }
+
+  return box;
+}
+
+static gboolean
+flush (gpointer unused)
+{
+  ClutterActor *stage = clutter_stage_get_default ();
+
+  Flush_id = 0;
+  if (Pending_full)
+    {
+      Pending_full = FALSE;
+      N_pending = 0;
+      Frame_ours = FALSE;
+      clutter_actor_queue_redraw (stage);
+    }
+  else if (N_pending)
+    {
+      Frame_ours = TRUE;
+      clutter_stage_set_damaged_area (stage, take_frame ());
+      clutter_actor_queue_redraw_damage (stage);
+    }
+
+  return FALSE;
+}
+
+static void
+schedule_flush (void)
+{
+  /* Run just before the stage is redrawn. */
+  if (!Flush_id)
+    Flush_id = g_idle_add_full (CLUTTER_PRIORITY_REDRAW - 1, flush,
+                                NULL, NULL);
+}
+
+static void
+stage_painted (ClutterActor *stage)
+{
+  Frame_ours = FALSE;
+  /* What didn't fit in this frame goes into the next one. */
+  if (N_pending || Pending_full)
+    schedule_flush ();
+}
+
+static void
+init (void)
+{
+  if (!Paint_handler)
+    Paint_handler = g_signal_connect_after (clutter_stage_get_default (),
+                                            "paint",
+                                            G_CALLBACK (stage_painted),
+                                            NULL);
+}
+
+void
+hd_damage_add (const ClutterGeometry *geo)
+{
+  ClutterActor *stage = clutter_stage_get_default ();
+  ClutterGeometry r;
+  guint i, covered, stage_w, stage_h;
+  gint x1, y1, x2, y2;
+
+  init ();
+  if (Pending_full)
+    return;
+
+  /* Clip to the stage. */
+  clutter_actor_get_size (stage, &stage_w, &stage_h);
+  x1 = MAX (geo->x, 0);
+  y1 = MAX (geo->y, 0);
+  x2 = MIN (geo->x + (gint)geo->width, (gint)stage_w);
+  y2 = MIN (geo->y + (gint)geo->height, (gint)stage_h);
+  if (x1 >= x2 || y1 >= y2)
+    return;
+  r.x = x1;
+  r.y = y1;
+  r.width = x2 - x1;
+  r.height = y2 - y1;
+
+  add_rect (r);
+
+  for (i = covered = 0; i < N_pending; i++)
+    covered += area (&Pending[i]);
+  if (covered * 100 > stage_w * stage_h * FULL_COVERAGE)
+    Pending_full = TRUE;
+
+  schedule_flush ();
+}
+
+void
+hd_damage_add_full (void)
+{
+  init ();
+  Pending_full = TRUE;
+  schedule_flush ();
+}
+
+gboolean
+hd_damage_get_frame (const ClutterGeometry **rects, guint *n_rects)
+{
+  if (!Frame_ours)
+    return FALSE;
+
+  *rects = Frame;
+  *n_rects = N_frame;
+  return TRUE;
+}
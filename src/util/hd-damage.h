@@ -0,0 +1,47 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Per-frame stage damage.  Instead of setting the stage's damaged area
+ * for every update, the rectangles are collected, merged where that
+ * doesn't waste much, and handed to the stage once, just before it is
+ * painted.  The stage only takes a single damaged box, so rectangles too
+ * far apart to share one without repainting most of the screen go into
+ * separate frames.
+ */
+
+#ifndef __HD_DAMAGE_H__
+#define __HD_DAMAGE_H__
+
+#include <glib.h>
+#include <clutter/clutter.h>
+
+/* Adds @area (in stage coordinates) to the damage of the next frame. */
+void hd_damage_add (const ClutterGeometry *area);
+
+/* The whole stage needs to be repainted. */
+void hd_damage_add_full (void);
+
+/* For use while painting: sets @rects and @n_rects to the damage being
+ * painted in this frame.  Returns FALSE if it's the whole stage. */
+gboolean hd_damage_get_frame (const ClutterGeometry **rects, guint *n_rects);
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-free-space.h"
+
+typedef struct
+{
+  gint x1, y1, x2, y2;
+} Rect;
+
+struct _HdFreeSpace
+{
+  /* The maximal free rectangles, by y1 and then x1. */
+  GArray *rects;
+  gint min_size;
+};
+
+static gint
+rect_cmp (const Rect *a, const Rect *b)
+{
+  if (a->y1 != b->y1)
+    return a->y1 - b->y1;
+  if (a->x1 != b->x1)
+    return a->x1 - b->x1;
+  if (a->y2 != b->y2)
+    return a->y2 - b->y2;
+  return a->x2 - b->x2;
+}
+
+static inline gboolean
+rect_contains (const Rect *outer, const Rect *inner)
+{
+  return outer->x1 <= inner->x1 && inner->x2 <= outer->x2
+    && outer->y1 <= inner->y1 && inner->y2 <= outer->y2;
+}
+
+static inline gboolean
+rect_intersects (const Rect *a, const Rect *b)
+{
+  return a->x1 < b->x2 && b->x1 < a->x2 && a->y1 < b->y2 && b->y1 < a->y2;
+}
+
+static void
+insert_rect (HdFreeSpace *space, const Rect *r)
+{
+  guint lo, hi;
+
+  lo = 0;
+  hi = space->rects->len;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (rect_cmp (&g_array_index (space->rects, Rect, mid), r) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  g_array_insert_val (space->rects, lo, *r);
+}
+
+HdFreeSpace *
+hd_free_space_new (gint x, gint y, gint width, gint height, gint min_size)
+{
+  HdFreeSpace *space = g_slice_new (HdFreeSpace);
+  Rect r = { x, y, x + width, y + height };
+
+  space->rects = g_array_new (FALSE, FALSE, sizeof (Rect));
+  space->min_size = min_size;
+  if (width > 0 && height > 0)
+    g_array_append_val (space->rects, r);
+
+  return space;
+}
+
+void
+hd_free_space_free (HdFreeSpace *space)
+{
+  if (!space)
+    return;
+
+  g_array_free (space->rects, TRUE);
+  g_slice_free (HdFreeSpace, space);
+}
+
+static inline void
+add_piece (GArray *pieces, gint x1, gint y1, gint x2, gint y2)
+{
+  Rect r = { x1, y1, x2, y2 };
+  g_array_append_val (pieces, r);
+}
+
+void
+hd_free_space_occupy (HdFreeSpace *space,
+                      gint x, gint y, gint width, gint height)
+{
+  Rect u = { x, y, x + width, y + height };
+  GArray *pieces;
+  guint i, j;
+  gint min = space->min_size;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  /* Cut what @u overlaps into the free strips around it, each of them
+   * as large as it can be.  Nothing from where the rectangles start
+   * below @u can overlap it. */
+  pieces = g_array_new (FALSE, FALSE, sizeof (Rect));
+  for (i = 0; i < space->rects->len; )
+    {
+      Rect f = g_array_index (space->rects, Rect, i);
+
+      if (f.y1 >= u.y2)
+        break;
+      if (!rect_intersects (&f, &u))
+        {
+          i++;
+          continue;
+        }
+      g_array_remove_index (space->rects, i);
+
+      if (u.y1 - f.y1 >= min)
+        add_piece (pieces, f.x1, f.y1, f.x2, u.y1);
+      if (f.y2 - u.y2 >= min)
+        add_piece (pieces, f.x1, u.y2, f.x2, f.y2);
+      if (u.x1 - f.x1 >= min)
+        add_piece (pieces, f.x1, f.y1, u.x1, f.y2);
+      if (f.x2 - u.x2 >= min)
+        add_piece (pieces, u.x2, f.y1, f.x2, f.y2);
+    }
+
+  /* Keep only the maximal ones.  The rectangles @u didn't touch were
+   * maximal, so they can't be inside the new ones, which are all parts
+   * of old maximal rectangles. */
+  for (i = 0; i < pieces->len; i++)
+    {
+      const Rect *p = &g_array_index (pieces, Rect, i);
+      gboolean contained = FALSE;
+
+      for (j = 0; j < space->rects->len && !contained; j++)
+        {
+          const Rect *f = &g_array_index (space->rects, Rect, j);
+
+          if (f->y1 > p->y1)
+            break;
+          contained = rect_contains (f, p);
+        }
+      for (j = 0; j < pieces->len && !contained; j++)
+        {
+          const Rect *q = &g_array_index (pieces, Rect, j);
+
+          /* Of equal ones keep the first. */
+          if (j != i && rect_contains (q, p))
+            contained = j < i || !rect_contains (p, q);
+        }
+
+      if (!contained)
+        insert_rect (space, p);
+    }
+
+  g_array_free (pieces, TRUE);
+}
+
+gboolean
+hd_free_space_find (HdFreeSpace *space, HdFreeSpaceFit fit,
+                    gint width, gint height, gint *x, gint *y)
+{
+  const Rect *best;
+  gint best_score, best_tie;
+  guint i;
+
+  best = NULL;
+  best_score = best_tie = G_MAXINT;
+  for (i = 0; i < space->rects->len; i++)
+    {
+      const Rect *f = &g_array_index (space->rects, Rect, i);
+      gint dw = (f->x2 - f->x1) - width;
+      gint dh = (f->y2 - f->y1) - height;
+      gint score, tie;
+
+      if (dw < 0 || dh < 0)
+        continue;
+
+      switch (fit)
+        {
+        case HD_FREE_SPACE_TOP_LEFT:
+          /* They're in this order already. */
+          *x = f->x1;
+          *y = f->y1;
+          return TRUE;
+        case HD_FREE_SPACE_BEST_AREA:
+          score = (f->x2 - f->x1) * (f->y2 - f->y1) - width * height;
+          tie = MIN (dw, dh);
+          break;
+        case HD_FREE_SPACE_BEST_SHORT_SIDE:
+        default:
+          score = MIN (dw, dh);
+          tie = MAX (dw, dh);
+          break;
+        }
+
+      if (score < best_score || (score == best_score && tie < best_tie))
+        {
+          best = f;
+          best_score = score;
+          best_tie = tie;
+        }
+    }
+
+  if (!best)
+    return FALSE;
+
+  *x = best->x1;
+  *y = best->y1;
+  return TRUE;
+}
+
+gboolean
+hd_free_space_find_near (HdFreeSpace *space,
+                         gint width, gint height,
+                         gint near_x, gint near_y,
+                         gint *x, gint *y)
+{
+  gint64 best;
+  gboolean found;
+  guint i;
+
+  found = FALSE;
+  best = G_MAXINT64;
+  for (i = 0; i < space->rects->len; i++)
+    {
+      const Rect *f = &g_array_index (space->rects, Rect, i);
+      gint cx, cy;
+      gint64 d;
+
+      /* The rest start even further down. */
+      if (f->y1 > near_y
+          && (gint64)(f->y1 - near_y) * (f->y1 - near_y) >= best)
+        break;
+      if (f->x2 - f->x1 < width || f->y2 - f->y1 < height)
+        continue;
+
+      cx = CLAMP (near_x, f->x1, f->x2 - width);
+      cy = CLAMP (near_y, f->y1, f->y2 - height);
+      d = (gint64)(cx - near_x) * (cx - near_x)
+        + (gint64)(cy - near_y) * (cy - near_y);
+      if (d < best)
+        {
+          best = d;
+          *x = cx;
+          *y = cy;
+          found = TRUE;
+        }
+    }
+
+  return found;
+}
+
+guint
+hd_free_space_size (HdFreeSpace *space)
+{
+  return space->rects->len;
+}
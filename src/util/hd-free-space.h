@@ -0,0 +1,73 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Free space allocator for placing rectangles (home applets) without
+ * overlap.  The free space is kept as the set of maximal free rectangles,
+ * sorted by their top and then left edge.  Occupying an area splits the
+ * free rectangles it overlaps into at most four maximal ones each, and
+ * drops any which became contained in another.
+ */
+
+#ifndef __HD_FREE_SPACE_H__
+#define __HD_FREE_SPACE_H__
+
+#include <glib.h>
+
+typedef struct _HdFreeSpace HdFreeSpace;
+
+/* Where hd_free_space_find() puts things. */
+typedef enum
+{
+  /* Topmost, then leftmost spot; fills the area in reading order. */
+  HD_FREE_SPACE_TOP_LEFT,
+  /* Where the shorter leftover side is the shortest. */
+  HD_FREE_SPACE_BEST_SHORT_SIDE,
+  /* In the smallest free rectangle. */
+  HD_FREE_SPACE_BEST_AREA,
+} HdFreeSpaceFit;
+
+/* An empty area of @width x @height at @x, @y.  Leftover strips
+ * narrower than @min_size aren't worth remembering. */
+HdFreeSpace *hd_free_space_new (gint x, gint y, gint width, gint height,
+                                gint min_size);
+void hd_free_space_free (HdFreeSpace *space);
+
+/* Marks the given area used; it may be partly outside or used already. */
+void hd_free_space_occupy (HdFreeSpace *space,
+                           gint x, gint y, gint width, gint height);
+
+/* Finds room for @width x @height and returns its position in @x, @y,
+ * or FALSE if there is none.  Doesn't occupy it. */
+gboolean hd_free_space_find (HdFreeSpace *space, HdFreeSpaceFit fit,
+                             gint width, gint height, gint *x, gint *y);
+
+/* Like hd_free_space_find(), but the room closest to @near_x, @near_y,
+ * eg. where an applet was dropped. */
+gboolean hd_free_space_find_near (HdFreeSpace *space,
+                                  gint width, gint height,
+                                  gint near_x, gint near_y,
+                                  gint *x, gint *y);
+
+/* How many free rectangles there are, for benchmarks. */
+guint hd_free_space_size (HdFreeSpace *space);
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-idle-work.h"
+
+#include <clutter/clutter.h>
+#include <clutter/x11/clutter-x11.h>
+#include <X11/Xlib.h>
+
+typedef struct
+{
+  guint id;
+  HdIdleWorkStep step;
+  HdIdleWorkFlush flush;
+  gpointer data;
+  GDestroyNotify notify;
+
+  /* Ran in the current slice. */
+  gboolean stepped;
+  /* Done or removed, to be freed when we aren't iterating the jobs. */
+  gboolean finished;
+} HdIdleJob;
+
+static GList *Jobs;
+static guint Last_id;
+static guint Idle_id;
+static GTimer *Slice_timer;
+
+static void
+job_free (HdIdleJob *job)
+{
+  if (job->notify)
+    job->notify (job->data);
+  g_free (job);
+}
+
+/* Whether the user is waiting for us. */
+static gboolean
+input_pending (void)
+{
+  return XPending (clutter_x11_get_default_display ()) > 0;
+}
+
+static gboolean
+run_slice (gpointer unused)
+{
+  gboolean progress;
+  GList *l, *next;
+
+  g_timer_start (Slice_timer);
+
+  /* Give every job a step in turn until the time is up. */
+  do
+    {
+      progress = FALSE;
+      for (l = Jobs; l; l = l->next)
+        {
+          HdIdleJob *job = l->data;
+
+          if (job->finished)
+            continue;
+
+          job->stepped = TRUE;
+          if (!job->step (job->data))
+            job->finished = TRUE;
+          else
+            progress = TRUE;
+
+          if (g_timer_elapsed (Slice_timer, NULL) * 1000
+              >= HD_IDLE_WORK_BUDGET)
+            {
+              progress = FALSE;
+              break;
+            }
+        }
+    }
+  while (progress && !input_pending ());
+
+  for (l = Jobs; l; l = next)
+    {
+      HdIdleJob *job = l->data;
+
+      next = l->next;
+      /* Not if it's been removed before it could run. */
+      if (job->stepped && job->flush)
+        job->flush (job->data);
+      job->stepped = FALSE;
+
+      if (job->finished)
+        {
+          Jobs = g_list_delete_link (Jobs, l);
+          job_free (job);
+        }
+    }
+
+  if (Jobs)
+    return TRUE;
+
+  Idle_id = 0;
+  return FALSE;
+}
+
+guint
+hd_idle_work_add (HdIdleWorkStep step, HdIdleWorkFlush flush,
+                  gpointer data, GDestroyNotify notify)
+{
+  HdIdleJob *job;
+
+  g_return_val_if_fail (step != NULL, 0);
+
+  job = g_new0 (HdIdleJob, 1);
+  job->id = ++Last_id;
+  job->step = step;
+  job->flush = flush;
+  job->data = data;
+  job->notify = notify;
+  Jobs = g_list_append (Jobs, job);
+
+  if (!Slice_timer)
+    Slice_timer = g_timer_new ();
+  if (!Idle_id)
+    Idle_id = clutter_threads_add_idle_full (CLUTTER_PRIORITY_REDRAW + 20,
+                                             run_slice, NULL, NULL);
+  return job->id;
+}
+
+void
+hd_idle_work_remove (guint id)
+{
+  GList *l;
+
+  for (l = Jobs; l; l = l->next)
+    {
+      HdIdleJob *job = l->data;
+
+      if (job->id != id || job->finished)
+        continue;
+
+      /* The job may be in the middle of a step, let run_slice()
+       * free it.  There's always one while there are jobs. */
+      job->finished = TRUE;
+      job->stepped = FALSE;
+      break;
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Cooperative background work.  Jobs are split into small steps which
+ * are run from a single idle source, below redraw priority, until the
+ * time budget of the current frame is spent or there is input waiting.
+ * Then the main loop gets control back and the work is continued in
+ * the next idle.  Jobs take turns, so a long one doesn't starve others.
+ */
+
+#ifndef __HD_IDLE_WORK_H__
+#define __HD_IDLE_WORK_H__
+
+#include <glib.h>
+
+/* How long a slice of idle work may take (ms). */
+#define HD_IDLE_WORK_BUDGET 8
+
+/* Does one small piece of work.  Returns FALSE when the job is done. */
+typedef gboolean (*HdIdleWorkStep) (gpointer data);
+
+/* Called after each slice in which the job made progress, including
+ * the last one, to finish up what the steps have done, eg. relayout. */
+typedef void (*HdIdleWorkFlush) (gpointer data);
+
+guint hd_idle_work_add (HdIdleWorkStep step, HdIdleWorkFlush flush,
+                        gpointer data, GDestroyNotify notify);
+
+/* Removes a job before it's done.  Its @notify is still called. */
+void hd_idle_work_remove (guint id);
+
+#endif
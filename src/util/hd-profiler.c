@@ -0,0 +1,318 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HD_ENABLE_PROFILER
+
+/* How many frames we remember. */
+#define RING_SIZE                 256
+/* How many of the slowest frames to report. */
+#define NWORST                    5
+/* Deepest nesting of instrumented scopes we keep track of. */
+#define MAX_DEPTH                 32
+
+typedef struct
+{
+  /* Sequence number of the frame, written last.  A reader who sees
+   * a different value before and after copying the frame knows it
+   * has been overwritten meanwhile. */
+  volatile gint seq;
+  guint32 total_us;
+  guint32 class_us[HD_PROFILER_NCLASSES];
+  guint16 class_calls[HD_PROFILER_NCLASSES];
+} Frame;
+
+typedef struct
+{
+  HdProfilerClass cls;
+  gint64 start;
+  gint64 children;
+} Scope;
+
+static const gchar *Class_names[HD_PROFILER_NCLASSES] =
+{
+  "blur-group",
+  "cached-group",
+  "desaturation-group",
+  "mem-texture",
+  "texture-upload",
+  "highlight",
+  "thumbnail",
+};
+
+/* The frame being painted; the paint path only ever touches this. */
+static Frame Current;
+static gint64 Frame_start;
+static Scope Stack[MAX_DEPTH];
+static guint Depth;
+
+/* Committed frames.  Single producer (the paint path), so publishing
+ * a frame is just bumping @Ring_head after it's been written. */
+static Frame Ring[RING_SIZE];
+static volatile gint Ring_head;
+
+HdProfilerClass
+hd_profiler_enter (HdProfilerClass cls)
+{
+  if (Depth < MAX_DEPTH)
+    {
+      Stack[Depth].cls = cls;
+      Stack[Depth].children = 0;
+      Stack[Depth].start = g_get_monotonic_time ();
+    }
+  Depth++;
+  return cls;
+}
+
+void
+hd_profiler_leave (HdProfilerClass cls)
+{
+  gint64 elapsed;
+  Scope *scope;
+
+  g_return_if_fail (Depth > 0);
+  if (--Depth >= MAX_DEPTH)
+    return;
+
+  scope = &Stack[Depth];
+  g_assert (scope->cls == cls);
+  elapsed = g_get_monotonic_time () - scope->start;
+
+  Current.class_us[cls] += elapsed - scope->children;
+  Current.class_calls[cls]++;
+  if (Depth > 0)
+    Stack[Depth-1].children += elapsed;
+}
+
+void
+hd_profiler_leave_scope (HdProfilerClass *cls)
+{
+  hd_profiler_leave (*cls);
+}
+
+static void
+paint_begin (ClutterActor *actor, HdProfilerClass cls)
+{
+  hd_profiler_enter (cls);
+}
+
+static void
+paint_end (ClutterActor *actor, HdProfilerClass cls)
+{
+  hd_profiler_leave (cls);
+}
+
+/* For actors without a paint() of their own, like the task navigator's
+ * thumbnails: time them around their ::paint emission. */
+void
+hd_profiler_watch_actor (ClutterActor *actor, HdProfilerClass cls)
+{
+  g_signal_connect (actor, "paint", G_CALLBACK (paint_begin),
+                    GINT_TO_POINTER (cls));
+  g_signal_connect_after (actor, "paint", G_CALLBACK (paint_end),
+                          GINT_TO_POINTER (cls));
+}
+
+static void
+frame_begin (ClutterActor *stage)
+{
+  Frame_start = g_get_monotonic_time ();
+}
+
+static void
+frame_end (ClutterActor *stage)
+{
+  gint head;
+  Frame *frame;
+
+  /* Anything accounted between two frames (eg. texture uploads done
+   * from an event handler) is charged to the next one. */
+  Current.total_us = g_get_monotonic_time () - Frame_start;
+
+  head = g_atomic_int_get (&Ring_head);
+  frame = &Ring[head % RING_SIZE];
+  g_atomic_int_set (&frame->seq, -1);
+  memcpy (frame->class_us, Current.class_us, sizeof (frame->class_us));
+  memcpy (frame->class_calls, Current.class_calls,
+          sizeof (frame->class_calls));
+  frame->total_us = Current.total_us;
+  g_atomic_int_set (&frame->seq, head);
+  g_atomic_int_set (&Ring_head, head + 1);
+
+  memset (&Current, 0, sizeof (Current));
+}
+
+void
+hd_profiler_init (ClutterActor *stage)
+{
+  g_signal_connect (stage, "paint", G_CALLBACK (frame_begin), NULL);
+  g_signal_connect_after (stage, "paint", G_CALLBACK (frame_end), NULL);
+}
+
+/* Copy the committed frames into @frames, oldest first, dropping those
+ * which were overwritten while we were reading them.  Returns how many
+ * frames are in @frames and sets @totalp to the number of frames ever
+ * painted. */
+static guint
+snapshot (Frame *frames, guint *totalp)
+{
+  gint head, first, i;
+  guint n;
+
+  head = g_atomic_int_get (&Ring_head);
+  first = head > RING_SIZE ? head - RING_SIZE : 0;
+  for (n = 0, i = first; i < head; i++)
+    {
+      const Frame *src = &Ring[i % RING_SIZE];
+
+      if (g_atomic_int_get (&src->seq) != i)
+        continue;
+      frames[n] = *src;
+      if (g_atomic_int_get (&src->seq) == i)
+        n++;
+    }
+
+  *totalp = head;
+  return n;
+}
+
+static int
+cmp_uint32 (const void *a, const void *b)
+{
+  guint32 ua = *(const guint32 *)a, ub = *(const guint32 *)b;
+  return ua < ub ? -1 : ua > ub;
+}
+
+static int
+cmp_frame_total_desc (const void *a, const void *b)
+{
+  return cmp_uint32 (&((const Frame *)b)->total_us,
+                     &((const Frame *)a)->total_us);
+}
+
+/* Returns the @pct-th percentile of the sorted @values. */
+static guint32
+percentile (const guint32 *values, guint n, guint pct)
+{
+  return n ? values[MIN (n - 1, n * pct / 100)] : 0;
+}
+
+static void
+append_percentiles (GString *str, const gchar *label,
+                    guint32 *values, guint n)
+{
+  qsort (values, n, sizeof (*values), cmp_uint32);
+  g_string_append_printf (str,
+             "  %-20s p50 %6.2f  p90 %6.2f  p99 %6.2f  max %6.2f ms\n",
+             label,
+             percentile (values, n, 50) / 1000.0,
+             percentile (values, n, 90) / 1000.0,
+             percentile (values, n, 99) / 1000.0,
+             n ? values[n - 1] / 1000.0 : 0.0);
+}
+
+gchar *
+hd_profiler_get_report (void)
+{
+  Frame *frames;
+  guint32 *values;
+  guint i, j, n, total;
+  GString *str;
+
+  frames = g_new (Frame, RING_SIZE);
+  values = g_new (guint32, RING_SIZE);
+  n = snapshot (frames, &total);
+
+  str = g_string_new (NULL);
+  g_string_append_printf (str, "frames: %u painted, last %u kept\n",
+                          total, n);
+  if (!n)
+    goto out;
+
+  for (i = 0; i < n; i++)
+    values[i] = frames[i].total_us;
+  append_percentiles (str, "frame", values, n);
+
+  for (j = 0; j < HD_PROFILER_NCLASSES; j++)
+    {
+      guint calls;
+
+      for (i = calls = 0; i < n; i++)
+        {
+          values[i] = frames[i].class_us[j];
+          calls += frames[i].class_calls[j];
+        }
+      if (!calls)
+        continue;
+      append_percentiles (str, Class_names[j], values, n);
+    }
+
+  g_string_append (str, "worst frames:\n");
+  qsort (frames, n, sizeof (*frames), cmp_frame_total_desc);
+  for (i = 0; i < MIN (n, NWORST); i++)
+    {
+      g_string_append_printf (str, "  #%d %.2f ms:", frames[i].seq,
+                              frames[i].total_us / 1000.0);
+      for (j = 0; j < HD_PROFILER_NCLASSES; j++)
+        if (frames[i].class_calls[j])
+          g_string_append_printf (str, " %s %.2f ms (%u)", Class_names[j],
+                                  frames[i].class_us[j] / 1000.0,
+                                  frames[i].class_calls[j]);
+      g_string_append_c (str, '\n');
+    }
+
+out:
+  g_free (values);
+  g_free (frames);
+  return g_string_free (str, FALSE);
+}
+
+#else /* ! HD_ENABLE_PROFILER */
+
+gchar *
+hd_profiler_get_report (void)
+{
+  return g_strdup ("");
+}
+
+#endif /* HD_ENABLE_PROFILER */
+
+void
+hd_profiler_dump (void)
+{
+#ifdef HD_ENABLE_PROFILER
+  gchar *report, **lines;
+  guint i;
+
+  report = hd_profiler_get_report ();
+  lines = g_strsplit (report, "\n", 0);
+  g_debug ("Paint profile:");
+  for (i = 0; lines[i]; i++)
+    if (*lines[i])
+      g_debug ("%s", lines[i]);
+  g_strfreev (lines);
+  g_free (report);
+#endif
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Per-frame paint profiler.  Built only with --enable-profiler; otherwise
+ * every HD_PROFILER_* macro expands to nothing and only the reporting
+ * entry points remain (returning an empty report).
+ *
+ * Instrumented code either wraps a whole function with HD_PROFILER_SCOPE()
+ * or an actor with hd_profiler_watch_actor().  Times are exclusive: the
+ * time spent in a nested instrumented scope is not counted for its parent.
+ */
+
+#ifndef __HD_PROFILER_H__
+#define __HD_PROFILER_H__
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+#include <clutter/clutter.h>
+
+typedef enum
+{
+  HD_PROFILER_BLUR_GROUP,
+  HD_PROFILER_CACHED_GROUP,
+  HD_PROFILER_DESATURATION_GROUP,
+  HD_PROFILER_MEM_TEXTURE,
+  HD_PROFILER_TEXTURE_UPLOAD,
+  HD_PROFILER_HIGHLIGHT,
+  HD_PROFILER_THUMBNAIL,
+
+  HD_PROFILER_NCLASSES
+} HdProfilerClass;
+
+/* Returns a human-readable summary of the recorded frames (percentiles
+ * and the worst frames with their per-class breakdown).  g_free() it. */
+gchar *hd_profiler_get_report (void);
+
+/* g_debug()s hd_profiler_get_report(). */
+void hd_profiler_dump (void);
+
+#ifdef HD_ENABLE_PROFILER
+
+void hd_profiler_init (ClutterActor *stage);
+HdProfilerClass hd_profiler_enter (HdProfilerClass cls);
+void hd_profiler_leave (HdProfilerClass cls);
+void hd_profiler_leave_scope (HdProfilerClass *cls);
+void hd_profiler_watch_actor (ClutterActor *actor, HdProfilerClass cls);
+
+# define HD_PROFILER_SCOPE(cls)                                         \
+  HdProfilerClass _hd_profiler_scope                                    \
+    __attribute__ ((cleanup (hd_profiler_leave_scope), unused))         \
+    = hd_profiler_enter (cls)
+
+#else /* ! HD_ENABLE_PROFILER */
+
+# define hd_profiler_init(stage)                  /* NOP */
+# define hd_profiler_watch_actor(actor, cls)      /* NOP */
+# define HD_PROFILER_SCOPE(cls)                   /* NOP */
+
+#endif /* HD_ENABLE_PROFILER */
+
+#endif
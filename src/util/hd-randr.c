@@ -0,0 +1,389 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-randr.h"
+
+#include <string.h>
+#include <X11/Xatom.h>
+
+typedef struct
+{
+  RROutput id;
+  RRCrtc crtc;
+  Connection connection;
+  gboolean is_panel;
+} HdRandrOutput;
+
+static Display *Dpy;
+static Window Root;
+/* -1 until we know whether we have RandR 1.3, 0 if not. */
+static int Event_base = -1;
+static Atom Connector_type, Connector_type_panel;
+
+/* The cached state.  @Res is only kept for the modes and the config
+ * timestamp, its CRTC and output lists may be out of date. */
+static XRRScreenResources *Res;
+static GArray *Crtcs, *Outputs;
+static RROutput Primary;
+static guint Screen_width, Screen_height;
+/* Whether the outputs have changed and everything must be reloaded. */
+static gboolean Dirty = TRUE;
+
+static void
+free_state (void)
+{
+  guint i;
+
+  for (i = 0; i < Crtcs->len; i++)
+    g_free (g_array_index (Crtcs, HdRandrCrtc, i).outputs);
+  g_array_set_size (Crtcs, 0);
+  g_array_set_size (Outputs, 0);
+  if (Res)
+    {
+      XRRFreeScreenResources (Res);
+      Res = NULL;
+    }
+}
+
+static gboolean
+output_is_panel (RROutput output)
+{
+  unsigned char *contype;
+  Atom actual_type;
+  int actual_format;
+  unsigned long nitems, bytes_after;
+  gboolean is_panel = FALSE;
+
+  if (XRRGetOutputProperty (Dpy, output, Connector_type,
+                            0, 1, False, False, AnyPropertyType,
+                            &actual_type, &actual_format, &nitems,
+                            &bytes_after, &contype) == Success)
+    {
+      is_panel = actual_type == XA_ATOM && actual_format == 32
+        && nitems == 1 && *(Atom *)contype == Connector_type_panel;
+      if (contype)
+        XFree (contype);
+    }
+
+  return is_panel;
+}
+
+static void
+load (void)
+{
+  int i;
+
+  free_state ();
+  Dirty = FALSE;
+
+  Screen_width  = DisplayWidth (Dpy, DefaultScreen (Dpy));
+  Screen_height = DisplayHeight (Dpy, DefaultScreen (Dpy));
+  if (!(Res = XRRGetScreenResourcesCurrent (Dpy, Root)))
+    {
+      g_warning ("Couldn't get RandR screen resources");
+      return;
+    }
+
+  for (i = 0; i < Res->ncrtc; i++)
+    {
+      XRRCrtcInfo *info;
+      HdRandrCrtc crtc;
+
+      if (!(info = XRRGetCrtcInfo (Dpy, Res, Res->crtcs[i])))
+        continue;
+      crtc.id = Res->crtcs[i];
+      crtc.x = info->x;
+      crtc.y = info->y;
+      crtc.width = info->width;
+      crtc.height = info->height;
+      crtc.mode = info->mode;
+      crtc.rotation = info->rotation;
+      crtc.rotations = info->rotations;
+      crtc.noutput = info->noutput;
+      crtc.outputs = g_memdup (info->outputs,
+                               info->noutput * sizeof (RROutput));
+      g_array_append_val (Crtcs, crtc);
+      XRRFreeCrtcInfo (info);
+    }
+
+  for (i = 0; i < Res->noutput; i++)
+    {
+      XRROutputInfo *info;
+      HdRandrOutput output;
+
+      if (!(info = XRRGetOutputInfo (Dpy, Res, Res->outputs[i])))
+        continue;
+      output.id = Res->outputs[i];
+      output.crtc = info->crtc;
+      output.connection = info->connection;
+      output.is_panel = output_is_panel (output.id);
+      g_array_append_val (Outputs, output);
+      XRRFreeOutputInfo (info);
+    }
+
+  Primary = XRRGetOutputPrimary (Dpy, Root);
+}
+
+static HdRandrCrtc *
+find_crtc (RRCrtc id)
+{
+  guint i;
+
+  if (id == None)
+    return NULL;
+  for (i = 0; i < Crtcs->len; i++)
+    if (g_array_index (Crtcs, HdRandrCrtc, i).id == id)
+      return &g_array_index (Crtcs, HdRandrCrtc, i);
+  return NULL;
+}
+
+static HdRandrOutput *
+find_output (RROutput id)
+{
+  guint i;
+
+  for (i = 0; i < Outputs->len; i++)
+    if (g_array_index (Outputs, HdRandrOutput, i).id == id)
+      return &g_array_index (Outputs, HdRandrOutput, i);
+  return NULL;
+}
+
+/* Loads the topology if it has changed.  Returns FALSE if there's no
+ * RandR to ask. */
+static gboolean
+update (void)
+{
+  if (Event_base <= 0)
+    return FALSE;
+  if (Dirty)
+    load ();
+  return Res != NULL;
+}
+
+gboolean
+hd_randr_init (Display *dpy)
+{
+  int error_base, major, minor;
+
+  if (Event_base >= 0)
+    return Event_base > 0;
+
+  Dpy = dpy;
+  Root = DefaultRootWindow (dpy);
+  Crtcs = g_array_new (FALSE, FALSE, sizeof (HdRandrCrtc));
+  Outputs = g_array_new (FALSE, FALSE, sizeof (HdRandrOutput));
+
+  if (!XRRQueryExtension (dpy, &Event_base, &error_base)
+      || !XRRQueryVersion (dpy, &major, &minor)
+      || !(major > 1 || (major == 1 && minor >= 3)))
+    {
+      Event_base = 0;
+      return FALSE;
+    }
+
+  Connector_type = XInternAtom (dpy, "ConnectorType", False);
+  Connector_type_panel = XInternAtom (dpy, "Panel", False);
+  XRRSelectInput (dpy, Root, RRScreenChangeNotifyMask
+                  | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask
+                  | RROutputPropertyNotifyMask);
+  return TRUE;
+}
+
+const HdRandrCrtc *
+hd_randr_get_panel_crtc (void)
+{
+  HdRandrOutput *output;
+  guint i;
+
+  if (!update ())
+    return NULL;
+
+  if (Crtcs->len == 1)
+    return &g_array_index (Crtcs, HdRandrCrtc, 0);
+
+  for (i = 0; i < Outputs->len; i++)
+    {
+      output = &g_array_index (Outputs, HdRandrOutput, i);
+      if (output->is_panel)
+        return find_crtc (output->crtc);
+    }
+
+  if (Primary != None && (output = find_output (Primary)) != NULL)
+    return find_crtc (output->crtc);
+
+  return NULL;
+}
+
+const HdRandrCrtc *
+hd_randr_get_connected_crtc (void)
+{
+  HdRandrOutput *output;
+  guint i;
+
+  if (!update ())
+    return NULL;
+
+  for (i = 0; i < Outputs->len; i++)
+    {
+      output = &g_array_index (Outputs, HdRandrOutput, i);
+      if (output->crtc && output->connection == RR_Connected)
+        return find_crtc (output->crtc);
+    }
+
+  return NULL;
+}
+
+void
+hd_randr_get_screen_size (guint *width, guint *height)
+{
+  if (!update ())
+    {
+      *width  = DisplayWidth (Dpy, DefaultScreen (Dpy));
+      *height = DisplayHeight (Dpy, DefaultScreen (Dpy));
+      return;
+    }
+
+  *width  = Screen_width;
+  *height = Screen_height;
+}
+
+Status
+hd_randr_set_crtc_config (RRCrtc id, int x, int y,
+                          RRMode mode, Rotation rotation,
+                          RROutput *outputs, int noutput)
+{
+  HdRandrCrtc *crtc;
+  Status status;
+  int i;
+
+  if (!update ())
+    return RRSetConfigFailed;
+
+  /* CurrentTime is always after the CRTC's last change, so we don't
+   * need to know when that was. */
+  status = XRRSetCrtcConfig (Dpy, Res, id, CurrentTime, x, y, mode,
+                             rotation, outputs, noutput);
+  if (status != RRSetConfigSuccess || !(crtc = find_crtc (id)))
+    return status;
+
+  crtc->x = x;
+  crtc->y = y;
+  crtc->mode = mode;
+  crtc->rotation = rotation;
+  if (outputs != crtc->outputs)
+    {
+      g_free (crtc->outputs);
+      crtc->outputs = g_memdup (outputs, noutput * sizeof (RROutput));
+    }
+  crtc->noutput = noutput;
+
+  crtc->width = crtc->height = 0;
+  for (i = 0; mode != None && i < Res->nmode; i++)
+    if (Res->modes[i].id == mode)
+      {
+        if (rotation & (RR_Rotate_90 | RR_Rotate_270))
+          {
+            crtc->width  = Res->modes[i].height;
+            crtc->height = Res->modes[i].width;
+          }
+        else
+          {
+            crtc->width  = Res->modes[i].width;
+            crtc->height = Res->modes[i].height;
+          }
+        break;
+      }
+
+  return status;
+}
+
+void
+hd_randr_set_screen_size (int width, int height, int mm_width, int mm_height)
+{
+  XRRSetScreenSize (Dpy, Root, width, height, mm_width, mm_height);
+  Screen_width  = width;
+  Screen_height = height;
+}
+
+void
+hd_randr_x_event (XEvent *xev)
+{
+  if (Event_base <= 0)
+    return;
+
+  if (xev->type == Event_base + RRScreenChangeNotify)
+    {
+      XRRScreenChangeNotifyEvent *sev = (XRRScreenChangeNotifyEvent *)xev;
+
+      /* Keep Xlib's idea of the screen size right. */
+      XRRUpdateConfiguration (xev);
+      Screen_width  = sev->width;
+      Screen_height = sev->height;
+
+      /* A new config timestamp means the server has re-probed. */
+      if (Res && sev->config_timestamp != Res->configTimestamp)
+        Dirty = TRUE;
+    }
+  else if (xev->type == Event_base + RRNotify && !Dirty)
+    {
+      XRRNotifyEvent *nev = (XRRNotifyEvent *)xev;
+
+      if (nev->subtype == RRNotify_CrtcChange)
+        {
+          XRRCrtcChangeNotifyEvent *cev = (XRRCrtcChangeNotifyEvent *)xev;
+          HdRandrCrtc *crtc;
+
+          if (!(crtc = find_crtc (cev->crtc)))
+            {
+              Dirty = TRUE;
+              return;
+            }
+          crtc->x = cev->x;
+          crtc->y = cev->y;
+          crtc->width = cev->width;
+          crtc->height = cev->height;
+          crtc->mode = cev->mode;
+          crtc->rotation = cev->rotation;
+        }
+      else if (nev->subtype == RRNotify_OutputChange)
+        {
+          XRROutputChangeNotifyEvent *oev = (XRROutputChangeNotifyEvent *)xev;
+          HdRandrOutput *output;
+
+          /* The CRTCs' output lists change too, just reload. */
+          if (!(output = find_output (oev->output))
+              || output->crtc != oev->crtc)
+            {
+              Dirty = TRUE;
+              return;
+            }
+          output->connection = oev->connection;
+        }
+      else if (nev->subtype == RRNotify_OutputProperty)
+        {
+          XRROutputPropertyNotifyEvent *pev
+            = (XRROutputPropertyNotifyEvent *)xev;
+
+          if (pev->property == Connector_type)
+            Dirty = TRUE;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * What RandR knows about the screen, kept locally.  The topology is
+ * loaded once with XRRGetScreenResourcesCurrent(), which doesn't make
+ * the server probe the outputs, and then kept up to date from RRNotify
+ * and RRScreenChangeNotify events and from our own changes, so the
+ * rotation and the input transformation code can ask about CRTCs
+ * without any round-trips.  Only when outputs come or go is it loaded
+ * again, the next time it's asked.
+ */
+
+#ifndef __HD_RANDR_H__
+#define __HD_RANDR_H__
+
+#include <glib.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+
+typedef struct
+{
+  RRCrtc id;
+  int x, y;
+  guint width, height;
+  RRMode mode;
+  Rotation rotation, rotations;
+  RROutput *outputs;
+  int noutput;
+} HdRandrCrtc;
+
+/* Returns FALSE if the server doesn't have RandR 1.3. */
+gboolean hd_randr_init (Display *dpy);
+
+/* The CRTC of the built-in panel, or if we can't tell which output
+ * that is, the primary output's.  NULL if there's none. */
+const HdRandrCrtc *hd_randr_get_panel_crtc (void);
+
+/* The CRTC of the first connected output which has one, or NULL. */
+const HdRandrCrtc *hd_randr_get_connected_crtc (void);
+
+void hd_randr_get_screen_size (guint *width, guint *height);
+
+/* XRRSetCrtcConfig() and XRRSetScreenSize() which update the cache
+ * right away, so the changes can be queried before the server's
+ * notifications arrive. */
+Status hd_randr_set_crtc_config (RRCrtc crtc, int x, int y,
+                                 RRMode mode, Rotation rotation,
+                                 RROutput *outputs, int noutput);
+void hd_randr_set_screen_size (int width, int height,
+                               int mm_width, int mm_height);
+
+/* Feed all X events here. */
+void hd_randr_x_event (XEvent *xev);
+
+#endif
@@ -0,0 +1,551 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "hd-recorder.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <X11/Xatom.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <matchbox/core/mb-wm.h>
+
+#include "hd-damage.h"
+#include "home/hd-render-manager.h"
+#include "mb/hd-comp-mgr.h"
+#include "launcher/hd-app-mgr.h"
+#include "launcher/hd-launcher.h"
+#include "mb/hd-atom-dispatch.h"
+#include "tidy/tidy-offscreen-pool.h"
+
+/* Don't log property values longer than this many bytes. */
+#define MAX_PROPERTY_SIZE         4096
+
+static Display *Dpy;
+
+/* Recording */
+static FILE *Record;
+static gint64 Record_start;
+static GHashTable *Atom_names;
+static gint Damage_event_base = -1;
+static gchar *Last_state;
+
+/* Statistics */
+static gchar *Stats_file;
+static Atom Bench_atom;
+static GArray *Frame_us, *Interval_us, *Input_latency_us;
+static gint64 Stats_start, Frame_start, Last_frame_start;
+static struct rusage Stats_rusage;
+static guint Restacks, X_events, Full_frames;
+static guint64 Damaged_px;
+/* When the oldest input not yet on the screen was received, or 0. */
+static gint64 Input_pending;
+static guint Motion_coalesced;
+/* Window manager syncs and the X events they covered. */
+static guint Wm_syncs, Wm_sync_events, Wm_sync_events_max;
+
+static const gchar *
+atom_name (Atom atom)
+{
+  gchar *name, *xname;
+
+  if (atom == None)
+    return "None";
+
+  name = g_hash_table_lookup (Atom_names, GUINT_TO_POINTER (atom));
+  if (name)
+    return name;
+
+  mb_wm_util_async_trap_x_errors (Dpy);
+  xname = XGetAtomName (Dpy, atom);
+  mb_wm_util_async_untrap_x_errors ();
+  name = g_strdup (xname ? xname : "None");
+  if (xname)
+    XFree (xname);
+
+  g_hash_table_insert (Atom_names, GUINT_TO_POINTER (atom), name);
+  return name;
+}
+
+static void
+record (const gchar *fmt, ...) G_GNUC_PRINTF (1, 2);
+
+static void
+record (const gchar *fmt, ...)
+{
+  va_list args;
+
+  fprintf (Record, "%lld ",
+           (long long)(g_get_monotonic_time () - Record_start) / 1000);
+  va_start (args, fmt);
+  vfprintf (Record, fmt, args);
+  va_end (args);
+  fputc ('\n', Record);
+}
+
+/* Logs the current value of @prop of @xwin, if it's still there,
+ * as "<type> <format> <hex data>". */
+static void
+record_property (Window xwin, Atom prop)
+{
+  Atom type;
+  int format, status;
+  unsigned long nitems, after, i, size;
+  unsigned char *data;
+  GString *line;
+
+  data = NULL;
+  mb_wm_util_async_trap_x_errors (Dpy);
+  status = XGetWindowProperty (Dpy, xwin, prop, 0,
+                               MAX_PROPERTY_SIZE / 4, False,
+                               AnyPropertyType, &type, &format,
+                               &nitems, &after, &data);
+  mb_wm_util_async_untrap_x_errors ();
+
+  line = g_string_new (NULL);
+  g_string_printf (line, "property 0x%lx %s ", xwin, atom_name (prop));
+  if (status != Success || type == None)
+    g_string_append (line, "None 0 -");
+  else
+    {
+      g_string_append_printf (line, "%s %d ", atom_name (type), format);
+
+      /* Atom values are only meaningful by name on another server;
+       * Xlib hands out 32-bit items as longs. */
+      if (type == XA_ATOM && format == 32)
+        for (i = 0; i < nitems; i++)
+          g_string_append_printf (line, "%s%s", i ? "," : "",
+                                  atom_name (((unsigned long *)data)[i]));
+      else if (format == 32)
+        for (i = 0; i < nitems; i++)
+          g_string_append_printf (line, "%08lx",
+                                  ((unsigned long *)data)[i] & 0xffffffff);
+      else
+        {
+          size = nitems * (format / 8);
+          for (i = 0; i < size; i++)
+            g_string_append_printf (line, "%02x", data[i]);
+        }
+      if (!nitems)
+        g_string_append_c (line, '-');
+    }
+
+  if (data)
+    XFree (data);
+  record ("%s", line->str);
+  g_string_free (line, TRUE);
+}
+
+static void
+record_x_event (const XEvent *xev)
+{
+  switch (xev->type)
+    {
+      case CreateNotify:
+        record ("create 0x%lx %d %d %d %d %d",
+                xev->xcreatewindow.window,
+                xev->xcreatewindow.x, xev->xcreatewindow.y,
+                xev->xcreatewindow.width, xev->xcreatewindow.height,
+                xev->xcreatewindow.override_redirect);
+        break;
+      case MapRequest:
+        record ("map 0x%lx", xev->xmaprequest.window);
+        break;
+      case MapNotify:
+        /* Nobody asks us to map override-redirect windows. */
+        if (xev->xmap.override_redirect
+            && xev->xmap.event != xev->xmap.window)
+          record ("map 0x%lx", xev->xmap.window);
+        break;
+      case UnmapNotify:
+        if (xev->xunmap.event != xev->xunmap.window)
+          record ("unmap 0x%lx", xev->xunmap.window);
+        break;
+      case DestroyNotify:
+        if (xev->xdestroywindow.event != xev->xdestroywindow.window)
+          record ("destroy 0x%lx", xev->xdestroywindow.window);
+        break;
+      case ConfigureRequest:
+        record ("configure 0x%lx %d %d %d %d",
+                xev->xconfigurerequest.window,
+                xev->xconfigurerequest.x, xev->xconfigurerequest.y,
+                xev->xconfigurerequest.width,
+                xev->xconfigurerequest.height);
+        break;
+      case PropertyNotify:
+        record_property (xev->xproperty.window, xev->xproperty.atom);
+        break;
+      case ClientMessage:
+        if (xev->xclient.message_type == Bench_atom)
+          break;
+        record ("message 0x%lx %s %d %lx %lx %lx %lx %lx",
+                xev->xclient.window,
+                atom_name (xev->xclient.message_type),
+                xev->xclient.format,
+                xev->xclient.data.l[0], xev->xclient.data.l[1],
+                xev->xclient.data.l[2], xev->xclient.data.l[3],
+                xev->xclient.data.l[4]);
+        break;
+      default:
+        if (Damage_event_base >= 0
+            && xev->type == Damage_event_base + XDamageNotify)
+          {
+            const XDamageNotifyEvent *dev = (const XDamageNotifyEvent *)xev;
+            record ("damage 0x%lx %d %d %d %d", dev->drawable,
+                    dev->area.x, dev->area.y,
+                    dev->area.width, dev->area.height);
+          }
+        break;
+    }
+}
+
+static void
+stats_reset (void)
+{
+  g_array_set_size (Frame_us, 0);
+  g_array_set_size (Interval_us, 0);
+  g_array_set_size (Input_latency_us, 0);
+  Restacks = X_events = Full_frames = Motion_coalesced = 0;
+  Wm_syncs = Wm_sync_events = Wm_sync_events_max = 0;
+  tidy_offscreen_pool_reset_stats ();
+  hd_atom_dispatch_reset_stats ();
+  hd_app_mgr_reset_orientation_stats ();
+  hd_launcher_reset_stats ();
+  hd_comp_mgr_reset_portrait_stats ();
+  Damaged_px = 0;
+  Input_pending = 0;
+  Last_frame_start = 0;
+  Stats_start = g_get_monotonic_time ();
+  getrusage (RUSAGE_SELF, &Stats_rusage);
+}
+
+static void
+stats_frame_begin (ClutterActor *stage)
+{
+  const ClutterGeometry *rects;
+  guint i, n;
+
+  Frame_start = g_get_monotonic_time ();
+  if (!hd_damage_get_frame (&rects, &n))
+    Full_frames++;
+  else
+    for (i = 0; i < n; i++)
+      Damaged_px += rects[i].width * rects[i].height;
+  if (Last_frame_start)
+    {
+      guint32 us = Frame_start - Last_frame_start;
+      g_array_append_val (Interval_us, us);
+    }
+  Last_frame_start = Frame_start;
+}
+
+static void
+stats_frame_end (ClutterActor *stage)
+{
+  gint64 now = g_get_monotonic_time ();
+  guint32 us = now - Frame_start;
+
+  g_array_append_val (Frame_us, us);
+  if (Input_pending)
+    {
+      us = now - Input_pending;
+      g_array_append_val (Input_latency_us, us);
+      Input_pending = 0;
+    }
+}
+
+static int
+cmp_uint32 (const void *a, const void *b)
+{
+  guint32 ua = *(const guint32 *)a, ub = *(const guint32 *)b;
+  return ua < ub ? -1 : ua > ub;
+}
+
+static void
+append_distribution (GString *json, const gchar *name, GArray *values)
+{
+  guint32 *v;
+  guint i, n;
+  guint64 sum;
+
+  n = values->len;
+  v = (guint32 *)values->data;
+  qsort (v, n, sizeof (*v), cmp_uint32);
+  for (i = 0, sum = 0; i < n; i++)
+    sum += v[i];
+
+#define PCT(p) (n ? v[MIN (n - 1, n * (p) / 100)] / 1000.0 : 0.0)
+  g_string_append_printf (json,
+        "  \"%s\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+        "\"max\": %.3f, \"mean\": %.3f },\n", name,
+        PCT (50), PCT (90), PCT (99),
+        n ? v[n - 1] / 1000.0 : 0.0,
+        n ? sum / 1000.0 / n : 0.0);
+#undef PCT
+}
+
+static gdouble
+timeval_ms (const struct timeval *end, const struct timeval *start)
+{
+  return (end->tv_sec - start->tv_sec) * 1000.0
+    + (end->tv_usec - start->tv_usec) / 1000.0;
+}
+
+static void
+append_atom_events (int type, Atom atom, guint events, void *atoms)
+{
+  if (events)
+    g_string_append_printf (atoms, "%s\"%s\": %u",
+                            ((GString *)atoms)->len ? ", " : "",
+                            atom_name (atom), events);
+}
+
+/* Writes the statistics collected since the last reset to @Stats_file.
+ * Written to a temporary file first, so whoever polls for it never sees
+ * it half-done. */
+static void
+stats_dump (void)
+{
+  struct rusage now;
+  TidyOffscreenPoolStats offscreen;
+  HdAppMgrOrientationStats orientation;
+  HdLauncherStats launcher;
+  HdCompMgrPortraitStats portrait;
+  GString *json, *atoms;
+  gchar *tmp;
+  GError *error = NULL;
+
+  getrusage (RUSAGE_SELF, &now);
+  tidy_offscreen_pool_get_stats (&offscreen);
+  hd_app_mgr_get_orientation_stats (&orientation);
+  hd_launcher_get_stats (&launcher);
+  hd_comp_mgr_get_portrait_stats (&portrait);
+  atoms = g_string_new (NULL);
+  hd_atom_dispatch_foreach_stat (append_atom_events, atoms);
+
+  json = g_string_new ("{\n");
+  g_string_append_printf (json, "  \"frames\": %u,\n", Frame_us->len);
+  append_distribution (json, "frame_ms", Frame_us);
+  append_distribution (json, "frame_interval_ms", Interval_us);
+  append_distribution (json, "input_latency_ms", Input_latency_us);
+  g_string_append_printf (json,
+        "  \"cpu_user_ms\": %.1f,\n"
+        "  \"cpu_sys_ms\": %.1f,\n"
+        "  \"wall_ms\": %.1f,\n"
+        "  \"restacks\": %u,\n"
+        "  \"x_events\": %u,\n"
+        "  \"full_frames\": %u,\n"
+        "  \"motion_coalesced\": %u,\n"
+        "  \"wm_syncs\": %u,\n"
+        "  \"events_per_sync\": %.2f,\n"
+        "  \"events_per_sync_max\": %u,\n"
+        "  \"atom_events\": { %s },\n"
+        "  \"atom_events_dropped\": %u,\n"
+        "  \"offscreen_leases\": %u,\n"
+        "  \"offscreen_allocations\": %u,\n"
+        "  \"offscreen_peak_kb\": %" G_GSIZE_FORMAT ",\n"
+        "  \"orientation_signals\": %u,\n"
+        "  \"orientation_changes\": %u,\n"
+        "  \"portrait_updates\": %u,\n"
+        "  \"portrait_evaluations\": %u,\n"
+        "  \"portrait_queries\": %u,\n"
+        "  \"portrait_stack_walks\": %u,\n"
+        "  \"launcher_rebuilds\": %u,\n"
+        "  \"launcher_tiles_created\": %u,\n"
+        "  \"launcher_tiles_changed\": %u,\n"
+        "  \"launcher_tiles_destroyed\": %u,\n"
+        "  \"launcher_tiles_prefetched\": %u,\n"
+        "  \"partial_damage_px\": %" G_GUINT64_FORMAT "\n"
+        "}\n",
+        timeval_ms (&now.ru_utime, &Stats_rusage.ru_utime),
+        timeval_ms (&now.ru_stime, &Stats_rusage.ru_stime),
+        (g_get_monotonic_time () - Stats_start) / 1000.0,
+        Restacks, X_events, Full_frames, Motion_coalesced,
+        Wm_syncs, Wm_syncs ? (gdouble)Wm_sync_events / Wm_syncs : 0,
+        Wm_sync_events_max,
+        atoms->str, hd_atom_dispatch_get_dropped (),
+        offscreen.leases, offscreen.allocations,
+        offscreen.peak_bytes / 1024,
+        orientation.signals, orientation.changes,
+        orientation.updates, orientation.evaluations,
+        portrait.queries, portrait.walks,
+        launcher.rebuilds, launcher.tiles_created,
+        launcher.tiles_changed, launcher.tiles_destroyed,
+        launcher.tiles_prefetched, Damaged_px);
+
+  tmp = g_strconcat (Stats_file, ".tmp", NULL);
+  if (!g_file_set_contents (tmp, json->str, json->len, &error))
+    {
+      g_warning ("%s: %s", tmp, error->message);
+      g_error_free (error);
+    }
+  else if (rename (tmp, Stats_file) < 0)
+    g_warning ("%s: %m", Stats_file);
+
+  g_free (tmp);
+  g_string_free (atoms, TRUE);
+  g_string_free (json, TRUE);
+}
+
+void
+hd_recorder_init (Display *dpy, ClutterActor *stage)
+{
+  const gchar *fname;
+
+  Dpy = dpy;
+  Atom_names = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, g_free);
+
+  if ((fname = g_getenv ("HD_RECORD")) != NULL)
+    {
+      int opcode, error_base;
+
+      if (!(Record = fopen (fname, "w")))
+        g_warning ("%s: %m", fname);
+      else
+        {
+          Record_start = g_get_monotonic_time ();
+          record ("root 0x%lx", DefaultRootWindow (dpy));
+          if (!XQueryExtension (dpy, "DAMAGE", &opcode, &Damage_event_base,
+                                &error_base))
+            Damage_event_base = -1;
+        }
+    }
+
+  if ((fname = g_getenv ("HD_BENCH_STATS")) != NULL)
+    {
+      Stats_file = g_strdup (fname);
+      Bench_atom = XInternAtom (dpy, "_HILDON_BENCH", False);
+      Frame_us = g_array_new (FALSE, FALSE, sizeof (guint32));
+      Interval_us = g_array_new (FALSE, FALSE, sizeof (guint32));
+      Input_latency_us = g_array_new (FALSE, FALSE, sizeof (guint32));
+      g_signal_connect (stage, "paint",
+                        G_CALLBACK (stats_frame_begin), NULL);
+      g_signal_connect_after (stage, "paint",
+                              G_CALLBACK (stats_frame_end), NULL);
+      stats_reset ();
+    }
+}
+
+void
+hd_recorder_finish (void)
+{
+  if (Record)
+    {
+      fclose (Record);
+      Record = NULL;
+    }
+
+  if (Stats_file)
+    {
+      stats_dump ();
+      g_free (Stats_file);
+      Stats_file = NULL;
+    }
+
+  if (Atom_names)
+    {
+      g_hash_table_destroy (Atom_names);
+      Atom_names = NULL;
+    }
+}
+
+void
+hd_recorder_x_event (const XEvent *xev)
+{
+  if (Stats_file)
+    {
+      if (xev->type == ClientMessage
+          && xev->xclient.message_type == Bench_atom)
+        {
+          switch (xev->xclient.data.l[0])
+            {
+              case 0:
+                stats_reset ();
+                break;
+              case 1:
+                stats_dump ();
+                break;
+              case 2:
+                /* There's no other way for a client to enter it. */
+                if (!STATE_IS_TASK_NAV (hd_render_manager_get_state ()))
+                  hd_render_manager_set_state (
+                         STATE_IS_PORTRAIT (hd_render_manager_get_state ())
+                         ? HDRM_STATE_TASK_NAV_PORTRAIT
+                         : HDRM_STATE_TASK_NAV);
+                break;
+              case 3:
+                hd_launcher_scroll_by (xev->xclient.data.l[1]);
+                break;
+            }
+          return;
+        }
+      X_events++;
+    }
+
+  if (Record)
+    record_x_event (xev);
+}
+
+void
+hd_recorder_state_changed (const gchar *state)
+{
+  if (!Record || !g_strcmp0 (state, Last_state))
+    return;
+
+  g_free (Last_state);
+  Last_state = g_strdup (state);
+  record ("state %s", state);
+}
+
+void
+hd_recorder_restacked (void)
+{
+  if (Stats_file)
+    Restacks++;
+}
+
+void
+hd_recorder_input_handled (gint64 received, guint n_events)
+{
+  if (!Stats_file || !n_events)
+    return;
+
+  if (!Input_pending || received < Input_pending)
+    Input_pending = received;
+  Motion_coalesced += n_events - 1;
+}
+
+void
+hd_recorder_wm_synced (guint n_events)
+{
+  if (!Stats_file)
+    return;
+
+  Wm_syncs++;
+  Wm_sync_events += n_events;
+  Wm_sync_events_max = MAX (Wm_sync_events_max, n_events);
+}
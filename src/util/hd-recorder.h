@@ -0,0 +1,63 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Session recorder and benchmark statistics for tests/hd-replay.
+ *
+ * With $HD_RECORD set to a file name the X-level session (window creation,
+ * map/unmap, configure requests, property changes, client messages,
+ * damage) and the render manager's state changes are logged there.
+ *
+ * With $HD_BENCH_STATS set to a file name frame times, CPU time, damage and
+ * restack counts are collected.  A _HILDON_BENCH client message sent to
+ * the root window resets them (l[0] == 0) or writes them to the file as
+ * JSON (l[0] == 1).  With l[0] == 2 it enters the task navigator and
+ * with l[0] == 3 it opens the launcher and scrolls it by l[1] pixels,
+ * so benchmarks can exercise them.  Without either variable all of
+ * this is a no-op.
+ *
+ * Input latency is measured from when an event was received (not the
+ * X server timestamp, which isn't comparable with our clock) to the end
+ * of the first frame painted after it was handled.
+ */
+
+#ifndef __HD_RECORDER_H__
+#define __HD_RECORDER_H__
+
+#include <X11/Xlib.h>
+#include <glib.h>
+#include <clutter/clutter.h>
+
+void hd_recorder_init (Display *dpy, ClutterActor *stage);
+void hd_recorder_finish (void);
+
+void hd_recorder_x_event (const XEvent *xev);
+void hd_recorder_state_changed (const gchar *state);
+void hd_recorder_restacked (void);
+
+/* Call when @n_events input events, the oldest of them received at
+ * @received (g_get_monotonic_time()), were handled as one. */
+void hd_recorder_input_handled (gint64 received, guint n_events);
+
+/* Call when the window manager is synced after @n_events X events. */
+void hd_recorder_wm_synced (guint n_events);
+
+#endif
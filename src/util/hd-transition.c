@@ -48,15 +48,29 @@
 #include "hd-volume-profile.h"
 #include "hd-util.h"
 #include "hd-dbus.h"
+#include "hd-client-sync.h"
 
 /* The master of puppets */
 #define TRANSITIONS_INI             "/usr/share/hildon-desktop/transitions.ini"
 #define TRANSITIONS_INI_FROM_THEME  "/etc/hildon/theme/transitions.ini"
 
-typedef struct _HDEffectData
+typedef struct _HDEffectData HDEffectData;
+
+/* Called by the frame clock with the progress of the effect (0..1). */
+typedef void (*HDEffectFrameFunc)(HDEffectData *data, float now);
+
+struct _HDEffectData
 {
   MBWMCompMgrClientEvent   event;
-  ClutterTimeline          *timeline;
+  /* Set by hd_transition_start(): called in every tick of the frame
+   * clock, which started the effect at @start (in microseconds) and
+   * completes it @duration milliseconds later.  Then @finished_callback
+   * is called with @finished_callback_data, if it's set. */
+  HDEffectFrameFunc         frame;
+  gint64                    start;
+  guint                     duration;
+  GSourceFunc               finished_callback;
+  gpointer                  finished_callback_data;
   MBWMCompMgrClutterClient *cclient;
   ClutterActor             *cclient_actor;
   /* In subview transitions, this is the ORIGINAL (non-subview) view */
@@ -74,7 +88,7 @@ typedef struct _HDEffectData
   /* In Fade effects, final_alpha specifies the alpha value when the
    * window/note if fully faded in. */
   float                     final_alpha;
-} HDEffectData;
+};
 
 /* %HPTimer %GSource state. */
 typedef struct
@@ -125,7 +139,9 @@ static struct
    *    in portrait.  Wait for a while for the initial application
    *    updates until thawing the display.
    * -- #WAIT_FOR_DAMAGES:
-   *    Damage done, start fading in.
+   *    The clients which support _NET_WM_SYNC_REQUEST have told us
+   *    they've redrawn, and the others' damage has settled (or we
+   *    got tired of waiting).  Start fading in.
    * -- #FADE_IN:
    *    Mission complete.
    * -- #RECOVER:
@@ -175,6 +191,16 @@ static struct
    * necessary we stop waiting for damages immedeately.
    */
   guint patience_requests;
+
+  /*
+   * In WAIT_FOR_DAMAGES, the number of visible clients we asked to
+   * tell us when they've redrawn (@n_synced) and of those we couldn't
+   * ask (@n_unsynced), whose damage we have to watch instead.
+   * @damage_settled is set if the latter stopped while we were still
+   * waiting for the former.
+   */
+  guint n_synced, n_unsynced;
+  gboolean damage_settled;
 } Orientation_change;
 
 /* The number of transitions in progress requesting for @fixup_visibilities.
@@ -182,6 +208,44 @@ static struct
  * and subview transitions are involved. */
 static guint Transitions_running;
 
+/*
+ * The frame clock driving all transitions in a single pass per tick.
+ * It ticks at most at Clutter's frame rate and not more often than the
+ * stage can be painted, measured by @paint_us: a tick is scheduled
+ * one period after the end of the last paint, so the effects are
+ * advanced right before the next one.  The progress of the effects
+ * is computed from the time of the tick, so under load they skip
+ * frames rather than take longer.
+ *
+ * @effects:      the running %HDEffectData:s
+ * @tick_id:      the %GSource of the next tick
+ * @paint_started, @painted:
+ *                when the last paint of the stage started and ended
+ * @paint_us:     the average time a paint takes
+ */
+static struct
+{
+  GList *effects;
+  guint tick_id;
+  gulong paint_cb_id, painted_cb_id;
+  gint64 paint_started, painted;
+  gint64 paint_us;
+} Clock;
+
+/* The easing curves sampled at %CURVE_SAMPLES+1 points on first use;
+ * they are evaluated by interpolating between the samples. */
+#define CURVE_SAMPLES 256
+enum
+{
+  CURVE_OVERSHOOT,
+  CURVE_SMOOTH_RAMP,
+  CURVE_EASE_IN,
+  CURVE_EASE_OUT,
+  CURVES
+};
+static float Curves[CURVES][CURVE_SAMPLES+1];
+static gboolean Curves_sampled;
+
 /* If %TRUE keep reloading transitions.ini until we can
  * and we can watch it. */
 static gboolean transitions_ini_is_dirty;
@@ -285,19 +349,53 @@ hptimer_new(unsigned expiry,
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+static void
+sample_curves (void)
+{
+  float amt, smooth_ramp, converge;
+  guint i;
+
+  for (i = 0; i <= CURVE_SAMPLES; i++)
+    {
+      amt = (float)i / CURVE_SAMPLES;
+
+      smooth_ramp = 1.0f - cos(amt*3.141592); // 0 <= smooth_ramp <= 2
+      converge = sin(0.5*3.141592*(1-amt)); // 0 <= converve <= 1
+      Curves[CURVE_OVERSHOOT][i] = (smooth_ramp*0.675)*converge
+                                   + (1-converge);
+      Curves[CURVE_SMOOTH_RAMP][i] = (1.0f - cos(amt*3.141592)) * 0.5f;
+      Curves[CURVE_EASE_IN][i] = 1.0f - cos(amt*3.141592*0.5);
+      Curves[CURVE_EASE_OUT][i] = cos((1-amt)*3.141592*0.5);
+    }
+  Curves_sampled = TRUE;
+}
+
+/* Returns @curve at 0 <= @amt <= 1. */
+static float
+curve (guint curve, float amt)
+{
+  float v;
+  guint i;
+
+  if (G_UNLIKELY (!Curves_sampled))
+    sample_curves ();
+
+  v = amt * CURVE_SAMPLES;
+  i = (guint)v;
+  if (i >= CURVE_SAMPLES)
+    return Curves[curve][CURVE_SAMPLES];
+  v -= i;
+  return Curves[curve][i]*(1-v) + Curves[curve][i+1]*v;
+}
+
 /* amt goes from 0->1, and the result goes mostly from 0->1 with a bit of
  * overshoot at the end */
 float
 hd_transition_overshoot(float x)
 {
-  float smooth_ramp, converge;
-  float amt;
   int offset;
   offset = (int)x;
-  amt = x-offset;
-  smooth_ramp = 1.0f - cos(amt*3.141592); // 0 <= smooth_ramp <= 2
-  converge = sin(0.5*3.141592*(1-amt)); // 0 <= converve <= 1
-  return offset + (smooth_ramp*0.675)*converge + (1-converge);
+  return offset + curve (CURVE_OVERSHOOT, x-offset);
 }
 
 /* amt goes from 0->1, and the result goes from 0->1 smoothly */
@@ -305,7 +403,7 @@ float
 hd_transition_smooth_ramp(float amt)
 {
   if (amt>0 && amt<1)
-    return (1.0f - cos(amt*3.141592)) * 0.5f;
+    return curve (CURVE_SMOOTH_RAMP, amt);
   return amt;
 }
 
@@ -313,7 +411,7 @@ float
 hd_transition_ease_in(float amt)
 {
   if (amt>0 && amt<1)
-    return (1.0f - cos(amt*3.141592*0.5));
+    return curve (CURVE_EASE_IN, amt);
   return amt;
 }
 
@@ -321,7 +419,7 @@ float
 hd_transition_ease_out(float amt)
 {
   if (amt>0 && amt<1)
-    return cos((1-amt)*3.141592*0.5);
+    return curve (CURVE_EASE_OUT, amt);
   return amt;
 }
 
@@ -329,15 +427,122 @@ hd_transition_ease_out(float amt)
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
-static ClutterTimeline *
-hd_transition_timeline_new(const gchar *transition,
+static guint
+hd_transition_get_duration(const gchar *transition,
                            MBWMCompMgrClientEvent event,
                            gint default_length)
 {
   const char *key =
     event==MBWMCompMgrClientEventMap ?"duration_in":"duration_out";
-  return clutter_timeline_new_for_duration (
-      hd_transition_get_int(transition, key, default_length) );
+  return MAX (hd_transition_get_int(transition, key, default_length), 0);
+}
+
+static void hd_transition_completed (HDEffectData *data);
+static void clock_schedule (void);
+
+static void
+clock_paint (ClutterActor *stage, gpointer unused)
+{
+  Clock.paint_started = g_get_monotonic_time ();
+}
+
+static void
+clock_painted (ClutterActor *stage, gpointer unused)
+{
+  Clock.painted = g_get_monotonic_time ();
+  if (Clock.paint_started)
+    Clock.paint_us = (3*Clock.paint_us
+                      + (Clock.painted - Clock.paint_started)) / 4;
+}
+
+/* Advances all running effects and completes those which are over. */
+static gboolean
+clock_tick (gpointer unused)
+{
+  GList *effects, *li;
+  HDEffectData *data;
+  gint64 now;
+  float progress;
+
+  Clock.tick_id = 0;
+  now = g_get_monotonic_time ();
+
+  /* The effects may start or stop others, so go through a copy
+   * and skip those which have been stopped meanwhile. */
+  effects = g_list_copy (Clock.effects);
+  for (li = effects; li; li = li->next)
+    {
+      data = li->data;
+      if (!g_list_find (Clock.effects, data))
+        continue;
+
+      progress = data->duration
+        ? (now - data->start) / (1000.0f * data->duration) : 1;
+      if (progress < 1)
+        {
+          data->frame (data, progress);
+          continue;
+        }
+
+      data->frame (data, 1);
+      hd_transition_completed (data);
+    }
+  g_list_free (effects);
+
+  clock_schedule ();
+  return FALSE;
+}
+
+/* Schedules the next tick if there are effects to advance, and stops
+ * watching the paints if there aren't. */
+static void
+clock_schedule (void)
+{
+  ClutterActor *stage = clutter_stage_get_default ();
+  gint64 period, since;
+
+  if (!Clock.effects)
+    {
+      if (Clock.tick_id)
+        Clock.tick_id = (g_source_remove (Clock.tick_id), 0);
+      if (Clock.paint_cb_id)
+        {
+          g_signal_handler_disconnect (stage, Clock.paint_cb_id);
+          g_signal_handler_disconnect (stage, Clock.painted_cb_id);
+          Clock.paint_cb_id = Clock.painted_cb_id = 0;
+          Clock.paint_started = 0;
+        }
+      return;
+    }
+
+  if (!Clock.paint_cb_id)
+    {
+      Clock.paint_cb_id = g_signal_connect (stage, "paint",
+                                            G_CALLBACK (clock_paint), NULL);
+      Clock.painted_cb_id = g_signal_connect_after (stage, "paint",
+                                            G_CALLBACK (clock_painted), NULL);
+    }
+  if (Clock.tick_id)
+    return;
+
+  period = MAX (1000000 / MAX (clutter_get_default_frame_rate (), 1),
+                Clock.paint_us);
+  since = g_get_monotonic_time () - Clock.painted;
+  Clock.tick_id = g_timeout_add (since < period ? (period - since) / 1000
+                                                 : 0,
+                                 clock_tick, NULL);
+}
+
+/* Lets the frame clock drive @data with @frame for @duration ms. */
+static void
+hd_transition_start (HDEffectData *data, HDEffectFrameFunc frame,
+                     guint duration)
+{
+  data->frame = frame;
+  data->duration = duration;
+  data->start = g_get_monotonic_time ();
+  Clock.effects = g_list_append (Clock.effects, data);
+  clock_schedule ();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -374,8 +579,7 @@ on_decor_progress_timeline_new_frame(ClutterTimeline *timeline,
 }
 
 static void
-on_popup_timeline_new_frame(ClutterTimeline *timeline,
-                            gint frame_num, HDEffectData *data)
+on_popup_frame(HDEffectData *data, float now)
 {
   float amt;
   ClutterActor *actor, *filler;
@@ -399,7 +603,7 @@ on_popup_timeline_new_frame(ClutterTimeline *timeline,
   pop_bottom = geo.y+geo.height==hd_comp_mgr_get_current_screen_height();
   if (pop_top && pop_bottom)
     pop_top = FALSE;
-  amt =  (float)clutter_timeline_get_progress(timeline);
+  amt = now;
   /* reverse if we're removing this */
   if (data->event == MBWMCompMgrClientEventUnmap)
     amt = 1-amt;
@@ -457,8 +661,7 @@ on_popup_timeline_new_frame(ClutterTimeline *timeline,
 }
 
 static void
-on_fade_timeline_new_frame(ClutterTimeline *timeline,
-                            gint frame_num, HDEffectData *data)
+on_fade_frame(HDEffectData *data, float now)
 {
   float amt, ramt;
   gint alpha;
@@ -478,7 +681,7 @@ on_fade_timeline_new_frame(ClutterTimeline *timeline,
       return;
     }
 
-  amt =  (float)clutter_timeline_get_progress(timeline);
+  amt = now;
   /* reverse if we're removing this */
   if (data->event == MBWMCompMgrClientEventUnmap)
     amt = 1-amt;
@@ -495,8 +698,7 @@ on_fade_timeline_new_frame(ClutterTimeline *timeline,
 }
 
 static void
-on_close_timeline_new_frame(ClutterTimeline *timeline,
-                            gint frame_num, HDEffectData *data)
+on_close_frame(HDEffectData *data, float now)
 {
   float amt;
   ClutterActor *actor;
@@ -518,7 +720,7 @@ on_close_timeline_new_frame(ClutterTimeline *timeline,
       return;
     }
 
-  amt = (float)clutter_timeline_get_progress(timeline);
+  amt = now;
 
   amtx = 1.6 - amt*2.5; // shrink in x
   amty = 1 - amt*2.5; // shrink in y
@@ -580,10 +782,8 @@ bezier(float t, float p0, float p1, float p2, float p3)
 }
 
 static void
-on_notification_timeline_new_frame(ClutterTimeline *timeline,
-                                   gint frame_num, HDEffectData *data)
+on_notification_frame(HDEffectData *data, float now)
 {
-  float now;
   ClutterActor *actor;
   guint width, height;
   gint tbw, px, py;
@@ -596,7 +796,6 @@ on_notification_timeline_new_frame(ClutterTimeline *timeline,
                         HD_TITLE_BAR(hd_render_manager_get_title_bar()));
   clutter_actor_get_size(actor, &width, &height);
   clutter_actor_get_position(actor, &px, &py);
-  now = frame_num / (float)clutter_timeline_get_n_frames(timeline);
 
   if (hd_comp_mgr_is_portrait()
       && hd_transition_get_int("notification", "is_cool", 0))
@@ -710,11 +909,9 @@ on_notification_timeline_new_frame(ClutterTimeline *timeline,
 }
 
 static void
-on_subview_timeline_new_frame(ClutterTimeline *timeline,
-                              gint frame_num, HDEffectData *data)
+on_subview_frame(HDEffectData *data, float now)
 {
   float amt;
-  gint n_frames;
   ClutterActor *subview_actor = 0, *main_actor = 0;
 
   if (data->cclient)
@@ -722,9 +919,7 @@ on_subview_timeline_new_frame(ClutterTimeline *timeline,
   if (data->cclient2)
     main_actor = data->cclient2_actor;
 
-  n_frames = clutter_timeline_get_n_frames(timeline);
-  amt = frame_num / (float)n_frames;
-  amt = hd_transition_smooth_ramp( amt );
+  amt = hd_transition_smooth_ramp( now );
   if (data->event == MBWMCompMgrClientEventUnmap)
     amt = 1-amt;
 
@@ -752,7 +947,7 @@ on_subview_timeline_new_frame(ClutterTimeline *timeline,
   }
 
   /* if we're at the last frame, return our actors to the correct places) */
-  if (frame_num == n_frames)
+  if (now >= 1)
     {
       if (subview_actor)
         {
@@ -771,16 +966,13 @@ on_subview_timeline_new_frame(ClutterTimeline *timeline,
 }
 
 static void
-on_rotate_screen_timeline_new_frame(ClutterTimeline *timeline,
-                                    gint frame_num, HDEffectData *data)
+on_rotate_screen_frame(HDEffectData *data, float now)
 {
   float amt, dim_amt, angle;
-  gint n_frames;
   gint use_zaxis = hd_transition_get_int ("thp_tweaks", "zaxisrotation", 0);
   ClutterActor *actor;
 
-  n_frames = clutter_timeline_get_n_frames(timeline);
-  amt = frame_num / (float)n_frames;
+  amt = now;
   // we want to ease in, but speed up as we go - X^3 does this nicely
   amt = amt*amt;
   if (data->event == MBWMCompMgrClientEventUnmap)
@@ -796,7 +988,7 @@ on_rotate_screen_timeline_new_frame(ClutterTimeline *timeline,
   actor = CLUTTER_ACTOR(hd_render_manager_get());
   clutter_actor_set_rotation(actor, use_zaxis ? CLUTTER_Z_AXIS :
       (hd_comp_mgr_is_portrait () ? CLUTTER_Y_AXIS : CLUTTER_X_AXIS),
-      frame_num < n_frames ? angle : 0,
+      now < 1 ? angle : 0,
       hd_comp_mgr_get_current_screen_width()/2,
       hd_comp_mgr_get_current_screen_height()/2, 0);
 
@@ -838,10 +1030,14 @@ on_screen_size_changed (ClutterActor *stage, GParamSpec *unused,
 }
 
 static void
-hd_transition_completed (ClutterTimeline* timeline, HDEffectData *data)
+hd_transition_completed (HDEffectData *data)
 {
   gint i;
   HdCompMgr *hmgr = HD_COMP_MGR (data->hmgr);
+  GSourceFunc finished_callback = data->finished_callback;
+  gpointer finished_callback_data = data->finished_callback_data;
+
+  Clock.effects = g_list_remove (Clock.effects, data);
 
   if (data->cclient)
     {
@@ -877,9 +1073,6 @@ hd_transition_completed (ClutterTimeline* timeline, HDEffectData *data)
 
 /*   dump_clutter_tree (CLUTTER_CONTAINER (clutter_stage_get_default()), 0); */
 
-  if (timeline)
-    g_object_unref ( timeline );
-
   if (hmgr)
     hd_comp_mgr_set_effect_running(hmgr, FALSE);
 
@@ -912,6 +1105,8 @@ hd_transition_completed (ClutterTimeline* timeline, HDEffectData *data)
 
   if (hmgr)
     hd_comp_mgr_reconsider_compositing (MB_WM_COMP_MGR (hmgr));
+  if (finished_callback)
+    finished_callback (finished_callback_data);
 }
 
 void
@@ -940,11 +1135,6 @@ hd_transition_popup(HdCompMgr                  *mgr,
   data->cclient = mb_wm_object_ref (MB_WM_OBJECT (cclient));
   data->cclient_actor = g_object_ref (actor);
   data->hmgr = HD_COMP_MGR (mgr);
-  data->timeline = hd_transition_timeline_new("popup", event, 250);
-  g_signal_connect (data->timeline, "new-frame",
-                        G_CALLBACK (on_popup_timeline_new_frame), data);
-  g_signal_connect (data->timeline, "completed",
-                        G_CALLBACK (hd_transition_completed), data);
   data->geo = geo;
   Transitions_running += data->fixup_visibilities = TRUE;
 
@@ -976,8 +1166,9 @@ hd_transition_popup(HdCompMgr                  *mgr,
                               &col);
 
   /* first call to stop flicker */
-  on_popup_timeline_new_frame(data->timeline, 0, data);
-  clutter_timeline_start (data->timeline);
+  on_popup_frame(data, 0);
+  hd_transition_start (data, on_popup_frame,
+                       hd_transition_get_duration("popup", event, 250));
 }
 
 /* For banners, information notes and confirmation notes. */
@@ -997,7 +1188,6 @@ hd_transition_fade(HdCompMgr                  *mgr,
   data->cclient_actor = g_object_ref (
       mb_wm_comp_mgr_clutter_client_get_actor( data->cclient ) );
   data->hmgr = HD_COMP_MGR (mgr);
-  data->timeline = hd_transition_timeline_new("fade", event, 250);
   Transitions_running += data->fixup_visibilities = TRUE;
 
   if (HD_IS_BANNER_NOTE(c))
@@ -1016,19 +1206,15 @@ hd_transition_fade(HdCompMgr                  *mgr,
     /* Leave @data->geo 0, we needn't move the actor around. */
     data->final_alpha = 1;
 
-  g_signal_connect (data->timeline, "new-frame",
-                        G_CALLBACK (on_fade_timeline_new_frame), data);
-  g_signal_connect (data->timeline, "completed",
-                        G_CALLBACK (hd_transition_completed), data);
-
   mb_wm_comp_mgr_clutter_client_set_flags (cclient,
                               MBWMCompMgrClutterClientDontUpdate |
                               MBWMCompMgrClutterClientEffectRunning);
   hd_comp_mgr_set_effect_running(mgr, TRUE);
 
   /* first call to stop flicker */
-  on_fade_timeline_new_frame(data->timeline, 0, data);
-  clutter_timeline_start (data->timeline);
+  on_fade_frame(data, 0);
+  hd_transition_start (data, on_fade_frame,
+                       hd_transition_get_duration("fade", event, 250));
 }
 void
 hd_transition_fade_out_loading_screen(ClutterActor *loading_image)
@@ -1046,14 +1232,12 @@ hd_transition_fade_out_loading_screen(ClutterActor *loading_image)
     data->event = MBWMCompMgrClientEventUnmap;
     data->cclient_actor = g_object_ref ( loading_image );
     data->hmgr = 0;
-    data->timeline = clutter_timeline_new_for_duration ( duration );
     data->final_alpha = 1;
     /* the delay before we start to fade out. We implement this by setting
      * the final_alpha value to something *past* opaque */
     fade_delay = hd_transition_get_int("launcher_launch", "delay", 150);
     if (fade_delay>0)
       {
-        gint duration = clutter_timeline_get_duration(data->timeline);
         if (fade_delay < duration) {
           data->final_alpha = 1 + fade_delay/(float)(duration-fade_delay);
           // safety in case strange values get put in
@@ -1062,16 +1246,12 @@ hd_transition_fade_out_loading_screen(ClutterActor *loading_image)
         }
       }
 
-    g_signal_connect (data->timeline, "new-frame",
-                          G_CALLBACK (on_fade_timeline_new_frame), data);
-    g_signal_connect (data->timeline, "completed",
-                          G_CALLBACK (hd_transition_completed), data);
     clutter_container_add_actor (
                  hd_render_manager_get_front_group(),
                  loading_image);
     /* first call to stop flicker */
-    on_fade_timeline_new_frame(data->timeline, 0, data);
-    clutter_timeline_start (data->timeline);
+    on_fade_frame(data, 0);
+    hd_transition_start (data, on_fade_frame, duration);
 }
 
 void
@@ -1128,14 +1308,8 @@ hd_transition_close_app (HdCompMgr                  *mgr,
   data->cclient = mb_wm_object_ref (MB_WM_OBJECT (cclient));
   data->cclient_actor = g_object_ref (actor);
   data->hmgr = HD_COMP_MGR (mgr);
-  data->timeline = clutter_timeline_new_for_duration (
-                    hd_transition_get_int("app_close", "duration", 500));
-  g_signal_connect (data->timeline, "new-frame",
-                    G_CALLBACK (on_close_timeline_new_frame), data);
   g_signal_connect (clutter_stage_get_default (), "notify::allocation",
                     G_CALLBACK (on_screen_size_changed), data);
-  g_signal_connect (data->timeline, "completed",
-                    G_CALLBACK (hd_transition_completed), data);
   data->geo = geo;
 
   mb_wm_comp_mgr_clutter_client_set_flags (cclient,
@@ -1163,7 +1337,8 @@ hd_transition_close_app (HdCompMgr                  *mgr,
     }
 
   hd_comp_mgr_set_effect_running(mgr, TRUE);
-  clutter_timeline_start (data->timeline);
+  hd_transition_start (data, on_close_frame,
+               MAX (hd_transition_get_int("app_close", "duration", 500), 0));
 
   hd_transition_play_sound (HDCM_WINDOW_CLOSED_SOUND);
 }
@@ -1188,25 +1363,19 @@ hd_transition_notification(HdCompMgr                  *mgr,
   data->cclient_actor = g_object_ref (
       mb_wm_comp_mgr_clutter_client_get_actor( data->cclient ) );
   data->hmgr = HD_COMP_MGR (mgr);
-  data->timeline = hd_transition_timeline_new("notification", event, 500);
-
-  g_signal_connect (data->timeline, "new-frame",
-                        G_CALLBACK (on_notification_timeline_new_frame), data);
-  g_signal_connect (data->timeline, "completed",
-                        G_CALLBACK (hd_transition_completed), data);
-
   mb_wm_comp_mgr_clutter_client_set_flags (cclient,
                               MBWMCompMgrClutterClientDontUpdate |
                               MBWMCompMgrClutterClientEffectRunning);
   hd_comp_mgr_set_effect_running(mgr, TRUE);
 
   /* first call to stop flicker */
-  on_notification_timeline_new_frame(data->timeline, 0, data);
+  on_notification_frame(data, 0);
   /* Show the actor and add it to the front group */
   clutter_actor_show(data->cclient_actor);
   hd_render_manager_add_to_front_group(data->cclient_actor);
-  /* Finally start the timeline... */
-  clutter_timeline_start (data->timeline);
+  /* Finally start the effect... */
+  hd_transition_start (data, on_notification_frame,
+                       hd_transition_get_duration("notification", event, 500));
 }
 
 void
@@ -1325,13 +1494,6 @@ hd_transition_subview(HdCompMgr                  *mgr,
       mb_wm_comp_mgr_clutter_client_get_actor( data->cclient2 ) );
   data->hmgr = HD_COMP_MGR (mgr);
   Transitions_running += data->fixup_visibilities = TRUE;
-  data->timeline = hd_transition_timeline_new("subview", event, 250);
-
-  g_signal_connect (data->timeline, "new-frame",
-                        G_CALLBACK (on_subview_timeline_new_frame), data);
-  g_signal_connect (data->timeline, "completed",
-                        G_CALLBACK (hd_transition_completed), data);
-
   mb_wm_comp_mgr_clutter_client_set_flags (cclient_subview,
                               MBWMCompMgrClutterClientDontUpdate |
                               MBWMCompMgrClutterClientEffectRunning);
@@ -1344,8 +1506,9 @@ hd_transition_subview(HdCompMgr                  *mgr,
   HD_COMP_MGR_CLIENT (cclient_subview)->effect  = data;
 
   /* first call to stop flicker */
-  on_subview_timeline_new_frame(data->timeline, 0, data);
-  clutter_timeline_start (data->timeline);
+  on_subview_frame(data, 0);
+  hd_transition_start (data, on_subview_frame,
+                       hd_transition_get_duration("subview", event, 250));
 }
 
 /* Stop any currently active transition on the given client (assuming the
@@ -1362,13 +1525,10 @@ hd_transition_stop(HdCompMgr                  *mgr,
 
   if ((data = HD_COMP_MGR_CLIENT (cclient)->effect))
     {
-      gint n_frames = clutter_timeline_get_n_frames(data->timeline);
-      clutter_timeline_stop(data->timeline);
       /* Make sure we update to the final state for this transition */
-      g_signal_emit_by_name (data->timeline, "new-frame",
-                             n_frames, NULL);
+      data->frame (data, 1);
       /* Call end-of-transition handler */
-      hd_transition_completed(data->timeline, data);
+      hd_transition_completed(data);
     }
 }
 
@@ -1378,7 +1538,7 @@ hd_transition_stop(HdCompMgr                  *mgr,
 static void
 hd_transition_fade_and_rotate(gboolean first_part,
                               gboolean goto_portrait,
-                              GCallback finished_callback,
+                              GSourceFunc finished_callback,
                               gpointer finished_callback_data)
 {
   ClutterColor black = {0x00, 0x00, 0x00, 0xFF};
@@ -1386,15 +1546,8 @@ hd_transition_fade_and_rotate(gboolean first_part,
   HDEffectData *data = g_new0 (HDEffectData, 1);
   data->event = first_part ? MBWMCompMgrClientEventMap :
                              MBWMCompMgrClientEventUnmap;
-  data->timeline = hd_transition_timeline_new("rotate", data->event, 300);
-
-  g_signal_connect (data->timeline, "new-frame",
-                        G_CALLBACK (on_rotate_screen_timeline_new_frame), data);
-  g_signal_connect (data->timeline, "completed",
-                         G_CALLBACK (hd_transition_completed), data);
-  if (finished_callback)
-    g_signal_connect_swapped (data->timeline, "completed",
-                          G_CALLBACK (finished_callback), finished_callback_data);
+  data->finished_callback = finished_callback;
+  data->finished_callback_data = finished_callback_data;
 
   data->angle = hd_transition_get_double("rotate", "angle", 40);
   /* Set the direction of movement - we want to rotate backwards if we
@@ -1435,8 +1588,9 @@ hd_transition_fade_and_rotate(gboolean first_part,
     }
 
   /* stop flicker by calling the first frame directly */
-  on_rotate_screen_timeline_new_frame(data->timeline, 0, data);
-  clutter_timeline_start (data->timeline);
+  on_rotate_screen_frame(data, 0);
+  hd_transition_start (data, on_rotate_screen_frame,
+                       hd_transition_get_duration("rotate", data->event, 300));
 }
 
 /* Process %_MAEMO_ROTATION_PATIENCE requests. */
@@ -1474,6 +1628,55 @@ patience (XClientMessageEvent *event, void *unused)
     }
 }
 
+static gboolean hd_transition_rotating_fsm(void);
+
+/* The %HPTimer of WAIT_FOR_DAMAGES expired.  If some clients haven't
+ * told us yet that they've redrawn, keep waiting for them until
+ * damage_timeout_max. */
+static gboolean
+rotation_timeout (gpointer unused)
+{
+  gint max;
+
+  if (Orientation_change.phase == WAIT_FOR_DAMAGES
+      && hd_client_sync_pending ())
+    {
+      max  = hd_transition_get_int("rotate", "damage_timeout_max", 1000);
+      max -= g_timer_elapsed(Orientation_change.timer, NULL) * 1000.0;
+      if (max > 0)
+        {
+          Orientation_change.timeout_id->remaining = max;
+          Orientation_change.damage_settled = TRUE;
+          return TRUE;
+        }
+    }
+
+  return hd_transition_rotating_fsm ();
+}
+
+/* All clients we asked in WAIT_FOR_DAMAGES have redrawn.
+ * Unless someone asked for patience, fade in as soon as the
+ * others' damage has settled too. */
+static void
+rotation_synced (gpointer unused)
+{
+  gint plus;
+
+  if (Orientation_change.phase != WAIT_FOR_DAMAGES
+      || !Orientation_change.timeout_id
+      || Orientation_change.patience_requests)
+    return;
+
+  if (!Orientation_change.n_unsynced || Orientation_change.damage_settled)
+    Orientation_change.timeout_id->remaining = 0;
+  else
+    {
+      plus = hd_transition_get_int("rotate", "damage_timeout_plus", 50);
+      if (Orientation_change.timeout_id->remaining > plus)
+        Orientation_change.timeout_id->remaining = plus;
+    }
+}
+
 static gboolean
 hd_transition_rotating_fsm(void)
 {
@@ -1526,6 +1729,10 @@ hd_transition_rotating_fsm(void)
         hd_util_set_screen_size_property(Orientation_change.wm,
                          Orientation_change.direction == GOTO_PORTRAIT);
         Orientation_change.wm->flags |= MBWindowManagerFlagLayoutRotated;
+        /* Warm up the other layout while we're fading out, unless the
+         * accelerometer or the slide has already asked for it. */
+        hd_render_manager_prepare_orientation(
+                         Orientation_change.direction == GOTO_PORTRAIT);
         /* We now call ourselves back on idle. The idea is that the sudden
          * influx of X events from resizing kills our animation as we don't
          * get to idle for a while. So only start the transition once we
@@ -1539,7 +1746,7 @@ hd_transition_rotating_fsm(void)
             Orientation_change.phase = FADE_OUT;
             hd_transition_fade_and_rotate(
                             TRUE, Orientation_change.direction == GOTO_PORTRAIT,
-                            G_CALLBACK(hd_transition_rotating_fsm), NULL);
+                            (GSourceFunc)hd_transition_rotating_fsm, NULL);
             break;
           }
         else
@@ -1620,6 +1827,7 @@ trans_start_error:
                               Orientation_change.root_config_signal_id);
                 Orientation_change.root_config_signal_id = 0;
               }
+            hd_client_sync_cancel();
             Orientation_change.direction = Orientation_change.new_direction;
             Orientation_change.phase = FADE_OUT;
             hd_transition_rotating_fsm();
@@ -1635,13 +1843,25 @@ trans_start_error:
              * counterpart. */
             hd_util_root_window_configured(Orientation_change.wm);
 
+            /*
+             * Ask the clients to tell us when they've redrawn in the
+             * new orientation.  If all of them can, the damage timeout
+             * is only a fallback for those who don't answer.
+             */
+            Orientation_change.damage_settled = FALSE;
+            Orientation_change.n_synced = hd_client_sync_request(
+                                  Orientation_change.wm, rotation_synced,
+                                  NULL, &Orientation_change.n_unsynced);
+
             g_assert(!Orientation_change.timeout_id);
             Orientation_change.timeout_id = hptimer_new(
                   Orientation_change.patience_requests
+                      || (Orientation_change.n_synced
+                          && !Orientation_change.n_unsynced)
                     ? hd_transition_get_int("rotate", "damage_timeout_max",
                                             1000)
                     : hd_transition_get_int("rotate", "damage_timeout", 50),
-                  (GSourceFunc)hd_transition_rotating_fsm,
+                  rotation_timeout,
                   &Orientation_change.timeout_id,
                   (GDestroyNotify)g_nullify_pointer);
             g_timer_start(Orientation_change.timer);
@@ -1649,6 +1869,7 @@ trans_start_error:
           }
         else /* WAIT_FOR_DAMAGES || FADE_OUT error path || TRANS_START error */
           {
+            hd_client_sync_cancel();
             /* We must update the layout again so the window sizes
              * return to normal relative to the screen. flags is probably
              * already correct. But just for safety. */
@@ -1665,7 +1886,7 @@ trans_start_error:
                 clutter_actor_show(CLUTTER_ACTOR(hd_render_manager_get()));
                 hd_transition_fade_and_rotate(
                         FALSE, Orientation_change.direction == GOTO_PORTRAIT,
-                        G_CALLBACK(hd_transition_rotating_fsm), NULL);
+                        (GSourceFunc)hd_transition_rotating_fsm, NULL);
                 /* Fix NB#117109 by re-evaluating what is blurred and what isn't */
                 hd_render_manager_restack();
               }
@@ -1826,6 +2047,11 @@ hd_transition_rotate_ignore_damage()
     {
       gint max;
 
+      /* If everybody tells us when they're done, damage says nothing. */
+      if (Orientation_change.n_synced && !Orientation_change.n_unsynced)
+        return TRUE;
+      Orientation_change.damage_settled = FALSE;
+
       /*
        * Only postpone the timeout if we haven't postponed
        * it too long already. This stops us getting stuck
@@ -1998,6 +2224,8 @@ hd_transition_get_keyfile(void)
   if (transitions_ini)
     g_key_file_free(transitions_ini);
   transitions_ini = ini;
+  /* The portrait white/blacklists may have changed. */
+  hd_comp_mgr_portrait_invalidate ();
 
   if (!transitions_ini_watcher || transitions_ini_is_dirty > TRUE)
     {
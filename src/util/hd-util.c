@@ -14,6 +14,8 @@
 #include "hd-transition.h"
 #include "hd-render-manager.h"
 #include "hd-xinput.h"
+#include "hd-randr.h"
+#include "hd-damage.h"
 
 #include <gdk/gdk.h>
 
@@ -231,67 +233,6 @@ hd_util_client_has_modal_blocker (MBWindowManagerClient *c)
       mb_wm_get_modality_type (c->wmref) == MBWMModalitySystem;
 }
 
-static RRCrtc
-get_primary_crtc (MBWindowManager *wm, XRRScreenResources *res)
-{
-  int i;
-  XRROutputInfo *output;
-  RRCrtc ret = ~0UL;
-  Atom rr_connector_type, rr_connector_panel;
-  unsigned char *contype;
-  Atom actual_type;
-  int actual_format;
-  unsigned long nitems, bytes_after;
-
-  if (res->ncrtc == 1)
-    return res->crtcs[0];
-
-  rr_connector_type = hd_comp_mgr_wm_get_atom(
-                        wm, HD_ATOM_RANDR_CONNECTOR_TYPE);
-  rr_connector_panel = hd_comp_mgr_wm_get_atom(
-                         wm, HD_ATOM_RANDR_CONNECTOR_TYPE_PANEL);
-
-  for (i = 0; i < res->noutput; i++)
-    {
-      output = XRRGetOutputInfo (wm->xdpy, res, res->outputs[i]);
-      if (!output)
-          continue;
-
-      if (XRRGetOutputProperty (wm->xdpy, res->outputs[i], rr_connector_type,
-                                0, 1, False, False, AnyPropertyType, &actual_type,
-                                &actual_format, &nitems, &bytes_after,
-                                &contype) == Success)
-        {
-          if (actual_type == XA_ATOM && actual_format == 32 && nitems == 1 &&
-              *(Atom *)contype == rr_connector_panel)
-            {
-              ret = output->crtc;
-              XRRFreeOutputInfo (output);
-              break;
-            }
-        }
-      XRRFreeOutputInfo (output);
-    }
-
-  if (ret == ~0UL)
-    {
-      RROutput primary = XRRGetOutputPrimary (wm->xdpy, wm->root_win->xwindow);
-
-      if (primary == None)
-        return ret;
-
-      output = XRRGetOutputInfo (wm->xdpy, res, primary);
-
-      if (output)
-        {
-          ret = output->crtc;
-          XRRFreeOutputInfo (output);
-        }
-    }
-
-  return ret;
-}
-
 /* Set a property on the root window to tell others whether we are doing
  * rotation or not, so they can do certain things like increasing our
  * process priority. */
@@ -319,69 +260,35 @@ void hd_util_set_screen_size_property(MBWindowManager *wm,
                     (unsigned char *)value, 2);
 }
 
-static gboolean
-randr_supported(MBWindowManager *wm)
-{
-  static int randr_supported = -1;
-  int rr_major, rr_minor;
-
-  if (randr_supported == -1)
-    {
-      Status ok = XRRQueryVersion (wm->xdpy, &rr_major, &rr_minor);
-
-      if (ok == 1 && (rr_major > 1 || (rr_major == 1 && rr_minor >= 3)))
-          randr_supported = 1;
-      else
-          randr_supported = 0;
-    }
-
-  return randr_supported != 0;
-}
-
 static gboolean
 hd_util_change_screen_orientation_real (MBWindowManager *wm,
                                         gboolean goto_portrait,
                                         gboolean do_change)
 {
-  static RRCrtc crtc = ~0UL; /* cache to avoid potentially lots of roundtrips */
-  XRRScreenResources *res;
-  XRRCrtcInfo *crtc_info;
+  const HdRandrCrtc *panel;
+  HdRandrCrtc crtc;
   Rotation want;
   Status status = RRSetConfigSuccess;
   int width, height, width_mm, height_mm;
   unsigned long one = 1;
   gboolean rv = FALSE;
 
-  if (!randr_supported(wm))
+  if (!hd_randr_init (wm->xdpy))
     {
       g_debug ("Server does not support RandR 1.3\n");
       return FALSE;
     }
 
-  res = XRRGetScreenResources (wm->xdpy, wm->root_win->xwindow);
-
-  if (!res)
-    {
-      g_warning ("Couldn't get RandR screen resources\n");
-      return FALSE;
-    }
-
-  if (crtc == ~0UL)
-      crtc = get_primary_crtc (wm, res);
-
-  if (crtc == ~0UL)
+  if (!(panel = hd_randr_get_panel_crtc ()))
     {
       g_warning ("Couldn't find CRTC to rotate\n");
-      goto err_res;
+      return FALSE;
     }
 
-  crtc_info = XRRGetCrtcInfo (wm->xdpy, res, crtc);
-
-  if (!crtc_info)
-    {
-      g_warning ("Couldn't find CRTC info\n");
-      goto err_res;
-    }
+  /* Our changes below update the cache, remember where we started. */
+  crtc = *panel;
+  crtc.outputs = g_memdup (panel->outputs,
+                           panel->noutput * sizeof (RROutput));
 
   if (display_is_portrait == -1)
     display_is_portrait = FALSE;
@@ -402,10 +309,10 @@ hd_util_change_screen_orientation_real (MBWindowManager *wm,
                           DisplayHeightMM (wm->xdpy, DefaultScreen (wm->xdpy)));
         }
 
-      if ((crtc_info->rotation == RR_Rotate_0 &&
-           crtc_info->width < crtc_info->height) ||
-          (crtc_info->rotation == RR_Rotate_270 &&
-           crtc_info->width > crtc_info->height))
+      if ((crtc.rotation == RR_Rotate_0 &&
+           crtc.width < crtc.height) ||
+          (crtc.rotation == RR_Rotate_270 &&
+           crtc.width > crtc.height))
         {
           want = RR_Rotate_0;
           display_is_portrait = TRUE;
@@ -427,10 +334,10 @@ hd_util_change_screen_orientation_real (MBWindowManager *wm,
                           DisplayHeightMM (wm->xdpy, DefaultScreen (wm->xdpy)));
         }
 
-      if ((crtc_info->rotation == RR_Rotate_0 &&
-           crtc_info->width < crtc_info->height) ||
-          (crtc_info->rotation == RR_Rotate_270 &&
-           crtc_info->width > crtc_info->height))
+      if ((crtc.rotation == RR_Rotate_0 &&
+           crtc.width < crtc.height) ||
+          (crtc.rotation == RR_Rotate_270 &&
+           crtc.width > crtc.height))
         {
           want = RR_Rotate_270;
           display_is_portrait = TRUE;
@@ -439,20 +346,20 @@ hd_util_change_screen_orientation_real (MBWindowManager *wm,
 
   if (initially_rotated == -1)
     {
-      initially_rotated = crtc_info->rotation != RR_Rotate_0 &&
-                          crtc_info->rotation != RR_Rotate_180;
+      initially_rotated = crtc.rotation != RR_Rotate_0 &&
+                          crtc.rotation != RR_Rotate_180;
     }
 
   if (do_change)
     {
-      if (!(crtc_info->rotations & want))
+      if (!(crtc.rotations & want))
         {
           g_warning ("CRTC does not support rotation (0x%.8X vs. 0x%.8X)",
-                     crtc_info->rotations, want);
+                     crtc.rotations, want);
           goto err_crtc_info;
         }
 
-      if (crtc_info->rotation == want)
+      if (crtc.rotation == want)
         {
           g_debug ("Requested rotation already active");
           goto err_crtc_info;
@@ -475,15 +382,12 @@ hd_util_change_screen_orientation_real (MBWindowManager *wm,
                       (unsigned char *)&one, 1);
 
       /* Disable the CRTC first, as it doesn't fit within our existing screen. */
-      XRRSetCrtcConfig (wm->xdpy, res, crtc, crtc_info->timestamp, 0, 0, None,
-                        RR_Rotate_0, NULL, 0);
+      hd_randr_set_crtc_config (crtc.id, 0, 0, None, RR_Rotate_0, NULL, 0);
       /* Then change the screen size to accommodate our glorious new CRTC. */
-      XRRSetScreenSize (wm->xdpy, wm->root_win->xwindow, width, height,
-                        width_mm, height_mm);
+      hd_randr_set_screen_size (width, height, width_mm, height_mm);
       /* And now rotate. */
-      status = XRRSetCrtcConfig (wm->xdpy, res, crtc, crtc_info->timestamp,
-                                 crtc_info->x, crtc_info->y, crtc_info->mode, want,
-                                 crtc_info->outputs, crtc_info->noutput);
+      status = hd_randr_set_crtc_config (crtc.id, crtc.x, crtc.y, crtc.mode,
+                                         want, crtc.outputs, crtc.noutput);
 
       /* hd_util_root_window_configured will be called directly after this root
        * window has been reconfigured */
@@ -497,10 +401,7 @@ hd_util_change_screen_orientation_real (MBWindowManager *wm,
   rv = TRUE;
 
 err_crtc_info:
-  XRRFreeCrtcInfo (crtc_info);
-
-err_res:
-  XRRFreeScreenResources (res);
+  g_free (crtc.outputs);
 
   if (rv == TRUE && do_change)
     {
@@ -669,6 +570,116 @@ hd_util_click (const MBWindowManagerClient *c)
   XSendEvent(xdpy, xwin, False, ButtonPressMask, (XEvent *)&button_event);
 }
 
+/* An actor's transformation to stage coordinates, ignoring rotation:
+ * stage = local * scale + translate.  Cached on the actor and valid as
+ * long as neither it nor any of its ancestors has @changed since it was
+ * @computed.  Every actor we have walked through has one of these, if
+ * only for @changed, which is stamped from Transform_clock whenever the
+ * actor moves, scales, rotates, is reparented or shown/hidden. */
+typedef struct
+{
+  guint changed, computed;
+  gboolean valid;     /* nothing on the way is rotated */
+  gboolean visible;   /* the actor and all its ancestors are */
+  gdouble scalex, scaley;
+  gdouble transx, transy;
+} HdActorTransform;
+
+static GQuark Transform_quark;
+static guint Transform_clock;
+
+static void
+hd_util_actor_transform_changed(ClutterActor *actor)
+{
+  HdActorTransform *t;
+
+  t = g_object_get_qdata(G_OBJECT(actor), Transform_quark);
+  t->changed = ++Transform_clock;
+}
+
+/* Returns @actor's cache, making sure we know when it changes. */
+static HdActorTransform *
+hd_util_actor_transform_data(ClutterActor *actor)
+{
+  static const gchar *signals[] = {
+    "notify::x", "notify::y", "notify::scale-x", "notify::scale-y",
+    "notify::anchor-x", "notify::anchor-y", "notify::rotation-angle-x",
+    "notify::rotation-angle-y", "notify::rotation-angle-z",
+    "parent-set", "show", "hide",
+  };
+  HdActorTransform *t;
+  guint i;
+
+  if (!Transform_quark)
+    Transform_quark = g_quark_from_static_string("hd-transform");
+  if ((t = g_object_get_qdata(G_OBJECT(actor), Transform_quark)) != NULL)
+    return t;
+
+  t = g_new0(HdActorTransform, 1);
+  g_object_set_qdata_full(G_OBJECT(actor), Transform_quark, t, g_free);
+  for (i = 0; i < G_N_ELEMENTS(signals); i++)
+    g_signal_connect(actor, signals[i],
+                     G_CALLBACK(hd_util_actor_transform_changed), NULL);
+  return t;
+}
+
+static const HdActorTransform *
+hd_util_get_actor_transform(ClutterActor *actor)
+{
+  HdActorTransform *t;
+  ClutterActor *it, *stage;
+
+  t = hd_util_actor_transform_data(actor);
+  stage = clutter_actor_get_stage(actor);
+  if (t->computed)
+    { /* Only what's moved and what's under it needs recomputing,
+       * so a pan doesn't invalidate everything else. */
+      const HdActorTransform *ti;
+
+      for (it = actor; it && it != stage; it = clutter_actor_get_parent(it))
+        if (!(ti = g_object_get_qdata(G_OBJECT(it), Transform_quark))
+            || ti->changed > t->computed)
+          break;
+      if (!it || it == stage)
+        return t;
+    }
+
+  t->valid = t->visible = TRUE;
+  t->scalex = t->scaley = 1;
+  t->transx = t->transy = 0;
+
+  for (it = actor; it && it != stage; it = clutter_actor_get_parent(it))
+    {
+      ClutterFixed px,py;
+      gdouble scalex, scaley;
+      ClutterUnit anchorx, anchory;
+
+      hd_util_actor_transform_data(it);
+      if (!CLUTTER_ACTOR_IS_VISIBLE(it))
+        t->visible = FALSE;
+
+      /* Big safety check here - don't attempt to work out bounds if anything
+       * is rotated, as we'll probably get it wrong. */
+      clutter_actor_get_scale(it, &scalex, &scaley);
+      clutter_actor_get_anchor_pointu(it, &anchorx, &anchory);
+      if (clutter_actor_get_rotationu(it, CLUTTER_X_AXIS, 0, 0, 0)!=0 ||
+          clutter_actor_get_rotationu(it, CLUTTER_Y_AXIS, 0, 0, 0)!=0 ||
+          clutter_actor_get_rotationu(it, CLUTTER_Z_AXIS, 0, 0, 0)!=0)
+        t->valid = FALSE;
+
+      clutter_actor_get_positionu(it, &px, &py);
+      t->transx = ((t->transx - CLUTTER_FIXED_TO_DOUBLE(anchorx))*scalex)
+          + CLUTTER_FIXED_TO_DOUBLE(px);
+      t->transy = ((t->transy - CLUTTER_FIXED_TO_DOUBLE(anchory))*scaley)
+          + CLUTTER_FIXED_TO_DOUBLE(py);
+      t->scalex *= scalex;
+      t->scaley *= scaley;
+    }
+
+  t->computed = ++Transform_clock;
+  return t;
+}
+
 /* Try and get the translated bounds for an actor (the actual pixel position
  * of it on the screen). If geo is 0 or width/height are 0, this func will
  * use the full bounds of the actor. Otherwise we translate the bounds given
@@ -679,10 +690,7 @@ hd_util_get_actor_bounds(ClutterActor *actor, ClutterGeometry *geo, gboolean *is
 {
   gdouble x, y;
   gdouble width, height;
-  ClutterActor *it = actor;
-  ClutterActor *stage = clutter_actor_get_stage(actor);
-  gboolean visible = TRUE;
-  gboolean valid = TRUE;
+  const HdActorTransform *t;
 
   if (geo && geo->width && geo->height)
     {
@@ -701,31 +709,11 @@ hd_util_get_actor_bounds(ClutterActor *actor, ClutterGeometry *geo, gboolean *is
       height = h;
     }
 
-  while (it && it != stage)
-    {
-      ClutterFixed px,py;
-      gdouble scalex, scaley;
-      ClutterUnit anchorx, anchory;
-
-      /* Big safety check here - don't attempt to work out bounds if anything
-       * is rotated, as we'll probably get it wrong. */
-      clutter_actor_get_scale(it, &scalex, &scaley);
-      clutter_actor_get_anchor_pointu(it, &anchorx, &anchory);
-      if (clutter_actor_get_rotationu(it, CLUTTER_X_AXIS, 0, 0, 0)!=0 ||
-          clutter_actor_get_rotationu(it, CLUTTER_Y_AXIS, 0, 0, 0)!=0 ||
-          clutter_actor_get_rotationu(it, CLUTTER_Z_AXIS, 0, 0, 0)!=0)
-        valid = FALSE;
-
-      clutter_actor_get_positionu(it, &px, &py);
-      x = ((x - CLUTTER_FIXED_TO_DOUBLE(anchorx))*scalex)
-          + CLUTTER_FIXED_TO_DOUBLE(px);
-      y = ((y - CLUTTER_FIXED_TO_DOUBLE(anchory))*scaley)
-          + CLUTTER_FIXED_TO_DOUBLE(py);
-      width *= scalex;
-      height *= scaley;
-
-      it = clutter_actor_get_parent(it);
-    }
+  t = hd_util_get_actor_transform(actor);
+  x = x * t->scalex + t->transx;
+  y = y * t->scaley + t->transy;
+  width *= t->scalex;
+  height *= t->scaley;
 
   if (geo)
     {
@@ -737,9 +725,9 @@ hd_util_get_actor_bounds(ClutterActor *actor, ClutterGeometry *geo, gboolean *is
     }
   if (is_visible)
     {
-      *is_visible = visible;
+      *is_visible = t->visible;
     }
-  return valid;
+  return t->valid;
 }
 
 /* Call this after an actor is updated, and it will ask the stage to redraw
@@ -754,7 +742,6 @@ void
 hd_util_partial_redraw_if_possible(ClutterActor *actor, ClutterGeometry *bounds)
 {
   ClutterGeometry area = {0,0,0,0};
-  ClutterActor *stage = clutter_stage_get_default();
   gboolean visible, valid;
 
   if (bounds)
@@ -762,16 +749,12 @@ hd_util_partial_redraw_if_possible(ClutterActor *actor, ClutterGeometry *bounds)
 
   valid = hd_util_get_actor_bounds(actor, &area, &visible);
   if (!visible) return;
+  /* The redraw itself is queued once per frame, with all the damage
+   * collected until then. */
   if (valid)
-    {
-      /* Queue a redraw, but without updating the whole area */
-      clutter_stage_set_damaged_area(stage, area);
-      clutter_actor_queue_redraw_damage(stage);
-    }
+    hd_damage_add(&area);
   else
-    {
-      clutter_actor_queue_redraw(stage);
-    }
+    hd_damage_add_full();
 }
 
 /* Check to see whether clients above this one totally obscure it */
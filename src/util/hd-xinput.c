@@ -9,13 +9,25 @@
 #include <clutter/x11/clutter-x11.h>
 #include <matchbox/core/mb-wm.h>
 #include "home/hd-render-manager.h"
+#include "hd-recorder.h"
+#include "hd-client-sync.h"
+#include "hd-randr.h"
 
 #define RR_Reflect_All	(RR_Reflect_X|RR_Reflect_Y)
 
+/* How long we may go on handling queued X events before the window
+ * manager must be synced anyway (ms). */
+#define HD_X_EVENT_BATCH_BUDGET	8
+
 static GArray *xi_devices = NULL;
 static int xi_motion_ev_type = -1;
 static int xi_presence_ev_type = -1;
 
+/* X events handled since the window manager was last synced. */
+static guint batch_events;
+static gint64 batch_start;
+static guint batch_sync_id;
+
 typedef struct {
 	gboolean is_ts;
 	XDevice *dev;
@@ -111,8 +123,6 @@ void hd_enumerate_input_devices(Display *dpy)
 
 static int apply_matrix(Display *dpy, int deviceid, Matrix *m)
 {
-	Atom prop_float, prop_matrix;
-
 	union {
 		unsigned char *c;
 		float *f;
@@ -123,8 +133,12 @@ static int apply_matrix(Display *dpy, int deviceid, Matrix *m)
 	unsigned long bytes_after;
 	int rc;
 
-	prop_float = XInternAtom(dpy, "FLOAT", False);
-	prop_matrix = XInternAtom(dpy, "Coordinate Transformation Matrix", False);
+	static Atom prop_float, prop_matrix;
+
+	if (!prop_float) {
+		prop_float = XInternAtom(dpy, "FLOAT", False);
+		prop_matrix = XInternAtom(dpy, "Coordinate Transformation Matrix", False);
+	}
 
 	if (!prop_float) {
 		fprintf(stderr, "Float atom not found. This server is too old.\n");
@@ -186,17 +200,11 @@ static void matrix_s4(Matrix *m, float x02, float x12, float d1, float d2, int m
 static void set_transformation_matrix(Matrix *m, int offset_x, int offset_y,
 				      int screen_width, int screen_height, int rotation)
 {
-	Display *dpy = XOpenDisplay(NULL);
-
-	if (dpy == NULL)
-		dpy = XOpenDisplay(":0.0");
-
-	if (dpy == NULL)
-		return;
+	guint width, height;
 
-	/* total display size */
-	int width = DisplayWidth(dpy, DefaultScreen(dpy));
-	int height = DisplayHeight(dpy, DefaultScreen(dpy));
+	/* total display size, as of our last change if the server
+	 * hasn't told us yet */
+	hd_randr_get_screen_size(&width, &height);
 
 	g_debug("width %i height %i\n", width, height);
 
@@ -253,8 +261,6 @@ static void set_transformation_matrix(Matrix *m, int offset_x, int offset_y,
 		matrix_s4(m, x + w, y + h, -w, -h, 1);
 		break;
 	}
-
-	XCloseDisplay(dpy);
 }
 
 static bool matrix_is_sane(const Matrix * const m)
@@ -269,59 +275,25 @@ static bool matrix_is_sane(const Matrix * const m)
 	return true;
 }
 
-static XRROutputInfo *find_output_xrandr(Display *dpy)
-{
-	XRRScreenResources *res;
-	XRROutputInfo *output_info = NULL;
-	int i;
-	int found = 0;
-
-	res = XRRGetScreenResources(dpy, DefaultRootWindow(dpy));
-
-	for (i = 0; i < res->noutput && !found; i++) {
-		output_info = XRRGetOutputInfo(dpy, res, res->outputs[i]);
-
-		if (output_info->crtc && output_info->connection == RR_Connected) {
-			found = 1;
-			break;
-		}
-
-		XRRFreeOutputInfo(output_info);
-	}
-
-	XRRFreeScreenResources(res);
-
-	if (!found)
-		output_info = NULL;
-
-	return output_info;
-}
-
 static int map_output_xrandr(Display *dpy, int deviceid)
 {
 	int rc = EXIT_FAILURE;
-	XRRScreenResources *res;
-	XRROutputInfo *output_info;
+	const HdRandrCrtc *crtc;
 
-	res = XRRGetScreenResources(dpy, DefaultRootWindow(dpy));
-	output_info = find_output_xrandr(dpy);
+	if (!hd_randr_init(dpy))
+		return rc;
 
 	/* crtc holds our screen info, need to compare to actual screen size */
-	if (output_info) {
-		XRRCrtcInfo *crtc_info;
+	crtc = hd_randr_get_connected_crtc();
+	if (crtc) {
 		Matrix m;
 		matrix_set_unity(&m);
-		crtc_info = XRRGetCrtcInfo(dpy, res, output_info->crtc);
-		set_transformation_matrix(&m, crtc_info->x, crtc_info->y,
-					  crtc_info->width, crtc_info->height, crtc_info->rotation);
+		set_transformation_matrix(&m, crtc->x, crtc->y,
+					  crtc->width, crtc->height, crtc->rotation);
 		if(matrix_is_sane(&m))
 			rc = apply_matrix(dpy, deviceid, &m);
-		XRRFreeCrtcInfo(crtc_info);
-		XRRFreeOutputInfo(output_info);
 	}
 
-	XRRFreeScreenResources(res);
-
 	return rc;
 }
 
@@ -338,10 +310,38 @@ int hd_rotate_input_devices(Display *dpy)
 	return ret;
 }
 
+static void sync_batch(MBWindowManager *wm)
+{
+	if (batch_sync_id) {
+		g_source_remove(batch_sync_id);
+		batch_sync_id = 0;
+	}
+
+	if (wm->sync_type) {
+		hd_recorder_wm_synced(batch_events);
+		mb_wm_sync(wm);
+	}
+
+	/* Nothing left to sync ends the batch just the same. */
+	batch_events = 0;
+	batch_start = 0;
+}
+
+static gboolean sync_batch_idle(gpointer data)
+{
+	batch_sync_id = 0;
+	sync_batch(data);
+	return FALSE;
+}
+
 ClutterX11FilterReturn hd_clutter_x11_event_filter(XEvent *xev, ClutterEvent *cev, gpointer data)
 {
 	MBWindowManager *wm = data;
 
+	hd_recorder_x_event(xev);
+	hd_client_sync_x_event(xev);
+	hd_randr_x_event(xev);
+
 	if (xev->type == ButtonPress) {
 		hd_render_manager_press_effect();
 	} else if (xev->type == xi_motion_ev_type) {
@@ -360,8 +360,25 @@ ClutterX11FilterReturn hd_clutter_x11_event_filter(XEvent *xev, ClutterEvent *ce
 
 	mb_wm_main_context_handle_x_event(xev, wm->main_ctx);
 
-	if (wm->sync_type)
-		mb_wm_sync(wm);
+	/*
+	 * Like matchbox's own main loop, handle everything already queued
+	 * before syncing, so a burst of events (eg. an application starting
+	 * up or everyone reconfiguring after a rotation) is stacked, laid out
+	 * and restacked once instead of once per event.  The idle is there
+	 * in case the rest of the batch doesn't come through here, and runs
+	 * before the stage is repainted.
+	 */
+	if (!batch_events++)
+		batch_start = g_get_monotonic_time();
+	if (wm->sync_type
+	    && XEventsQueued(xev->xany.display, QueuedAlready) > 0
+	    && g_get_monotonic_time() - batch_start
+	         < HD_X_EVENT_BATCH_BUDGET * 1000) {
+		if (!batch_sync_id)
+			batch_sync_id = g_idle_add_full(CLUTTER_PRIORITY_REDRAW - 2,
+							sync_batch_idle, wm, NULL);
+	} else
+		sync_batch(wm);
 
 	return CLUTTER_X11_FILTER_CONTINUE;
 }
@@ -0,0 +1,208 @@
+/* See bench-common.h. */
+
+#include "bench-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define BENCH_MAX_FRAMES  65536
+#define BENCH_MAX_METRICS 16
+
+int Bench;
+double Bench_duration = 10;
+int Bench_count = -1;
+double Bench_fps = -1;
+
+static FILE *Bench_out;
+static double Bench_start;
+static double *Bench_frames;
+static int Bench_nframes;
+
+static struct
+{
+  const char *name;
+  double value;
+} Bench_metrics[BENCH_MAX_METRICS];
+static int Bench_nmetrics;
+
+double bench_now (void)
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* Takes our options out of @argv, leaving the rest to the client. */
+void bench_args (int *argc, char **argv)
+{
+  int i, j;
+
+  for (i = j = 1; i < *argc; i++)
+    if (!strcmp (argv[i], "--bench"))
+      Bench = 1;
+    else if (!strncmp (argv[i], "--duration=", 11))
+      Bench_duration = atof (argv[i] + 11);
+    else if (!strncmp (argv[i], "--count=", 8))
+      Bench_count = atoi (argv[i] + 8);
+    else if (!strncmp (argv[i], "--fps=", 6))
+      Bench_fps = atof (argv[i] + 6);
+    else
+      argv[j++] = argv[i];
+  argv[j] = NULL;
+  *argc = j;
+
+  if (Bench)
+    {
+      int null = open ("/dev/null", O_WRONLY);
+
+      fflush (stdout);
+      Bench_out = fdopen (dup (STDOUT_FILENO), "w");
+      dup2 (null, STDOUT_FILENO);
+      close (null);
+    }
+}
+
+/* Sends hildon-desktop a _HILDON_BENCH message to reset (0) or dump (1)
+ * its statistics, to enter the task navigator (2) or to scroll the
+ * launcher by @arg pixels (3). */
+void bench_control (Display *dpy, long what, long arg)
+{
+  XClientMessageEvent xclient;
+
+  memset (&xclient, 0, sizeof (xclient));
+  xclient.type = ClientMessage;
+  xclient.window = DefaultRootWindow (dpy);
+  xclient.message_type = XInternAtom (dpy, "_HILDON_BENCH", False);
+  xclient.format = 32;
+  xclient.data.l[0] = what;
+  xclient.data.l[1] = arg;
+
+  XSendEvent (dpy, DefaultRootWindow (dpy), False,
+              SubstructureRedirectMask | SubstructureNotifyMask,
+              (XEvent *)&xclient);
+  XSync (dpy, False);
+}
+
+void bench_start (Display *dpy)
+{
+  if (!Bench)
+    return;
+  if (getenv ("HD_BENCH_STATS"))
+    bench_control (dpy, 0, 0);
+  Bench_frames = malloc (sizeof (*Bench_frames) * BENCH_MAX_FRAMES);
+  Bench_start = bench_now ();
+}
+
+/* Whether the scenario has run for --duration. */
+int bench_done (void)
+{
+  return Bench && bench_now () - Bench_start >= Bench_duration;
+}
+
+/* Call whenever the client has drawn something. */
+void bench_frame (void)
+{
+  if (Bench && Bench_nframes < BENCH_MAX_FRAMES)
+    Bench_frames[Bench_nframes++] = bench_now ();
+}
+
+/* Adds a scenario-specific number to the report. */
+void bench_metric (const char *name, double value)
+{
+  if (Bench_nmetrics < BENCH_MAX_METRICS)
+    {
+      Bench_metrics[Bench_nmetrics].name = name;
+      Bench_metrics[Bench_nmetrics].value = value;
+      Bench_nmetrics++;
+    }
+}
+
+static int bench_cmp_double (const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+  return da < db ? -1 : da > db;
+}
+
+/* Prints the compositor's statistics, or null if there are none. */
+static void bench_print_compositor (Display *dpy)
+{
+  const char *fname;
+  struct stat st;
+  char buf[4096];
+  double until;
+  size_t n;
+  FILE *f;
+
+  if (!(fname = getenv ("HD_BENCH_STATS")))
+    {
+      fprintf (Bench_out, "null");
+      return;
+    }
+
+  unlink (fname);
+  bench_control (dpy, 1, 0);
+  for (until = bench_now () + 10; stat (fname, &st) < 0; usleep (50000))
+    if (bench_now () > until)
+      {
+        fprintf (stderr, "%s: not written\n", fname);
+        fprintf (Bench_out, "null");
+        return;
+      }
+
+  if (!(f = fopen (fname, "r")))
+    {
+      fprintf (Bench_out, "null");
+      return;
+    }
+  while ((n = fread (buf, 1, sizeof (buf), f)) > 0)
+    fwrite (buf, 1, n, Bench_out);
+  fclose (f);
+}
+
+/* Prints the report of scenario @name. */
+void bench_finish (Display *dpy, const char *name)
+{
+  double elapsed, *intervals;
+  int i, n;
+
+  if (!Bench)
+    return;
+  elapsed = bench_now () - Bench_start;
+
+  n = Bench_nframes > 1 ? Bench_nframes - 1 : 0;
+  intervals = malloc (sizeof (*intervals) * (n + 1));
+  for (i = 0; i < n; i++)
+    intervals[i] = (Bench_frames[i+1] - Bench_frames[i]) * 1000;
+  qsort (intervals, n, sizeof (*intervals), bench_cmp_double);
+
+#define PCT(p) (n ? intervals[(n * (p) / 100) < n ? n * (p) / 100 : n - 1] : 0)
+  fprintf (Bench_out, "{\n"
+          "  \"scenario\": \"%s\",\n"
+          "  \"params\": { \"duration\": %.1f, \"count\": %d, \"fps\": %.1f },\n"
+          "  \"client\": {\n"
+          "    \"elapsed_ms\": %.1f,\n"
+          "    \"frames\": %d,\n"
+          "    \"fps\": %.2f,\n"
+          "    \"frame_interval_ms\": { \"p50\": %.3f, \"p90\": %.3f, "
+          "\"p99\": %.3f, \"max\": %.3f }",
+          name, Bench_duration, Bench_count, Bench_fps,
+          elapsed * 1000, Bench_nframes,
+          elapsed > 0 ? Bench_nframes / elapsed : 0,
+          PCT (50), PCT (90), PCT (99), n ? intervals[n - 1] : 0);
+#undef PCT
+  for (i = 0; i < Bench_nmetrics; i++)
+    fprintf (Bench_out, ",\n    \"%s\": %.3f", Bench_metrics[i].name,
+            Bench_metrics[i].value);
+  fprintf (Bench_out, "\n  },\n  \"compositor\": ");
+  bench_print_compositor (dpy);
+  fprintf (Bench_out, "\n}\n");
+  fflush (Bench_out);
+
+  free (intervals);
+}
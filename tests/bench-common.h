@@ -0,0 +1,36 @@
+/* Shared by the test clients which double as benchmark scenarios
+ * (see hd-bench.sh).  It only needs Xlib and libc.
+ *
+ * A client runs as a scenario when given --bench, and then takes
+ *
+ *   --duration=<seconds>  how long to run (default 10)
+ *   --count=<n>           how many windows/notes/applets to use
+ *   --fps=<f>             how often to update
+ *
+ * whose defaults are up to the client.  At the end it prints a JSON
+ * report with its own timings and, if $HD_BENCH_STATS names the file
+ * the hildon-desktop under test writes its statistics to, those too.
+ * Anything else the client prints to stdout meanwhile is discarded. */
+
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+#include <X11/Xlib.h>
+
+/* Whether we're running as a scenario, and the parameters it was
+ * given.  @Bench_count and @Bench_fps are negative if not given. */
+extern int Bench;
+extern double Bench_duration;
+extern int Bench_count;
+extern double Bench_fps;
+
+double bench_now (void);
+void bench_args (int *argc, char **argv);
+void bench_control (Display *dpy, long what, long arg);
+void bench_start (Display *dpy);
+int bench_done (void);
+void bench_frame (void);
+void bench_metric (const char *name, double value);
+void bench_finish (Display *dpy, const char *name);
+
+#endif /* __BENCH_COMMON_H__ */
@@ -0,0 +1,35 @@
+# Sourced by the benchmark scripts: starts a headless X server with
+# software GL and a hildon-desktop collecting statistics on it, and
+# kills them on exit.  Afterwards $DISPLAY and $HD_BENCH_STATS are set
+# for the clients.
+#
+# $HILDON_DESKTOP and $XVFB override the binaries used, $HD_BENCH_DISPLAY
+# the display number (default :99).
+
+hd="${HILDON_DESKTOP:-$here/../src/hildon-desktop}"
+xvfb="${XVFB:-Xvfb}"
+DISPLAY="${HD_BENCH_DISPLAY:-:99}"
+HD_BENCH_STATS=`mktemp /tmp/hd-bench.XXXXXX`
+export DISPLAY HD_BENCH_STATS
+
+bench_cleanup()
+{
+  [ -n "$hd_pid" ] && kill $hd_pid 2>/dev/null
+  [ -n "$xvfb_pid" ] && kill $xvfb_pid 2>/dev/null
+  rm -f "$HD_BENCH_STATS" "$HD_BENCH_STATS.tmp"
+}
+trap bench_cleanup EXIT INT TERM
+
+$xvfb $DISPLAY -screen 0 800x480x24 +extension GLX +extension DAMAGE \
+  -nolisten tcp >/dev/null 2>&1 &
+xvfb_pid=$!
+sleep 1
+
+LIBGL_ALWAYS_SOFTWARE=1 "$hd" >/dev/null 2>&1 &
+hd_pid=$!
+# Let it settle; the clients reset the statistics anyway.
+sleep 5
+if ! kill -0 $hd_pid 2>/dev/null; then
+  echo "$hd didn't start" >&2
+  exit 1
+fi
@@ -0,0 +1,50 @@
+# Prints "<dotted.path> <value>" for every number in a JSON document.
+# Only as much JSON as the benchmark reports use: objects, strings,
+# numbers and null.
+
+{ doc = doc $0 " " }
+
+END {
+  depth = 0;
+  prefix[0] = "";
+  while (doc != "")
+    {
+      if (match (doc, /^[ \t\r\n,:]+/))
+        {
+          doc = substr (doc, RLENGTH + 1);
+          continue;
+        }
+
+      c = substr (doc, 1, 1);
+      if (c == "{")
+        {
+          prefix[depth + 1] = depth ? prefix[depth] key "." : "";
+          depth++;
+          doc = substr (doc, 2);
+        }
+      else if (c == "}")
+        {
+          depth--;
+          doc = substr (doc, 2);
+        }
+      else if (match (doc, /^"[^"]*"/))
+        {
+          str = substr (doc, 2, RLENGTH - 2);
+          doc = substr (doc, RLENGTH + 1);
+          if (match (doc, /^[ \t\r\n]*:/))
+            key = str;
+        }
+      else if (match (doc, /^-?[0-9][0-9.eE+-]*/))
+        {
+          print prefix[depth] key, substr (doc, 1, RLENGTH);
+          doc = substr (doc, RLENGTH + 1);
+        }
+      else if (match (doc, /^[a-z]+/))
+        doc = substr (doc, RLENGTH + 1);
+      else
+        {
+          print "bench-flatten: can't parse: " substr (doc, 1, 20) > "/dev/stderr";
+          exit 1;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#!/bin/sh
+# Compares two bench-results.json files.
+#
+# hd-bench-compare.sh <baseline> <results> <tolerances>
+#
+# Every non-comment line of <tolerances> is
+#
+#   <key regexp> <allowed regression in percent> [higher]
+#
+# where the key is the dotted path of a number in the results, eg.
+# speed.compositor.frame_ms.p90.  The first matching line applies;
+# numbers no line matches aren't compared.  Lower is better unless the
+# line says "higher".  Exits 1 if anything regressed beyond tolerance.
+
+if [ $# -ne 3 ]; then
+  echo "usage: $0 <baseline> <results> <tolerances>" >&2
+  exit 2
+fi
+
+here=`dirname "$0"`
+flatten="awk -f $here/bench-flatten.awk"
+
+$flatten "$1" > "$2.base.$$"
+$flatten "$2" > "$2.new.$$"
+trap 'rm -f "$2.base.$$" "$2.new.$$"' EXIT
+
+awk -v basefile="$2.base.$$" -v newfile="$2.new.$$" '
+  BEGIN { ntol = 0 }
+  /^[ \t]*(#|$)/ { next }
+  { pat[ntol] = $1; pct[ntol] = $2; higher[ntol] = $3 == "higher"; ntol++ }
+  END {
+    while ((getline line < basefile) > 0)
+      {
+        split (line, f, " ");
+        base[f[1]] = f[2];
+      }
+    failed = 0;
+    while ((getline line < newfile) > 0)
+      {
+        split (line, f, " ");
+        key = f[1]; val = f[2];
+        if (!(key in base))
+          continue;
+        for (i = 0; i < ntol; i++)
+          if (key ~ pat[i])
+            break;
+        if (i == ntol)
+          continue;
+
+        old = base[key];
+        if (higher[i])
+          limit = old * (1 - pct[i] / 100);
+        else
+          limit = old * (1 + pct[i] / 100);
+        bad = higher[i] ? val < limit : val > limit;
+        printf ("%-4s %-45s %10.3f -> %10.3f (%+.1f%%, limit %s%%)\n",
+                bad ? "FAIL" : "ok", key, old, val,
+                old ? (val - old) * 100 / old : 0,
+                (higher[i] ? "-" : "+") pct[i]);
+        failed += bad;
+      }
+    if (failed)
+      printf ("%d regression(s)\n", failed);
+    exit failed != 0;
+  }' "$3"
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Replays a session recorded with HD_RECORD=<log> against a fresh
+# hildon-desktop on a headless X server with software GL and prints
+# the frame statistics (JSON) to stdout.
+#
+# hd-bench-replay.sh <log> [hd-replay options]
+#
+# $HD_REPLAY overrides the hd-replay binary; see bench-env.sh for the rest.
+
+set -e
+
+log="$1"
+shift || true
+if [ -z "$log" ]; then
+  echo "usage: $0 <log> [hd-replay options]" >&2
+  exit 1
+fi
+
+here=`dirname "$0"`
+replay="${HD_REPLAY:-$here/hd-replay}"
+. "$here/bench-env.sh"
+
+"$replay" -o "$HD_BENCH_STATS" "$@" "$log"
@@ -0,0 +1,124 @@
+#!/bin/sh
+# Runs the benchmark scenarios against a fresh hildon-desktop on a
+# headless X server (see bench-env.sh), collects their JSON reports into
+# bench-results.json and compares them against a baseline.  This is what
+# 'make bench' does.
+#
+# Parameters, from the environment:
+#   BENCH_DURATION      seconds to run the timed scenarios (default 10)
+#   BENCH_FPS           test-speed redraw rate (default 25)
+#   BENCH_WINDOWS       stackable windows to push (default 20)
+#   BENCH_NOTES         notes to show (default 10)
+#   BENCH_APPLETS       home applets to create (default 8)
+#   BENCH_LIVE_BG_FPS   live background update rate (default 25)
+#   BENCH_LAYOUT        applets to lay out across home views (default 60)
+#   BENCH_ROTATIONS     screen rotations to time (default 6)
+#   BENCH_BURST         windows to map at once (default 20)
+#   BENCH_ACTORS        animation actors to animate (default 50)
+#   BENCH_SCENARIOS     which scenarios to run (default all); switcher-<n>
+#                       toggles the task navigator with <n> thumbnails
+#   BENCH_BASELINE      results to compare against
+#                       (default bench-baseline.json in the source dir)
+#   BENCH_TOLERANCES    what to compare and how strictly
+#                       (default bench-tolerances in the source dir)
+#
+# Without a baseline the results are only printed; copy bench-results.json
+# to the baseline to start tracking.  Exits non-zero on regressions or
+# if any scenario failed; a failed scenario's report is null.
+
+set -e
+
+here=`dirname "$0"`
+srcdir="${srcdir:-$here}"
+bin="${BENCH_BINDIR:-.}"
+results=bench-results.json
+duration="${BENCH_DURATION:-10}"
+scenarios="${BENCH_SCENARIOS:-speed winstack notes applets live-bg layout rotate rotate-nosync map-burst actors actors-ring switcher-10 switcher-30 switcher-60}"
+failed=
+baseline="${BENCH_BASELINE:-$srcdir/bench-baseline.json}"
+tolerances="${BENCH_TOLERANCES:-$srcdir/bench-tolerances}"
+
+. "$here/bench-env.sh"
+
+run()
+{
+  name=$1
+  shift
+  echo "bench: $name" >&2
+  status=0
+  out=`"$@"` || status=$?
+  if [ $status != 0 ]; then
+    echo "bench: $name failed with status $status" >&2
+    failed="$failed $name"
+    out=null
+  elif [ -z "$out" ]; then
+    echo "bench: $name produced no report" >&2
+    failed="$failed $name"
+    out=null
+  fi
+  [ -n "$sep" ] && echo "$sep"
+  printf '"%s": %s' "$name" "$out"
+  sep=,
+}
+
+{
+  echo "{"
+  for s in $scenarios; do
+    case $s in
+      speed)
+        run speed $bin/test-speed --bench --duration=$duration \
+          --fps=${BENCH_FPS:-25} ;;
+      winstack)
+        run winstack $bin/test-winstack --bench \
+          --count=${BENCH_WINDOWS:-20} ;;
+      notes)
+        run notes $bin/test-large-note --bench \
+          --count=${BENCH_NOTES:-10} ;;
+      applets)
+        run applets $bin/test-applet --bench --duration=$duration \
+          --count=${BENCH_APPLETS:-8} ;;
+      live-bg)
+        run live-bg $bin/test-live-bg --bench --duration=$duration \
+          --fps=${BENCH_LIVE_BG_FPS:-25} ;;
+      layout)
+        run layout $bin/test-applet-layout --bench --duration=$duration \
+          --count=${BENCH_LAYOUT:-60} ;;
+      rotate)
+        run rotate $bin/test-rotation --bench \
+          --count=${BENCH_ROTATIONS:-6} ;;
+      rotate-nosync)
+        run rotate-nosync $bin/test-rotation --bench --no-sync \
+          --count=${BENCH_ROTATIONS:-6} ;;
+      map-burst)
+        run map-burst $bin/test-map-burst --bench --duration=$duration \
+          --count=${BENCH_BURST:-20} ;;
+      actors)
+        run actors $bin/test-animation-actors --bench --no-ring \
+          --duration=$duration --count=${BENCH_ACTORS:-50} ;;
+      actors-ring)
+        run actors-ring $bin/test-animation-actors --bench \
+          --duration=$duration --count=${BENCH_ACTORS:-50} ;;
+      switcher-*)
+        run $s $bin/test-switcher --bench --duration=$duration \
+          --count=${s#switcher-} ;;
+      *)
+        echo "bench: unknown scenario $s" >&2
+        exit 1 ;;
+    esac
+  done
+  echo
+  echo "}"
+} > $results
+
+cat $results
+status=0
+if [ ! -f "$baseline" ]; then
+  echo "bench: no baseline at $baseline, not comparing" >&2
+else
+  "$here/hd-bench-compare.sh" "$baseline" $results "$tolerances" || status=$?
+fi
+if [ -n "$failed" ]; then
+  echo "bench: failed:$failed" >&2
+  exit 1
+fi
+exit $status
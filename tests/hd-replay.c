@@ -0,0 +1,379 @@
+/* Replays a session recorded by hildon-desktop with HD_RECORD=<file>
+ * against a running hildon-desktop, and optionally collects the frame
+ * statistics it gathers when started with HD_BENCH_STATS=<file>.
+ *
+ * hd-replay [-s <speed>] [-f] [-o <stats-file>] [-t <timeout>] <log>
+ *
+ *   -s  replay <speed> times faster than recorded (default 1)
+ *   -f  don't wait between events at all
+ *   -o  the HD_BENCH_STATS file of the hildon-desktop under test;
+ *       the statistics are reset before the replay, dumped afterwards
+ *       and printed to stdout
+ *   -t  how many seconds to wait for the statistics (default 10)
+ *
+ * Every line of the log is "<msec> <what> <window> ...":
+ *
+ *   root      <xid>
+ *   create    <xid> <x> <y> <w> <h> <override-redirect>
+ *   map       <xid>
+ *   unmap     <xid>
+ *   destroy   <xid>
+ *   configure <xid> <x> <y> <w> <h>
+ *   property  <xid> <name> <type> <format> <hex data>|<atom,...>|-
+ *   message   <xid> <type> <format> <l0> <l1> <l2> <l3> <l4>
+ *   damage    <xid> <x> <y> <w> <h>
+ *   state     <render manager state>
+ *
+ * Only windows created during the recording (and the root window) are
+ * replayed; events for anything else are ignored.  ClientMessage data
+ * is sent verbatim, so atoms in it are only right if both servers
+ * interned them in the same order, which is the case for fresh Xvfbs
+ * running the same hildon-desktop. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define MAX_WINDOWS 1024
+
+static Display *dpy;
+static GC gc;
+
+static struct
+{
+  Window recorded, real;
+} windows[MAX_WINDOWS];
+static int nwindows;
+static Window recorded_root;
+
+static long now_ms (void)
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static Window lookup_window (Window recorded)
+{
+  int i;
+
+  if (recorded == recorded_root)
+    return DefaultRootWindow (dpy);
+  for (i = 0; i < nwindows; i++)
+    if (windows[i].recorded == recorded)
+      return windows[i].real;
+  return None;
+}
+
+static void forget_window (Window recorded)
+{
+  int i;
+
+  for (i = 0; i < nwindows; i++)
+    if (windows[i].recorded == recorded)
+      {
+        windows[i] = windows[--nwindows];
+        return;
+      }
+}
+
+static void create_window (Window recorded, int x, int y, int w, int h,
+                           int override)
+{
+  XSetWindowAttributes attr;
+
+  if (nwindows >= MAX_WINDOWS)
+    {
+      fprintf (stderr, "too many windows\n");
+      return;
+    }
+
+  attr.override_redirect = override;
+  attr.background_pixel = WhitePixel (dpy, DefaultScreen (dpy));
+  windows[nwindows].recorded = recorded;
+  windows[nwindows].real = XCreateWindow (dpy, DefaultRootWindow (dpy),
+                                          x, y, w > 0 ? w : 1,
+                                          h > 0 ? h : 1, 0,
+                                          CopyFromParent, InputOutput,
+                                          CopyFromParent,
+                                          CWOverrideRedirect | CWBackPixel,
+                                          &attr);
+  nwindows++;
+}
+
+static void set_property (Window w, const char *name, const char *type,
+                          int format, const char *value)
+{
+  Atom prop, ptype;
+  unsigned char *data;
+  long *ldata;
+  int n, i;
+
+  prop = XInternAtom (dpy, name, False);
+  if (!strcmp (type, "None"))
+    {
+      XDeleteProperty (dpy, w, prop);
+      return;
+    }
+  ptype = XInternAtom (dpy, type, False);
+
+  if (!strcmp (value, "-"))
+    {
+      XChangeProperty (dpy, w, prop, ptype, format, PropModeReplace,
+                       NULL, 0);
+      return;
+    }
+
+  if (ptype == XA_ATOM && format == 32)
+    {
+      char *names, *tok;
+
+      names = strdup (value);
+      ldata = malloc (sizeof (*ldata) * (strlen (value) + 1));
+      for (n = 0, tok = strtok (names, ","); tok; tok = strtok (NULL, ","))
+        ldata[n++] = XInternAtom (dpy, tok, False);
+      XChangeProperty (dpy, w, prop, ptype, 32, PropModeReplace,
+                       (unsigned char *)ldata, n);
+      free (ldata);
+      free (names);
+      return;
+    }
+
+  /* Hex data, 8 digits per item for format 32. */
+  n = strlen (value) / 2;
+  data = malloc (n);
+  for (i = 0; i < n; i++)
+    sscanf (&value[i * 2], "%2hhx", &data[i]);
+
+  if (format == 32)
+    {
+      /* Xlib wants longs. */
+      n /= 4;
+      ldata = malloc (sizeof (*ldata) * n);
+      for (i = 0; i < n; i++)
+        {
+          ldata[i] = (data[i*4] << 24) | (data[i*4+1] << 16)
+            | (data[i*4+2] << 8) | data[i*4+3];
+          if (ptype == XA_WINDOW && lookup_window (ldata[i]) != None)
+            ldata[i] = lookup_window (ldata[i]);
+        }
+      XChangeProperty (dpy, w, prop, ptype, 32, PropModeReplace,
+                       (unsigned char *)ldata, n);
+      free (ldata);
+    }
+  else
+    XChangeProperty (dpy, w, prop, ptype, format, PropModeReplace,
+                     data, n / (format / 8));
+
+  free (data);
+}
+
+static void send_message (Window w, const char *type, int format, long *l)
+{
+  XClientMessageEvent xclient;
+  int i;
+
+  memset (&xclient, 0, sizeof (xclient));
+  xclient.type = ClientMessage;
+  xclient.window = w;
+  xclient.message_type = XInternAtom (dpy, type, False);
+  xclient.format = format;
+  for (i = 0; i < 5; i++)
+    xclient.data.l[i] = l[i];
+
+  XSendEvent (dpy, DefaultRootWindow (dpy), False,
+              SubstructureRedirectMask | SubstructureNotifyMask,
+              (XEvent *)&xclient);
+}
+
+/* Asks hildon-desktop to reset (0) or dump (1) its statistics. */
+static void bench_control (long what)
+{
+  long l[5] = { what, 0, 0, 0, 0 };
+
+  send_message (DefaultRootWindow (dpy), "_HILDON_BENCH", 32, l);
+  XSync (dpy, False);
+}
+
+static void damage (Window w, int x, int y, int width, int height)
+{
+  static unsigned long pixel;
+
+  /* Change the color so it's actual damage. */
+  XSetForeground (dpy, gc, pixel += 0x010101);
+  XFillRectangle (dpy, w, gc, x, y, width, height);
+}
+
+static void replay_line (char *line)
+{
+  char what[32], name[256], type[256], *value;
+  unsigned long xid;
+  int x, y, w, h, n, format;
+  long l[5];
+  Window win;
+
+  if (sscanf (line, "%*d %31s %lx%n", what, &xid, &n) < 2)
+    return;
+  line += n;
+
+  if (!strcmp (what, "root"))
+    {
+      recorded_root = xid;
+      return;
+    }
+  if (!strcmp (what, "create"))
+    {
+      int override;
+
+      if (sscanf (line, "%d %d %d %d %d", &x, &y, &w, &h, &override) == 5)
+        create_window (xid, x, y, w, h, override);
+      return;
+    }
+
+  if ((win = lookup_window (xid)) == None)
+    return;
+
+  if (!strcmp (what, "map"))
+    XMapWindow (dpy, win);
+  else if (!strcmp (what, "unmap"))
+    XUnmapWindow (dpy, win);
+  else if (!strcmp (what, "destroy"))
+    {
+      XDestroyWindow (dpy, win);
+      forget_window (xid);
+    }
+  else if (!strcmp (what, "configure"))
+    {
+      if (sscanf (line, "%d %d %d %d", &x, &y, &w, &h) == 4)
+        XMoveResizeWindow (dpy, win, x, y, w > 0 ? w : 1, h > 0 ? h : 1);
+    }
+  else if (!strcmp (what, "property"))
+    {
+      if (sscanf (line, "%255s %255s %d %n", name, type, &format, &n) < 3)
+        return;
+      value = line + n;
+      value[strcspn (value, "\n")] = '\0';
+      set_property (win, name, type, format, value);
+    }
+  else if (!strcmp (what, "message"))
+    {
+      if (sscanf (line, "%255s %d %lx %lx %lx %lx %lx", type, &format,
+                  &l[0], &l[1], &l[2], &l[3], &l[4]) == 7)
+        send_message (win, type, format, l);
+    }
+  else if (!strcmp (what, "damage"))
+    {
+      if (sscanf (line, "%d %d %d %d", &x, &y, &w, &h) == 4)
+        damage (win, x, y, w, h);
+    }
+}
+
+/* Waits for hildon-desktop to write @fname and prints it. */
+static int print_stats (const char *fname, int timeout)
+{
+  struct stat st;
+  char buf[4096];
+  FILE *f;
+  size_t n;
+  long until;
+
+  until = now_ms () + timeout * 1000;
+  while (stat (fname, &st) < 0)
+    {
+      if (now_ms () > until)
+        {
+          fprintf (stderr, "%s: not written in %d seconds\n",
+                   fname, timeout);
+          return 1;
+        }
+      usleep (50000);
+    }
+
+  if (!(f = fopen (fname, "r")))
+    {
+      perror (fname);
+      return 1;
+    }
+  while ((n = fread (buf, 1, sizeof (buf), f)) > 0)
+    fwrite (buf, 1, n, stdout);
+  fclose (f);
+  return 0;
+}
+
+int main (int argc, char **argv)
+{
+  const char *stats = NULL;
+  double speed = 1;
+  int fast = 0, timeout = 10, opt;
+  char line[16384];
+  long start, at;
+  FILE *log;
+
+  while ((opt = getopt (argc, argv, "s:fo:t:")) != -1)
+    switch (opt)
+      {
+        case 's': speed = atof (optarg); break;
+        case 'f': fast = 1; break;
+        case 'o': stats = optarg; break;
+        case 't': timeout = atoi (optarg); break;
+        default:
+          fprintf (stderr, "usage: %s [-s speed] [-f] [-o stats-file] "
+                   "[-t timeout] log\n", argv[0]);
+          return 1;
+      }
+  if (optind >= argc || speed <= 0)
+    {
+      fprintf (stderr, "usage: %s [-s speed] [-f] [-o stats-file] "
+               "[-t timeout] log\n", argv[0]);
+      return 1;
+    }
+
+  if (!(log = fopen (argv[optind], "r")))
+    {
+      perror (argv[optind]);
+      return 1;
+    }
+  if (!(dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+  gc = XCreateGC (dpy, DefaultRootWindow (dpy), 0, NULL);
+
+  if (stats)
+    {
+      unlink (stats);
+      bench_control (0);
+    }
+
+  start = now_ms ();
+  while (fgets (line, sizeof (line), log))
+    {
+      if (!fast && sscanf (line, "%ld", &at) == 1)
+        {
+          long due = start + at / speed;
+
+          XFlush (dpy);
+          while (now_ms () < due)
+            usleep ((due - now_ms ()) * 1000);
+        }
+      replay_line (line);
+    }
+  XSync (dpy, False);
+  fclose (log);
+
+  if (stats)
+    {
+      bench_control (1);
+      return print_stats (stats, timeout);
+    }
+
+  return 0;
+}
@@ -0,0 +1,358 @@
+/* Animates --count (default 50) HildonAnimationActor:s on top of an
+ * application window at --fps (default 30), moving, rotating and
+ * scaling every one of them in every frame.
+ *
+ * test-animation-actors [--no-ring]
+ *
+ * Unless --no-ring is given or hildon-desktop doesn't support it, the
+ * changes are written into a shared-memory command ring (see
+ * src/mb/hd-animation-ring.h) and hildon-desktop is told once per frame
+ * to apply them.  Otherwise every change is a ClientMessage of its own,
+ * as libhildon sends them.  Reports how many X messages a frame took. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "hd-animation-ring.h"
+#include "bench-common.h"
+
+#define RING_COMMANDS 1024
+
+static Display *Dpy;
+static Window App, *Actors;
+static int N_actors;
+
+static Atom Ready, Ring_tail, Msg_show, Msg_position, Msg_rotation,
+            Msg_scale, Msg_parent, Msg_ring, Msg_frame;
+
+static key_t Ring_key;
+static HdAnimationRing *Ring;
+/* How far hildon-desktop has consumed the ring, as far as we know. */
+static unsigned Tail;
+
+static void set_atom (Window w, const char *prop, const char *value)
+{
+  Atom atom = XInternAtom (Dpy, value, False);
+
+  XChangeProperty (Dpy, w, XInternAtom (Dpy, prop, False),
+                   XA_ATOM, 32, PropModeReplace,
+                   (unsigned char *)&atom, 1);
+}
+
+static void send_message (Window w, Atom type,
+                          long l0, long l1, long l2, long l3, long l4)
+{
+  XClientMessageEvent xclient;
+
+  memset (&xclient, 0, sizeof (xclient));
+  xclient.type = ClientMessage;
+  xclient.window = w;
+  xclient.message_type = type;
+  xclient.format = 32;
+  xclient.data.l[0] = l0;
+  xclient.data.l[1] = l1;
+  xclient.data.l[2] = l2;
+  xclient.data.l[3] = l3;
+  xclient.data.l[4] = l4;
+  XSendEvent (Dpy, w, False, StructureNotifyMask, (XEvent *)&xclient);
+}
+
+/* Tells whose windows these are, so we may share a ring with it. */
+static void set_pid (Window w)
+{
+  long pid = getpid ();
+
+  XChangeProperty (Dpy, w, XInternAtom (Dpy, "_NET_WM_PID", False),
+                   XA_CARDINAL, 32, PropModeReplace,
+                   (unsigned char *)&pid, 1);
+}
+
+static long get_long (Window w, Atom prop)
+{
+  Atom type;
+  int format;
+  unsigned long items, left;
+  unsigned char *data;
+  long value = 0;
+
+  if (XGetWindowProperty (Dpy, w, prop, 0, 1, False, AnyPropertyType,
+                          &type, &format, &items, &left, &data) == Success
+      && data)
+    {
+      if (items)
+        value = *(long *)data;
+      XFree (data);
+    }
+  return value;
+}
+
+/* Waits until every actor is ready.  Returns the bits all of them have
+ * in common or 0 if some of them didn't get ready. */
+static long wait_ready (void)
+{
+  XEvent xev;
+  double end;
+  long common;
+  int i;
+
+  for (end = bench_now () + 5; bench_now () < end; )
+    {
+      common = HD_ANIMATION_READY | HD_ANIMATION_READY_RING;
+      for (i = 0; i < N_actors; i++)
+        common &= get_long (Actors[i], Ready);
+      if (common & HD_ANIMATION_READY)
+        return common;
+
+      while (XPending (Dpy))
+        XNextEvent (Dpy, &xev);
+      usleep (10000);
+    }
+
+  return 0;
+}
+
+static int ring_create (void)
+{
+  int shm_id;
+
+  Ring_key = (key_t)(0x48440000 | (getpid () & 0xffff));
+  shm_id = shmget (Ring_key, HD_ANIMATION_RING_SIZE (RING_COMMANDS),
+                   IPC_CREAT | IPC_EXCL | 0600);
+  if (shm_id < 0)
+    {
+      perror ("shmget");
+      return 0;
+    }
+  if ((Ring = shmat (shm_id, NULL, 0)) == (void *)-1)
+    {
+      perror ("shmat");
+      shmctl (shm_id, IPC_RMID, NULL);
+      Ring = NULL;
+      return 0;
+    }
+
+  memset (Ring, 0, HD_ANIMATION_RING_SIZE (RING_COMMANDS));
+  Ring->magic = HD_ANIMATION_RING_MAGIC;
+  Ring->n_commands = RING_COMMANDS;
+  return 1;
+}
+
+static void ring_destroy (void)
+{
+  int shm_id;
+
+  if (!Ring)
+    return;
+  shm_id = shmget (Ring_key, 0, 0);
+  shmdt (Ring);
+  if (shm_id >= 0)
+    shmctl (shm_id, IPC_RMID, NULL);
+  Ring = NULL;
+}
+
+/* Writes a command at *@pos, which it advances, but doesn't publish it. */
+static void ring_put (unsigned *pos, Window w, unsigned frame, unsigned type,
+                      long l0, long l1, long l2, long l3, long l4)
+{
+  HdAnimationRingCommand *cmd;
+
+  cmd = &Ring->commands[(*pos)++ & (RING_COMMANDS - 1)];
+  cmd->window = w;
+  cmd->frame = frame;
+  cmd->type = type;
+  cmd->args[0] = l0;
+  cmd->args[1] = l1;
+  cmd->args[2] = l2;
+  cmd->args[3] = l3;
+  cmd->args[4] = l4;
+}
+
+/* Where actor @i is in @frame. */
+static void place (int i, unsigned frame, long *x, long *y,
+                   long *degrees, long *scale)
+{
+  double t = frame / 30.0 + i * 0.4;
+
+  *x = 400 + 300 * cos (t) - 16;
+  *y = 240 + 180 * sin (t * 1.3) - 16;
+  *degrees = (long)(fmod (t * 90, 360) * 65536);
+  *scale = (long)((1.0 + 0.5 * sin (t * 2)) * 65536);
+}
+
+/* Sends the changes of @frame.  Returns how many X messages it took,
+ * or -1 if the ring was full. */
+static int animate (unsigned frame)
+{
+  long x, y, degrees, scale;
+  int i;
+
+  if (Ring)
+    {
+      unsigned head;
+
+      /* Wait for room for the whole frame.  Frames are always sent
+       * to Actors[0], so that's where we learn how far we got. */
+      if (RING_COMMANDS - (Ring->head - Tail) < 3 * N_actors)
+        Tail = get_long (Actors[0], Ring_tail);
+      if (RING_COMMANDS - (Ring->head - Tail) < 3 * N_actors)
+        return -1;
+
+      head = Ring->head;
+      for (i = 0; i < N_actors; i++)
+        {
+          place (i, frame, &x, &y, &degrees, &scale);
+          ring_put (&head, Actors[i], frame, HD_ANIMATION_RING_POSITION,
+                    x, y, 0, 0, 0);
+          ring_put (&head, Actors[i], frame, HD_ANIMATION_RING_ROTATION,
+                    2, degrees, 16, 16, 0);
+          ring_put (&head, Actors[i], frame, HD_ANIMATION_RING_SCALE,
+                    scale, scale, 0, 0, 0);
+        }
+
+      /* Publish the frame only when all of it is there. */
+      __sync_synchronize ();
+      Ring->head = head;
+      send_message (Actors[0], Msg_frame, frame, 0, 0, 0, 0);
+      XFlush (Dpy);
+      return 1;
+    }
+
+  for (i = 0; i < N_actors; i++)
+    {
+      place (i, frame, &x, &y, &degrees, &scale);
+      send_message (Actors[i], Msg_position, x, y, 0, 0, 0);
+      send_message (Actors[i], Msg_rotation, 2, degrees, 16, 16, 0);
+      send_message (Actors[i], Msg_scale, scale, scale, 0, 0, 0);
+    }
+  XFlush (Dpy);
+  return 3 * N_actors;
+}
+
+int main (int argc, char **argv)
+{
+  int i, ring = 1, sent, frames, skipped;
+  unsigned frame;
+  double next_frame;
+  long ready;
+  XEvent xev;
+
+  bench_args (&argc, argv);
+  for (i = 1; i < argc; i++)
+    if (!strcmp (argv[i], "--no-ring"))
+      ring = 0;
+  N_actors = Bench_count > 0 ? Bench_count : 50;
+  if (Bench_fps <= 0)
+    Bench_fps = 30;
+
+  if (!(Dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+  Ready = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_READY", False);
+  Ring_tail = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_RING_TAIL", False);
+  Msg_show = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_MESSAGE_SHOW",
+                          False);
+  Msg_position = XInternAtom (Dpy,
+                              "_HILDON_ANIMATION_CLIENT_MESSAGE_POSITION",
+                              False);
+  Msg_rotation = XInternAtom (Dpy,
+                              "_HILDON_ANIMATION_CLIENT_MESSAGE_ROTATION",
+                              False);
+  Msg_scale = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_MESSAGE_SCALE",
+                           False);
+  Msg_parent = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT",
+                            False);
+  Msg_ring = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_MESSAGE_RING",
+                          False);
+  Msg_frame = XInternAtom (Dpy, "_HILDON_ANIMATION_CLIENT_MESSAGE_FRAME",
+                           False);
+
+  App = XCreateSimpleWindow (Dpy, DefaultRootWindow (Dpy), 0, 0, 800, 480,
+                             0, 0, WhitePixel (Dpy, DefaultScreen (Dpy)));
+  XStoreName (Dpy, App, "test-animation-actors");
+  set_atom (App, "_NET_WM_WINDOW_TYPE", "_NET_WM_WINDOW_TYPE_NORMAL");
+  set_pid (App);
+  XMapWindow (Dpy, App);
+
+  Actors = calloc (N_actors, sizeof (*Actors));
+  for (i = 0; i < N_actors; i++)
+    {
+      Actors[i] = XCreateSimpleWindow (Dpy, DefaultRootWindow (Dpy),
+                                       0, 0, 32, 32, 0, 0,
+                                       BlackPixel (Dpy,
+                                                   DefaultScreen (Dpy)));
+      XSelectInput (Dpy, Actors[i], PropertyChangeMask);
+      XSetTransientForHint (Dpy, Actors[i], App);
+      set_atom (Actors[i], "_NET_WM_WINDOW_TYPE",
+                "_HILDON_WM_WINDOW_TYPE_ANIMATION_ACTOR");
+      set_pid (Actors[i]);
+      XMapWindow (Dpy, Actors[i]);
+    }
+  XFlush (Dpy);
+
+  if (!(ready = wait_ready ()))
+    {
+      fprintf (stderr, "the actors didn't get ready\n");
+      return 1;
+    }
+  if (ring && !(ready & HD_ANIMATION_READY_RING))
+    fprintf (stderr, "no command ring support, sending messages\n");
+  else if (ring && 3 * N_actors > RING_COMMANDS)
+    fprintf (stderr, "too many actors for the ring, sending messages\n");
+  else if (ring && ring_create ())
+    for (i = 0; i < N_actors; i++)
+      send_message (Actors[i], Msg_ring, Ring_key, 0, 0, 0, 0);
+
+  for (i = 0; i < N_actors; i++)
+    {
+      send_message (Actors[i], Msg_parent, App, 0, 0, 0, 0);
+      send_message (Actors[i], Msg_show, 1, 255, 0, 0, 0);
+    }
+  XSync (Dpy, False);
+
+  bench_start (Dpy);
+  sent = frames = skipped = 0;
+  next_frame = bench_now ();
+  for (frame = 0; Bench ? !bench_done () : frame < 300; )
+    {
+      while (XPending (Dpy))
+        XNextEvent (Dpy, &xev);
+
+      if (bench_now () < next_frame)
+        {
+          usleep (1000);
+          continue;
+        }
+      next_frame += 1 / Bench_fps;
+
+      if ((i = animate (frame)) < 0)
+        {
+          skipped++;
+          continue;
+        }
+      sent += i;
+      frames++;
+      frame++;
+      bench_frame ();
+    }
+
+  printf ("%d frames, %.1f messages per frame, %d skipped\n", frames,
+          frames ? (double)sent / frames : 0, skipped);
+  bench_metric ("actors", N_actors);
+  bench_metric ("messages_per_frame", frames ? (double)sent / frames : 0);
+  bench_metric ("frames_skipped", skipped);
+  bench_finish (Dpy, Ring ? "actors-ring" : "actors");
+
+  ring_destroy ();
+  XCloseDisplay (Dpy);
+  return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * This file is part of hildon-desktop tests
+ *
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Checks the applet placement of hd-free-space: applets of random sizes
+ * are placed on home views in both orientations, the way HdHomeViewLayout
+ * does it, until the views are full, and none of them may overlap or
+ * stick out.  Exits 1 if any does.
+ *
+ * With --bench it places --count applets (default 60) across as many
+ * views as they need over and over for --duration seconds, and reports
+ * how long placing one took.
+ */
+
+#include <stdio.h>
+#include <glib.h>
+
+#include "hd-free-space.h"
+#include "bench-common.h"
+
+/* What HdHomeViewLayout uses. */
+#define PADDING     13
+#define MIN_SIZE    (2 * PADDING + 1)
+#define TOP_MARGIN  56
+#define MAX_VIEWS   9
+
+typedef struct
+{
+  gint x, y, width, height, view;
+} Applet;
+
+static const HdFreeSpaceFit Fits[] =
+{
+  HD_FREE_SPACE_TOP_LEFT,
+  HD_FREE_SPACE_BEST_SHORT_SIDE,
+  HD_FREE_SPACE_BEST_AREA,
+};
+
+static void
+random_size (GRand *rand, gint *width, gint *height)
+{
+  /* From a contact to a full-width clock. */
+  *width = g_rand_int_range (rand, 60, 400);
+  *height = g_rand_int_range (rand, 60, 240);
+}
+
+/* Places @n applets across views of @width x @height.  Returns how many
+ * fit. */
+static guint
+place (GRand *rand, HdFreeSpaceFit fit, gint width, gint height,
+       Applet *applets, guint n)
+{
+  HdFreeSpace *views[MAX_VIEWS];
+  guint i, v;
+
+  for (v = 0; v < MAX_VIEWS; v++)
+    views[v] = hd_free_space_new (0, TOP_MARGIN, width, height - TOP_MARGIN,
+                                  MIN_SIZE);
+
+  for (i = 0; i < n; i++)
+    {
+      Applet *a = &applets[i];
+      gboolean found = FALSE;
+
+      random_size (rand, &a->width, &a->height);
+      for (v = 0; v < MAX_VIEWS && !found; v++)
+        {
+          /* Every other one as if it was dropped somewhere. */
+          if (i % 2)
+            found = hd_free_space_find_near (views[v],
+                                             a->width + 2 * PADDING,
+                                             a->height + 2 * PADDING,
+                                             g_rand_int_range (rand, 0, width),
+                                             g_rand_int_range (rand, 0, height),
+                                             &a->x, &a->y);
+          else
+            found = hd_free_space_find (views[v], fit,
+                                        a->width + 2 * PADDING,
+                                        a->height + 2 * PADDING,
+                                        &a->x, &a->y);
+          if (found)
+            a->view = v;
+        }
+      if (!found)
+        break;
+
+      a->x += PADDING;
+      a->y += PADDING;
+      hd_free_space_occupy (views[a->view], a->x, a->y, a->width, a->height);
+    }
+
+  for (v = 0; v < MAX_VIEWS; v++)
+    hd_free_space_free (views[v]);
+  return i;
+}
+
+static gboolean
+check (const Applet *applets, guint n, gint width, gint height)
+{
+  guint i, j;
+
+  for (i = 0; i < n; i++)
+    {
+      const Applet *a = &applets[i];
+
+      if (a->x < 0 || a->y < TOP_MARGIN
+          || a->x + a->width > width || a->y + a->height > height)
+        {
+          fprintf (stderr, "applet %u (%dx%d%+d%+d) is off view %d\n",
+                   i, a->width, a->height, a->x, a->y, a->view);
+          return FALSE;
+        }
+
+      for (j = 0; j < i; j++)
+        {
+          const Applet *b = &applets[j];
+
+          if (a->view == b->view
+              && a->x < b->x + b->width && b->x < a->x + a->width
+              && a->y < b->y + b->height && b->y < a->y + a->height)
+            {
+              fprintf (stderr, "applets %u and %u overlap on view %d\n",
+                       j, i, a->view);
+              return FALSE;
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+static int
+test (void)
+{
+  static const gint sizes[][2] = { { 800, 480 }, { 480, 800 } };
+  Applet applets[200];
+  GRand *rand;
+  guint round, s, f, n, total;
+
+  rand = g_rand_new_with_seed (1);
+  total = 0;
+  for (round = 0; round < 100; round++)
+    for (s = 0; s < G_N_ELEMENTS (sizes); s++)
+      for (f = 0; f < G_N_ELEMENTS (Fits); f++)
+        {
+          n = place (rand, Fits[f], sizes[s][0], sizes[s][1],
+                     applets, G_N_ELEMENTS (applets));
+          if (!check (applets, n, sizes[s][0], sizes[s][1]))
+            {
+              fprintf (stderr, "round %u, %dx%d, fit %d\n", round,
+                       sizes[s][0], sizes[s][1], Fits[f]);
+              return 1;
+            }
+          total += n;
+        }
+  g_rand_free (rand);
+
+  printf ("%u applets placed without overlap\n", total);
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  Applet *applets;
+  GRand *rand;
+  double t, place_ms;
+  guint placed;
+
+  bench_args (&argc, argv);
+  if (!Bench)
+    return test ();
+
+  if (Bench_count < 0)
+    Bench_count = 60;
+
+  /* There's no compositor involved. */
+  g_unsetenv ("HD_BENCH_STATS");
+
+  applets = g_new (Applet, Bench_count);
+  rand = g_rand_new_with_seed (1);
+  place_ms = 0;
+  placed = 0;
+  bench_start (NULL);
+  while (!bench_done ())
+    {
+      t = bench_now ();
+      placed += place (rand, HD_FREE_SPACE_TOP_LEFT, 800, 480,
+                       applets, Bench_count);
+      place_ms += (bench_now () - t) * 1000;
+      bench_frame ();
+    }
+
+  bench_metric ("place_us", placed ? place_ms * 1000 / placed : 0);
+  bench_finish (NULL, "layout");
+
+  g_rand_free (rand);
+  g_free (applets);
+  return 0;
+}
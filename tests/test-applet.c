@@ -33,6 +33,8 @@
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>          /* for XA_ATOM etc */
 
+#include "bench-common.h"
+
 #define PAN_THRESHOLD 20
 
 /*
@@ -133,48 +135,31 @@ x_event_filter_func (GdkXEvent *xevent, GdkEvent *event, gpointer data)
   return GDK_FILTER_CONTINUE;
 }
 
-int main (int argc, char *argv[])
-{
-  Atom applet_id, wm_type, applet_type, view_id_atom;
-  GtkWidget *w, *b;
-  int i;
-
-  for (i = 1; i < argc; ++i)
-    {
-      if (!strncmp (argv[i], "--view-id", 9))
-	{
-	  g_message ("got view id %s", argv[i]+10);
-
-	  view_id = atoi (argv[i]+10);
-	}
-    }
-
-  gtk_init (&argc, &argv);
-
-  wm_type = XInternAtom (GDK_DISPLAY (), "_NET_WM_WINDOW_TYPE", False);
+static Atom applet_id, wm_type, applet_type, view_id_atom;
 
-  applet_id = XInternAtom (GDK_DISPLAY (), "_HILDON_APPLET_ID", False);
-
-  applet_type = XInternAtom (GDK_DISPLAY (),
-			    "_HILDON_WM_WINDOW_TYPE_HOME_APPLET", False);
-
-  pan_atom = XInternAtom (GDK_DISPLAY (), "_HILDON_CLIENT_MESSAGE_PAN", False);
+static GtkWidget *
+new_applet (int n)
+{
+  GtkWidget *win, *w, *b;
+  char id[32];
 
-  view_id_atom = XInternAtom (GDK_DISPLAY (), "_HILDON_HOME_VIEW", False);
-  window  = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  win = gtk_window_new (GTK_WINDOW_TOPLEVEL);
 
-  g_signal_connect (G_OBJECT (window), "button-release-event",
+  g_signal_connect (G_OBJECT (win), "button-release-event",
 		    G_CALLBACK (on_button_event), NULL);
 
-  g_signal_connect (G_OBJECT (window), "button-press-event",
+  g_signal_connect (G_OBJECT (win), "button-press-event",
 		    G_CALLBACK (on_button_event), NULL);
 
-  gtk_window_resize (GTK_WINDOW (window), 300, 150);
-  gtk_window_move (GTK_WINDOW (window), 200, 200);
+  gtk_window_resize (GTK_WINDOW (win), 300, 150);
+  if (n)
+    gtk_window_move (GTK_WINDOW (win), 20 + n % 2 * 320, 20 + n / 2 % 2 * 170);
+  else
+    gtk_window_move (GTK_WINDOW (win), 200, 200);
 
   b = gtk_hbox_new (FALSE, 5);
   gtk_widget_show (b);
-  gtk_container_add (GTK_CONTAINER (window), b);
+  gtk_container_add (GTK_CONTAINER (win), b);
 
   /*
   w = gtk_hscale_new_with_range (0.0, 100.0, 1.0);
@@ -186,30 +171,109 @@ int main (int argc, char *argv[])
   w = gtk_entry_new ();
   gtk_widget_show (w);
   gtk_box_pack_start (GTK_BOX (b), w, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (win), "entry", w);
 
-  gtk_widget_realize (window);
+  gtk_widget_realize (win);
 
-  gdk_window_set_events (window->window,
-			 gdk_window_get_events (window->window)|
+  gdk_window_set_events (win->window,
+			 gdk_window_get_events (win->window)|
 			 GDK_BUTTON_PRESS_MASK   |
 			 GDK_BUTTON_RELEASE_MASK |
 			 GDK_POINTER_MOTION_MASK);
 
-  XChangeProperty (GDK_DISPLAY (), GDK_WINDOW_XID (window->window),
+  XChangeProperty (GDK_DISPLAY (), GDK_WINDOW_XID (win->window),
 		   wm_type, XA_ATOM, 32, PropModeReplace,
 		   (unsigned char *)&applet_type, 1);
 
-  XChangeProperty (GDK_DISPLAY (), GDK_WINDOW_XID (window->window),
+  if (n)
+    snprintf (id, sizeof (id), "test-applet-id-%d", n);
+  else
+    strcpy (id, "test-applet-id");
+  XChangeProperty (GDK_DISPLAY (), GDK_WINDOW_XID (win->window),
 		   applet_id, XA_STRING, 8, PropModeReplace,
-		   (unsigned char *) "test-applet-id", 14);
+		   (unsigned char *) id, strlen (id));
 
-  XChangeProperty (GDK_DISPLAY (), GDK_WINDOW_XID (window->window),
+  XChangeProperty (GDK_DISPLAY (), GDK_WINDOW_XID (win->window),
 		   view_id_atom, XA_CARDINAL, 32, PropModeReplace,
 		   (unsigned char *)&view_id, 1);
 
-  gdk_window_add_filter (window->window, x_event_filter_func, NULL);
+  gdk_window_add_filter (win->window, x_event_filter_func, NULL);
+
+  gtk_widget_show_all (win);
+
+  return win;
+}
+
+/* In --bench mode change the contents of all applets at --fps. */
+static gboolean
+update_applets (gpointer data)
+{
+  GPtrArray *applets = data;
+  static unsigned tick;
+  char text[16];
+  guint i;
+
+  if (bench_done ())
+    {
+      bench_finish (GDK_DISPLAY (), "applets");
+      gtk_main_quit ();
+      return FALSE;
+    }
+
+  snprintf (text, sizeof (text), "%u", tick++);
+  for (i = 0; i < applets->len; i++)
+    gtk_entry_set_text (g_object_get_data (applets->pdata[i], "entry"),
+                        text);
+  gdk_display_sync (gdk_display_get_default ());
+  bench_frame ();
+
+  return TRUE;
+}
+
+int main (int argc, char *argv[])
+{
+  GPtrArray *applets;
+  int i;
+
+  bench_args (&argc, argv);
+  for (i = 1; i < argc; ++i)
+    {
+      if (!strncmp (argv[i], "--view-id", 9))
+	{
+	  g_message ("got view id %s", argv[i]+10);
+
+	  view_id = atoi (argv[i]+10);
+	}
+    }
 
-  gtk_widget_show_all (window);
+  gtk_init (&argc, &argv);
+
+  wm_type = XInternAtom (GDK_DISPLAY (), "_NET_WM_WINDOW_TYPE", False);
+
+  applet_id = XInternAtom (GDK_DISPLAY (), "_HILDON_APPLET_ID", False);
+
+  applet_type = XInternAtom (GDK_DISPLAY (),
+			    "_HILDON_WM_WINDOW_TYPE_HOME_APPLET", False);
+
+  pan_atom = XInternAtom (GDK_DISPLAY (), "_HILDON_CLIENT_MESSAGE_PAN", False);
+
+  view_id_atom = XInternAtom (GDK_DISPLAY (), "_HILDON_HOME_VIEW", False);
+
+  if (Bench_count < 1)
+    Bench_count = Bench ? 8 : 1;
+  if (Bench_fps <= 0)
+    Bench_fps = 10;
+
+  applets = g_ptr_array_new ();
+  for (i = 0; i < Bench_count; i++)
+    g_ptr_array_add (applets, new_applet (i));
+  window = applets->pdata[0];
+
+  if (Bench)
+    {
+      bench_start (GDK_DISPLAY ());
+      g_timeout_add (1000 / Bench_fps, update_applets, applets);
+    }
 
   gtk_main();
 
@@ -22,25 +22,75 @@
  */
 
 #include <gtk/gtk.h>
+#include <gdk/gdkx.h>
 #include <hildon/hildon.h>
 
+#include "bench-common.h"
+
 /* Just creates a large note that would have caused NB#117673. It'll need
- * killing to remove it. */
+ * killing to remove it.  With --bench it shows --count notes one after
+ * the other, each for 1/--fps seconds, and reports. */
+
+static GtkWidget *
+large_note (gboolean fullscreen)
+{
+  GtkWidget *note;
+
+  note = hildon_note_new_confirmation(NULL, "1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n11\n12\n13\n14\n15\n16\n17\n18");
+  if (fullscreen)
+    gtk_window_fullscreen(GTK_WINDOW(note));
+  gtk_widget_show_all (note);
+
+  return note;
+}
+
+static gboolean
+next_note (gpointer data)
+{
+  static GtkWidget *note;
+  static int shown;
+  gboolean fullscreen = GPOINTER_TO_INT (data);
+  double t;
+
+  if (note)
+    gtk_widget_destroy (note);
+  if (shown++ >= Bench_count)
+    {
+      bench_finish (GDK_DISPLAY (), "notes");
+      gtk_main_quit ();
+      return FALSE;
+    }
+
+  t = bench_now ();
+  note = large_note (fullscreen);
+  gdk_display_sync (gdk_display_get_default ());
+  bench_frame ();
+  if (shown == 1)
+    bench_metric ("first_note_ms", (bench_now () - t) * 1000);
+
+  return TRUE;
+}
 
 int
 main (int argc, char **argv)
 {
+  bench_args (&argc, argv);
   gtk_init (&argc, &argv);
 
-  HildonNote *note;
-
-  note = HILDON_NOTE(hildon_note_new_confirmation(NULL, "1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n11\n12\n13\n14\n15\n16\n17\n18"));
-  if (argv[1])
-    gtk_window_fullscreen(GTK_WINDOW(note));
-  gtk_widget_show_all (GTK_WIDGET (note));
+  if (!Bench)
+    large_note (argv[1] != NULL);
+  else
+    {
+      if (Bench_count < 0)
+        Bench_count = 10;
+      if (Bench_fps <= 0)
+        Bench_fps = 2;
+      bench_start (GDK_DISPLAY ());
+      g_timeout_add (1000 / Bench_fps, next_note,
+                     GINT_TO_POINTER (argv[1] != NULL));
+    }
 
   gtk_main ();
 
   return 0;
 }
-
@@ -1,5 +1,12 @@
 #include <stdlib.h>
 #include <hildon/hildon.h>
+#include <gdk/gdkx.h>
+
+#include "bench-common.h"
+
+/* Keeps pushing stackable windows until tapped, then pops them until
+ * tapped again.  With --bench it pushes --count windows at --fps,
+ * pops them all and reports. */
 
 static gboolean Add_windows = TRUE;
 
@@ -30,28 +37,63 @@ static GtkWidget *newin(void)
 
 static gboolean wakeup(gpointer unused)
 {
+  HildonWindowStack *stack;
+  double t;
+
+  stack = hildon_window_stack_get_default();
+  if (Bench)
+    {
+      if (Add_windows && hildon_window_stack_size(stack) > Bench_count)
+        Add_windows = FALSE;
+      else if (!Add_windows && hildon_window_stack_size(stack) <= 1)
+        {
+          bench_finish(GDK_DISPLAY(), "winstack");
+          gtk_main_quit();
+          return FALSE;
+        }
+    }
+
+  t = bench_now();
   if (Add_windows)
     newin();
-  else
+  else if (hildon_window_stack_size(stack) > 1)
+    gtk_widget_destroy(hildon_window_stack_pop_1(stack));
+  gdk_display_sync(gdk_display_get_default());
+  bench_frame();
+  if (Bench)
     {
-      HildonWindowStack *stack;
+      static double push_ms, pop_ms;
+      static int pushes, pops;
 
-      stack = hildon_window_stack_get_default();
-      if (hildon_window_stack_size(stack) > 1)
-        gtk_widget_destroy(hildon_window_stack_pop_1(stack));
+      if (Add_windows)
+        push_ms += (bench_now() - t) * 1000, pushes++;
+      else
+        pop_ms += (bench_now() - t) * 1000, pops++;
+      if (!Add_windows && hildon_window_stack_size(stack) <= 1)
+        {
+          bench_metric("push_ms", pushes ? push_ms / pushes : 0);
+          bench_metric("pop_ms", pops ? pop_ms / pops : 0);
+        }
     }
   return TRUE;
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
   GtkWidget *win;
 
-  gtk_init(NULL, NULL);
+  bench_args(&argc, argv);
+  if (Bench_count < 0)
+    Bench_count = 20;
+  if (Bench_fps <= 0)
+    Bench_fps = 4;
+
+  gtk_init(&argc, &argv);
   win = newin();
   g_signal_connect(win, "delete-event", G_CALLBACK(exit), NULL);
 
-  g_timeout_add(250, wakeup, NULL);
+  g_timeout_add(1000 / Bench_fps, wakeup, NULL);
+  bench_start(GDK_DISPLAY());
   gtk_main();
   return 0;
 }
@@ -0,0 +1,57 @@
+/* Opens the launcher, scrolls it down to the bottom and back up a row
+ * at a time, --count rows (default 50) each way, --fps rows a second
+ * (default 20), then leaves it alone for a while.  Tiles scroll past
+ * faster than they're loaded, so many of them are prefetched and then
+ * unloaded without ever being loaded.  With --bench the report has
+ * the launcher's statistics, which test-launcher-scroll.sh checks:
+ * none of the tiles outside the window should hold on to an icon. */
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "bench-common.h"
+
+/* HD_LAUNCHER_TILE_HEIGHT plus the spacing between the rows, in
+ * landscape. */
+#define ROW_HEIGHT 136
+
+int main (int argc, char **argv)
+{
+  Display *dpy;
+  int rows, i;
+  double fps;
+
+  bench_args (&argc, argv);
+  rows = Bench_count > 0 ? Bench_count : 50;
+  fps = Bench_fps > 0 ? Bench_fps : 20;
+
+  if (!(dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+
+  /* Let the launcher read the menu, then open it. */
+  sleep (2);
+  bench_control (dpy, 3, 0);
+  sleep (1);
+
+  bench_start (dpy);
+  for (i = 0; i < 2 * rows; i++)
+    {
+      bench_control (dpy, 3, i < rows ? ROW_HEIGHT : -ROW_HEIGHT);
+      bench_frame ();
+      usleep (1000000 / fps);
+    }
+
+  /* Until the rows in the window are loaded. */
+  sleep (2);
+
+  printf ("scrolled %d rows\n", rows);
+  bench_metric ("rows", rows);
+  bench_finish (dpy, "launcher-scroll");
+
+  XCloseDisplay (dpy);
+  return 0;
+}
@@ -0,0 +1,59 @@
+#!/bin/sh
+# Checks that tiles scrolled out of the launcher's window don't keep the
+# icons prefetched for them.  Runs a fresh hildon-desktop on a headless
+# X server (see bench-env.sh) with a menu of a few hundred entries of
+# its own, scrolls through them with test-launcher-scroll and looks at
+# the launcher statistics it reports.  This is what 'make check-live'
+# does.
+#
+# $BENCH_BINDIR is where test-launcher-scroll is (default .).
+
+set -e
+
+here=`dirname "$0"`
+bin="${BENCH_BINDIR:-.}"
+
+tmp=`mktemp -d /tmp/hd-launcher.XXXXXX`
+mkdir "$tmp/menus" "$tmp/apps"
+cat > "$tmp/menus/hildon.menu" <<EOF2
+<!DOCTYPE Menu PUBLIC "-//freedesktop//DTD Menu 1.0//EN"
+ "http://www.freedesktop.org/standards/menu-spec/menu-1.0.dtd">
+<Menu>
+  <Name>Main</Name>
+  <AppDir>$tmp/apps</AppDir>
+  <Include>
+    <All/>
+  </Include>
+</Menu>
+EOF2
+# None of the icons exist, so they fall back to the default one, which
+# is decoded for each tile all the same.
+i=0
+while [ $i -lt 300 ]; do
+  cat > "$tmp/apps/app$i.desktop" <<EOF2
+[Desktop Entry]
+Type=Application
+Name=app$i
+Exec=/bin/true
+Icon=app$i
+EOF2
+  i=`expr $i + 1`
+done
+
+# hildon-desktop takes hildon.menu from here before the system one.
+XDG_CONFIG_HOME="$tmp"
+export XDG_CONFIG_HOME
+. "$here/bench-env.sh"
+trap 'bench_cleanup; rm -rf "$tmp"' EXIT INT TERM
+
+out=`"$bin/test-launcher-scroll" --bench --count=50`
+
+prefetched=`echo "$out" \
+  | sed -n 's/.*"launcher_tiles_prefetched": \([0-9]*\).*/\1/p'`
+echo "prefetched=$prefetched"
+if [ "$prefetched" != 0 ]; then
+  echo "$out" >&2
+  echo "FAIL: tiles outside the window hold prefetched icons" >&2
+  exit 1
+fi
+echo "PASS"
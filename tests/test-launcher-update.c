@@ -0,0 +1,66 @@
+/* Adds an application to the launcher menu while hildon-desktop is
+ * running, by writing a .desktop file into the directory given on the
+ * command line, waits --duration seconds (default 10) for the launcher
+ * to pick it up, then removes it again.  With --bench the report has
+ * the launcher's statistics of the change, which test-launcher-update.sh
+ * checks: the launcher should have made one new tile and left all the
+ * others alone. */
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench-common.h"
+
+#define NEW_APP "hd-test-launcher-new"
+
+int main (int argc, char **argv)
+{
+  Display *dpy;
+  char fname[1024];
+  FILE *f;
+
+  bench_args (&argc, argv);
+  if (argc != 2)
+    {
+      fprintf (stderr, "usage: %s [--bench] [--duration=<s>] <appdir>\n",
+               argv[0]);
+      return 1;
+    }
+
+  if (!(dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+
+  snprintf (fname, sizeof (fname), "%s/%s.desktop", argv[1], NEW_APP);
+  bench_start (dpy);
+  if (!(f = fopen (fname, "w")))
+    {
+      perror (fname);
+      return 1;
+    }
+  fprintf (f, "[Desktop Entry]\n"
+              "Type=Application\n"
+              "Name=" NEW_APP "\n"
+              "Exec=/bin/true\n"
+              "Icon=" NEW_APP "\n");
+  fclose (f);
+  bench_frame ();
+
+  /* The menu is monitored, but it takes a while to be noticed. */
+  if (Bench)
+    while (!bench_done ())
+      usleep (100000);
+  else
+    sleep (10);
+
+  printf ("added %s\n", fname);
+  bench_finish (dpy, "launcher-update");
+  unlink (fname);
+
+  XCloseDisplay (dpy);
+  return 0;
+}
@@ -0,0 +1,60 @@
+#!/bin/sh
+# Checks that adding an application to the menu only adds a tile to the
+# launcher, rather than rebuilding every page.  Runs a fresh
+# hildon-desktop on a headless X server (see bench-env.sh) with a menu
+# of its own, adds an entry with test-launcher-update and looks at the
+# launcher statistics it reports.  This is what 'make check-live' does.
+#
+# $BENCH_BINDIR is where test-launcher-update is (default .).
+
+set -e
+
+here=`dirname "$0"`
+bin="${BENCH_BINDIR:-.}"
+
+tmp=`mktemp -d /tmp/hd-launcher.XXXXXX`
+mkdir "$tmp/menus" "$tmp/apps"
+cat > "$tmp/menus/hildon.menu" <<EOF
+<!DOCTYPE Menu PUBLIC "-//freedesktop//DTD Menu 1.0//EN"
+ "http://www.freedesktop.org/standards/menu-spec/menu-1.0.dtd">
+<Menu>
+  <Name>Main</Name>
+  <AppDir>$tmp/apps</AppDir>
+  <Include>
+    <All/>
+  </Include>
+</Menu>
+EOF
+for app in one two three four five six; do
+  cat > "$tmp/apps/$app.desktop" <<EOF
+[Desktop Entry]
+Type=Application
+Name=$app
+Exec=/bin/true
+Icon=$app
+EOF
+done
+
+# hildon-desktop takes hildon.menu from here before the system one.
+XDG_CONFIG_HOME="$tmp"
+export XDG_CONFIG_HOME
+. "$here/bench-env.sh"
+trap 'bench_cleanup; rm -rf "$tmp"' EXIT INT TERM
+
+out=`"$bin/test-launcher-update" --bench --duration=5 "$tmp/apps"`
+
+stat()
+{
+  echo "$out" | sed -n "s/.*\"$1\": \([0-9]*\).*/\1/p"
+}
+
+rebuilds=`stat launcher_rebuilds`
+created=`stat launcher_tiles_created`
+destroyed=`stat launcher_tiles_destroyed`
+echo "rebuilds=$rebuilds created=$created destroyed=$destroyed"
+if [ "$rebuilds" != 0 ] || [ "$created" != 1 ] || [ "$destroyed" != 0 ]; then
+  echo "$out" >&2
+  echo "FAIL: the existing tiles didn't survive adding an entry" >&2
+  exit 1
+fi
+echo "PASS"
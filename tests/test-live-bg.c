@@ -11,6 +11,8 @@
 #include <unistd.h>
 #include <X11/extensions/Xrender.h>
 
+#include "bench-common.h"
+
 
 /* Reading position of applets. */
 
@@ -274,8 +276,14 @@ int main(int argc, char **argv)
         char green[] = "#00ff00";
         char red[] = "#ff0000";
         time_t last_time;
+        double next_frame = 0;
         int mode = 1;
 
+        /* with --bench draw at --fps instead of once a second */
+        bench_args(&argc, argv);
+        if (Bench_fps <= 0)
+          Bench_fps = 25;
+
         if (argc == 2)
           mode = atoi(argv[1]);
 
@@ -339,11 +347,29 @@ int main(int argc, char **argv)
         /* ignore X errors */
         XSetErrorHandler (error_handler);
 
+        bench_start(dpy);
+
         for (;;) {
                 XEvent xev;
 
                 if (XEventsQueued (dpy, QueuedAfterFlush))
                   XNextEvent(dpy, &xev);
+                else if (Bench) {
+                  if (bench_done()) {
+                    bench_finish(dpy, "live-bg");
+                    return 0;
+                  }
+                  if (bench_now() >= next_frame) {
+                    unsigned int rx = rand() * 1000 % 800 + 1,
+                                 ry = rand() * 1000 % 480 + 1;
+                    draw_rect (dpy, w, green_gc, &green_col, rx, ry);
+                    XFlush (dpy);
+                    bench_frame();
+                    next_frame = bench_now() + 1 / Bench_fps;
+                  }
+                  usleep (1000);
+                  continue;
+                }
                 else {
                   int t = time(NULL);
                   if (t - last_time > 0) {
@@ -0,0 +1,114 @@
+/* Maps --count (default 20) application windows at once, waits until
+ * all of them are mapped, then unmaps them all at once, and does it
+ * again for --duration seconds.  The window manager sees a burst of
+ * MapRequests, property changes and ConfigureNotifys each time, like
+ * when a lot of windows are restored or an application with many
+ * windows starts up.  Reports how long mapping and unmapping took. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench-common.h"
+
+static Display *Dpy;
+
+static void set_window_type (Window w)
+{
+  Atom normal;
+
+  normal = XInternAtom (Dpy, "_NET_WM_WINDOW_TYPE_NORMAL", False);
+  XChangeProperty (Dpy, w, XInternAtom (Dpy, "_NET_WM_WINDOW_TYPE", False),
+                   XA_ATOM, 32, PropModeReplace,
+                   (unsigned char *)&normal, 1);
+}
+
+/* Waits until @n windows got @type.  Returns the time it took. */
+static double wait_for (int type, int n, double start)
+{
+  XEvent xev;
+  double end;
+
+  for (end = start + 10; n > 0 && bench_now () < end; )
+    {
+      if (!XPending (Dpy))
+        {
+          usleep (1000);
+          continue;
+        }
+
+      XNextEvent (Dpy, &xev);
+      if (xev.type == type)
+        n--;
+    }
+
+  if (n > 0)
+    fprintf (stderr, "%d windows didn't get event %d\n", n, type);
+  return (bench_now () - start) * 1000;
+}
+
+int main (int argc, char **argv)
+{
+  Window *wins;
+  double start, map_ms, unmap_ms;
+  int i, rounds;
+  char name[32];
+
+  bench_args (&argc, argv);
+  if (Bench_count <= 0)
+    Bench_count = 20;
+
+  if (!(Dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+
+  wins = calloc (Bench_count, sizeof (*wins));
+  for (i = 0; i < Bench_count; i++)
+    {
+      wins[i] = XCreateSimpleWindow (Dpy, DefaultRootWindow (Dpy),
+                                     0, 0, 800, 424, 0, 0,
+                                     WhitePixel (Dpy, DefaultScreen (Dpy)));
+      XSelectInput (Dpy, wins[i], StructureNotifyMask);
+      sprintf (name, "burst %d", i);
+      XStoreName (Dpy, wins[i], name);
+      set_window_type (wins[i]);
+    }
+
+  bench_start (Dpy);
+  map_ms = unmap_ms = 0;
+  for (rounds = 0; !rounds || (Bench && !bench_done ()); rounds++)
+    {
+      start = bench_now ();
+      for (i = 0; i < Bench_count; i++)
+        XMapWindow (Dpy, wins[i]);
+      XFlush (Dpy);
+      map_ms += wait_for (MapNotify, Bench_count, start);
+      bench_frame ();
+
+      /* Let the transitions finish. */
+      usleep (500000);
+
+      start = bench_now ();
+      for (i = 0; i < Bench_count; i++)
+        XUnmapWindow (Dpy, wins[i]);
+      XFlush (Dpy);
+      unmap_ms += wait_for (UnmapNotify, Bench_count, start);
+      bench_frame ();
+
+      usleep (500000);
+    }
+
+  printf ("map %.1f ms, unmap %.1f ms\n", map_ms / rounds, unmap_ms / rounds);
+  bench_metric ("map_ms", map_ms / rounds);
+  bench_metric ("unmap_ms", unmap_ms / rounds);
+  bench_finish (Dpy, "map-burst");
+
+  XCloseDisplay (Dpy);
+  return 0;
+}
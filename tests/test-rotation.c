@@ -0,0 +1,234 @@
+/* Rotates the screen back and forth by requesting portrait mode and
+ * measures how long each rotation takes, from the request until
+ * hildon-desktop clears _MAEMO_ROTATION_TRANSITION.
+ *
+ * test-rotation [--no-sync] [--draw-ms=<ms>]
+ *
+ * The window pretends to be an application which takes --draw-ms
+ * (default 40) to redraw after it's been configured.  Unless --no-sync
+ * is given it supports _NET_WM_SYNC_REQUEST, so hildon-desktop can fade
+ * in as soon as it's done instead of waiting for its damage to settle.
+ * As a benchmark scenario --count is the number of rotations. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/sync.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench-common.h"
+
+static Display *Dpy;
+static Window Win;
+static GC Gc;
+static int Draw_ms = 40;
+
+static XSyncCounter Counter;
+static XSyncValue Pending;
+static int Have_pending;
+
+static Atom Wm_protocols, Sync_request, Rotating;
+
+static void set_card (Window w, const char *prop, long value)
+{
+  XChangeProperty (Dpy, w, XInternAtom (Dpy, prop, False),
+                   XA_CARDINAL, 32, PropModeReplace,
+                   (unsigned char *)&value, 1);
+}
+
+static void set_fullscreen (Window w)
+{
+  Atom state_fs;
+
+  state_fs = XInternAtom (Dpy, "_NET_WM_STATE_FULLSCREEN", False);
+  XChangeProperty (Dpy, w, XInternAtom (Dpy, "_NET_WM_STATE", False),
+                   XA_ATOM, 32, PropModeReplace,
+                   (unsigned char *)&state_fs, 1);
+}
+
+static void set_sync_counter (Window w)
+{
+  XSyncValue zero;
+  Atom protos[2];
+  int major, minor, event_base, error_base;
+
+  if (!XSyncQueryExtension (Dpy, &event_base, &error_base)
+      || !XSyncInitialize (Dpy, &major, &minor))
+    {
+      fprintf (stderr, "no XSync, not synchronizing\n");
+      return;
+    }
+
+  XSyncIntToValue (&zero, 0);
+  Counter = XSyncCreateCounter (Dpy, zero);
+  XChangeProperty (Dpy, w,
+                   XInternAtom (Dpy, "_NET_WM_SYNC_REQUEST_COUNTER", False),
+                   XA_CARDINAL, 32, PropModeReplace,
+                   (unsigned char *)&Counter, 1);
+
+  protos[0] = XInternAtom (Dpy, "WM_DELETE_WINDOW", False);
+  protos[1] = Sync_request;
+  XSetWMProtocols (Dpy, w, protos, 2);
+}
+
+/* What a slow application does after it's been configured. */
+static void redraw (int width, int height)
+{
+  usleep (Draw_ms * 1000);
+  XSetForeground (Dpy, Gc, WhitePixel (Dpy, DefaultScreen (Dpy)));
+  XFillRectangle (Dpy, Win, Gc, 0, 0, width, height);
+  XSetForeground (Dpy, Gc, BlackPixel (Dpy, DefaultScreen (Dpy)));
+  XDrawLine (Dpy, Win, Gc, 0, 0, width, height);
+  XDrawLine (Dpy, Win, Gc, width, 0, 0, height);
+
+  /* Tell the window manager the frame is complete. */
+  if (Counter && Have_pending)
+    {
+      XSyncSetCounter (Dpy, Counter, Pending);
+      Have_pending = 0;
+    }
+  XFlush (Dpy);
+  bench_frame ();
+}
+
+static long get_rotating (void)
+{
+  Atom type;
+  int format;
+  unsigned long items, left;
+  unsigned char *data;
+  long value = 0;
+
+  if (XGetWindowProperty (Dpy, DefaultRootWindow (Dpy), Rotating, 0, 1,
+                          False, XA_CARDINAL, &type, &format, &items, &left,
+                          &data) == Success && data)
+    {
+      if (items)
+        value = *(long *)data;
+      XFree (data);
+    }
+  return value;
+}
+
+/* Handles events until the root's _MAEMO_ROTATION_TRANSITION becomes
+ * @until or @timeout seconds pass.  Returns whether it did. */
+static int process (long until, double timeout)
+{
+  XEvent xev;
+  double end;
+
+  for (end = bench_now () + timeout; bench_now () < end; )
+    {
+      if (!XPending (Dpy))
+        {
+          usleep (1000);
+          continue;
+        }
+
+      XNextEvent (Dpy, &xev);
+      switch (xev.type)
+        {
+          case ClientMessage:
+            if (xev.xclient.message_type == Wm_protocols
+                && (Atom)xev.xclient.data.l[0] == Sync_request)
+              {
+                XSyncIntsToValue (&Pending, xev.xclient.data.l[2],
+                                  xev.xclient.data.l[3]);
+                Have_pending = 1;
+              }
+            break;
+          case ConfigureNotify:
+            if (xev.xconfigure.window == Win)
+              redraw (xev.xconfigure.width, xev.xconfigure.height);
+            break;
+          case Expose:
+            if (!xev.xexpose.count)
+              {
+                XWindowAttributes attrs;
+
+                XGetWindowAttributes (Dpy, Win, &attrs);
+                redraw (attrs.width, attrs.height);
+              }
+            break;
+          case PropertyNotify:
+            if (xev.xproperty.atom == Rotating && get_rotating () == until)
+              return 1;
+            break;
+        }
+    }
+
+  return 0;
+}
+
+int main (int argc, char **argv)
+{
+  int i, sync = 1, rotations, done;
+  double start, total, max, took;
+
+  bench_args (&argc, argv);
+  for (i = 1; i < argc; i++)
+    if (!strcmp (argv[i], "--no-sync"))
+      sync = 0;
+    else if (!strncmp (argv[i], "--draw-ms=", 10))
+      Draw_ms = atoi (argv[i] + 10);
+  rotations = Bench_count > 0 ? Bench_count : 6;
+
+  if (!(Dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+  Wm_protocols = XInternAtom (Dpy, "WM_PROTOCOLS", False);
+  Sync_request = XInternAtom (Dpy, "_NET_WM_SYNC_REQUEST", False);
+  Rotating = XInternAtom (Dpy, "_MAEMO_ROTATION_TRANSITION", False);
+
+  Win = XCreateSimpleWindow (Dpy, DefaultRootWindow (Dpy), 0, 0, 800, 480,
+                             0, 0, WhitePixel (Dpy, DefaultScreen (Dpy)));
+  Gc = XCreateGC (Dpy, Win, 0, NULL);
+  XSelectInput (Dpy, Win, StructureNotifyMask | ExposureMask);
+  XSelectInput (Dpy, DefaultRootWindow (Dpy), PropertyChangeMask);
+  XStoreName (Dpy, Win, "test-rotation");
+  set_fullscreen (Win);
+  set_card (Win, "_HILDON_PORTRAIT_MODE_SUPPORT", 1);
+  if (sync)
+    set_sync_counter (Win);
+  XMapWindow (Dpy, Win);
+
+  /* Let the mapping transition finish. */
+  process (-1, 2);
+
+  bench_start (Dpy);
+  total = max = 0;
+  for (i = done = 0; i < rotations; i++)
+    {
+      start = bench_now ();
+      set_card (Win, "_HILDON_PORTRAIT_MODE_REQUEST", !(i % 2));
+      XFlush (Dpy);
+      if (!process (1, 2) || !process (0, 5))
+        {
+          fprintf (stderr, "rotation %d didn't happen\n", i);
+          continue;
+        }
+
+      took = (bench_now () - start) * 1000;
+      printf ("rotation %d: %.1f ms\n", i, took);
+      total += took;
+      if (took > max)
+        max = took;
+      done++;
+
+      /* Don't start the next one while the screen settles. */
+      process (-1, 0.5);
+    }
+
+  bench_metric ("rotations", done);
+  bench_metric ("rotate_ms", done ? total / done : 0);
+  bench_metric ("rotate_max_ms", max);
+  bench_finish (Dpy, sync ? "rotate" : "rotate-nosync");
+
+  XCloseDisplay (Dpy);
+  return done == rotations ? 0 : 1;
+}
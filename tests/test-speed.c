@@ -10,9 +10,12 @@
 #include <gdk/gdkwindow.h>
 #include <string.h>
 
+#include "bench-common.h"
+
 /* This just attempts to paint itself at FPS fps and outputs the actual fps it
    has managed. You can then run 'xresponse -i' to check 
-   how fast hildon-desktop is rendering it, or top to see CPU usage. */
+   how fast hildon-desktop is rendering it, or top to see CPU usage.
+   With --bench it does so for --duration seconds at --fps and reports. */
 
 #define FPS 25
 
@@ -94,6 +97,7 @@ static gboolean expose(GtkWidget *widget, GdkEventExpose *event, gpointer userda
 
     if (event->count == 0)
       {
+        bench_frame();
         frame++;
         if (frame > 100) 
           {	    
@@ -107,12 +111,21 @@ static gboolean expose(GtkWidget *widget, GdkEventExpose *event, gpointer userda
 }
 
 static gboolean timeout(GtkWidget *widget) {
+  if (bench_done())
+    {
+      bench_finish(GDK_DISPLAY(), "speed");
+      gtk_main_quit();
+      return FALSE;
+    }
   gtk_widget_queue_draw_area(widget, 0, 0, AREAW, AREAH);
   return TRUE;
 }
 
 int main(int argc, char **argv)
 {
+    bench_args(&argc, argv);
+    if (Bench_fps <= 0)
+      Bench_fps = FPS;
     gtk_init(&argc, &argv);
 
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -128,7 +141,7 @@ int main(int argc, char **argv)
      * in this event */
     gtk_window_set_decorated(GTK_WINDOW(window), FALSE);
 
-    g_timeout_add(1000/FPS, (GSourceFunc)timeout, window);
+    g_timeout_add(1000/Bench_fps, (GSourceFunc)timeout, window);
 
     /* Run the program */
     gtk_widget_realize (window);
@@ -144,6 +157,7 @@ int main(int argc, char **argv)
     set_fullscreen (display, GDK_WINDOW_XID (GTK_WIDGET (window)->window));
 #endif
 
+    bench_start(GDK_DISPLAY());
     gtk_main();
 
     return 0;
@@ -0,0 +1,127 @@
+/* Maps --count (default 30) application windows, then enters and leaves
+ * the task navigator over and over for --duration seconds, so that all
+ * the thumbnails fly and fade in and out each time.  The navigator is
+ * entered with a _HILDON_BENCH message (hildon-desktop has to run with
+ * $HD_BENCH_STATS) and left by activating the topmost window.  Reports
+ * how many times it went in and out; the interesting numbers are the
+ * compositor's frame times. */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench-common.h"
+
+static Display *Dpy;
+
+static void set_window_type (Window w)
+{
+  Atom normal;
+
+  normal = XInternAtom (Dpy, "_NET_WM_WINDOW_TYPE_NORMAL", False);
+  XChangeProperty (Dpy, w, XInternAtom (Dpy, "_NET_WM_WINDOW_TYPE", False),
+                   XA_ATOM, 32, PropModeReplace,
+                   (unsigned char *)&normal, 1);
+}
+
+/* Asks the window manager to activate @w, which leaves the navigator. */
+static void activate (Window w)
+{
+  XClientMessageEvent xclient;
+
+  memset (&xclient, 0, sizeof (xclient));
+  xclient.type = ClientMessage;
+  xclient.window = w;
+  xclient.message_type = XInternAtom (Dpy, "_NET_ACTIVE_WINDOW", False);
+  xclient.format = 32;
+  xclient.data.l[0] = 2; /* pager */
+  xclient.data.l[1] = CurrentTime;
+
+  XSendEvent (Dpy, DefaultRootWindow (Dpy), False,
+              SubstructureRedirectMask | SubstructureNotifyMask,
+              (XEvent *)&xclient);
+  XFlush (Dpy);
+}
+
+/* Handles events for @secs seconds, counting the MapNotify:s in @mapped. */
+static void process (double secs, int *mapped)
+{
+  XEvent xev;
+  double end;
+
+  for (end = bench_now () + secs; bench_now () < end; )
+    {
+      if (!XPending (Dpy))
+        {
+          usleep (1000);
+          continue;
+        }
+
+      XNextEvent (Dpy, &xev);
+      if (xev.type == MapNotify && mapped)
+        (*mapped)++;
+    }
+}
+
+int main (int argc, char **argv)
+{
+  Window *wins;
+  int i, mapped, toggles;
+  char name[32];
+
+  bench_args (&argc, argv);
+  if (Bench_count <= 0)
+    Bench_count = 30;
+
+  if (!(Dpy = XOpenDisplay (NULL)))
+    {
+      fprintf (stderr, "can't open display\n");
+      return 1;
+    }
+
+  wins = calloc (Bench_count, sizeof (*wins));
+  for (i = 0; i < Bench_count; i++)
+    {
+      wins[i] = XCreateSimpleWindow (Dpy, DefaultRootWindow (Dpy),
+                                     0, 0, 800, 424, 0, 0,
+                                     WhitePixel (Dpy, DefaultScreen (Dpy)));
+      XSelectInput (Dpy, wins[i], StructureNotifyMask);
+      sprintf (name, "switcher %d", i);
+      XStoreName (Dpy, wins[i], name);
+      set_window_type (wins[i]);
+      XMapWindow (Dpy, wins[i]);
+    }
+  XFlush (Dpy);
+
+  /* Let all of them map and their transitions finish. */
+  mapped = 0;
+  process (2, &mapped);
+  if (mapped < Bench_count)
+    fprintf (stderr, "only %d of %d windows mapped\n", mapped, Bench_count);
+
+  bench_start (Dpy);
+  for (toggles = 0; Bench ? !bench_done () : toggles < 5; toggles++)
+    {
+      /* Enough for the thumbnails to fly in and out. */
+      bench_control (Dpy, 2, 0);
+      process (0.6, NULL);
+      bench_frame ();
+
+      activate (wins[Bench_count - 1]);
+      process (0.6, NULL);
+      bench_frame ();
+    }
+
+  printf ("%d windows, %d toggles\n", Bench_count, toggles);
+  sprintf (name, "switcher-%d", Bench_count);
+  bench_metric ("windows", Bench_count);
+  bench_metric ("toggles", toggles);
+  bench_finish (Dpy, name);
+
+  XCloseDisplay (Dpy);
+  return 0;
+}